@@ -0,0 +1,413 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#include "benchmarkStdafx.h"
+#include "benchmarkScenes.h"
+
+#define D_BENCHMARK_TERRAIN_SIZE		256
+#define D_BENCHMARK_TERRAIN_GRID_SIZE	2.0f
+
+static ndBodyDynamic* AddRigidBody(ndWorld& world, const ndMatrix& matrix, const ndShapeInstance& shape, ndFloat32 mass)
+{
+	ndBodyDynamic* const body = new ndBodyDynamic();
+	body->SetNotifyCallback(new ndBodyNotify(ndVector(0.0f, -10.0f, 0.0f, 0.0f)));
+	body->SetMatrix(matrix);
+	body->SetCollisionShape(shape);
+	if (mass > ndFloat32(0.0f))
+	{
+		body->SetMassMatrix(mass, shape);
+	}
+	world.AddBody(body);
+	return body;
+}
+
+static void BuildFloorBox(ndWorld& world)
+{
+	ndShapeInstance box(new ndShapeBox(200.0f, 1.0f, 200.f));
+	ndMatrix matrix(dGetIdentityMatrix());
+	matrix.m_posit.m_y = -0.5f;
+	AddRigidBody(world, matrix, box, ndFloat32(0.0f));
+}
+
+static void BuildFlatPlane(ndWorld& world)
+{
+	ndVector floor[] =
+	{
+		{ 200.0f, 0.0f,  200.0f, 1.0f },
+		{ 200.0f, 0.0f, -200.0f, 1.0f },
+		{ -200.0f, 0.0f, -200.0f, 1.0f },
+		{ -200.0f, 0.0f,  200.0f, 1.0f },
+	};
+	ndInt32 index[][3] = { { 0, 1, 2 },{ 0, 2, 3 } };
+
+	ndPolygonSoupBuilder meshBuilder;
+	meshBuilder.Begin();
+	meshBuilder.AddFaceIndirect(&floor[0].m_x, sizeof(ndVector), 31, &index[0][0], 3);
+	meshBuilder.AddFaceIndirect(&floor[0].m_x, sizeof(ndVector), 31, &index[1][0], 3);
+	meshBuilder.End(true);
+
+	ndShapeInstance plane(new ndShapeStatic_bvh(meshBuilder));
+	AddRigidBody(world, dGetIdentityMatrix(), plane, ndFloat32(0.0f));
+}
+
+static ndFloat32 TerrainElevation(ndFloat32 x, ndFloat32 z)
+{
+	// smooth hills, flat enough around the origin for the stacks to settle
+	const ndFloat32 r2 = x * x + z * z;
+	const ndFloat32 scale = r2 / (r2 + ndFloat32(400.0f));
+	return scale * (ndFloat32(2.0f) * ndSin(x * ndFloat32(0.05f)) * ndCos(z * ndFloat32(0.07f)) + ndFloat32(0.5f) * ndSin((x + z) * ndFloat32(0.21f)));
+}
+
+static void BuildHeightFieldTerrain(ndWorld& world)
+{
+	const ndFloat32 origin = -ndFloat32(0.5f) * D_BENCHMARK_TERRAIN_SIZE * D_BENCHMARK_TERRAIN_GRID_SIZE;
+	ndShapeInstance heighfieldInstance(new ndShapeHeightfield(D_BENCHMARK_TERRAIN_SIZE, D_BENCHMARK_TERRAIN_SIZE,
+		ndShapeHeightfield::m_invertedDiagonals, 1.0f / 100.0f, D_BENCHMARK_TERRAIN_GRID_SIZE, D_BENCHMARK_TERRAIN_GRID_SIZE));
+
+	ndShapeHeightfield* const shape = heighfieldInstance.GetShape()->GetAsShapeHeightfield();
+	ndArray<ndInt16>& hightMap = shape->GetElevationMap();
+	for (ndInt32 z = 0; z < D_BENCHMARK_TERRAIN_SIZE; ++z)
+	{
+		for (ndInt32 x = 0; x < D_BENCHMARK_TERRAIN_SIZE; ++x)
+		{
+			const ndFloat32 high = TerrainElevation(origin + x * D_BENCHMARK_TERRAIN_GRID_SIZE, origin + z * D_BENCHMARK_TERRAIN_GRID_SIZE);
+			hightMap[z * D_BENCHMARK_TERRAIN_SIZE + x] = ndInt16(high * ndFloat32(100.0f));
+		}
+	}
+	shape->UpdateElevationMapAabb();
+
+	ndMatrix matrix(dGetIdentityMatrix());
+	matrix.m_posit.m_x = origin;
+	matrix.m_posit.m_z = origin;
+	AddRigidBody(world, matrix, heighfieldInstance, ndFloat32(0.0f));
+}
+
+static void BuildSphereColumn(ndWorld& world, ndFloat32 mass, const ndVector& origin, const ndVector& size, ndInt32 count)
+{
+	ndMatrix matrix(dGetIdentityMatrix());
+	matrix.m_posit.m_x = origin.m_x;
+	matrix.m_posit.m_y = origin.m_y + size.m_x;
+	matrix.m_posit.m_z = origin.m_z;
+
+	ndShapeInstance shape(new ndShapeSphere(size.m_x));
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		AddRigidBody(world, matrix, shape, mass);
+		matrix.m_posit += matrix.m_up.Scale(size.m_x * 2.0f);
+	}
+}
+
+static void BuildBoxColumn(ndWorld& world, ndFloat32 mass, const ndVector& origin, const ndVector& size, ndInt32 count)
+{
+	const ndVector blockBoxSize(size.Scale(2.0f));
+	ndMatrix matrix(dGetIdentityMatrix());
+	matrix.m_posit.m_x = origin.m_x;
+	matrix.m_posit.m_y = origin.m_y + blockBoxSize.m_y * 0.5f;
+	matrix.m_posit.m_z = origin.m_z;
+
+	ndShapeInstance shape(new ndShapeBox(blockBoxSize.m_x, blockBoxSize.m_y, blockBoxSize.m_z));
+	const ndMatrix rotation(dYawMatrix(20.0f * ndDegreeToRad));
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		AddRigidBody(world, matrix, shape, mass);
+		matrix.m_posit += matrix.m_up.Scale(blockBoxSize.m_x);
+		matrix = rotation * matrix;
+	}
+}
+
+static void BuildCylinderColumn(ndWorld& world, ndFloat32 mass, const ndVector& origin, const ndVector& size, ndInt32 count)
+{
+	ndMatrix matrix(dGetIdentityMatrix());
+	matrix.m_posit.m_x = origin.m_x;
+	matrix.m_posit.m_y = origin.m_y + size.m_z * 0.5f;
+	matrix.m_posit.m_z = origin.m_z;
+
+	ndShapeInstance shape(new ndShapeCylinder(size.m_x, size.m_y, size.m_z));
+	shape.SetLocalMatrix(dRollMatrix(ndPi * 0.5f));
+	const ndMatrix rotation(dYawMatrix(20.0f * ndDegreeToRad));
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		AddRigidBody(world, matrix, shape, mass);
+		matrix.m_posit += matrix.m_up.Scale(size.m_z);
+		matrix = rotation * matrix;
+	}
+}
+
+static void BuildPyramid(ndWorld& world, ndFloat32 mass, const ndVector& origin, const ndVector& boxSize, ndInt32 count)
+{
+	ndShapeInstance shape(new ndShapeBox(boxSize.m_x, boxSize.m_y, boxSize.m_z));
+
+	ndMatrix matrix(dGetIdentityMatrix());
+	matrix.m_posit = origin;
+	matrix.m_posit.m_w = 1.0f;
+
+	const ndFloat32 stepz = boxSize.m_z + 1.0e-2f;
+	const ndFloat32 stepy = boxSize.m_y;
+	ndFloat32 z0 = matrix.m_posit.m_z - stepz * count / 2;
+	matrix.m_posit.m_y = origin.m_y + stepy / 2.0f - 0.01f;
+	for (ndInt32 j = 0; j < count; ++j)
+	{
+		matrix.m_posit.m_z = z0;
+		for (ndInt32 i = 0; i < (count - j); ++i)
+		{
+			AddRigidBody(world, matrix, shape, mass);
+			matrix.m_posit.m_z += stepz;
+		}
+		z0 += stepz * 0.5f;
+		matrix.m_posit.m_y += stepy;
+	}
+}
+
+static void BuildCapsuleStack(ndWorld& world, ndFloat32 mass, const ndVector& origin, const ndVector& size, ndInt32 stackHigh)
+{
+	ndShapeInstance shape(new ndShapeCapsule(size.m_x, size.m_x, size.m_z));
+
+	const ndFloat32 vertialStep = size.m_x * 2.0f;
+	const ndFloat32 horizontalStep = size.m_z * 0.8f;
+
+	ndMatrix matrix0(dGetIdentityMatrix());
+	matrix0.m_posit = origin;
+	matrix0.m_posit.m_y += size.m_x;
+	matrix0.m_posit.m_w = 1.0f;
+
+	ndMatrix matrix1(matrix0);
+	matrix1.m_posit.m_z += horizontalStep;
+
+	ndMatrix matrix2(dYawMatrix(ndPi * 0.5f) * matrix0);
+	matrix2.m_posit.m_x += horizontalStep * 0.5f;
+	matrix2.m_posit.m_z += horizontalStep * 0.5f;
+	matrix2.m_posit.m_y += vertialStep;
+
+	ndMatrix matrix3(matrix2);
+	matrix3.m_posit.m_x -= horizontalStep;
+
+	for (ndInt32 i = 0; i < stackHigh / 2; ++i)
+	{
+		AddRigidBody(world, matrix0, shape, mass);
+		AddRigidBody(world, matrix1, shape, mass);
+		AddRigidBody(world, matrix2, shape, mass);
+		AddRigidBody(world, matrix3, shape, mass);
+
+		matrix0.m_posit.m_y += vertialStep * 2.0f;
+		matrix1.m_posit.m_y += vertialStep * 2.0f;
+		matrix2.m_posit.m_y += vertialStep * 2.0f;
+		matrix3.m_posit.m_y += vertialStep * 2.0f;
+	}
+}
+
+static void AddCapsulesStacks(ndWorld& world, const ndVector& origin, ndFloat32 mass, ndFloat32 radius0, ndFloat32 radius1, ndFloat32 high, ndInt32 rows_x, ndInt32 rows_z, ndInt32 columHigh)
+{
+	ndShapeInstance shape(new ndShapeCapsule(radius0, radius1, high));
+
+	const ndFloat32 spacing = 2.0f;
+	for (ndInt32 i = 0; i < rows_x; ++i)
+	{
+		for (ndInt32 j = 0; j < rows_z; ++j)
+		{
+			ndMatrix matrix(dRollMatrix(90.0f * ndDegreeToRad));
+			matrix.m_posit = origin + ndVector((j - rows_x / 2) * spacing, 0.0f, (i - rows_z / 2) * spacing, 0.0f);
+			// the terrain elevation is a drop height above the flat floors too
+			matrix.m_posit.m_y = TerrainElevation(matrix.m_posit.m_x, matrix.m_posit.m_z) + high + 7.0f;
+			matrix.m_posit.m_w = 1.0f;
+			for (ndInt32 k = 0; k < columHigh; ++k)
+			{
+				ndBodyDynamic* const body = AddRigidBody(world, matrix, shape, mass);
+				body->SetAngularDamping(ndVector(ndFloat32(0.5f)));
+				matrix.m_posit.m_y += high * 2.5f;
+			}
+		}
+	}
+}
+
+static void AddConvexHull(ndWorld& world, const ndVector& origin, ndFloat32 mass, ndFloat32 radius, ndFloat32 high, ndInt32 segments)
+{
+	ndInt32 count = 0;
+	ndVector points[1024];
+	for (ndInt32 i = 0; i < segments; ++i)
+	{
+		const ndFloat32 angle = ndFloat32(2.0f) * ndPi * i / segments;
+		const ndFloat32 x = radius * ndCos(angle);
+		const ndFloat32 z = radius * ndSin(angle);
+		points[count++] = ndVector(0.7f * x, -high * 0.5f, 0.7f * z, 0.0f);
+		points[count++] = ndVector(0.7f * x, high * 0.5f, 0.7f * z, 0.0f);
+		points[count++] = ndVector(x, -high * 0.25f, z, 0.0f);
+		points[count++] = ndVector(x, high * 0.25f, z, 0.0f);
+	}
+
+	ndShapeInstance shape(new ndShapeConvexHull(count, sizeof(ndVector), 0.0f, &points[0].m_x));
+	ndMatrix matrix(dGetIdentityMatrix());
+	matrix.m_posit = origin;
+	matrix.m_posit.m_y += TerrainElevation(origin.m_x, origin.m_z) + 1.0f;
+	matrix.m_posit.m_w = 1.0f;
+	AddRigidBody(world, matrix, shape, mass);
+}
+
+static void AddBox(ndWorld& world, const ndVector& origin, ndFloat32 mass, ndFloat32 sizex, ndFloat32 sizey, ndFloat32 sizez)
+{
+	ndShapeInstance shape(new ndShapeBox(sizex, sizey, sizez));
+	ndMatrix matrix(dGetIdentityMatrix());
+	matrix.m_posit = origin;
+	matrix.m_posit.m_y += TerrainElevation(origin.m_x, origin.m_z) + 1.0f;
+	matrix.m_posit.m_w = 1.0f;
+	AddRigidBody(world, matrix, shape, mass);
+}
+
+static void BuildRagdollChains(ndWorld& world, const ndVector& origin, ndInt32 rows_x, ndInt32 rows_z, ndInt32 links)
+{
+	// articulated chains of hinges and ball and sockets that start horizontal 
+	// and swing from a static bar, they replace the fbx skeletons of the ragdoll demos
+	ndShapeInstance barShape(new ndShapeBox(0.5f, 0.5f, rows_z * 3.0f));
+	ndShapeInstance linkShape(new ndShapeCapsule(0.15f, 0.15f, 0.8f));
+
+	const ndMatrix hingeFrame(dYawMatrix(90.0f * ndDegreeToRad));
+	for (ndInt32 i = 0; i < rows_x; ++i)
+	{
+		ndMatrix barMatrix(dGetIdentityMatrix());
+		barMatrix.m_posit = origin + ndVector(i * (links + 2.0f), links * 1.0f + 2.0f, 0.0f, 0.0f);
+		barMatrix.m_posit.m_w = 1.0f;
+		ndBodyKinematic* const bar = AddRigidBody(world, barMatrix, barShape, ndFloat32(0.0f));
+
+		for (ndInt32 j = 0; j < rows_z; ++j)
+		{
+			ndBodyKinematic* parent = bar;
+			ndMatrix pinMatrix(dGetIdentityMatrix());
+			pinMatrix.m_posit = barMatrix.m_posit + ndVector(0.25f, 0.0f, (j - rows_z / 2) * 3.0f, 0.0f);
+			for (ndInt32 k = 0; k < links; ++k)
+			{
+				// capsules are aligned to the x axis
+				ndMatrix linkMatrix(dGetIdentityMatrix());
+				linkMatrix.m_posit = pinMatrix.m_posit + ndVector(0.5f, 0.0f, 0.0f, 0.0f);
+				ndBodyDynamic* const link = AddRigidBody(world, linkMatrix, linkShape, ndFloat32(1.0f));
+
+				ndJointBilateralConstraint* joint = nullptr;
+				if (k & 1)
+				{
+					ndMatrix hingeMatrix(hingeFrame);
+					hingeMatrix.m_posit = pinMatrix.m_posit;
+					joint = new ndJointHinge(hingeMatrix, link, parent);
+				}
+				else
+				{
+					ndJointBallAndSocket* const ballJoint = new ndJointBallAndSocket(pinMatrix, link, parent);
+					ballJoint->SetConeLimit(60.0f * ndDegreeToRad);
+					ballJoint->SetTwistLimits(-30.0f * ndDegreeToRad, 30.0f * ndDegreeToRad);
+					joint = ballJoint;
+				}
+				joint->SetSolverModel(m_jointkinematicOpenLoop);
+				world.AddJoint(joint);
+
+				parent = link;
+				pinMatrix.m_posit.m_x += 1.0f;
+			}
+		}
+	}
+}
+
+static void ndBasicRigidBody(ndWorld& world)
+{
+	BuildFloorBox(world);
+	AddCapsulesStacks(world, ndVector(0.0f, 0.0f, 0.0f, 0.0f), 10.0f, 0.5f, 0.5f, 1.0f, 10, 10, 7);
+}
+
+static void ndBasicStacks(ndWorld& world)
+{
+	BuildFlatPlane(world);
+
+	ndVector origin(ndVector::m_zero);
+	for (ndInt32 i = 0; i < 4; ++i)
+	{
+		BuildPyramid(world, 1.0f, origin + ndVector(3.0f, 0.0f, 0.0f, 0.0f), ndVector(0.5f, 0.25f, 0.8f, 0.0f), 30);
+		origin.m_x += 4.0f;
+	}
+
+	origin = ndVector::m_zero;
+	origin.m_x -= 2.0f;
+	origin.m_z -= 3.0f;
+	BuildSphereColumn(world, 10.0f, origin, ndVector(0.5f, 0.5f, 0.5f, 0.0f), 20);
+
+	origin.m_z += 6.0f;
+	BuildBoxColumn(world, 10.0f, origin, ndVector(0.5f, 0.5f, 0.5f, 0.0f), 18);
+
+	origin.m_z += 6.0f;
+	BuildCylinderColumn(world, 10.0f, origin, ndVector(0.75f, 0.6f, 1.0f, 0.0f), 20);
+
+	origin.m_x -= 6.0f;
+	origin.m_z -= 6.0f;
+	BuildCapsuleStack(world, 10.0f, origin, ndVector(0.25f, 0.25f, 2.0f, 0.0f), 20);
+}
+
+static void ndStaticMeshCollision(ndWorld& world)
+{
+	BuildHeightFieldTerrain(world);
+
+	AddBox(world, ndVector(10.0f, 1.0f, 0.0f, 0.0f), 30.0f, 2.0f, 0.25f, 2.5f);
+	AddBox(world, ndVector(10.0f, 1.5f, 1.125f, 0.0f), 30.0f, 2.0f, 0.25f, 2.5f);
+	AddBox(world, ndVector(10.0f, 2.0f, 1.250f, 0.0f), 30.0f, 2.0f, 0.25f, 2.5f);
+	AddConvexHull(world, ndVector(8.0f, 1.0f, -3.0f, 0.0f), 10.0f, 0.6f, 1.0f, 15);
+	AddConvexHull(world, ndVector(7.0f, 1.0f, -3.0f, 0.0f), 10.0f, 0.7f, 1.0f, 10);
+	AddConvexHull(world, ndVector(6.0f, 1.0f, -3.0f, 0.0f), 10.0f, 0.5f, 1.2f, 6);
+	AddCapsulesStacks(world, ndVector(45.0f, 0.0f, 0.0f, 0.0f), 10.0f, 0.5f, 0.5f, 1.0f, 10, 10, 7);
+}
+
+static void ndBasicParticleFluid(ndWorld& world)
+{
+	BuildFlatPlane(world);
+
+	const ndFloat32 diameter = 0.25f;
+	const ndInt32 particleCountPerAxis = 32;
+	const ndFloat32 spacing = diameter * 1.0f;
+	const ndFloat32 offset = spacing * particleCountPerAxis / 2.0f;
+
+	ndBodySphFluid* const fluidObject = new ndBodySphFluid();
+	fluidObject->SetNotifyCallback(new ndBodyNotify(ndVector(0.0f, -10.0f, 0.0f, 0.0f)));
+	fluidObject->SetMatrix(dGetIdentityMatrix());
+	fluidObject->SetParticleRadius(diameter * 0.5f);
+
+	const ndVector origin(-offset, 1.0f, -offset, ndFloat32(0.0f));
+	for (ndInt32 z = 0; z < particleCountPerAxis; ++z)
+	{
+		for (ndInt32 y = 0; y < particleCountPerAxis; ++y)
+		{
+			for (ndInt32 x = 0; x < particleCountPerAxis; ++x)
+			{
+				const ndVector posit(origin + ndVector(x * spacing, y * spacing, z * spacing, ndFloat32(1.0f)));
+				fluidObject->AddParticle(0.1f, posit, ndVector::m_zero);
+			}
+		}
+	}
+	world.AddBody(fluidObject);
+}
+
+static void ndRagdollChains(ndWorld& world)
+{
+	BuildFloorBox(world);
+	BuildRagdollChains(world, ndVector(-60.0f, 0.0f, 0.0f, 0.0f), 8, 12, 12);
+}
+
+static const ndBenchmarkScene benchmarkScenes[] =
+{
+	{ "basicRigidBody", ndBasicRigidBody },
+	{ "basicStacks", ndBasicStacks },
+	{ "staticMeshCollision", ndStaticMeshCollision },
+	{ "ragdollChains", ndRagdollChains },
+	{ "basicParticleFluid", ndBasicParticleFluid },
+};
+
+ndInt32 GetBenchmarkSceneCount()
+{
+	return ndInt32(sizeof(benchmarkScenes) / sizeof(benchmarkScenes[0]));
+}
+
+const ndBenchmarkScene& GetBenchmarkScene(ndInt32 index)
+{
+	dAssert((index >= 0) && (index < GetBenchmarkSceneCount()));
+	return benchmarkScenes[index];
+}
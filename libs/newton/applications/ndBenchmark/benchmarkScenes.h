@@ -0,0 +1,32 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#ifndef _BENCHMARK_SCENES_H_
+#define _BENCHMARK_SCENES_H_
+
+#include "benchmarkStdafx.h"
+
+// headless versions of the physics content of the sandbox demos, 
+// they do not use random numbers so that every run builds the same scene.
+typedef void (*ndBuildBenchmarkScene)(ndWorld& world);
+
+class ndBenchmarkScene
+{
+	public:
+	const char* m_name;
+	ndBuildBenchmarkScene m_build;
+};
+
+ndInt32 GetBenchmarkSceneCount();
+const ndBenchmarkScene& GetBenchmarkScene(ndInt32 index);
+
+#endif
+
@@ -0,0 +1,308 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#include "benchmarkStdafx.h"
+#include "benchmarkScenes.h"
+
+// headless benchmark of the sandbox demo scenes.
+// each scene is built and stepped a fixed number of frames for every 
+// combination of solver and thread count, the results are printed 
+// as json so that they can be compared between versions.
+//
+// usage: ndBenchmark [-frames n] [-threads 1,2,4] [-solvers standard,soa,avx2] [-scenes name,name] [-output file.json] [-deterministic]
+
+#define D_BENCHMARK_MAX_THREADS		64
+#define D_BENCHMARK_TIMESTEP		(1.0f / 60.0f)
+
+class ndBenchmarkSolver
+{
+	public:
+	const char* m_name;
+	ndWorld::ndSolverModes m_mode;
+};
+
+static const ndBenchmarkSolver benchmarkSolvers[] =
+{
+	{ "standard", ndWorld::ndStandardSolver },
+	{ "soa", ndWorld::ndSimdSoaSolver },
+	{ "avx2", ndWorld::ndSimdAvx2Solver },
+};
+
+class ndBenchmarkResult
+{
+	public:
+	const char* m_scene;
+	const char* m_solver;
+	ndInt32 m_threads;
+	ndInt32 m_bodyCount;
+	ndInt32 m_jointCount;
+	ndFloat64 m_buildTime;
+	ndFloat64 m_totalTime;
+	ndFloat64 m_minFrameTime;
+	ndFloat64 m_maxFrameTime;
+	ndFloat64 m_speedup;
+	ndFloat64 m_phaseTime[ndWorldStatistics::m_phaseCount];
+	ndUnsigned64 m_memoryUsed;
+	ndUnsigned64 m_checksum;
+};
+
+class ndBenchmarkOptions
+{
+	public:
+	ndBenchmarkOptions()
+		:m_frames(300)
+		,m_threadCount(0)
+		,m_solverCount(0)
+		,m_sceneFilter(nullptr)
+		,m_outputName(nullptr)
+		,m_deterministic(false)
+	{
+	}
+
+	ndInt32 m_frames;
+	ndInt32 m_threadCount;
+	ndInt32 m_solverCount;
+	ndInt32 m_threads[D_BENCHMARK_MAX_THREADS];
+	const ndBenchmarkSolver* m_solvers[sizeof(benchmarkSolvers) / sizeof(benchmarkSolvers[0])];
+	const char* m_sceneFilter;
+	const char* m_outputName;
+	bool m_deterministic;
+};
+
+static bool IsInList(const char* const list, const char* const name)
+{
+	// list is a coma separated set of names
+	const size_t size = strlen(name);
+	for (const char* ptr = list; ptr; ptr = strchr(ptr, ','))
+	{
+		ptr += (*ptr == ',') ? 1 : 0;
+		if (!strncmp(ptr, name, size) && ((ptr[size] == ',') || (ptr[size] == 0)))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool ParseOptions(ndInt32 argc, const char* const argv[], ndBenchmarkOptions& options)
+{
+	const char* threads = nullptr;
+	const char* solvers = nullptr;
+	for (ndInt32 i = 1; i < argc; ++i)
+	{
+		const bool hasValue = (i + 1) < argc;
+		if (!strcmp(argv[i], "-frames") && hasValue)
+		{
+			options.m_frames = dMax(atoi(argv[++i]), 1);
+		}
+		else if (!strcmp(argv[i], "-threads") && hasValue)
+		{
+			threads = argv[++i];
+		}
+		else if (!strcmp(argv[i], "-solvers") && hasValue)
+		{
+			solvers = argv[++i];
+		}
+		else if (!strcmp(argv[i], "-scenes") && hasValue)
+		{
+			options.m_sceneFilter = argv[++i];
+		}
+		else if (!strcmp(argv[i], "-output") && hasValue)
+		{
+			options.m_outputName = argv[++i];
+		}
+		else if (!strcmp(argv[i], "-deterministic"))
+		{
+			options.m_deterministic = true;
+		}
+		else
+		{
+			fprintf(stderr, "usage: %s [-frames n] [-threads 1,2,4] [-solvers standard,soa,avx2] [-scenes name,name] [-output file.json] [-deterministic]\n", argv[0]);
+			for (ndInt32 j = 0; j < GetBenchmarkSceneCount(); ++j)
+			{
+				fprintf(stderr, "  scene: %s\n", GetBenchmarkScene(j).m_name);
+			}
+			return false;
+		}
+	}
+
+	if (threads)
+	{
+		for (const char* ptr = threads; ptr && (options.m_threadCount < D_BENCHMARK_MAX_THREADS); ptr = strchr(ptr, ','))
+		{
+			ptr += (*ptr == ',') ? 1 : 0;
+			options.m_threads[options.m_threadCount++] = dClamp(atoi(ptr), 1, D_MAX_THREADS_COUNT);
+		}
+	}
+	else
+	{
+		// powers of two up to the hardware thread count
+		const ndInt32 hardwareThreads = dClamp(ndInt32(std::thread::hardware_concurrency()), 1, D_MAX_THREADS_COUNT);
+		for (ndInt32 count = 1; count < hardwareThreads; count *= 2)
+		{
+			options.m_threads[options.m_threadCount++] = count;
+		}
+		options.m_threads[options.m_threadCount++] = hardwareThreads;
+	}
+
+	for (ndInt32 i = 0; i < ndInt32(sizeof(benchmarkSolvers) / sizeof(benchmarkSolvers[0])); ++i)
+	{
+		if (!solvers || IsInList(solvers, benchmarkSolvers[i].m_name))
+		{
+			options.m_solvers[options.m_solverCount++] = &benchmarkSolvers[i];
+		}
+	}
+	return true;
+}
+
+static ndUnsigned64 CalculateChecksum(const ndWorld& world)
+{
+	// hash of the final body positions, it only matches between 
+	// runs that produce bit identical simulations.
+	ndUnsigned64 checksum = 0;
+	const ndBodyList& bodyList = world.GetBodyList();
+	for (ndBodyList::ndNode* node = bodyList.GetFirst(); node; node = node->GetNext())
+	{
+		const ndVector posit(node->GetInfo()->GetMatrix().m_posit);
+		checksum = dCRC64(&posit, sizeof(ndFloat32) * 3, checksum);
+	}
+	return checksum;
+}
+
+static bool RunBenchmark(const ndBenchmarkScene& scene, const ndBenchmarkSolver& solver, ndInt32 threads, const ndBenchmarkOptions& options, ndBenchmarkResult& result)
+{
+	memset(&result, 0, sizeof(result));
+	result.m_scene = scene.m_name;
+	result.m_solver = solver.m_name;
+	result.m_threads = threads;
+
+	ndWorld* const world = new ndWorld();
+	world->SelectSolver(solver.m_mode);
+	if (world->GetSelectedSolver() != solver.m_mode)
+	{
+		// this solver is not part of this build
+		delete world;
+		return false;
+	}
+	world->SetSubSteps(2);
+	world->SetThreadCount(threads);
+	world->SetStatisticsEnabled(true);
+	world->SetDeterministic(options.m_deterministic);
+
+	const ndUnsigned64 buildStart = dGetTimeInMicroseconds();
+	scene.m_build(*world);
+	result.m_buildTime = ndFloat64(dGetTimeInMicroseconds() - buildStart) * 1.0e-6;
+
+	result.m_minFrameTime = 1.0e10;
+	for (ndInt32 i = 0; i < options.m_frames; ++i)
+	{
+		world->Update(D_BENCHMARK_TIMESTEP);
+		world->Sync();
+
+		const ndWorldStatistics& statistics = world->GetStatistics();
+		const ndFloat64 frameTime = statistics.m_updateTime;
+		result.m_totalTime += frameTime;
+		result.m_minFrameTime = dMin(result.m_minFrameTime, frameTime);
+		result.m_maxFrameTime = dMax(result.m_maxFrameTime, frameTime);
+		for (ndInt32 j = 0; j < statistics.m_subStepCount; ++j)
+		{
+			for (ndInt32 k = 0; k < ndWorldStatistics::m_phaseCount; ++k)
+			{
+				result.m_phaseTime[k] += statistics.m_subSteps[j].m_phaseTime[k];
+			}
+		}
+		result.m_memoryUsed = dMax(result.m_memoryUsed, statistics.m_memoryUsed);
+	}
+
+	result.m_bodyCount = world->GetBodyList().GetCount();
+	result.m_jointCount = world->GetJointList().GetCount();
+	result.m_checksum = CalculateChecksum(*world);
+	delete world;
+	return true;
+}
+
+static void PrintResults(FILE* const file, const ndBenchmarkOptions& options, const ndArray<ndBenchmarkResult>& results)
+{
+	fprintf(file, "{\n");
+	fprintf(file, "\t\"engineVersion\": \"%d.%02d\",\n", D_NEWTON_ENGINE_MAJOR_VERSION, D_NEWTON_ENGINE_MINOR_VERSION);
+	fprintf(file, "\t\"frames\": %d,\n", options.m_frames);
+	fprintf(file, "\t\"timestep\": %f,\n", D_BENCHMARK_TIMESTEP);
+	fprintf(file, "\t\"results\": [\n");
+	for (ndInt32 i = 0; i < results.GetCount(); ++i)
+	{
+		const ndBenchmarkResult& result = results[i];
+		fprintf(file, "\t\t{ \"scene\": \"%s\", \"solver\": \"%s\", \"threads\": %d, ", result.m_scene, result.m_solver, result.m_threads);
+		fprintf(file, "\"bodies\": %d, \"joints\": %d, ", result.m_bodyCount, result.m_jointCount);
+		fprintf(file, "\"buildTime\": %.6f, \"totalTime\": %.6f, ", result.m_buildTime, result.m_totalTime);
+		fprintf(file, "\"averageFrameTime\": %.6f, \"minFrameTime\": %.6f, \"maxFrameTime\": %.6f, ", result.m_totalTime / options.m_frames, result.m_minFrameTime, result.m_maxFrameTime);
+		fprintf(file, "\"speedup\": %.3f, \"memoryUsed\": %llu, \"checksum\": \"%016llx\",\n", result.m_speedup, (unsigned long long)result.m_memoryUsed, (unsigned long long)result.m_checksum);
+		fprintf(file, "\t\t  \"phases\": {");
+		for (ndInt32 j = 0; j < ndWorldStatistics::m_phaseCount; ++j)
+		{
+			fprintf(file, "%s \"%s\": %.6f", j ? "," : "", ndWorldStatistics::GetPhaseName(ndWorldStatistics::ndPhase(j)), result.m_phaseTime[j]);
+		}
+		fprintf(file, " } }%s\n", (i + 1) < results.GetCount() ? "," : "");
+	}
+	fprintf(file, "\t]\n");
+	fprintf(file, "}\n");
+}
+
+int main(int argc, const char* argv[])
+{
+	ndBenchmarkOptions options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		return 1;
+	}
+
+	ndArray<ndBenchmarkResult> results;
+	for (ndInt32 i = 0; i < GetBenchmarkSceneCount(); ++i)
+	{
+		const ndBenchmarkScene& scene = GetBenchmarkScene(i);
+		if (options.m_sceneFilter && !IsInList(options.m_sceneFilter, scene.m_name))
+		{
+			continue;
+		}
+
+		for (ndInt32 j = 0; j < options.m_solverCount; ++j)
+		{
+			ndFloat64 baseTime = 0.0;
+			for (ndInt32 k = 0; k < options.m_threadCount; ++k)
+			{
+				ndBenchmarkResult result;
+				if (!RunBenchmark(scene, *options.m_solvers[j], options.m_threads[k], options, result))
+				{
+					fprintf(stderr, "solver %s not available\n", options.m_solvers[j]->m_name);
+					break;
+				}
+
+				// the speedup is relative to the first thread count of the sweep
+				baseTime = k ? baseTime : result.m_totalTime;
+				result.m_speedup = (result.m_totalTime > 0.0) ? baseTime / result.m_totalTime : 0.0;
+				results.PushBack(result);
+				fprintf(stderr, "%s %s threads %d: %.3f ms per frame\n", scene.m_name, result.m_solver, result.m_threads, 1000.0 * result.m_totalTime / options.m_frames);
+			}
+		}
+	}
+
+	FILE* const file = options.m_outputName ? fopen(options.m_outputName, "wb") : stdout;
+	if (!file)
+	{
+		fprintf(stderr, "can't open %s\n", options.m_outputName);
+		return 1;
+	}
+	PrintResults(file, options, results);
+	if (file != stdout)
+	{
+		fclose(file);
+	}
+	return 0;
+}
@@ -26,6 +26,7 @@
 #include "ndBodyNotify.h"
 
 ndUnsigned32 ndBody::m_uniqueIdCount = 0;
+ndUnsigned32 ndBody::m_liveBodyCount = 0;
 
 ndBody::ndBody()
 	:ndContainersFreeListAlloc<ndBody>()
@@ -50,6 +51,7 @@ ndBody::ndBody()
 	,m_bodyIsConstrained(0)
 {
 	m_uniqueIdCount++;
+	m_liveBodyCount++;
 	m_transformIsDirty = 1;
 }
 
@@ -76,6 +78,7 @@ ndBody::ndBody(const ndLoadSaveBase::ndLoadDescriptor& desc)
 	,m_bodyIsConstrained(0)
 {
 	m_uniqueIdCount++;
+	m_liveBodyCount++;
 	m_transformIsDirty = 1;
 
 	const nd::TiXmlNode* const xmlNode = desc.m_rootNode;
@@ -102,6 +105,8 @@ ndBody::ndBody(const ndLoadSaveBase::ndLoadDescriptor& desc)
 
 ndBody::~ndBody()
 {
+	dAssert(m_liveBodyCount);
+	m_liveBodyCount--;
 	if (m_notifyCallback)
 	{
 		delete m_notifyCallback;
@@ -134,18 +139,18 @@ void ndBody::SetNotifyCallback(ndBodyNotify* const notify)
 void ndBody::SetOmega(const ndVector& omega)
 {
 	m_omega = omega;
-	m_equilibrium = 0;
+	WakeUp();
 }
 
 void ndBody::SetVelocity(const ndVector& veloc)
 {
 	m_veloc = veloc;
-	m_equilibrium = 0;
+	WakeUp();
 }
 
 void ndBody::SetMatrix(const ndMatrix& matrix)
 {
-	m_equilibrium = 0;
+	WakeUp();
 	m_transformIsDirty = 1;
 	m_matrix = matrix;
 	dAssert(m_matrix.TestOrthogonal(ndFloat32(1.0e-4f)));
@@ -90,6 +90,9 @@ class ndBody : public ndContainersFreeListAlloc<ndBody>
 	virtual void AttachContact(ndContact* const) {}
 	virtual void DetachContact(ndContact* const) {}
 	virtual ndContact* FindContact(const ndBody* const) const { return nullptr; }
+	virtual void WakeSleepingIsland() {}
+
+	void WakeUp();
 
 	ndMatrix m_matrix;
 	ndVector m_veloc;
@@ -114,6 +117,9 @@ class ndBody : public ndContainersFreeListAlloc<ndBody>
 			ndUnsigned32 m_contactTestOnly : 1;
 			ndUnsigned32 m_transformIsDirty : 1;
 			ndUnsigned32 m_equilibriumOverride : 1;
+			ndUnsigned32 m_speculativeContacts : 1;
+			ndUnsigned32 m_sleepingIsland : 1;
+			ndUnsigned32 m_sleepingIslandMark : 1;
 		};
 	};
 
@@ -126,6 +132,7 @@ class ndBody : public ndContainersFreeListAlloc<ndBody>
 	ndUnsigned8 m_isJointFence1;
 	ndUnsigned8 m_bodyIsConstrained;
 	D_COLLISION_API static ndUnsigned32 m_uniqueIdCount;
+	D_COLLISION_API static ndUnsigned32 m_liveBodyCount;
 
 	friend class ndWorld;
 	friend class ndScene;
@@ -194,6 +201,17 @@ inline ndFloat32 ndBody::GetInvMass() const
 	return ndFloat32(0.0f); 
 }
 
+// clears the equilibrium state, a body that is part of a sleeping island 
+// also asks the scene to move its island back to the set of awake bodies.
+inline void ndBody::WakeUp()
+{
+	m_equilibrium = 0;
+	if (m_sleepingIsland)
+	{
+		WakeSleepingIsland();
+	}
+}
+
 inline void ndBody::SetMatrixAndCentreOfMass(const ndQuaternion& rotation, const ndVector& globalcom)
 {
 	m_rotation = rotation;
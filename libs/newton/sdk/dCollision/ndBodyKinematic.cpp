@@ -21,6 +21,7 @@
 
 #include "ndCoreStdafx.h"
 #include "ndCollisionStdafx.h"
+#include "ndScene.h"
 #include "ndContact.h"
 #include "ndShapeNull.h"
 #include "ndRayCastNotify.h"
@@ -167,6 +168,10 @@ ndBodyKinematic::~ndBodyKinematic()
 void ndBodyKinematic::SetSleepState(bool state)
 {
 	m_equilibrium = state ? 1 : 0;
+	if (!state && m_sleepingIsland)
+	{
+		WakeSleepingIsland();
+	}
 	if ((m_invMass.m_w > ndFloat32(0.0f)) && (m_veloc.DotProduct(m_veloc).GetScalar() < ndFloat32(1.0e-10f)) && (m_omega.DotProduct(m_omega).GetScalar() < ndFloat32(1.0e-10f))) 
 	{
 		ndVector invalidateVeloc(ndFloat32(10.0f));
@@ -187,6 +192,18 @@ void ndBodyKinematic::SetCollisionShape(const ndShapeInstance& shapeInstance)
 	{
 		m_shapeInstance.GetShape()->GetAsShapeCompound()->SetSubShapeOwner(this);
 	}
+
+	// the child pairs cached by the contacts point to nodes of the old shape
+	ndContactMap::Iterator it(m_contactList);
+	for (it.Begin(); it; it++)
+	{
+		ndContact* const contact = *it;
+		if (contact->m_childCache)
+		{
+			delete contact->m_childCache;
+			contact->m_childCache = nullptr;
+		}
+	}
 }
 
 ndContact* ndBodyKinematic::FindContact(const ndBody* const otherBody) const
@@ -201,7 +218,7 @@ void ndBodyKinematic::AttachContact(ndContact* const contact)
 	dAssert((this == contact->GetBody0()) || (this == contact->GetBody1()));
 	if (m_invMass.m_w > ndFloat32(0.0f))
 	{
-		m_equilibrium = 0;
+		WakeUp();
 	}
 
 	m_contactList.AttachContact(contact);
@@ -211,19 +228,22 @@ void ndBodyKinematic::DetachContact(ndContact* const contact)
 {
 	ndScopeSpinLock lock(m_lock);
 	dAssert((this == contact->GetBody0()) || (this == contact->GetBody1()));
-	m_equilibrium = contact->m_body0->m_equilibrium & contact->m_body1->m_equilibrium;
+	if (contact->m_wakeBodies)
+	{
+		WakeUp();
+	}
 	m_contactList.DetachContact(contact);
 }
 
 ndJointList::ndNode* ndBodyKinematic::AttachJoint(ndJointBilateralConstraint* const joint)
 {
-	m_equilibrium = 0;
+	WakeUp();
 	return m_jointList.Append(joint);
 }
 
 void ndBodyKinematic::DetachJoint(ndJointList::ndNode* const node)
 {
-	m_equilibrium = 0;
+	WakeUp();
 #ifdef _DEBUG
 	bool found = false;
 	for (ndJointList::ndNode* nodeptr = m_jointList.GetFirst(); nodeptr; nodeptr = nodeptr->GetNext())
@@ -235,6 +255,12 @@ void ndBodyKinematic::DetachJoint(ndJointList::ndNode* const node)
 	m_jointList.Remove(node);
 }
 
+void ndBodyKinematic::WakeSleepingIsland()
+{
+	dAssert(m_scene);
+	m_scene->WakeSleepingIsland(this);
+}
+
 void ndBodyKinematic::SetMassMatrix(ndFloat32 mass, const ndMatrix& inertia)
 {
 	mass = dAbs(mass);
@@ -109,6 +109,9 @@ class ndBodyKinematic: public ndBody
 
 	bool GetAutoSleep() const;
 	void SetAutoSleep(bool state);
+
+	bool GetSpeculativeContacts() const;
+	void SetSpeculativeContacts(bool state);
 	void SetDebugMaxAngularIntegrationSteepAndLinearSpeed(ndFloat32 angleInRadian, ndFloat32 speedInMitersPerSeconds);
 
 	virtual ndFloat32 GetLinearDamping() const;
@@ -170,6 +173,7 @@ class ndBodyKinematic: public ndBody
 
 	D_COLLISION_API virtual ndJointList::ndNode* AttachJoint(ndJointBilateralConstraint* const joint);
 	D_COLLISION_API virtual void DetachJoint(ndJointList::ndNode* const node);
+	D_COLLISION_API virtual void WakeSleepingIsland();
 	D_COLLISION_API virtual void IntegrateExternalForce(ndFloat32 timestep);
 
 	void SetAccel(const ndJacobian& accel);
@@ -222,6 +226,7 @@ class ndBodyKinematic: public ndBody
 	friend class ndDynamicsUpdateAvx2;
 	friend class ndDynamicsUpdateOpencl;
 	friend class ndJointBilateralConstraint;
+	friend class ndLoadSave;
 } D_GCC_NEWTON_ALIGN_32;
 
 inline ndUnsigned32 ndBodyKinematic::GetIndex() const
@@ -438,6 +443,16 @@ inline void ndBodyKinematic::SetAutoSleep(bool state)
 	SetSleepState(false);
 }
 
+inline bool ndBodyKinematic::GetSpeculativeContacts() const
+{
+	return m_speculativeContacts ? true : false;
+}
+
+inline void ndBodyKinematic::SetSpeculativeContacts(bool state)
+{
+	m_speculativeContacts = state ? 1 : 0;
+}
+
 inline ndSkeletonContainer* ndBodyKinematic::GetSkeleton() const
 { 
 	return m_skeletonContainer;
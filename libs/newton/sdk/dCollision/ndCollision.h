@@ -54,6 +54,7 @@
 #include <ndRayCastNotify.h>
 #include <ndContactNotify.h>
 #include <ndShapeCompound.h>
+#include <ndShapeRegistry.h>
 #include <ndContactOptions.h>
 #include <ndShapeStatic_bvh.h>
 #include <ndShapeConvexHull.h>
@@ -39,6 +39,7 @@ ndContact::ndContact()
 	,m_rotationAcc()
 	,m_separatingVector(m_initialSeparatingVector)
 	,m_contacPointsList()
+	,m_childCache(nullptr)
 	,m_body0(nullptr)
 	,m_body1(nullptr)
 	,m_material()
@@ -52,12 +53,21 @@ ndContact::ndContact()
 	,m_isIntersetionTestOnly(0)
 	,m_skeletonIntraCollision(1)
 	,m_skeletonSelftCollision(1)
+	,m_wakeBodies(0)
+	,m_sleepingIsland(0)
+	,m_isTouching(0)
 {
 	m_active = 0;
+	m_supportVertexCache[0] = -1;
+	m_supportVertexCache[1] = -1;
 }
 
 ndContact::~ndContact()
 {
+	if (m_childCache)
+	{
+		delete m_childCache;
+	}
 }
 
 void ndContact::SetBodies(ndBodyKinematic* const body0, ndBodyKinematic* const body1)
@@ -82,9 +92,18 @@ void ndContact::AttachToBodies()
 
 void ndContact::DetachFromBodies()
 {
+	m_wakeBodies = (m_body0->m_equilibrium & m_body1->m_equilibrium) ? 0 : 1;
+	DetachBodies();
+}
+
+void ndContact::DetachBodies()
+{
+	// m_wakeBodies must be set before the bodies are detached, 
+	// so that many contacts can be detached at the same time.
 	m_isAttached = false;
 	m_body0->DetachContact(this);
 	m_body1->DetachContact(this);
+	m_wakeBodies = 0;
 }
 
 void ndContact::JacobianDerivative(ndConstraintDescritor& desc)
@@ -150,12 +169,23 @@ void ndContact::JacobianContactDerivative(ndConstraintDescritor& desc, const ndC
 	desc.m_forceBounds[normalIndex].m_normalIndex = D_INDEPENDENT_ROW;
 	desc.m_forceBounds[normalIndex].m_jointForce = (ndForceImpactPair*)&contact.m_normal_Force;
 	
-	const ndFloat32 restitutionVelocity = (relSpeed > D_REST_RELATIVE_VELOCITY) ? relSpeed * restitutionCoefficient : ndFloat32(0.0f);
-	const ndFloat32 penetrationStiffness = D_MAX_PENETRATION_STIFFNESS * contact.m_material.m_softness;
-	const ndFloat32 penetrationVeloc = penetration * penetrationStiffness;
-	dAssert(dAbs(penetrationVeloc - D_MAX_PENETRATION_STIFFNESS * contact.m_material.m_softness * penetration) < ndFloat32(1.0e-6f));
-	desc.m_penetrationStiffness[normalIndex] = penetrationStiffness;
-	relSpeed += dMax(restitutionVelocity, penetrationVeloc);
+	if (contact.m_penetration < -D_PENETRATION_TOL)
+	{
+		// speculative contact: the shapes are still apart, 
+		// the solver only removes the approach speed in excess of the gap.
+		desc.m_penetration[normalIndex] = contact.m_penetration;
+		desc.m_penetrationStiffness[normalIndex] = desc.m_invTimestep;
+		relSpeed += contact.m_penetration * desc.m_invTimestep;
+	}
+	else
+	{
+		const ndFloat32 restitutionVelocity = (relSpeed > D_REST_RELATIVE_VELOCITY) ? relSpeed * restitutionCoefficient : ndFloat32(0.0f);
+		const ndFloat32 penetrationStiffness = D_MAX_PENETRATION_STIFFNESS * contact.m_material.m_softness;
+		const ndFloat32 penetrationVeloc = penetration * penetrationStiffness;
+		dAssert(dAbs(penetrationVeloc - D_MAX_PENETRATION_STIFFNESS * contact.m_material.m_softness * penetration) < ndFloat32(1.0e-6f));
+		desc.m_penetrationStiffness[normalIndex] = penetrationStiffness;
+		relSpeed += dMax(restitutionVelocity, penetrationVeloc);
+	}
 	
 	const bool isHardContact = !(contact.m_material.m_flags & m_isSoftContact);
 	desc.m_diagonalRegularizer[normalIndex] = isHardContact ? D_DIAGONAL_REGULARIZER : dMax(D_DIAGONAL_REGULARIZER, contact.m_material.m_skinThickness);
@@ -317,6 +347,13 @@ void ndContact::JointAccelerations(ndJointAccelerationDecriptor* const desc)
 					}
 					penetrationVeloc = -(rhs->m_penetration * rhs->m_penetrationStiffness);
 				}
+				else if (rhs->m_penetration < ndFloat32(0.0f))
+				{
+					// speculative contact, the stiffness is the inverse of the step, 
+					// so the bodies are allowed to close the gap but not to cross it. 
+					restitution = ndFloat32(1.0f);
+					penetrationVeloc = -(rhs->m_penetration * rhs->m_penetrationStiffness);
+				}
 				vRel = vRel * restitution + penetrationVeloc;
 			}
 		
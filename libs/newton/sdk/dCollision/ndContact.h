@@ -80,6 +80,48 @@ class ndContactPointList : public ndList<ndContactMaterial, ndContainersFreeList
 	}
 };
 
+// the leaf pairs of two shape hierarchies that were closer than m_margin 
+// at the cached relative matrix, they are valid while the bodies move less 
+// than the margin so the trees are not walked again every step.
+D_MSV_NEWTON_ALIGN_32
+class ndContactChildCache: public ndClassAlloc
+{
+	public:
+	class ndPair
+	{
+		public:
+		ndVector m_p0;
+		ndVector m_p1;
+		const void* m_node0;
+		const void* m_node1;
+		ndUnsigned64 m_key;
+	};
+
+	ndContactChildCache()
+		:ndClassAlloc()
+		,m_pairs()
+		,m_matrix(dGetIdentityMatrix())
+		,m_scale0(ndVector::m_one)
+		,m_scale1(ndVector::m_one)
+		,m_shape0(nullptr)
+		,m_shape1(nullptr)
+		,m_margin(ndFloat32(0.0f))
+		,m_revision0(0)
+		,m_revision1(0)
+	{
+	}
+
+	ndArray<ndPair> m_pairs;
+	ndMatrix m_matrix;
+	ndVector m_scale0;
+	ndVector m_scale1;
+	const ndShape* m_shape0;
+	const ndShape* m_shape1;
+	ndFloat32 m_margin;
+	ndUnsigned32 m_revision0;
+	ndUnsigned32 m_revision1;
+} D_GCC_NEWTON_ALIGN_32;
+
 D_MSV_NEWTON_ALIGN_32 
 class ndContact: public ndConstraint
 {
@@ -109,6 +151,7 @@ class ndContact: public ndConstraint
 	bool IsSkeletonIntraCollision() const;
 	
 	private:
+	void DetachBodies();
 	void SetBodies(ndBodyKinematic* const body0, ndBodyKinematic* const body1);
 	void CalculatePointDerivative(ndInt32 index, ndConstraintDescritor& desc, const ndVector& dir, const dgPointParam& param) const;
 	void JacobianContactDerivative(ndConstraintDescritor& desc, const ndContactMaterial& contact, ndInt32 normalIndex, ndInt32& frictionIndex);
@@ -117,12 +160,14 @@ class ndContact: public ndConstraint
 	ndQuaternion m_rotationAcc;
 	ndVector m_separatingVector;
 	ndContactPointList m_contacPointsList;
+	ndContactChildCache* m_childCache;
 	ndBodyKinematic* m_body0;
 	ndBodyKinematic* m_body1;
 	ndMaterial m_material;
 	ndFloat32 m_timeOfImpact;
 	ndFloat32 m_separationDistance;
 	ndFloat32 m_contactPruningTolereance;
+	ndInt32 m_supportVertexCache[2];
 	ndUnsigned32 m_maxDOF;
 	ndUnsigned32 m_sceneLru;
 	ndUnsigned32 m_isDead : 1;
@@ -130,9 +175,13 @@ class ndContact: public ndConstraint
 	ndUnsigned32 m_isIntersetionTestOnly : 1;
 	ndUnsigned32 m_skeletonIntraCollision : 1;
 	ndUnsigned32 m_skeletonSelftCollision : 1;
+	ndUnsigned32 m_wakeBodies : 1;
+	ndUnsigned32 m_sleepingIsland : 1;
+	ndUnsigned32 m_isTouching : 1;
 	static ndVector m_initialSeparatingVector;
 
 	friend class ndScene;
+	friend class ndWorld;
 	friend class ndContactArray;
 	friend class ndBodyKinematic;
 	friend class ndContactSolver;
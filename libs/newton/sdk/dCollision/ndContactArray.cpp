@@ -27,14 +27,163 @@
 
 ndContact* ndContactArray::CreateContact(ndBodyKinematic* const body0, ndBodyKinematic* const body1)
 {
-	ndContact* const contact = new ndContact;
+	ndContact* contact = nullptr;
+	{
+		ndScopeSpinLock lock(m_lock);
+		if (!m_freeList)
+		{
+			AllocSlab(m_freeList, m_freeCount);
+		}
+		ndFreeContact* const entry = m_freeList;
+		m_freeList = entry->m_next;
+		m_freeCount--;
+		contact = ::new (entry) ndContact;
+		PushBack(contact);
+	}
 	contact->SetBodies(body0, body1);
 	contact->AttachToBodies();
-	ndScopeSpinLock lock(m_lock);
-	PushBack(contact);
 	return contact;
 }
 
+ndContact* ndContactArray::CreateContact(ndInt32 threadIndex, ndBodyKinematic* const body0, ndBodyKinematic* const body1)
+{
+	// the contact is attached to the bodies right away, so that other 
+	// threads can find it, but it only goes to the array in AddNewContacts.
+	ndContact* const contact = AllocContact(threadIndex);
+	contact->SetBodies(body0, body1);
+	contact->AttachToBodies();
+	m_threadContacts[threadIndex].m_newContacts.PushBack(contact);
+	return contact;
+}
+
+void ndContactArray::AddNewContacts(ndInt32 threadCount)
+{
+	D_TRACKTIME();
+	ndInt32 count = GetCount();
+	for (ndInt32 i = 0; i < threadCount; ++i)
+	{
+		count += m_threadContacts[i].m_newContacts.GetCount();
+	}
+
+	ndInt32 index = GetCount();
+	SetCount(count);
+	for (ndInt32 i = 0; i < threadCount; ++i)
+	{
+		ndArray<ndContact*>& newContacts = m_threadContacts[i].m_newContacts;
+		if (newContacts.GetCount())
+		{
+			memcpy(&m_array[index], &newContacts[0], newContacts.GetCount() * sizeof(ndContact*));
+			index += newContacts.GetCount();
+			newContacts.SetCount(0);
+		}
+	}
+}
+
+ndContact* ndContactArray::AllocContact(ndInt32 threadIndex)
+{
+	ndThreadContacts& cache = m_threadContacts[threadIndex];
+	if (!cache.m_freeList)
+	{
+		// take a batch of the contacts freed by other threads, 
+		// and only go to the system when there are none.
+		ndScopeSpinLock lock(m_lock);
+		const ndInt32 batch = dMin(m_freeCount, ndInt32(D_CONTACT_POOL_SLAB_SIZE));
+		for (ndInt32 i = 0; i < batch; ++i)
+		{
+			ndFreeContact* const entry = m_freeList;
+			m_freeList = entry->m_next;
+			entry->m_next = cache.m_freeList;
+			cache.m_freeList = entry;
+		}
+		m_freeCount -= batch;
+		cache.m_freeCount = batch;
+		if (!cache.m_freeList)
+		{
+			AllocSlab(cache.m_freeList, cache.m_freeCount);
+		}
+	}
+
+	ndFreeContact* const entry = cache.m_freeList;
+	cache.m_freeList = entry->m_next;
+	cache.m_freeCount--;
+	return ::new (entry) ndContact;
+}
+
+void ndContactArray::AllocSlab(ndFreeContact*& freeList, ndInt32& freeCount)
+{
+	// called with the lock held
+	const ndInt32 stride = ndInt32(sizeof(ndContact));
+	char* const slab = (char*)ndMemory::Malloc(size_t(stride * D_CONTACT_POOL_SLAB_SIZE));
+	m_slabs.PushBack(slab);
+	for (ndInt32 i = D_CONTACT_POOL_SLAB_SIZE - 1; i >= 0; --i)
+	{
+		ndFreeContact* const entry = (ndFreeContact*)&slab[i * stride];
+		entry->m_next = freeList;
+		freeList = entry;
+	}
+	freeCount += D_CONTACT_POOL_SLAB_SIZE;
+}
+
+void ndContactArray::FreeContact(ndInt32 threadIndex, ndContact* const contact)
+{
+	dAssert(!contact->m_isAttached);
+	ndThreadContacts& cache = m_threadContacts[threadIndex];
+	contact->~ndContact();
+	ndFreeContact* const entry = (ndFreeContact*)contact;
+	entry->m_next = cache.m_freeList;
+	cache.m_freeList = entry;
+	cache.m_freeCount++;
+}
+
+void ndContactArray::FreeContact(ndContact* const contact)
+{
+	dAssert(!contact->m_isAttached);
+	contact->~ndContact();
+	ndScopeSpinLock lock(m_lock);
+	ndFreeContact* const entry = (ndFreeContact*)contact;
+	entry->m_next = m_freeList;
+	m_freeList = entry;
+	m_freeCount++;
+}
+
+void ndContactArray::TrimFreeLists(ndInt32 threadCount)
+{
+	D_TRACKTIME();
+	// contacts are not freed by the same thread that created them, 
+	// the excess of each thread goes back to the shared list.
+	ndScopeSpinLock lock(m_lock);
+	for (ndInt32 i = 0; i < threadCount; ++i)
+	{
+		ndThreadContacts& cache = m_threadContacts[i];
+		while (cache.m_freeCount > D_CONTACT_POOL_SLAB_SIZE)
+		{
+			ndFreeContact* const entry = cache.m_freeList;
+			cache.m_freeList = entry->m_next;
+			cache.m_freeCount--;
+			entry->m_next = m_freeList;
+			m_freeList = entry;
+			m_freeCount++;
+		}
+	}
+}
+
+void ndContactArray::ReleaseSlabs()
+{
+	for (ndInt32 i = 0; i < m_slabs.GetCount(); ++i)
+	{
+		ndMemory::Free(m_slabs[i]);
+	}
+	for (ndInt32 i = 0; i < D_MAX_THREADS_COUNT; ++i)
+	{
+		m_threadContacts[i].m_freeList = nullptr;
+		m_threadContacts[i].m_freeCount = 0;
+		m_threadContacts[i].m_newContacts.SetCount(0);
+	}
+	m_slabs.SetCount(0);
+	m_freeList = nullptr;
+	m_freeCount = 0;
+}
+
 void ndContactArray::DeleteContact(ndContact* const contact)
 {
 	if (contact->m_isAttached)
@@ -53,8 +202,9 @@ void ndContactArray::DeleteAllContacts()
 		{
 			DeleteContact(contact);
 		}
-		delete (contact);
+		contact->~ndContact();
 	}
+	ReleaseSlabs();
 	Resize(1024);
 	SetCount(0);
 }
@@ -25,23 +25,70 @@
 #include "ndCollisionStdafx.h"
 #include "ndContact.h"
 
+// number of contacts in each block of memory of the contact pool
+#define D_CONTACT_POOL_SLAB_SIZE	256
+
+// contacts are allocated from slabs and recycled through per thread free lists, 
+// so that creating and freeing contacts from the worker threads takes no lock.
 class ndContactArray : public ndArray<ndContact*>
 {
+	class ndFreeContact
+	{
+		public:
+		ndFreeContact* m_next;
+	};
+
+	class ndThreadContacts
+	{
+		public:
+		ndThreadContacts()
+			:m_newContacts(256)
+			,m_freeList(nullptr)
+			,m_freeCount(0)
+		{
+		}
+
+		ndArray<ndContact*> m_newContacts;
+		ndFreeContact* m_freeList;
+		ndInt32 m_freeCount;
+	};
+
 	public:
 	ndContactArray()
 		:ndArray<ndContact*>(1024)
+		,m_slabs()
+		,m_freeList(nullptr)
+		,m_freeCount(0)
 		,m_lock()
 	{
 	}
 
 	~ndContactArray()
 	{
+		ReleaseSlabs();
 	}
 
 	void DeleteAllContacts();
 	void DeleteContact(ndContact* const contact);
 	ndContact* CreateContact(ndBodyKinematic* const body0, ndBodyKinematic* const body1);
 
+	ndContact* CreateContact(ndInt32 threadIndex, ndBodyKinematic* const body0, ndBodyKinematic* const body1);
+	void FreeContact(ndInt32 threadIndex, ndContact* const contact);
+	void FreeContact(ndContact* const contact);
+	void AddNewContacts(ndInt32 threadCount);
+	void TrimFreeLists(ndInt32 threadCount);
+
+	private:
+	ndContact* AllocContact(ndInt32 threadIndex);
+	void AllocSlab(ndFreeContact*& freeList, ndInt32& freeCount);
+	void ReleaseSlabs();
+
+	ndThreadContacts m_threadContacts[D_MAX_THREADS_COUNT];
+	ndArray<void*> m_slabs;
+	ndFreeContact* m_freeList;
+	ndInt32 m_freeCount;
+
+	public:
 	ndSpinLock m_lock;
 };
 
@@ -0,0 +1,44 @@
+/* Copyright (c) <2003-2021> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "ndCoreStdafx.h"
+#include "ndCollisionStdafx.h"
+#include "ndContactNotify.h"
+
+void ndContactNotify::RegisterMaterialPair(ndUnsigned32 id0, ndUnsigned32 id1, const ndMaterial& material)
+{
+	const ndUnsigned64 key = GetMaterialPairKey(id0, id1);
+	ndTree<ndMaterial, ndUnsigned64>::ndNode* const node = m_materialPairs.Find(key);
+	if (node)
+	{
+		node->GetInfo() = material;
+	}
+	else
+	{
+		m_materialPairs.Insert(material, key);
+	}
+}
+
+void ndContactNotify::UnregisterMaterialPair(ndUnsigned32 id0, ndUnsigned32 id1)
+{
+	m_materialPairs.Remove(GetMaterialPairKey(id0, id1));
+}
@@ -28,6 +28,7 @@
 class ndScene;
 class ndContact;
 class ndShapeInstance;
+class ndBodyKinematic;
 
 class ndMaterial
 {
@@ -56,12 +57,35 @@ class ndMaterial
 	ndUnsigned32 m_userFlags;
 };
 
+// a contact state change reported by the scene after the solver, 
+// see ndScene::SetContactEvents
+class ndContactEvent
+{
+	public:
+	enum ndType
+	{
+		m_begin,
+		m_persist,
+		m_end,
+	};
+
+	ndBodyKinematic* m_body0;
+	ndBodyKinematic* m_body1;
+	// sum of the normal impulses of all contact points
+	ndFloat32 m_normalImpulse;
+	// largest relative speed at the contact points
+	ndFloat32 m_relativeSpeed;
+	// m_begin is the first step the bodies touch
+	ndType m_type;
+};
+
 D_MSV_NEWTON_ALIGN_32
 class ndContactNotify: public ndClassAlloc
 {
 	public:
 	ndContactNotify()
 		:ndClassAlloc()
+		,m_materialPairs()
 		,m_scene(nullptr)
 	{
 	}
@@ -99,9 +123,35 @@ class ndContactNotify: public ndClassAlloc
 	{
 	}
 
+	// a registered pair of shape material ids replaces the GetMaterial and OnAabbOverlap 
+	// calls for bodies with those ids, the pair is skipped without m_collisionEnable and 
+	// OnContactCallback is only called with m_contactCallbackEnable set. the pairs that
+	// are not registered still use the virtual functions.
+	D_COLLISION_API void RegisterMaterialPair(ndUnsigned32 id0, ndUnsigned32 id1, const ndMaterial& material);
+	D_COLLISION_API void UnregisterMaterialPair(ndUnsigned32 id0, ndUnsigned32 id1);
+	const ndMaterial* FindMaterialPair(ndInt64 id0, ndInt64 id1) const;
+
 	protected:
+	static ndUnsigned64 GetMaterialPairKey(ndUnsigned32 id0, ndUnsigned32 id1);
+
+	ndTree<ndMaterial, ndUnsigned64> m_materialPairs;
 	ndScene* m_scene;
 	friend class ndScene;
 };
 
+inline ndUnsigned64 ndContactNotify::GetMaterialPairKey(ndUnsigned32 id0, ndUnsigned32 id1)
+{
+	return (ndUnsigned64(dMin(id0, id1)) << 32) | ndUnsigned64(dMax(id0, id1));
+}
+
+inline const ndMaterial* ndContactNotify::FindMaterialPair(ndInt64 id0, ndInt64 id1) const
+{
+	if (!m_materialPairs.GetCount() || (ndUnsigned64(id0) > 0xffffffff) || (ndUnsigned64(id1) > 0xffffffff))
+	{
+		return nullptr;
+	}
+	const ndTree<ndMaterial, ndUnsigned64>::ndNode* const node = m_materialPairs.Find(GetMaterialPairKey(ndUnsigned32(id0), ndUnsigned32(id1)));
+	return node ? &node->GetInfo() : nullptr;
+}
+
 #endif
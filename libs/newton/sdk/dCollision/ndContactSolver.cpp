@@ -26,6 +26,9 @@
 #include "ndContact.h"
 #include "ndShapePoint.h"
 #include "ndShapeConvex.h"
+#include "ndShapeBox.h"
+#include "ndShapeSphere.h"
+#include "ndShapeCapsule.h"
 #include "ndShapeCompound.h"
 #include "ndBodyKinematic.h"
 #include "ndContactSolver.h"
@@ -34,6 +37,8 @@
 #include "ndShapeHeightfield.h"
 #include "ndShapeConvexPolygon.h"
 
+#define D_CHILD_CACHE_SEPARATION	ndFloat32 (0.5f)
+
 ndVector ndContactSolver::m_pruneUpDir(ndFloat32(0.0f), ndFloat32(0.0f), ndFloat32(1.0f), ndFloat32(0.0f));
 ndVector ndContactSolver::m_pruneSupportX(ndFloat32(1.0f), ndFloat32(0.0f), ndFloat32(0.0f), ndFloat32(0.0f));
 
@@ -233,69 +238,308 @@ class ndContactSolver::ndBoxBoxDistance2
 class ndStackBvhStackEntry
 {
 	public:
+	ndVector m_treeNodeP0;
+	ndVector m_treeNodeP1;
 	const ndShapeCompound::ndNodeBase* m_compoundNode;
 	const ndAabbPolygonSoup::ndNode* m_collisionTreeNode;
 	ndFloat32 m_dist2;
 	ndInt32 m_treeNodeIsLeaf;
 };
 
-static void PushStackEntry(
-	ndContactSolver::ndBoxBoxDistance2& data,
+class ndCompareChildPairs
+{
+	public:
+	ndInt32 Compare(const ndContactChildCache::ndPair& pair0, const ndContactChildCache::ndPair& pair1, void* const) const
+	{
+		if (pair0.m_key < pair1.m_key)
+		{
+			return -1;
+		}
+		else if (pair0.m_key > pair1.m_key)
+		{
+			return 1;
+		}
+		return 0;
+	}
+};
+
+static ndFloat32 CalculateChildCacheRadius(const ndShapeCompound::ndNodeBase* const root)
+{
+	// radius of a sphere centered at the compound origin that contains all its children
+	const ndFloat32 origin2 = root->m_origin.DotProduct(root->m_origin & ndVector::m_triplexMask).GetScalar();
+	const ndFloat32 size2 = root->m_size.DotProduct(root->m_size & ndVector::m_triplexMask).GetScalar();
+	return ndSqrt(origin2) + ndSqrt(size2);
+}
+
+static bool ValidateChildCache(
+	const ndContactChildCache& cache, 
+	const ndShapeInstance* const instance0, ndUnsigned32 revision0, 
+	const ndShapeInstance* const instance1, ndUnsigned32 revision1, 
+	const ndMatrix& matrix, ndFloat32 radius)
+{
+	if ((cache.m_shape0 != instance0->GetShape()) || (cache.m_shape1 != instance1->GetShape()))
+	{
+		return false;
+	}
+	if ((cache.m_revision0 != revision0) || (cache.m_revision1 != revision1))
+	{
+		return false;
+	}
+	const ndVector scaleMask((cache.m_scale0 == instance0->GetScale()) & (cache.m_scale1 == instance1->GetScale()));
+	if ((scaleMask.GetSignMask() & 7) != 7)
+	{
+		return false;
+	}
+
+	// the box distance of shape0 nodes measured in the space of shape1 changes 
+	// at most sqrt(3) times the largest displacement of a shape0 point, 
+	// while that is inside the margin no pair outside the cache can be closer 
+	// than D_CHILD_CACHE_SEPARATION, so the cached pairs are all that need testing.
+	const ndVector step(matrix.m_posit - cache.m_matrix.m_posit);
+	const ndFloat32 trace = 
+		matrix.m_front.DotProduct(cache.m_matrix.m_front & ndVector::m_triplexMask).GetScalar() + 
+		matrix.m_up.DotProduct(cache.m_matrix.m_up & ndVector::m_triplexMask).GetScalar() + 
+		matrix.m_right.DotProduct(cache.m_matrix.m_right & ndVector::m_triplexMask).GetScalar();
+	const ndFloat32 rotation = ndSqrt(dMax(ndFloat32(2.0f) * (ndFloat32(3.0f) - trace), ndFloat32(0.0f)));
+	const ndFloat32 displacement = ndSqrt(step.DotProduct(step & ndVector::m_triplexMask).GetScalar()) + radius * rotation;
+	return (D_CHILD_CACHE_SEPARATION + ndFloat32(1.7321f) * displacement) < cache.m_margin;
+}
+
+static void ResetChildCache(
+	ndContactChildCache& cache, 
+	const ndShapeInstance* const instance0, ndUnsigned32 revision0, 
+	const ndShapeInstance* const instance1, ndUnsigned32 revision1, 
+	const ndMatrix& matrix, ndFloat32 radius, 
+	const ndBodyKinematic* const body0, const ndBodyKinematic* const body1, ndFloat32 timestep)
+{
+	// pad the margin with a few steps of relative motion so a moving pair 
+	// can reuse its cache for several steps before the trees are walked again.
+	const ndVector veloc(body0->GetVelocity() - body1->GetVelocity());
+	const ndVector omega(body0->GetOmega() - body1->GetOmega());
+	const ndFloat32 linearSpeed = ndSqrt(veloc.DotProduct(veloc & ndVector::m_triplexMask).GetScalar());
+	const ndFloat32 angularSpeed = ndSqrt(omega.DotProduct(omega & ndVector::m_triplexMask).GetScalar());
+	const ndFloat32 speed = linearSpeed + angularSpeed * radius;
+	const ndFloat32 padding = D_CHILD_CACHE_SEPARATION + ndFloat32(8.0f) * speed * timestep;
+
+	cache.m_pairs.SetCount(0);
+	cache.m_matrix = matrix;
+	cache.m_scale0 = instance0->GetScale();
+	cache.m_scale1 = instance1->GetScale();
+	cache.m_shape0 = instance0->GetShape();
+	cache.m_shape1 = instance1->GetShape();
+	cache.m_revision0 = revision0;
+	cache.m_revision1 = revision1;
+	cache.m_margin = D_CHILD_CACHE_SEPARATION + dMin(padding, ndFloat32(4.0f) * D_CHILD_CACHE_SEPARATION);
+}
+
+static void CollectCompoundChildPairs(const ndContactSolver::ndBoxBoxDistance2& data, ndContactChildCache& cache, const ndShapeCompound::ndNodeBase* const root0, const ndShapeCompound::ndNodeBase* const root1)
+{
+	// depth first walk of both trees, only the shape1 space box distance is 
+	// used for pruning because it grows monotonically down the trees.
+	class ndNodePair
+	{
+		public:
+		const ndShapeCompound::ndNodeBase* m_node0;
+		const ndShapeCompound::ndNodeBase* m_node1;
+	};
+
+	const ndFloat32 margin2 = cache.m_margin * cache.m_margin;
+	ndNodePair stackPool[2 * D_COMPOUND_STACK_DEPTH];
+
+	ndInt32 stack = 0;
+	if (data.CalculateBox0Distance2(root0->m_origin, root0->m_size, root1->m_origin, root1->m_size) <= margin2)
+	{
+		stackPool[0].m_node0 = root0;
+		stackPool[0].m_node1 = root1;
+		stack = 1;
+	}
+
+	while (stack)
+	{
+		stack--;
+		const ndShapeCompound::ndNodeBase* const node0 = stackPool[stack].m_node0;
+		const ndShapeCompound::ndNodeBase* const node1 = stackPool[stack].m_node1;
+		if ((node0->m_type == ndShapeCompound::m_leaf) && (node1->m_type == ndShapeCompound::m_leaf))
+		{
+			ndContactChildCache::ndPair pair;
+			pair.m_p0 = ndVector::m_zero;
+			pair.m_p1 = ndVector::m_zero;
+			pair.m_node0 = node0;
+			pair.m_node1 = node1;
+			pair.m_key = (ndUnsigned64(ndUnsigned32(node0->m_myNode->GetKey())) << 32) + ndUnsigned32(node1->m_myNode->GetKey());
+			cache.m_pairs.PushBack(pair);
+		}
+		else
+		{
+			const ndShapeCompound::ndNodeBase* subNodes0[2];
+			const ndShapeCompound::ndNodeBase* subNodes1[2];
+			ndInt32 count0 = 1;
+			ndInt32 count1 = 1;
+			subNodes0[0] = node0;
+			subNodes1[0] = node1;
+			if (node0->m_type == ndShapeCompound::m_node)
+			{
+				subNodes0[0] = node0->m_left;
+				subNodes0[1] = node0->m_right;
+				count0 = 2;
+			}
+			if (node1->m_type == ndShapeCompound::m_node)
+			{
+				subNodes1[0] = node1->m_left;
+				subNodes1[1] = node1->m_right;
+				count1 = 2;
+			}
+
+			for (ndInt32 i = 0; i < count0; ++i)
+			{
+				const ndShapeCompound::ndNodeBase* const subNode0 = subNodes0[i];
+				for (ndInt32 j = 0; j < count1; ++j)
+				{
+					const ndShapeCompound::ndNodeBase* const subNode1 = subNodes1[j];
+					if (data.CalculateBox0Distance2(subNode0->m_origin, subNode0->m_size, subNode1->m_origin, subNode1->m_size) <= margin2)
+					{
+						stackPool[stack].m_node0 = subNode0;
+						stackPool[stack].m_node1 = subNode1;
+						stack++;
+						dAssert(stack < 2 * D_COMPOUND_STACK_DEPTH);
+					}
+				}
+			}
+		}
+	}
+
+	if (cache.m_pairs.GetCount() > 1)
+	{
+		ndSort<ndContactChildCache::ndPair, ndCompareChildPairs>(&cache.m_pairs[0], cache.m_pairs.GetCount());
+	}
+}
+
+static void PushChildCacheStackEntry(
+	const ndContactSolver::ndBoxBoxDistance2& data,
+	ndFloat32 margin2,
 	ndInt32& stack,
 	ndStackBvhStackEntry* const stackPool,
 	const ndShapeCompound::ndNodeBase* const compoundNode,
-	ndShapeStatic_bvh* const bvhTreeCollision,
 	ndInt32 treeNodeType,
-	const ndAabbPolygonSoup::ndNode* const treeNode)
+	const ndAabbPolygonSoup::ndNode* const treeNode,
+	const ndVector& bvhp0,
+	const ndVector& bvhp1)
 {
-	ndVector bvhp0;
-	ndVector bvhp1;
-	bvhTreeCollision->GetNodeAabb(treeNode, bvhp0, bvhp1);
 	const ndVector bvhSize((bvhp1 - bvhp0) * ndVector::m_half);
 	const ndVector bvhOrigin((bvhp1 + bvhp0) * ndVector::m_half);
-
-	ndInt32 j = stack;
-	ndFloat32 dist2 = data.CalculateDistance2(compoundNode->m_origin, compoundNode->m_size, bvhOrigin, bvhSize);
-	for (; j && (dist2 > stackPool[j - 1].m_dist2); j--)
+	const ndFloat32 dist2 = data.CalculateBox0Distance2(compoundNode->m_origin, compoundNode->m_size, bvhOrigin, bvhSize);
+	if (dist2 <= margin2)
 	{
-		stackPool[j] = stackPool[j - 1];
+		stackPool[stack].m_treeNodeIsLeaf = treeNodeType;
+		stackPool[stack].m_compoundNode = compoundNode;
+		stackPool[stack].m_collisionTreeNode = treeNode;
+		stackPool[stack].m_treeNodeP0 = bvhp0;
+		stackPool[stack].m_treeNodeP1 = bvhp1;
+		stackPool[stack].m_dist2 = dist2;
+		stack++;
+		dAssert(stack < 2 * D_COMPOUND_STACK_DEPTH);
 	}
-	stackPool[j].m_treeNodeIsLeaf = treeNodeType;
-	stackPool[j].m_compoundNode = compoundNode;
-	stackPool[j].m_collisionTreeNode = treeNode;
-	stackPool[j].m_dist2 = dist2;
-	stack++;
-	dAssert(stack < 2 * D_COMPOUND_STACK_DEPTH);
 }
 
-class ndStackEntry
+static void CollectStaticBvhChildPairs(const ndContactSolver::ndBoxBoxDistance2& data, ndContactChildCache& cache, const ndShapeCompound::ndNodeBase* const compoundRoot, const ndShapeStatic_bvh* const bvhTreeCollision, const ndVector& treeScale)
 {
-	public:
-	const ndShapeCompound::ndNodeBase* m_node0;
-	const ndShapeCompound::ndNodeBase* m_node1;
-	ndFloat32 m_dist2;
-};
+	// same split rules as the best first traversal, but the nodes are 
+	// pruned by the cache margin and every surviving leaf pair is recorded.
+	const ndFloat32 margin2 = cache.m_margin * cache.m_margin;
+	const ndAabbPolygonSoup::ndNode* const treeRoot = bvhTreeCollision->GetRootNode();
 
-static void PushStackEntry(
-	ndContactSolver::ndBoxBoxDistance2& data,
-	ndInt32& stack,
-	ndStackEntry* const stackPool,
-	const ndShapeCompound::ndNodeBase* const node0,
-	const ndShapeCompound::ndNodeBase* const node1)
-{
-	dAssert(node0);
-	dAssert(node1);
-	ndInt32 j = stack;
-	ndFloat32 subDist2 = data.CalculateDistance2(node0->m_origin, node0->m_size, node1->m_origin, node1->m_size);
-	for (; j && (subDist2 > stackPool[j - 1].m_dist2); j--)
-	{
-		stackPool[j] = stackPool[j - 1];
-	}
-	stackPool[j].m_node0 = node0;
-	stackPool[j].m_node1 = node1;
-	stackPool[j].m_dist2 = subDist2;
-	stack++;
-	dAssert(stack < 2 * D_COMPOUND_STACK_DEPTH);
+	ndVector bvhp0;
+	ndVector bvhp1;
+	bvhTreeCollision->GetAABB(bvhp0, bvhp1);
+
+	ndInt32 stack = 0;
+	ndStackBvhStackEntry stackPool[2 * D_COMPOUND_STACK_DEPTH];
+	PushChildCacheStackEntry(data, margin2, stack, stackPool, compoundRoot, 0, treeRoot, bvhp0, bvhp1);
+
+	while (stack)
+	{
+		stack--;
+		const ndShapeCompound::ndNodeBase* const compoundNode = stackPool[stack].m_compoundNode;
+		const ndAabbPolygonSoup::ndNode* const collisionTreeNode = stackPool[stack].m_collisionTreeNode;
+		const ndVector treeP0(stackPool[stack].m_treeNodeP0);
+		const ndVector treeP1(stackPool[stack].m_treeNodeP1);
+		const ndInt32 treeNodeIsLeaf = stackPool[stack].m_treeNodeIsLeaf;
+		dAssert(compoundNode && collisionTreeNode);
+
+		if (treeNodeIsLeaf && (compoundNode->m_type == ndShapeCompound::m_leaf))
+		{
+			ndContactChildCache::ndPair pair;
+			pair.m_p0 = treeP0;
+			pair.m_p1 = treeP1;
+			pair.m_node0 = compoundNode;
+			pair.m_node1 = collisionTreeNode;
+			pair.m_key = (ndUnsigned64(ndUnsigned32(compoundNode->m_myNode->GetKey())) << 32) + ndUnsigned32(collisionTreeNode - treeRoot);
+			cache.m_pairs.PushBack(pair);
+		}
+		else if (treeNodeIsLeaf)
+		{
+			dAssert(compoundNode->m_type == ndShapeCompound::m_node);
+			PushChildCacheStackEntry(data, margin2, stack, stackPool, compoundNode->m_left, 1, collisionTreeNode, treeP0, treeP1);
+			PushChildCacheStackEntry(data, margin2, stack, stackPool, compoundNode->m_right, 1, collisionTreeNode, treeP0, treeP1);
+		}
+		else
+		{
+			bool splitTree = true;
+			if (compoundNode->m_type == ndShapeCompound::m_node)
+			{
+				const ndVector p0(treeP0 * treeScale);
+				const ndVector p1(treeP1 * treeScale);
+				const ndVector size((p1 - p0) * ndVector::m_half);
+				const ndFloat32 area = size.DotProduct(size.ShiftTripleRight()).GetScalar();
+				splitTree = area > compoundNode->m_area;
+			}
+
+			if (splitTree)
+			{
+				const ndAabbPolygonSoup::ndNode* const backNode = bvhTreeCollision->GetBackNode(collisionTreeNode);
+				const ndAabbPolygonSoup::ndNode* const frontNode = bvhTreeCollision->GetFrontNode(collisionTreeNode);
+				if (backNode)
+				{
+					ndVector backP0;
+					ndVector backP1;
+					bvhTreeCollision->GetNodeAabb(backNode, treeP0, treeP1, backP0, backP1);
+					PushChildCacheStackEntry(data, margin2, stack, stackPool, compoundNode, 0, backNode, backP0, backP1);
+				}
+				if (frontNode)
+				{
+					ndVector frontP0;
+					ndVector frontP1;
+					bvhTreeCollision->GetNodeAabb(frontNode, treeP0, treeP1, frontP0, frontP1);
+					PushChildCacheStackEntry(data, margin2, stack, stackPool, compoundNode, 0, frontNode, frontP0, frontP1);
+				}
+
+				if (!(backNode && frontNode))
+				{
+					if ((compoundNode->m_type == ndShapeCompound::m_leaf) || !(backNode || frontNode))
+					{
+						PushChildCacheStackEntry(data, margin2, stack, stackPool, compoundNode, 1, collisionTreeNode, treeP0, treeP1);
+					}
+					else
+					{
+						PushChildCacheStackEntry(data, margin2, stack, stackPool, compoundNode->m_left, 1, collisionTreeNode, treeP0, treeP1);
+						PushChildCacheStackEntry(data, margin2, stack, stackPool, compoundNode->m_right, 1, collisionTreeNode, treeP0, treeP1);
+					}
+				}
+			}
+			else
+			{
+				dAssert(compoundNode->m_left);
+				dAssert(compoundNode->m_right);
+				PushChildCacheStackEntry(data, margin2, stack, stackPool, compoundNode->m_left, 0, collisionTreeNode, treeP0, treeP1);
+				PushChildCacheStackEntry(data, margin2, stack, stackPool, compoundNode->m_right, 0, collisionTreeNode, treeP0, treeP1);
+			}
+		}
+	}
+
+	if (cache.m_pairs.GetCount() > 1)
+	{
+		ndSort<ndContactChildCache::ndPair, ndCompareChildPairs>(&cache.m_pairs[0], cache.m_pairs.GetCount());
+	}
 }
 
 static ndFloat32 CalculateHeighfieldDist2(const ndContactSolver::ndBoxBoxDistance2& data, const ndShapeCompound::ndNodeBase* const compoundNode, ndShapeInstance* const heightfieldInstance)
@@ -330,11 +574,14 @@ ndContactSolver::ndContactSolver(ndShapeInstance* const instance, ndContactNotif
 	,m_timestep(timestep)
 	,m_skinThickness(ndFloat32(0.0f))
 	,m_separationDistance(ndFloat32(0.0f))
+	,m_speculativeDistance(ndFloat32(0.0f))
 	,m_maxCount(D_MAX_CONTATCS)
 	,m_vertexIndex(0)
 	,m_pruneContacts(1)
 	,m_intersectionTestOnly(0)
 {
+	m_supportVertexCache[0] = -1;
+	m_supportVertexCache[1] = -1;
 }
 
 ndContactSolver::ndContactSolver(ndContact* const contact, ndContactNotify* const notification, ndFloat32 timestep)
@@ -351,11 +598,14 @@ ndContactSolver::ndContactSolver(ndContact* const contact, ndContactNotify* cons
 	,m_timestep(timestep)
 	,m_skinThickness(ndFloat32(0.0f))
 	,m_separationDistance(ndFloat32(0.0f))
+	,m_speculativeDistance(ndFloat32(0.0f))
 	,m_maxCount(D_MAX_CONTATCS)
 	,m_vertexIndex(0)
 	,m_pruneContacts(1)
 	,m_intersectionTestOnly(0)
 {
+	m_supportVertexCache[0] = contact->m_supportVertexCache[0];
+	m_supportVertexCache[1] = contact->m_supportVertexCache[1];
 }
 
 ndContactSolver::ndContactSolver(const ndContactSolver& src, const ndShapeInstance& instance0, const ndShapeInstance& instance1)
@@ -372,11 +622,14 @@ ndContactSolver::ndContactSolver(const ndContactSolver& src, const ndShapeInstan
 	,m_timestep(src.m_timestep)
 	,m_skinThickness(src.m_skinThickness)
 	,m_separationDistance(src.m_separationDistance)
+	,m_speculativeDistance(src.m_speculativeDistance)
 	,m_maxCount(D_MAX_CONTATCS)
 	,m_vertexIndex(0)
 	,m_pruneContacts(src.m_pruneContacts)
 	,m_intersectionTestOnly(src.m_intersectionTestOnly)
 {
+	m_supportVertexCache[0] = -1;
+	m_supportVertexCache[1] = -1;
 }
 
 void ndContactSolver::TranslateSimplex(const ndVector& step)
@@ -397,8 +650,8 @@ void ndContactSolver::SupportVertex(const ndVector& dir0, ndInt32 vertexIndex)
 	
 	const ndMatrix& matrix0 = m_instance0.m_globalMatrix;
 	const ndMatrix& matrix1 = m_instance1.m_globalMatrix;
-	ndVector p(matrix0.TransformVector(m_instance0.SupportVertexSpecial(matrix0.UnrotateVector (dir0), nullptr)) & ndVector::m_triplexMask);
-	ndVector q(matrix1.TransformVector(m_instance1.SupportVertexSpecial(matrix1.UnrotateVector (dir1), nullptr)) & ndVector::m_triplexMask);
+	ndVector p(matrix0.TransformVector(m_instance0.SupportVertexSpecial(matrix0.UnrotateVector (dir0), &m_supportVertexCache[0])) & ndVector::m_triplexMask);
+	ndVector q(matrix1.TransformVector(m_instance1.SupportVertexSpecial(matrix1.UnrotateVector (dir1), &m_supportVertexCache[1])) & ndVector::m_triplexMask);
 	m_hullDiff[vertexIndex] = p - q;
 	m_hullSum[vertexIndex] = p + q;
 }
@@ -996,11 +1249,11 @@ ndInt32 ndContactSolver::CalculateContacts(const ndVector& point0, const ndVecto
 		}
 	}
 
-	//if (!count && m_ccdMode) 
-	//{
-	//	count = 1;
-	//	contactsOut[0] = origin;
-	//}
+	if (!count && (m_speculativeDistance > ndFloat32(0.0f)))
+	{
+		count = 1;
+		contactsOut[0] = origin;
+	}
 
 	return count;
 }
@@ -2311,6 +2564,8 @@ ndInt32 ndContactSolver::CalculateContactsDiscrete()
 
 	m_contact->m_timeOfImpact = m_timestep;
 	m_contact->m_separatingVector = m_separatingVector;
+	m_contact->m_supportVertexCache[0] = m_supportVertexCache[0];
+	m_contact->m_supportVertexCache[1] = m_supportVertexCache[1];
 	dAssert(m_separationDistance < ndFloat32(100.0f));
 	m_contact->m_separationDistance = m_separationDistance;
 	return count;
@@ -2334,7 +2589,20 @@ ndInt32 ndContactSolver::ConvexContactsDiscrete()
 	if (m_instance1.GetShape()->GetAsShapeConvex())
 	{
 		dAssert(m_instance0.GetShape()->GetAsShapeConvex());
-		count = ConvexToConvexContactsDiscrete();
+		count = -1;
+		const ndPrimitiveType type0 = GetPrimitiveType(m_instance0);
+		if (type0 != m_notPrimitive)
+		{
+			const ndPrimitiveType type1 = GetPrimitiveType(m_instance1);
+			if (type1 != m_notPrimitive)
+			{
+				count = PrimitiveToPrimitiveContactsDiscrete(type0, type1);
+			}
+		}
+		if (count < 0)
+		{
+			count = ConvexToConvexContactsDiscrete();
+		}
 	}
 	else
 	{
@@ -2390,7 +2658,9 @@ ndInt32 ndContactSolver::ConvexToConvexContactsDiscrete()
 	}
 	else if (colliding)
 	{
-		if (penetration <= ndFloat32(1.0e-5f))
+		// speculative contacts are generated for shapes that are 
+		// separated by less than the distance they can close in one step.
+		if (penetration <= (m_speculativeDistance + ndFloat32(1.0e-5f)))
 		{
 			if (m_instance0.GetCollisionMode() & m_instance1.GetCollisionMode())
 			{
@@ -2423,6 +2693,356 @@ ndInt32 ndContactSolver::ConvexToConvexContactsDiscrete()
 	return count;
 }
 
+ndContactSolver::ndPrimitiveType ndContactSolver::GetPrimitiveType(const ndShapeInstance& instance) const
+{
+	if (instance.GetScaleType() > ndShapeInstance::m_uniform)
+	{
+		return m_notPrimitive;
+	}
+
+	ndShape* const shape = (ndShape*)instance.GetShape();
+	if (shape->GetAsShapeSphere())
+	{
+		return m_spherePrimitive;
+	}
+	if (shape->GetAsShapeBox())
+	{
+		return m_boxPrimitive;
+	}
+	const ndShapeCapsule* const capsule = shape->GetAsShapeCapsule();
+	if (capsule && (capsule->m_radius0 == capsule->m_radius1))
+	{
+		return m_capsulePrimitive;
+	}
+	return m_notPrimitive;
+}
+
+void ndContactSolver::GetPrimitiveSegment(const ndShapeInstance& instance, ndVector& p0, ndVector& p1, ndFloat32& radius) const
+{
+	// a sphere is a capsule of zero length, the capsule axis is the shape x axis.
+	// the radius is reduced by the penetration tolerance the same way the support 
+	// functions of the rounded shapes do, so the contacts rest at the same depth.
+	const ndMatrix& matrix = instance.m_globalMatrix;
+	const ndFloat32 scale = instance.GetScale().m_x;
+	ndShape* const shape = (ndShape*)instance.GetShape();
+	const ndShapeSphere* const sphere = shape->GetAsShapeSphere();
+	if (sphere)
+	{
+		p0 = matrix.m_posit;
+		p1 = matrix.m_posit;
+		radius = sphere->m_radius * scale - D_PENETRATION_TOL;
+	}
+	else
+	{
+		const ndShapeCapsule* const capsule = shape->GetAsShapeCapsule();
+		dAssert(capsule);
+		const ndVector height(matrix.m_front.Scale(capsule->m_height * scale));
+		p0 = matrix.m_posit - height;
+		p1 = matrix.m_posit + height;
+		radius = capsule->m_radius0 * scale - D_PENETRATION_TOL;
+	}
+}
+
+ndInt32 ndContactSolver::SegmentToSegmentContacts()
+{
+	ndVector p0;
+	ndVector p1;
+	ndVector q0;
+	ndVector q1;
+	ndFloat32 radius0;
+	ndFloat32 radius1;
+	GetPrimitiveSegment(m_instance0, p0, p1, radius0);
+	GetPrimitiveSegment(m_instance1, q0, q1, radius1);
+
+	// closest points of two segments, Christer Ericson "Real-Time Collision Detection" 5.1.9
+	const ndFloat32 tol = ndFloat32(1.0e-10f);
+	const ndVector segment0(p1 - p0);
+	const ndVector segment1(q1 - q0);
+	const ndVector diff(p0 - q0);
+	const ndFloat32 a = segment0.DotProduct(segment0).GetScalar();
+	const ndFloat32 e = segment1.DotProduct(segment1).GetScalar();
+	const ndFloat32 f = segment1.DotProduct(diff).GetScalar();
+
+	ndFloat32 s = ndFloat32(0.0f);
+	ndFloat32 t = ndFloat32(0.0f);
+	ndFloat32 overlap0 = ndFloat32(0.0f);
+	ndFloat32 overlap1 = ndFloat32(0.0f);
+	if ((a > tol) && (e > tol))
+	{
+		const ndFloat32 b = segment0.DotProduct(segment1).GetScalar();
+		const ndFloat32 c = segment0.DotProduct(diff).GetScalar();
+		const ndFloat32 den = a * e - b * b;
+		if (den > ndFloat32(1.0e-4f) * a * e)
+		{
+			s = dClamp((b * f - c * e) / den, ndFloat32(0.0f), ndFloat32(1.0f));
+		}
+		else
+		{
+			// parallel capsules, get the span where the two segments overlap
+			const ndFloat32 u0 = -c / a;
+			const ndFloat32 u1 = (b - c) / a;
+			overlap0 = dClamp(dMin(u0, u1), ndFloat32(0.0f), ndFloat32(1.0f));
+			overlap1 = dClamp(dMax(u0, u1), ndFloat32(0.0f), ndFloat32(1.0f));
+			s = (overlap0 + overlap1) * ndFloat32(0.5f);
+		}
+		t = (b * s + f) / e;
+		if (t < ndFloat32(0.0f))
+		{
+			t = ndFloat32(0.0f);
+			s = dClamp(-c / a, ndFloat32(0.0f), ndFloat32(1.0f));
+		}
+		else if (t > ndFloat32(1.0f))
+		{
+			t = ndFloat32(1.0f);
+			s = dClamp((b - c) / a, ndFloat32(0.0f), ndFloat32(1.0f));
+		}
+	}
+	else if (a > tol)
+	{
+		s = dClamp(-segment0.DotProduct(diff).GetScalar() / a, ndFloat32(0.0f), ndFloat32(1.0f));
+	}
+	else if (e > tol)
+	{
+		t = dClamp(f / e, ndFloat32(0.0f), ndFloat32(1.0f));
+	}
+
+	const ndVector closest0(p0 + segment0.Scale(s));
+	const ndVector closest1(q0 + segment1.Scale(t));
+	const ndVector step(closest1 - closest0);
+	const ndFloat32 dist2 = step.DotProduct(step).GetScalar();
+	if (dist2 < ndFloat32(1.0e-12f))
+	{
+		// the axis cross, there is not a unique direction
+		return 0;
+	}
+
+	const ndFloat32 dist = ndSqrt(dist2);
+	const ndVector normal(step.Scale(ndFloat32(1.0f) / dist));
+	m_separatingVector = normal;
+	m_closestPoint0 = closest0 + normal.Scale(radius0);
+	m_closestPoint1 = closest1 - normal.Scale(radius1);
+
+	if ((overlap1 - overlap0) * ndSqrt(a) > D_PENETRATION_TOL)
+	{
+		// the contact plane is half way between the two surfaces
+		const ndVector offset(normal.Scale(radius0 + (dist - radius0 - radius1) * ndFloat32(0.5f)));
+		m_buffer[0] = p0 + segment0.Scale(overlap0) + offset;
+		m_buffer[1] = p0 + segment0.Scale(overlap1) + offset;
+		return 2;
+	}
+
+	m_buffer[0] = (m_closestPoint0 + m_closestPoint1).Scale(ndFloat32(0.5f));
+	return 1;
+}
+
+ndInt32 ndContactSolver::BoxToSphereContacts(bool boxIsInstance0)
+{
+	const ndShapeInstance& boxInstance = boxIsInstance0 ? m_instance0 : m_instance1;
+	const ndShapeInstance& sphereInstance = boxIsInstance0 ? m_instance1 : m_instance0;
+	const ndShapeBox* const box = ((ndShape*)boxInstance.GetShape())->GetAsShapeBox();
+	const ndShapeSphere* const sphere = ((ndShape*)sphereInstance.GetShape())->GetAsShapeSphere();
+	dAssert(box && sphere);
+
+	const ndMatrix& matrix = boxInstance.m_globalMatrix;
+	const ndVector size(box->m_size[0].Scale(boxInstance.GetScale().m_x));
+	const ndFloat32 radius = sphere->m_radius * sphereInstance.GetScale().m_x - D_PENETRATION_TOL;
+	const ndVector center(sphereInstance.m_globalMatrix.m_posit);
+
+	// closest point on the box to the sphere center in box space
+	const ndVector localCenter(matrix.UntransformVector(center) & ndVector::m_triplexMask);
+	ndVector boxPoint(localCenter.GetMax(size * ndVector::m_negOne).GetMin(size));
+	ndVector localNormal(localCenter - boxPoint);
+	const ndFloat32 dist2 = localNormal.DotProduct(localNormal).GetScalar();
+	if (dist2 > ndFloat32(1.0e-12f))
+	{
+		localNormal = localNormal.Scale(ndRsqrt(dist2));
+	}
+	else
+	{
+		// the center is inside the box, push it out through the closest face
+		ndInt32 index = 0;
+		ndFloat32 faceDist = size[0] - dAbs(localCenter[0]);
+		for (ndInt32 i = 1; i < 3; i++)
+		{
+			const ndFloat32 dist = size[i] - dAbs(localCenter[i]);
+			if (dist < faceDist)
+			{
+				index = i;
+				faceDist = dist;
+			}
+		}
+		localNormal = ndVector::m_zero;
+		localNormal[index] = (localCenter[index] >= ndFloat32(0.0f)) ? ndFloat32(1.0f) : ndFloat32(-1.0f);
+		boxPoint[index] = localNormal[index] * size[index];
+	}
+
+	const ndVector normal(matrix.RotateVector(localNormal));
+	const ndVector pointOnBox(matrix.TransformVector(boxPoint));
+	const ndVector pointOnSphere(center - normal.Scale(radius));
+	if (boxIsInstance0)
+	{
+		m_separatingVector = normal;
+		m_closestPoint0 = pointOnBox;
+		m_closestPoint1 = pointOnSphere;
+	}
+	else
+	{
+		m_separatingVector = normal * ndVector::m_negOne;
+		m_closestPoint0 = pointOnSphere;
+		m_closestPoint1 = pointOnBox;
+	}
+	m_buffer[0] = (pointOnBox + pointOnSphere).Scale(ndFloat32(0.5f));
+	return 1;
+}
+
+void ndContactSolver::BoxToBoxSeparatingAxis()
+{
+	const ndShapeBox* const box0 = m_instance0.GetShape()->GetAsShapeBox();
+	const ndShapeBox* const box1 = m_instance1.GetShape()->GetAsShapeBox();
+	dAssert(box0 && box1);
+
+	const ndMatrix& matrix0 = m_instance0.m_globalMatrix;
+	const ndMatrix& matrix1 = m_instance1.m_globalMatrix;
+	const ndVector size0(box0->m_size[0].Scale(m_instance0.GetScale().m_x));
+	const ndVector size1(box1->m_size[0].Scale(m_instance1.GetScale().m_x));
+	const ndVector step(matrix1.m_posit - matrix0.m_posit);
+
+	ndFloat32 absDot[3][3];
+	for (ndInt32 i = 0; i < 3; i++)
+	{
+		for (ndInt32 j = 0; j < 3; j++)
+		{
+			absDot[i][j] = dAbs(matrix0[i].DotProduct(matrix1[j]).GetScalar()) + ndFloat32(1.0e-6f);
+		}
+	}
+
+	// separating axis test over the 15 box axis, the face axis
+	// are preferred, they produce the more stable manifolds
+	ndVector axis(matrix0[0]);
+	ndFloat32 separation = ndFloat32(-1.0e10f);
+	for (ndInt32 i = 0; i < 3; i++)
+	{
+		const ndFloat32 dist = step.DotProduct(matrix0[i]).GetScalar();
+		const ndFloat32 radius = size0[i] + size1[0] * absDot[i][0] + size1[1] * absDot[i][1] + size1[2] * absDot[i][2];
+		if ((dAbs(dist) - radius) > separation)
+		{
+			separation = dAbs(dist) - radius;
+			axis = (dist >= ndFloat32(0.0f)) ? matrix0[i] : matrix0[i] * ndVector::m_negOne;
+		}
+	}
+
+	for (ndInt32 i = 0; i < 3; i++)
+	{
+		const ndFloat32 dist = step.DotProduct(matrix1[i]).GetScalar();
+		const ndFloat32 radius = size0[0] * absDot[0][i] + size0[1] * absDot[1][i] + size0[2] * absDot[2][i] + size1[i];
+		if ((dAbs(dist) - radius) > separation)
+		{
+			separation = dAbs(dist) - radius;
+			axis = (dist >= ndFloat32(0.0f)) ? matrix1[i] : matrix1[i] * ndVector::m_negOne;
+		}
+	}
+
+	for (ndInt32 i = 0; i < 3; i++)
+	{
+		for (ndInt32 j = 0; j < 3; j++)
+		{
+			ndVector edgeAxis(matrix0[i].CrossProduct(matrix1[j]));
+			const ndFloat32 mag2 = edgeAxis.DotProduct(edgeAxis).GetScalar();
+			if (mag2 > ndFloat32(1.0e-6f))
+			{
+				edgeAxis = edgeAxis.Scale(ndRsqrt(mag2));
+				const ndVector dir0(matrix0.UnrotateVector(edgeAxis).Abs());
+				const ndVector dir1(matrix1.UnrotateVector(edgeAxis).Abs());
+				const ndFloat32 radius = size0.DotProduct(dir0).GetScalar() + size1.DotProduct(dir1).GetScalar();
+				const ndFloat32 dist = step.DotProduct(edgeAxis).GetScalar();
+				if ((dAbs(dist) - radius) > (separation + D_PENETRATION_TOL))
+				{
+					separation = dAbs(dist) - radius;
+					axis = (dist >= ndFloat32(0.0f)) ? edgeAxis : edgeAxis * ndVector::m_negOne;
+				}
+			}
+		}
+	}
+
+	// the support points of the two boxes along the separating axis
+	const ndVector dir0(matrix0.UnrotateVector(axis));
+	const ndVector dir1(matrix1.UnrotateVector(axis));
+	const ndVector support0(size0 * ndVector::m_one.Select(ndVector::m_negOne, dir0 < ndVector::m_zero));
+	const ndVector support1(size1 * ndVector::m_negOne.Select(ndVector::m_one, dir1 < ndVector::m_zero));
+
+	m_separatingVector = axis & ndVector::m_triplexMask;
+	m_closestPoint0 = matrix0.TransformVector(support0);
+	m_closestPoint1 = matrix1.TransformVector(support1);
+}
+
+ndInt32 ndContactSolver::PrimitiveToPrimitiveContactsDiscrete(ndPrimitiveType type0, ndPrimitiveType type1)
+{
+	// returns -1 if the pair does not have a closed form solution
+	ndInt32 pointCount = 0;
+	if ((type0 == m_boxPrimitive) && (type1 == m_boxPrimitive))
+	{
+		// the manifold of the separating axis is made by clipping the box faces
+		BoxToBoxSeparatingAxis();
+	}
+	else if ((type0 == m_boxPrimitive) || (type1 == m_boxPrimitive))
+	{
+		if ((type0 == m_capsulePrimitive) || (type1 == m_capsulePrimitive))
+		{
+			return -1;
+		}
+		pointCount = BoxToSphereContacts(type0 == m_boxPrimitive);
+	}
+	else
+	{
+		pointCount = SegmentToSegmentContacts();
+		if (!pointCount)
+		{
+			return -1;
+		}
+	}
+
+	ndInt32 count = 0;
+	ndFloat32 penetration = m_separatingVector.DotProduct(m_closestPoint1 - m_closestPoint0).GetScalar() - m_skinThickness - D_PENETRATION_TOL;
+	m_separationDistance = penetration;
+	if (m_intersectionTestOnly)
+	{
+		count = (penetration <= ndFloat32(0.0f)) ? 1 : 0;
+	}
+	else
+	{
+		if (penetration <= (m_speculativeDistance + ndFloat32(1.0e-5f)))
+		{
+			if (m_instance0.GetCollisionMode() & m_instance1.GetCollisionMode())
+			{
+				count = pointCount ? pointCount : CalculateContacts(m_closestPoint0, m_closestPoint1, m_separatingVector * ndVector::m_negOne);
+			}
+		}
+
+		count = dMin(m_maxCount, count);
+		ndContactPoint* const contactOut = m_contactBuffer;
+
+		ndBodyKinematic* const body0 = m_contact->GetBody0();
+		ndBodyKinematic* const body1 = m_contact->GetBody1();
+		ndShapeInstance* const instance0 = &body0->GetCollisionShape();
+		ndShapeInstance* const instance1 = &body1->GetCollisionShape();
+
+		ndVector normal(m_separatingVector * ndVector::m_negOne);
+		for (ndInt32 i = count - 1; i >= 0; i--)
+		{
+			contactOut[i].m_point = m_buffer[i];
+			contactOut[i].m_normal = normal;
+			contactOut[i].m_body0 = body0;
+			contactOut[i].m_body1 = body1;
+			contactOut[i].m_shapeInstance0 = instance0;
+			contactOut[i].m_shapeInstance1 = instance1;
+			contactOut[i].m_penetration = -penetration;
+		}
+	}
+
+	dAssert(m_separationDistance < ndFloat32(1.0e6f));
+	return count;
+}
+
 ndInt32 ndContactSolver::CompoundContactsDiscrete()
 {
 	if (!m_instance1.GetShape()->GetAsShapeCompound())
@@ -2727,31 +3347,43 @@ ndInt32 ndContactSolver::CompoundToCompoundContactsDiscrete()
 	dAssert(compoundShape0);
 	dAssert(compoundShape1);
 
-	ndInt32 stack = 1;
-	ndInt32 contactCount = 0;
-	ndStackEntry stackPool[2 * D_COMPOUND_STACK_DEPTH];
-
-	stackPool[0].m_node0 = compoundShape0->m_root;
-	stackPool[0].m_node1 = compoundShape1->m_root;
-	stackPool[0].m_dist2 = data.CalculateDistance2(compoundShape0->m_root->m_origin, compoundShape0->m_root->m_size, compoundShape1->m_root->m_origin, compoundShape1->m_root->m_size);
+	const ndShapeCompound::ndNodeBase* const root0 = compoundShape0->m_root;
+	const ndShapeCompound::ndNodeBase* const root1 = compoundShape1->m_root;
+	const ndFloat32 rootDist2 = data.CalculateDistance2(root0->m_origin, root0->m_size, root1->m_origin, root1->m_size);
+	if (rootDist2 > ndFloat32(0.0f))
+	{
+		m_separationDistance = ndSqrt(rootDist2);
+		return 0;
+	}
 
-	ndFloat32 closestDist = (stackPool[0].m_dist2 > ndFloat32(0.0f)) ? stackPool[0].m_dist2 : ndFloat32(1.0e10f);
+	ndContactChildCache localCache;
+	ndContactChildCache* const cache = GetChildCache(localCache);
+	const ndMatrix matrix(matrix0 * matrix1.Inverse());
+	const ndFloat32 radius = CalculateChildCacheRadius(root0);
+	if (!ValidateChildCache(*cache, &m_instance0, compoundShape0->m_revision, &m_instance1, compoundShape1->m_revision, matrix, radius))
+	{
+		ResetChildCache(*cache, &m_instance0, compoundShape0->m_revision, &m_instance1, compoundShape1->m_revision, matrix, radius, compoundBody0, compoundBody1, m_timestep);
+		CollectCompoundChildPairs(data, *cache, root0, root1);
+	}
 
-	while (stack)
+	// the pairs are visited in key order, so the contacts do not 
+	// depend on whether the cache was reused or just rebuilt.
+	ndInt32 contactCount = 0;
+	ndFloat32 closestDist = D_CHILD_CACHE_SEPARATION * D_CHILD_CACHE_SEPARATION;
+	for (ndInt32 k = 0; k < cache->m_pairs.GetCount(); ++k)
 	{
-		stack--;
-		ndFloat32 dist2 = stackPool[stack].m_dist2;
+		const ndContactChildCache::ndPair& pair = cache->m_pairs[k];
+		const ndShapeCompound::ndNodeBase* const node0 = (ndShapeCompound::ndNodeBase*)pair.m_node0;
+		const ndShapeCompound::ndNodeBase* const node1 = (ndShapeCompound::ndNodeBase*)pair.m_node1;
+		dAssert(node0->m_type == ndShapeCompound::m_leaf);
+		dAssert(node1->m_type == ndShapeCompound::m_leaf);
+
+		const ndFloat32 dist2 = data.CalculateDistance2(node0->m_origin, node0->m_size, node1->m_origin, node1->m_size);
 		if (dist2 > ndFloat32(0.0f))
 		{
 			closestDist = dMin(closestDist, dist2);
-			break;
 		}
-
-		const ndShapeCompound::ndNodeBase* const node0 = stackPool[stack].m_node0;
-		const ndShapeCompound::ndNodeBase* const node1 = stackPool[stack].m_node1;
-		dAssert(node0 && node1);
-
-		if ((node0->m_type == ndShapeCompound::m_leaf) && (node1->m_type == ndShapeCompound::m_leaf))
+		else
 		{
 			ndShapeInstance* const subShape0 = node0->GetShape();
 			ndShapeInstance* const subShape1 = node1->GetShape();
@@ -2790,64 +3422,6 @@ ndInt32 ndContactSolver::CompoundToCompoundContactsDiscrete()
 				}
 			}
 		}
-		else if (node0->m_type == ndShapeCompound::m_leaf)
-		{
-			dAssert(node1->m_type == ndShapeCompound::m_node);
-			{
-				const ndShapeCompound::ndNodeBase* const subNode0 = node0;
-				const ndShapeCompound::ndNodeBase* const subNode1 = node1->m_left;
-				PushStackEntry(data, stack, stackPool, subNode0, subNode1);
-			}
-
-			{
-				const ndShapeCompound::ndNodeBase* const subNode0 = node0;
-				const ndShapeCompound::ndNodeBase* const subNode1 = node1->m_right;
-				PushStackEntry(data, stack, stackPool, subNode0, subNode1);
-			}
-		}
-		else if (node1->m_type == ndShapeCompound::m_leaf)
-		{
-			dAssert(node0->m_type == ndShapeCompound::m_node);
-			{
-				const ndShapeCompound::ndNodeBase* const subNode0 = node0->m_left;
-				const ndShapeCompound::ndNodeBase* const subNode1 = node1;
-				PushStackEntry(data, stack, stackPool, subNode0, subNode1);
-			}
-
-			{
-				const ndShapeCompound::ndNodeBase* const subNode0 = node0->m_right;
-				const ndShapeCompound::ndNodeBase* const subNode1 = node1;
-				PushStackEntry(data, stack, stackPool, subNode0, subNode1);
-			}
-		}
-		else
-		{
-			dAssert(node0->m_type == ndShapeCompound::m_node);
-			dAssert(node1->m_type == ndShapeCompound::m_node);
-			{
-				const ndShapeCompound::ndNodeBase* const subNode0 = node0->m_left;
-				const ndShapeCompound::ndNodeBase* const subNode1 = node1->m_left;
-				PushStackEntry(data, stack, stackPool, subNode0, subNode1);
-			}
-
-			{
-				const ndShapeCompound::ndNodeBase* const subNode0 = node0->m_left;
-				const ndShapeCompound::ndNodeBase* const subNode1 = node1->m_right;
-				PushStackEntry(data, stack, stackPool, subNode0, subNode1);
-			}
-
-			{
-				const ndShapeCompound::ndNodeBase* const subNode0 = node0->m_right;
-				const ndShapeCompound::ndNodeBase* const subNode1 = node1->m_left;
-				PushStackEntry(data, stack, stackPool, subNode0, subNode1);
-			}
-
-			{
-				const ndShapeCompound::ndNodeBase* const subNode0 = node0->m_right;
-				const ndShapeCompound::ndNodeBase* const subNode1 = node1->m_right;
-				PushStackEntry(data, stack, stackPool, subNode0, subNode1);
-			}
-		}
 	}
 
 	if (m_pruneContacts && (contactCount > 1))
@@ -2996,7 +3570,7 @@ ndInt32 ndContactSolver::ConvexToStaticMeshContactsDiscrete()
 	return count;
 }
 
-ndInt32 ndContactSolver::ConvexToSaticStaticBvhContactsNodeDescrete(const ndAabbPolygonSoup::ndNode* const node)
+ndInt32 ndContactSolver::ConvexToSaticStaticBvhContactsNodeDescrete(const ndAabbPolygonSoup::ndNode* const node, const ndVector& nodeP0, const ndVector& nodeP1)
 {
 	ndVector origin0(m_instance0.m_globalMatrix.m_posit);
 	ndVector origin1(m_instance1.m_globalMatrix.m_posit);
@@ -3019,7 +3593,7 @@ ndInt32 ndContactSolver::ConvexToSaticStaticBvhContactsNodeDescrete(const ndAabb
 	data.m_faceIndexStart = data.m_meshData.m_globalFaceIndexStart;
 	data.m_faceVertexIndex = data.m_globalFaceVertexIndex;
 	data.m_hitDistance = data.m_meshData.m_globalHitDistance;
-	polysoup->ForThisSector(node, data, data.m_boxDistanceTravelInMeshSpace, data.m_maxT, polysoup->GetPolygon, &data);
+	polysoup->ForThisSector(node, nodeP0, nodeP1, data, data.m_boxDistanceTravelInMeshSpace, data.m_maxT, polysoup->GetPolygon, &data);
 
 	ndInt32 count = 0;
 	if (data.m_faceCount)
@@ -3086,39 +3660,49 @@ ndInt32 ndContactSolver::CompoundToShapeStaticBvhContactsDiscrete()
 
 	ndVector bvhp0;
 	ndVector bvhp1;
-	bvhTreeCollision->GetNodeAabb(bvhTreeCollision->GetRootNode(), bvhp0, bvhp1);
+	bvhTreeCollision->GetAABB(bvhp0, bvhp1);
 	const ndVector bvhSize((bvhp1 - bvhp0) * ndVector::m_half);
 	const ndVector bvhOrigin((bvhp1 + bvhp0) * ndVector::m_half);
 	const ndVector treeScale(bvhTreeInstance->GetScale());
 
-	ndInt32 stack = 1;
-	ndInt32 contactCount = 0;
-	ndStackBvhStackEntry stackPool[2 * D_COMPOUND_STACK_DEPTH];
-
-	stackPool[0].m_treeNodeIsLeaf = 0;
-	stackPool[0].m_compoundNode = compoundShape->m_root;
-	stackPool[0].m_collisionTreeNode = bvhTreeCollision->GetRootNode();
-	stackPool[0].m_dist2 = data.CalculateDistance2(compoundShape->m_root->m_origin, compoundShape->m_root->m_size, bvhOrigin, bvhSize);
+	const ndShapeCompound::ndNodeBase* const root = compoundShape->m_root;
+	const ndFloat32 rootDist2 = data.CalculateDistance2(root->m_origin, root->m_size, bvhOrigin, bvhSize);
+	if (rootDist2 > ndFloat32(0.0f))
+	{
+		// this path reports the square of the separation
+		m_separationDistance = rootDist2;
+		return 0;
+	}
 
-	ndFloat32 closestDist = (stackPool[0].m_dist2 > ndFloat32(0.0f)) ? stackPool[0].m_dist2 : ndFloat32(1.0e10f);
-	while (stack)
+	ndContactChildCache localCache;
+	ndContactChildCache* const cache = GetChildCache(localCache);
+	const ndMatrix matrix(compoundMatrix * treeMatrix.Inverse());
+	const ndFloat32 radius = CalculateChildCacheRadius(root);
+	if (!ValidateChildCache(*cache, &m_instance0, compoundShape->m_revision, &m_instance1, 0, matrix, radius))
 	{
-		stack--;
+		ResetChildCache(*cache, &m_instance0, compoundShape->m_revision, &m_instance1, 0, matrix, radius, compoundBody, bvhTreeBody, m_timestep);
+		CollectStaticBvhChildPairs(data, *cache, root, bvhTreeCollision, treeScale);
+	}
 
-		ndFloat32 dist2 = stackPool[stack].m_dist2;
+	// the pairs are visited in key order, so the contacts do not 
+	// depend on whether the cache was reused or just rebuilt.
+	ndInt32 contactCount = 0;
+	ndFloat32 closestDist = D_CHILD_CACHE_SEPARATION * D_CHILD_CACHE_SEPARATION;
+	for (ndInt32 k = 0; k < cache->m_pairs.GetCount(); ++k)
+	{
+		const ndContactChildCache::ndPair& pair = cache->m_pairs[k];
+		const ndShapeCompound::ndNodeBase* const compoundNode = (ndShapeCompound::ndNodeBase*)pair.m_node0;
+		const ndAabbPolygonSoup::ndNode* const collisionTreeNode = (ndAabbPolygonSoup::ndNode*)pair.m_node1;
+		const ndVector treeSize((pair.m_p1 - pair.m_p0) * ndVector::m_half);
+		const ndVector treeOrigin((pair.m_p1 + pair.m_p0) * ndVector::m_half);
+		dAssert(compoundNode->m_type == ndShapeCompound::m_leaf);
+
+		const ndFloat32 dist2 = data.CalculateDistance2(compoundNode->m_origin, compoundNode->m_size, treeOrigin, treeSize);
 		if (dist2 > ndFloat32(0.0f))
 		{
 			closestDist = dMin(closestDist, dist2);
-			break;
 		}
-
-		const ndShapeCompound::ndNodeBase* const compoundNode = stackPool[stack].m_compoundNode;
-		const ndAabbPolygonSoup::ndNode* const collisionTreeNode = stackPool[stack].m_collisionTreeNode;
-		const ndInt32 treeNodeIsLeaf = stackPool[stack].m_treeNodeIsLeaf;
-
-		dAssert(compoundNode && collisionTreeNode);
-
-		if (treeNodeIsLeaf && (compoundNode->m_type == ndShapeCompound::m_leaf))
+		else
 		{
 			ndShapeInstance* const subShape = compoundNode->GetShape();
 			if (subShape->GetCollisionMode())
@@ -3134,7 +3718,7 @@ ndInt32 ndContactSolver::CompoundToShapeStaticBvhContactsDiscrete()
 					contactSolver.m_maxCount = D_MAX_CONTATCS - contactCount;
 					contactSolver.m_contactBuffer += contactCount;
 
-					ndInt32 count = contactSolver.ConvexToSaticStaticBvhContactsNodeDescrete(collisionTreeNode);
+					ndInt32 count = contactSolver.ConvexToSaticStaticBvhContactsNodeDescrete(collisionTreeNode, pair.m_p0, pair.m_p1);
 					ndFloat32 dist = dMax(contactSolver.m_separationDistance, ndFloat32(0.0f));
 					closestDist = dMin(closestDist, dist * dist);
 					if (!m_intersectionTestOnly)
@@ -3152,86 +3736,6 @@ ndInt32 ndContactSolver::CompoundToShapeStaticBvhContactsDiscrete()
 				}
 			}
 		}
-		else if (compoundNode->m_type == ndShapeCompound::m_leaf)
-		{
-			dAssert(!treeNodeIsLeaf);
-			const ndAabbPolygonSoup::ndNode* const backNode = bvhTreeCollision->GetBackNode(collisionTreeNode);
-			const ndAabbPolygonSoup::ndNode* const frontNode = bvhTreeCollision->GetFrontNode(collisionTreeNode);
-
-			if (backNode && frontNode)
-			{
-				PushStackEntry(data, stack, stackPool, compoundNode, bvhTreeCollision, 0, backNode);
-				PushStackEntry(data, stack, stackPool, compoundNode, bvhTreeCollision, 0, frontNode);
-			}
-			else if (backNode && !frontNode)
-			{
-				PushStackEntry(data, stack, stackPool, compoundNode, bvhTreeCollision, 0, backNode);
-				PushStackEntry(data, stack, stackPool, compoundNode, bvhTreeCollision, 1, collisionTreeNode);
-			}
-			else if (!backNode && frontNode)
-			{
-				PushStackEntry(data, stack, stackPool, compoundNode, bvhTreeCollision, 0, frontNode);
-				PushStackEntry(data, stack, stackPool, compoundNode, bvhTreeCollision, 1, collisionTreeNode);
-			}
-			else
-			{
-				PushStackEntry(data, stack, stackPool, compoundNode, bvhTreeCollision, 1, collisionTreeNode);
-			}
-		}
-		else if (treeNodeIsLeaf)
-		{
-			dAssert(compoundNode->m_type == ndShapeCompound::m_node);
-			PushStackEntry(data, stack, stackPool, compoundNode->m_left, bvhTreeCollision, 1, collisionTreeNode);
-			PushStackEntry(data, stack, stackPool, compoundNode->m_right, bvhTreeCollision, 1, collisionTreeNode);
-		}
-		else
-		{
-			dAssert(compoundNode->m_type == ndShapeCompound::m_node);
-			dAssert(!treeNodeIsLeaf);
-
-			ndVector p0;
-			ndVector p1;
-			bvhTreeCollision->GetNodeAabb(collisionTreeNode, p0, p1);
-			p0 = p0 * treeScale;
-			p1 = p1 * treeScale;
-			ndVector size((p1 - p0) * ndVector::m_half);
-			ndFloat32 area = size.DotProduct(size.ShiftTripleRight()).GetScalar();
-
-			if (area > compoundNode->m_area)
-			{
-				const ndAabbPolygonSoup::ndNode* const backNode = bvhTreeCollision->GetBackNode(collisionTreeNode);
-				const ndAabbPolygonSoup::ndNode* const frontNode = bvhTreeCollision->GetFrontNode(collisionTreeNode);
-				if (backNode && frontNode)
-				{
-					PushStackEntry(data, stack, stackPool, compoundNode, bvhTreeCollision, 0, backNode);
-					PushStackEntry(data, stack, stackPool, compoundNode, bvhTreeCollision, 0, frontNode);
-				}
-				else if (backNode && !frontNode)
-				{
-					PushStackEntry(data, stack, stackPool, compoundNode, bvhTreeCollision, 0, backNode);
-					PushStackEntry(data, stack, stackPool, compoundNode->m_left, bvhTreeCollision, 1, collisionTreeNode);
-					PushStackEntry(data, stack, stackPool, compoundNode->m_right, bvhTreeCollision, 1, collisionTreeNode);
-				}
-				else if (!backNode && frontNode)
-				{
-					PushStackEntry(data, stack, stackPool, compoundNode, bvhTreeCollision, 0, frontNode);
-					PushStackEntry(data, stack, stackPool, compoundNode->m_left, bvhTreeCollision, 1, collisionTreeNode);
-					PushStackEntry(data, stack, stackPool, compoundNode->m_right, bvhTreeCollision, 1, collisionTreeNode);
-				}
-				else
-				{
-					PushStackEntry(data, stack, stackPool, compoundNode, bvhTreeCollision, 1, collisionTreeNode);
-				}
-			}
-			else
-			{
-				dAssert(!treeNodeIsLeaf);
-				dAssert(compoundNode->m_left);
-				dAssert(compoundNode->m_right);
-				PushStackEntry(data, stack, stackPool, compoundNode->m_left, bvhTreeCollision, 0, collisionTreeNode);
-				PushStackEntry(data, stack, stackPool, compoundNode->m_right, bvhTreeCollision, 0, collisionTreeNode);
-			}
-		}
 	}
 
 	if (m_pruneContacts && (contactCount > 1))
@@ -3244,6 +3748,24 @@ ndInt32 ndContactSolver::CompoundToShapeStaticBvhContactsDiscrete()
 	return contactCount;
 }
 
+ndContactChildCache* ndContactSolver::GetChildCache(ndContactChildCache& localCache) const
+{
+	// only the top level shapes of a contact keep their pairs across 
+	// steps, nested solvers use a cache that lives for this call.
+	ndContact* const contactJoint = m_contact;
+	const ndShape* const shape0 = contactJoint->GetBody0()->GetCollisionShape().GetShape();
+	const ndShape* const shape1 = contactJoint->GetBody1()->GetCollisionShape().GetShape();
+	if ((m_instance0.GetShape() != shape0) || (m_instance1.GetShape() != shape1))
+	{
+		return &localCache;
+	}
+	if (!contactJoint->m_childCache)
+	{
+		contactJoint->m_childCache = new ndContactChildCache();
+	}
+	return contactJoint->m_childCache;
+}
+
 ndInt32 ndContactSolver::CompoundToStaticHeightfieldContactsDiscrete()
 {
 	ndContact* const contactJoint = m_contact;
@@ -3392,6 +3914,8 @@ ndInt32 ndContactSolver::CalculateContactsContinue()
 
 	m_contact->m_timeOfImpact = m_timestep;
 	m_contact->m_separatingVector = m_separatingVector;
+	m_contact->m_supportVertexCache[0] = m_supportVertexCache[0];
+	m_contact->m_supportVertexCache[1] = m_supportVertexCache[1];
 	m_contact->m_separationDistance = m_separationDistance;
 	return count;
 }
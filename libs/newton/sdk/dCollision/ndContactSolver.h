@@ -53,6 +53,7 @@ class ndMinkFace
 #define D_MINK_VERTEX_ERR2				(D_MINK_VERTEX_ERR * D_MINK_VERTEX_ERR)
 
 class ndContact;
+class ndContactChildCache;
 class dCollisionParamProxy;
 
 D_MSV_NEWTON_ALIGN_32
@@ -81,7 +82,23 @@ class ndContactSolver: public ndDownHeap<ndMinkFace *, ndFloat32>
 	ndInt32 CompoundToShapeStaticBvhContactsDiscrete(); // done
 	ndInt32 CompoundToStaticHeightfieldContactsDiscrete(); // done
 	ndInt32 CalculatePolySoupToHullContactsDescrete(ndPolygonMeshDesc& data); // done
-	ndInt32 ConvexToSaticStaticBvhContactsNodeDescrete(const ndAabbPolygonSoup::ndNode* const node); // done
+	ndInt32 ConvexToSaticStaticBvhContactsNodeDescrete(const ndAabbPolygonSoup::ndNode* const node, const ndVector& nodeP0, const ndVector& nodeP1); // done
+	ndContactChildCache* GetChildCache(ndContactChildCache& localCache) const;
+
+	// closed form contacts for pairs of spheres, capsules and boxes with unit or uniform scale
+	enum ndPrimitiveType
+	{
+		m_notPrimitive,
+		m_spherePrimitive,
+		m_capsulePrimitive,
+		m_boxPrimitive,
+	};
+	ndPrimitiveType GetPrimitiveType(const ndShapeInstance& instance) const;
+	ndInt32 PrimitiveToPrimitiveContactsDiscrete(ndPrimitiveType type0, ndPrimitiveType type1);
+	void GetPrimitiveSegment(const ndShapeInstance& instance, ndVector& p0, ndVector& p1, ndFloat32& radius) const;
+	ndInt32 SegmentToSegmentContacts();
+	ndInt32 BoxToSphereContacts(bool boxIsInstance0);
+	void BoxToBoxSeparatingAxis();
 
 	ndInt32 ConvexContactsContinue(); // done
 	ndInt32 CompoundContactsContinue(); // done
@@ -151,9 +168,11 @@ class ndContactSolver: public ndDownHeap<ndMinkFace *, ndFloat32>
 	ndFloat32 m_timestep;
 	ndFloat32 m_skinThickness;
 	ndFloat32 m_separationDistance;
+	ndFloat32 m_speculativeDistance;
 
 	ndInt32 m_maxCount;
 	ndInt32 m_vertexIndex;
+	ndInt32 m_supportVertexCache[2];
 	ndUnsigned32 m_pruneContacts			: 1;
 	ndUnsigned32 m_intersectionTestOnly	: 1;
 	
@@ -44,6 +44,32 @@ class ndIndexArray
 	ndInt32* m_indexList;
 };
 
+// decompositions made by ndMeshEffect::CreateConvexApproximation, keyed by the 
+// hash of the mesh and the parameters. Meshes with the same geometry get a copy 
+// of the cached compound, and all the copies share the same hull shapes.
+class ndConvexApproximationCache: public ndClassAlloc
+{
+	public:
+	D_COLLISION_API ndConvexApproximationCache();
+	D_COLLISION_API ~ndConvexApproximationCache();
+
+	D_COLLISION_API void Clear();
+	ndInt32 GetCount() const;
+
+	private:
+	ndShapeInstance* Find(ndUnsigned64 key) const;
+	void Add(ndUnsigned64 key, const ndShapeInstance& instance);
+
+	ndTree<ndShapeInstance*, ndUnsigned64> m_entries;
+	mutable ndSpinLock m_lock;
+	friend class ndMeshEffect;
+};
+
+inline ndInt32 ndConvexApproximationCache::GetCount() const
+{
+	return m_entries.GetCount();
+}
+
 class ndMeshEffect: public ndPolyhedra
 {
 #if 0
@@ -386,7 +412,7 @@ class ndMeshEffect: public ndPolyhedra
 	D_COLLISION_API ndMeshEffect(ndPolyhedra& mesh, const ndMeshEffect& source);
 	
 	// Create a convex hull Mesh from point cloud
-	D_COLLISION_API ndMeshEffect(const ndFloat64* const vertexCloud, ndInt32 count, ndInt32 strideInByte, ndFloat64 distTol);
+	D_COLLISION_API ndMeshEffect(const ndFloat64* const vertexCloud, ndInt32 count, ndInt32 strideInByte, ndFloat64 distTol, ndConvexHull3dScratch* const scratch = nullptr);
 
 	D_COLLISION_API virtual ~ndMeshEffect();
 
@@ -462,10 +488,22 @@ class ndMeshEffect: public ndPolyhedra
 	D_COLLISION_API void AddInterpolatedEdgeAttribute(ndEdge* const edge, ndFloat64 param);
 	D_COLLISION_API void RemoveUnusedVertices(ndInt32* const vertexRemapTable);
 	D_COLLISION_API ndInt32 PlaneClip(const ndMeshEffect& convexMesh, const ndEdge* const face);
-	D_COLLISION_API ndShapeInstance* CreateConvexCollision(ndFloat64 tolerance) const;
+	D_COLLISION_API ndShapeInstance* CreateConvexCollision(ndFloat64 tolerance, ndInt32 maxPointCount = 0x7fffffff) const;
+
+	// compound of convex hulls that approximates the solid. maxConcavity is the total volume 
+	// of the hulls outside the solid as a fraction of the solid volume, the mesh is cut until 
+	// it is below that or there are maxPieceCount pieces. The result is added to the cache 
+	// when one is given, and later calls with the same mesh and parameters return a copy.
+	D_COLLISION_API ndShapeInstance* CreateConvexApproximation(ndFloat32 maxConcavity, ndInt32 maxPieceCount, ndInt32 maxVertexPerHull = 64, ndInt32 threadCount = 1, ndConvexApproximationCache* const cache = nullptr) const;
+	D_COLLISION_API ndUnsigned64 CalculateHash() const;
 	D_COLLISION_API ndMeshEffect* ConvexMeshIntersection(const ndMeshEffect* const convexMesh) const;
 	D_COLLISION_API ndMeshEffect* InverseConvexMeshIntersection(const ndMeshEffect* const convexMesh) const;
-	D_COLLISION_API ndMeshEffect* CreateVoronoiConvexDecomposition(const ndArray<ndVector>& pointCloud, ndInt32 interiorMaterialIndex, const ndMatrix& textureProjectionMatrix);
+	D_COLLISION_API ndMeshEffect* CreateVoronoiConvexDecomposition(const ndArray<ndVector>& pointCloud, ndInt32 interiorMaterialIndex, const ndMatrix& textureProjectionMatrix, ndInt32 threadCount = 1);
+
+	// same cells as CreateVoronoiConvexDecomposition, clipped against this mesh and 
+	// carved by innerMesh if not null. The pieces are appended in cell order as 
+	// separate meshes, so there is no need to merge them and split the layers again.
+	D_COLLISION_API void CreateVoronoiConvexPieces(ndArray<ndMeshEffect*>& pieces, const ndArray<ndVector>& pointCloud, ndInt32 interiorMaterialIndex, const ndMatrix& textureProjectionMatrix, const ndMeshEffect* const innerMesh = nullptr, ndInt32 threadCount = 1) const;
 
 	protected:
 	D_COLLISION_API void Init();
@@ -482,6 +520,8 @@ class ndMeshEffect: public ndPolyhedra
 	ndInt32 AddInterpolatedHalfAttribute(ndEdge* const edge, ndInt32 midPoint);
 	
 	void MergeFaces(const ndMeshEffect* const source);
+	void CalculateVoronoiCells(const ndArray<ndVector>& pointCloud, ndArray<ndBigVector>& cellPoints, ndArray<ndInt32>& cellStart) const;
+	static ndMeshEffect* CreateVoronoiCell(const ndBigVector* const points, ndInt32 count, ndInt32 interiorMaterialIndex, const ndMatrix& textureProjectionMatrix, ndConvexHull3dScratch* const scratch);
 	D_COLLISION_API ndMeshEffect* GetNextLayer(ndInt32 mark);
 
 	ndString m_name;
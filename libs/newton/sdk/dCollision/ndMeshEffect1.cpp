@@ -3739,7 +3739,7 @@ void ndMeshEffect::MergeFaces(const ndMeshEffect* const source)
 }
 
 // create a convex hull
-ndMeshEffect::ndMeshEffect(const ndFloat64* const vertexCloud, ndInt32 count, ndInt32 strideInByte, ndFloat64 distTol)
+ndMeshEffect::ndMeshEffect(const ndFloat64* const vertexCloud, ndInt32 count, ndInt32 strideInByte, ndFloat64 distTol, ndConvexHull3dScratch* const scratch)
 	:ndPolyhedra()
 	,m_name()
 	,m_points()
@@ -3752,7 +3752,7 @@ ndMeshEffect::ndMeshEffect(const ndFloat64* const vertexCloud, ndInt32 count, nd
 	Init();
 	if (count >= 4) 
 	{
-		ndConvexHull3d convexHull(vertexCloud, strideInByte, count, distTol);
+		ndConvexHull3d convexHull(vertexCloud, strideInByte, count, distTol, 0x7fffffff, scratch);
 		if (convexHull.GetCount()) 
 		{
 			ndStack<ndInt32> faceCountPool(convexHull.GetCount());
@@ -3911,6 +3911,48 @@ void ndMeshEffect::CalculateAABB(ndBigVector& minBox, ndBigVector& maxBox) const
 	maxBox = maxP;
 }
 
+ndUnsigned64 ndMeshEffect::CalculateHash() const
+{
+	// hash of the face positions, every face starts at its lowest vertex and the 
+	// faces are added in any order, so two meshes with the same geometry get the 
+	// same value regardless of their vertex order and their attributes.
+	ndUnsigned64 hash = 0;
+	ndInt32 mark = IncLRU();
+	ndPolyhedra::Iterator iter(*this);
+	for (iter.Begin(); iter; iter++)
+	{
+		ndEdge* const face = &(*iter);
+		if ((face->m_incidentFace > 0) && (face->m_mark != mark))
+		{
+			ndEdge* first = face;
+			ndEdge* ptr = face;
+			do
+			{
+				ptr->m_mark = mark;
+				const ndBigVector& p = m_points.m_vertex[ptr->m_incidentVertex];
+				const ndBigVector& q = m_points.m_vertex[first->m_incidentVertex];
+				if ((p.m_x < q.m_x) || ((p.m_x == q.m_x) && ((p.m_y < q.m_y) || ((p.m_y == q.m_y) && (p.m_z < q.m_z)))))
+				{
+					first = ptr;
+				}
+				ptr = ptr->m_next;
+			} while (ptr != face);
+
+			ndUnsigned64 faceHash = 0;
+			ptr = first;
+			do
+			{
+				const ndBigVector& p = m_points.m_vertex[ptr->m_incidentVertex];
+				const ndFloat64 position[3] = { p.m_x, p.m_y, p.m_z };
+				faceHash = dCRC64(position, sizeof(position), faceHash);
+				ptr = ptr->m_next;
+			} while (ptr != first);
+			hash += faceHash;
+		}
+	}
+	return hash;
+}
+
 ndFloat64 ndMeshEffect::CalculateVolume() const
 {
 	ndPolyhedraMassProperties localData;
@@ -4002,7 +4044,7 @@ ndMeshEffect* ndMeshEffect::GetNextLayer(ndInt32 mark)
 	return solid;
 }
 
-ndShapeInstance* ndMeshEffect::CreateConvexCollision(ndFloat64 tolerance) const
+ndShapeInstance* ndMeshEffect::CreateConvexCollision(ndFloat64 tolerance, ndInt32 maxPointCount) const
 {
 	ndStack<ndVector> poolPtr(m_points.m_vertex.GetCount() * 2);
 	ndVector* const pool = &poolPtr[0];
@@ -4040,7 +4082,7 @@ ndShapeInstance* ndMeshEffect::CreateConvexCollision(ndFloat64 tolerance) const
 	matrix.m_posit += matrix.RotateVector(com);
 	matrix.m_posit.m_w = ndFloat32(1.0f);
 	
-	ndShapeConvexHull* const collision = new ndShapeConvexHull(count, sizeof(ndVector), ndFloat32(tolerance), &pool[0].m_x);
+	ndShapeConvexHull* const collision = new ndShapeConvexHull(count, sizeof(ndVector), ndFloat32(tolerance), &pool[0].m_x, maxPointCount);
 	if (!collision->GetConvexVertexCount()) 
 	{
 		delete collision;
@@ -22,6 +22,7 @@
 #include "ndCoreStdafx.h"
 #include "ndCollisionStdafx.h"
 #include "ndStack.h"
+#include "ndThreadPool.h"
 #include "ndMatrix.h"
 #include "ndMeshEffect.h"
 #include "ndConvexHull3d.h"
@@ -1103,8 +1104,9 @@ dAssert(0);
 }
 #endif
 
-ndMeshEffect* ndMeshEffect::CreateVoronoiConvexDecomposition(const ndArray<ndVector>& pointCloud, ndInt32 interiorMaterialIndex, const ndMatrix& textureProjectionMatrix)
+void ndMeshEffect::CalculateVoronoiCells(const ndArray<ndVector>& pointCloud, ndArray<ndBigVector>& cellPoints, ndArray<ndInt32>& cellStart) const
 {
+	D_TRACKTIME();
 	ndStack<ndBigVector> buffer(pointCloud.GetCount() + 32);
 	ndBigVector* const pool = &buffer[0];
 	ndInt32 count = 0;
@@ -1173,7 +1175,6 @@ ndMeshEffect* ndMeshEffect::CreateVoronoiConvexDecomposition(const ndArray<ndVec
 	//	delaunayTetrahedras.Save("xxx0.txt");
 	ndInt32 tetraCount = delaunayTetrahedras.GetCount();
 	ndStack<ndBigVector> voronoiPoints(tetraCount + 32);
-	ndStack<ndDelaunayTetrahedralization::ndNode*> tetradrumNode(tetraCount);
 	ndTree<ndList<ndInt32>, ndInt32> delaunayNodes;
 	
 	ndInt32 index = 0;
@@ -1182,7 +1183,6 @@ ndMeshEffect* ndMeshEffect::CreateVoronoiConvexDecomposition(const ndArray<ndVec
 	{
 		ndConvexHull4dTetraherum& tetra = node->GetInfo();
 		voronoiPoints[index] = tetra.CircumSphereCenter(convexHulPoints);
-		tetradrumNode[index] = node;
 	
 		for (ndInt32 i = 0; i < 4; i++) 
 		{
@@ -1196,11 +1196,9 @@ ndMeshEffect* ndMeshEffect::CreateVoronoiConvexDecomposition(const ndArray<ndVec
 		}
 		index++;
 	}
-	
-	const ndFloat32 normalAngleInRadians = ndFloat32(30.0f * ndDegreeToRad);
-	ndMeshEffect* const voronoiPartition = new ndMeshEffect;
-	voronoiPartition->BeginBuild();
-	ndInt32 layer = 0;
+
+	// the vertices of every cell are packed in one array, the hulls are built later
+	ndArray<ndInt32> indexArray;
 	ndTree<ndList<ndInt32>, ndInt32>::Iterator iter(delaunayNodes);
 	for (iter.Begin(); iter; iter++) 
 	{
@@ -1210,35 +1208,118 @@ ndMeshEffect* ndMeshEffect::CreateVoronoiConvexDecomposition(const ndArray<ndVec
 	
 		if (key < guardVertexKey) 
 		{
-			ndBigVector pointArray[512];
-			ndInt32 indexArray[512];
-	
-			ndInt32 count1 = 0;
+			const ndInt32 start = cellPoints.GetCount();
 			for (ndList<ndInt32>::ndNode* ptr = list.GetFirst(); ptr; ptr = ptr->GetNext()) 
 			{
-				ndInt32 i = ptr->GetInfo();
-				pointArray[count1] = voronoiPoints[i];
-				count1++;
-				dAssert(count1 < ndInt32(sizeof(pointArray) / sizeof(pointArray[0])));
+				cellPoints.PushBack(voronoiPoints[ptr->GetInfo()]);
 			}
-	
-			count1 = dVertexListToIndexList(&pointArray[0].m_x, sizeof(ndBigVector), 3, count1, &indexArray[0], ndFloat64(1.0e-3f));
+
+			ndInt32 count1 = cellPoints.GetCount() - start;
+			indexArray.SetCount(count1);
+			count1 = dVertexListToIndexList(&cellPoints[start].m_x, sizeof(ndBigVector), 3, count1, &indexArray[0], ndFloat64(1.0e-3f));
 			if (count1 >= 4) 
 			{
-				ndMeshEffect convexMesh(&pointArray[0].m_x, count1, sizeof(ndBigVector), ndFloat64(0.0f));
-				if (convexMesh.GetCount()) 
-				{
-					convexMesh.m_materials.SetCount(interiorMaterialIndex + 1);
-					convexMesh.CalculateNormals(normalAngleInRadians);
-					convexMesh.UniformBoxMapping(interiorMaterialIndex, textureProjectionMatrix);
-					for (ndInt32 i = 0; i < convexMesh.m_points.m_vertex.GetCount(); i++) 
-					{
-						convexMesh.m_points.m_layers[i] = layer;
-					}
-					voronoiPartition->MergeFaces(&convexMesh);
-					layer++;
-				}
+				cellPoints.SetCount(start + count1);
+				cellStart.PushBack(start);
+			}
+			else
+			{
+				cellPoints.SetCount(start);
+			}
+		}
+	}
+	cellStart.PushBack(cellPoints.GetCount());
+}
+
+ndMeshEffect* ndMeshEffect::CreateVoronoiCell(const ndBigVector* const points, ndInt32 count, ndInt32 interiorMaterialIndex, const ndMatrix& textureProjectionMatrix, ndConvexHull3dScratch* const scratch)
+{
+	const ndFloat32 normalAngleInRadians = ndFloat32(30.0f * ndDegreeToRad);
+	ndMeshEffect* convexMesh = new ndMeshEffect(&points[0].m_x, count, sizeof(ndBigVector), ndFloat64(0.0f), scratch);
+	if (convexMesh->GetCount()) 
+	{
+		convexMesh->m_materials.SetCount(interiorMaterialIndex + 1);
+		convexMesh->CalculateNormals(normalAngleInRadians);
+		convexMesh->UniformBoxMapping(interiorMaterialIndex, textureProjectionMatrix);
+	}
+	else
+	{
+		delete convexMesh;
+		convexMesh = nullptr;
+	}
+	return convexMesh;
+}
+
+ndMeshEffect* ndMeshEffect::CreateVoronoiConvexDecomposition(const ndArray<ndVector>& pointCloud, ndInt32 interiorMaterialIndex, const ndMatrix& textureProjectionMatrix, ndInt32 threadCount)
+{
+	D_TRACKTIME();
+	class ndVoronoiContext
+	{
+		public:
+		const ndBigVector* m_points;
+		const ndInt32* m_cellStart;
+		const ndMatrix* m_textureMatrix;
+		ndMeshEffect** m_cells;
+		ndInt32 m_cellCount;
+		ndInt32 m_materialIndex;
+		ndAtomic<ndInt32> m_cellIndex;
+	};
+
+	class ndBuildCells: public ndJobThreadPool::ndBaseJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			// the hull working memory is reused by all the cells of this worker
+			ndConvexHull3dScratch scratch;
+			ndVoronoiContext* const context = (ndVoronoiContext*)m_context;
+			for (ndInt32 i = context->m_cellIndex.fetch_add(1); i < context->m_cellCount; i = context->m_cellIndex.fetch_add(1))
+			{
+				const ndInt32 start = context->m_cellStart[i];
+				const ndInt32 count = context->m_cellStart[i + 1] - start;
+				context->m_cells[i] = CreateVoronoiCell(&context->m_points[start], count, context->m_materialIndex, *context->m_textureMatrix, &scratch);
+			}
+		}
+	};
+
+	ndArray<ndBigVector> cellPoints;
+	ndArray<ndInt32> cellStart;
+	CalculateVoronoiCells(pointCloud, cellPoints, cellStart);
+
+	const ndInt32 cellCount = cellStart.GetCount() - 1;
+	ndArray<ndMeshEffect*> cells;
+	cells.SetCount(cellCount);
+	if (cellCount)
+	{
+		ndVoronoiContext context;
+		context.m_points = &cellPoints[0];
+		context.m_cellStart = &cellStart[0];
+		context.m_textureMatrix = &textureProjectionMatrix;
+		context.m_cells = &cells[0];
+		context.m_cellCount = cellCount;
+		context.m_materialIndex = interiorMaterialIndex;
+		context.m_cellIndex.store(0);
+
+		ndJobThreadPool threadPool(dMin(threadCount, cellCount), "meshVoronoi");
+		threadPool.SubmitJobs<ndBuildCells>(&context);
+	}
+
+	// merge in cell order, so the layers do not depend on the thread count
+	ndMeshEffect* const voronoiPartition = new ndMeshEffect;
+	voronoiPartition->BeginBuild();
+	ndInt32 layer = 0;
+	for (ndInt32 i = 0; i < cellCount; i++)
+	{
+		ndMeshEffect* const convexMesh = cells[i];
+		if (convexMesh)
+		{
+			for (ndInt32 j = 0; j < convexMesh->m_points.m_vertex.GetCount(); j++) 
+			{
+				convexMesh->m_points.m_layers[j] = layer;
 			}
+			voronoiPartition->MergeFaces(convexMesh);
+			layer++;
+			delete convexMesh;
 		}
 	}
 
@@ -1253,3 +1334,96 @@ ndMeshEffect* ndMeshEffect::CreateVoronoiConvexDecomposition(const ndArray<ndVec
 	}
 	return voronoiPartition;
 }
+
+void ndMeshEffect::CreateVoronoiConvexPieces(ndArray<ndMeshEffect*>& pieces, const ndArray<ndVector>& pointCloud, ndInt32 interiorMaterialIndex, const ndMatrix& textureProjectionMatrix, const ndMeshEffect* const innerMesh, ndInt32 threadCount) const
+{
+	D_TRACKTIME();
+	class ndVoronoiContext
+	{
+		public:
+		const ndMeshEffect* m_me;
+		const ndMeshEffect* m_innerMesh;
+		const ndBigVector* m_points;
+		const ndInt32* m_cellStart;
+		const ndMatrix* m_textureMatrix;
+		ndMeshEffect** m_pieces;
+		ndInt32 m_cellCount;
+		ndInt32 m_materialIndex;
+		ndAtomic<ndInt32> m_cellIndex;
+	};
+
+	class ndClipCells: public ndJobThreadPool::ndBaseJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			ndConvexHull3dScratch scratch;
+			ndVoronoiContext* const context = (ndVoronoiContext*)m_context;
+			for (ndInt32 i = context->m_cellIndex.fetch_add(1); i < context->m_cellCount; i = context->m_cellIndex.fetch_add(1))
+			{
+				ndMeshEffect* piece = nullptr;
+				const ndInt32 start = context->m_cellStart[i];
+				const ndInt32 count = context->m_cellStart[i + 1] - start;
+				ndMeshEffect* const cell = CreateVoronoiCell(&context->m_points[start], count, context->m_materialIndex, *context->m_textureMatrix, &scratch);
+				if (cell)
+				{
+					piece = context->m_me->ConvexMeshIntersection(cell);
+					delete cell;
+				}
+				if (piece && context->m_innerMesh)
+				{
+					// the part outside the inner mesh, one layer per piece
+					ndMeshEffect* const layers = piece->InverseConvexMeshIntersection(context->m_innerMesh);
+					delete piece;
+					piece = layers;
+				}
+				context->m_pieces[i] = piece;
+			}
+		}
+	};
+
+	ndArray<ndBigVector> cellPoints;
+	ndArray<ndInt32> cellStart;
+	CalculateVoronoiCells(pointCloud, cellPoints, cellStart);
+
+	const ndInt32 cellCount = cellStart.GetCount() - 1;
+	ndArray<ndMeshEffect*> cellPieces;
+	cellPieces.SetCount(cellCount);
+	if (cellCount)
+	{
+		ndVoronoiContext context;
+		context.m_me = this;
+		context.m_innerMesh = innerMesh;
+		context.m_points = &cellPoints[0];
+		context.m_cellStart = &cellStart[0];
+		context.m_textureMatrix = &textureProjectionMatrix;
+		context.m_pieces = &cellPieces[0];
+		context.m_cellCount = cellCount;
+		context.m_materialIndex = interiorMaterialIndex;
+		context.m_cellIndex.store(0);
+
+		ndJobThreadPool threadPool(dMin(threadCount, cellCount), "meshVoronoi");
+		threadPool.SubmitJobs<ndClipCells>(&context);
+	}
+
+	for (ndInt32 i = 0; i < cellCount; i++)
+	{
+		ndMeshEffect* const piece = cellPieces[i];
+		if (piece)
+		{
+			if (innerMesh)
+			{
+				for (ndMeshEffect* layer = piece->GetFirstLayer(); layer; layer = piece->GetNextLayer(layer))
+				{
+					pieces.PushBack(layer);
+				}
+				delete piece;
+			}
+			else
+			{
+				pieces.PushBack(piece);
+			}
+		}
+	}
+}
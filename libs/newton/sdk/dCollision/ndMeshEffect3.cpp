@@ -22,6 +22,11 @@
 #include "ndCoreStdafx.h"
 #include "ndCollisionStdafx.h"
 #include "ndMeshEffect.h"
+#include "ndThreadPool.h"
+#include "ndConvexHull3d.h"
+#include "ndShapeInstance.h"
+#include "ndShapeCompound.h"
+#include "ndShapeConvexHull.h"
 //#include "dgBody.h"
 //#include "dgWorld.h"
 //#include "ndMeshEffect.h"
@@ -1370,4 +1375,882 @@ ndMeshEffect* ndMeshEffect::CreateConvexApproximation(ndFloat32 maxConcavity, nd
 	return partition;
 }
 
-#endif
\ No newline at end of file
+#endif
+// approximate convex decomposition in the style of V-HACD. 
+// the solid is voxelized, then the pieces are cut recursively by axis aligned planes,
+// always cutting the piece with the largest concavity, which is the volume of the hull 
+// of the mesh clipped to the piece that is not part of the solid. When the budget is 
+// spent, the pairs of pieces that add the least concavity are merged while the total 
+// is still under the limit.
+#define D_CONVEX_APPROXIMATION_RESOLUTION		40
+#define D_CONVEX_APPROXIMATION_SPLIT_SAMPLES	7
+
+// boxes are six integers, the min and max corners in voxel units, 
+// the max corner is not part of the box.
+class ndConvexApproximationGrid
+{
+	public:
+	enum ndVoxelState
+	{
+		m_empty = 0,
+		m_surface = 1,
+		m_interior = 2,
+		m_outside = 3,
+	};
+
+	ndConvexApproximationGrid(const ndArray<ndBigVector>& triangles, const ndBigVector& pMin, const ndBigVector& pMax, ndInt32 resolution)
+	{
+		const ndBigVector size(pMax - pMin);
+		m_size = dMax(dMax(size.m_x, size.m_y), size.m_z) / ndFloat64(resolution);
+		m_origin = pMin - ndBigVector(m_size, m_size, m_size, ndFloat64(0.0f));
+		for (ndInt32 i = 0; i < 3; i++)
+		{
+			m_dim[i] = ndInt32(ceil(size[i] / m_size)) + 2;
+		}
+
+		const ndInt32 voxelCount = m_dim[0] * m_dim[1] * m_dim[2];
+		m_voxels.SetCount(voxelCount);
+		memset(&m_voxels[0], m_empty, voxelCount * sizeof(ndUnsigned8));
+
+		// mark the voxels touched by the surface, the triangles are sampled at 
+		// half the voxel size so that no voxel crossed by a triangle is missed.
+		const ndFloat64 invSize = ndFloat64(1.0f) / m_size;
+		for (ndInt32 i = 0; i < triangles.GetCount(); i += 3)
+		{
+			const ndBigVector& p0 = triangles[i];
+			const ndBigVector e1(triangles[i + 1] - p0);
+			const ndBigVector e2(triangles[i + 2] - p0);
+			const ndBigVector e3(e2 - e1);
+			const ndFloat64 maxEdge2 = dMax(dMax(e1.DotProduct(e1).GetScalar(), e2.DotProduct(e2).GetScalar()), e3.DotProduct(e3).GetScalar());
+			const ndInt32 steps = ndInt32(ceil(ndFloat64(2.0f) * sqrt(maxEdge2) * invSize)) + 1;
+			const ndFloat64 invSteps = ndFloat64(1.0f) / ndFloat64(steps);
+			for (ndInt32 j = 0; j <= steps; j++)
+			{
+				for (ndInt32 k = 0; k <= (steps - j); k++)
+				{
+					const ndBigVector p(p0 + e1.Scale(ndFloat64(j) * invSteps) + e2.Scale(ndFloat64(k) * invSteps) - m_origin);
+					const ndInt32 x = dClamp(ndInt32(floor(p.m_x * invSize)), 0, m_dim[0] - 1);
+					const ndInt32 y = dClamp(ndInt32(floor(p.m_y * invSize)), 0, m_dim[1] - 1);
+					const ndInt32 z = dClamp(ndInt32(floor(p.m_z * invSize)), 0, m_dim[2] - 1);
+					m_voxels[GetIndex(x, y, z)] = m_surface;
+				}
+			}
+		}
+
+		// flood the outside from the border, what is not reached is inside the solid.
+		ndArray<ndInt32> stack(1024);
+		for (ndInt32 z = 0; z < m_dim[2]; z++)
+		{
+			for (ndInt32 y = 0; y < m_dim[1]; y++)
+			{
+				for (ndInt32 x = 0; x < m_dim[0]; x++)
+				{
+					const bool border = !x || !y || !z || (x == m_dim[0] - 1) || (y == m_dim[1] - 1) || (z == m_dim[2] - 1);
+					const ndInt32 index = GetIndex(x, y, z);
+					if (border && (m_voxels[index] == m_empty))
+					{
+						m_voxels[index] = m_outside;
+						stack.PushBack(index);
+					}
+				}
+			}
+		}
+
+		const ndInt32 stride[3] = { 1, m_dim[0], m_dim[0] * m_dim[1] };
+		while (stack.GetCount())
+		{
+			const ndInt32 index = stack[stack.GetCount() - 1];
+			stack.SetCount(stack.GetCount() - 1);
+			ndInt32 coordinate[3];
+			coordinate[2] = index / stride[2];
+			coordinate[1] = (index - coordinate[2] * stride[2]) / stride[1];
+			coordinate[0] = index - coordinate[2] * stride[2] - coordinate[1] * stride[1];
+			for (ndInt32 i = 0; i < 3; i++)
+			{
+				if ((coordinate[i] > 0) && (m_voxels[index - stride[i]] == m_empty))
+				{
+					m_voxels[index - stride[i]] = m_outside;
+					stack.PushBack(index - stride[i]);
+				}
+				if ((coordinate[i] < m_dim[i] - 1) && (m_voxels[index + stride[i]] == m_empty))
+				{
+					m_voxels[index + stride[i]] = m_outside;
+					stack.PushBack(index + stride[i]);
+				}
+			}
+		}
+
+		for (ndInt32 i = 0; i < voxelCount; i++)
+		{
+			const ndUnsigned8 state = m_voxels[i];
+			m_voxels[i] = (state == m_empty) ? ndUnsigned8(m_interior) : ((state == m_outside) ? ndUnsigned8(m_empty) : state);
+		}
+
+		// summed volume table of the solid voxels, the surface voxels are 
+		// about half inside the solid so they count one and the interior two.
+		m_solidSum.SetCount((m_dim[0] + 1) * (m_dim[1] + 1) * (m_dim[2] + 1));
+		memset(&m_solidSum[0], 0, m_solidSum.GetCount() * sizeof(ndInt32));
+		for (ndInt32 z = 0; z < m_dim[2]; z++)
+		{
+			for (ndInt32 y = 0; y < m_dim[1]; y++)
+			{
+				for (ndInt32 x = 0; x < m_dim[0]; x++)
+				{
+					const ndInt32 solid = m_voxels[GetIndex(x, y, z)];
+					m_solidSum[GetSumIndex(x + 1, y + 1, z + 1)] = solid +
+						m_solidSum[GetSumIndex(x, y + 1, z + 1)] + m_solidSum[GetSumIndex(x + 1, y, z + 1)] + m_solidSum[GetSumIndex(x + 1, y + 1, z)] -
+						m_solidSum[GetSumIndex(x, y, z + 1)] - m_solidSum[GetSumIndex(x, y + 1, z)] - m_solidSum[GetSumIndex(x + 1, y, z)] +
+						m_solidSum[GetSumIndex(x, y, z)];
+				}
+			}
+		}
+	}
+
+	ndInt32 GetIndex(ndInt32 x, ndInt32 y, ndInt32 z) const
+	{
+		return (z * m_dim[1] + y) * m_dim[0] + x;
+	}
+
+	ndInt32 GetSumIndex(ndInt32 x, ndInt32 y, ndInt32 z) const
+	{
+		return (z * (m_dim[1] + 1) + y) * (m_dim[0] + 1) + x;
+	}
+
+	ndBigVector GetPoint(ndInt32 x, ndInt32 y, ndInt32 z) const
+	{
+		return m_origin + ndBigVector(ndFloat64(x), ndFloat64(y), ndFloat64(z), ndFloat64(0.0f)).Scale(m_size);
+	}
+
+	ndFloat64 GetVolume(const ndInt32* const box) const
+	{
+		return ndFloat64(0.5f) * m_size * m_size * m_size * ndFloat64(GetSolidCount(box));
+	}
+
+	ndInt32 GetSolidCount(const ndInt32* const box) const
+	{
+		const ndInt32 x0 = box[0];
+		const ndInt32 y0 = box[1];
+		const ndInt32 z0 = box[2];
+		const ndInt32 x1 = box[3];
+		const ndInt32 y1 = box[4];
+		const ndInt32 z1 = box[5];
+		return
+			m_solidSum[GetSumIndex(x1, y1, z1)] - m_solidSum[GetSumIndex(x0, y1, z1)] - m_solidSum[GetSumIndex(x1, y0, z1)] - m_solidSum[GetSumIndex(x1, y1, z0)] +
+			m_solidSum[GetSumIndex(x0, y0, z1)] + m_solidSum[GetSumIndex(x0, y1, z0)] + m_solidSum[GetSumIndex(x1, y0, z0)] - m_solidSum[GetSumIndex(x0, y0, z0)];
+	}
+
+	// the smallest box with all the solid voxels of a box, false if it has none.
+	bool Shrink(const ndInt32* const box, ndInt32* const tightBox) const
+	{
+		for (ndInt32 i = 0; i < 6; i++)
+		{
+			tightBox[i] = box[i];
+		}
+		if (!GetSolidCount(tightBox))
+		{
+			return false;
+		}
+
+		ndInt32 slab[6];
+		for (ndInt32 i = 0; i < 3; i++)
+		{
+			for (ndInt32 j = 0; j < 6; j++)
+			{
+				slab[j] = tightBox[j];
+			}
+			slab[i + 3] = slab[i] + 1;
+			while (!GetSolidCount(slab))
+			{
+				slab[i]++;
+				slab[i + 3]++;
+			}
+			tightBox[i] = slab[i];
+
+			slab[i + 3] = tightBox[i + 3];
+			slab[i] = slab[i + 3] - 1;
+			while (!GetSolidCount(slab))
+			{
+				slab[i]--;
+				slab[i + 3]--;
+			}
+			tightBox[i + 3] = slab[i + 3];
+		}
+		return true;
+	}
+
+	// a lattice point is inside the solid if all the voxels around it are interior
+	bool IsInside(ndInt32 x, ndInt32 y, ndInt32 z) const
+	{
+		for (ndInt32 k = z - 1; k <= z; k++)
+		{
+			for (ndInt32 j = y - 1; j <= y; j++)
+			{
+				for (ndInt32 i = x - 1; i <= x; i++)
+				{
+					if ((i < 0) || (j < 0) || (k < 0) || (i >= m_dim[0]) || (j >= m_dim[1]) || (k >= m_dim[2]))
+					{
+						return false;
+					}
+					if (m_voxels[GetIndex(i, j, k)] != m_interior)
+					{
+						return false;
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+	ndBigVector m_origin;
+	ndFloat64 m_size;
+	ndInt32 m_dim[3];
+	ndArray<ndUnsigned8> m_voxels;
+	ndArray<ndInt32> m_solidSum;
+};
+
+
+class ndConvexApproximationPiece: public ndClassAlloc
+{
+	public:
+	ndConvexApproximationPiece()
+		:ndClassAlloc()
+		,m_cells()
+		,m_triangles()
+		,m_hull()
+		,m_volume(ndFloat64(0.0f))
+		,m_error(ndFloat64(0.0f))
+		,m_canSplit(true)
+	{
+	}
+
+	// add the part of a triangle inside a box, returns false if there is none
+	static bool ClipTriangle(const ndBigVector* const triangle, const ndBigVector& boxP0, const ndBigVector& boxP1, ndArray<ndBigVector>& points)
+	{
+		const ndBigVector triangleP0(triangle[0].GetMin(triangle[1]).GetMin(triangle[2]));
+		const ndBigVector triangleP1(triangle[0].GetMax(triangle[1]).GetMax(triangle[2]));
+		for (ndInt32 i = 0; i < 3; i++)
+		{
+			if ((triangleP0[i] > boxP1[i]) || (triangleP1[i] < boxP0[i]))
+			{
+				return false;
+			}
+		}
+
+		ndBigVector polygon[2][16];
+		ndInt32 count = 3;
+		polygon[0][0] = triangle[0];
+		polygon[0][1] = triangle[1];
+		polygon[0][2] = triangle[2];
+		ndInt32 src = 0;
+		for (ndInt32 plane = 0; (plane < 6) && count; plane++)
+		{
+			const ndInt32 axis = plane >> 1;
+			const ndFloat64 sign = (plane & 1) ? ndFloat64(-1.0f) : ndFloat64(1.0f);
+			const ndFloat64 offset = (plane & 1) ? boxP1[axis] : boxP0[axis];
+			const ndBigVector* const in = polygon[src];
+			ndBigVector* const out = polygon[src ^ 1];
+			ndInt32 outCount = 0;
+			ndInt32 i0 = count - 1;
+			ndFloat64 side0 = sign * (in[i0][axis] - offset);
+			for (ndInt32 i1 = 0; i1 < count; i1++)
+			{
+				const ndFloat64 side1 = sign * (in[i1][axis] - offset);
+				if (side0 >= ndFloat64(0.0f))
+				{
+					out[outCount] = in[i0];
+					outCount++;
+				}
+				if ((side0 * side1) < ndFloat64(0.0f))
+				{
+					const ndFloat64 t = side0 / (side0 - side1);
+					out[outCount] = in[i0] + (in[i1] - in[i0]).Scale(t);
+					out[outCount][axis] = offset;
+					outCount++;
+				}
+				i0 = i1;
+				side0 = side1;
+			}
+			count = outCount;
+			src ^= 1;
+		}
+
+		for (ndInt32 i = 0; i < count; i++)
+		{
+			points.PushBack(polygon[src][i]);
+		}
+		return count > 0;
+	}
+
+	// the mesh clipped to a cell and the corners of the cell inside the solid,
+	// these are all the points that can be on the hull of the solid in the cell.
+	static void GetCellPoints(const ndConvexApproximationGrid& grid, const ndArray<ndBigVector>& triangleList, const ndArray<ndInt32>& triangles, const ndInt32* const cell, ndArray<ndBigVector>& points, ndArray<ndInt32>* const cellTriangles)
+	{
+		points.SetCount(0);
+		const ndBigVector boxP0(grid.GetPoint(cell[0], cell[1], cell[2]));
+		const ndBigVector boxP1(grid.GetPoint(cell[3], cell[4], cell[5]));
+		for (ndInt32 i = 0; i < triangles.GetCount(); i++)
+		{
+			if (ClipTriangle(&triangleList[triangles[i] * 3], boxP0, boxP1, points) && cellTriangles)
+			{
+				cellTriangles->PushBack(triangles[i]);
+			}
+		}
+		for (ndInt32 i = 0; i < 8; i++)
+		{
+			const ndInt32 x = cell[(i & 1) ? 3 : 0];
+			const ndInt32 y = cell[(i & 2) ? 4 : 1];
+			const ndInt32 z = cell[(i & 4) ? 5 : 2];
+			if (grid.IsInside(x, y, z))
+			{
+				points.PushBack(grid.GetPoint(x, y, z));
+			}
+		}
+	}
+
+	static ndFloat64 CalculateHull(const ndArray<ndBigVector>& points, ndArray<ndBigVector>* const hullPoints)
+	{
+		ndFloat64 volume = ndFloat64(0.0f);
+		if (hullPoints)
+		{
+			hullPoints->SetCount(0);
+		}
+		if (points.GetCount() >= 4)
+		{
+			ndConvexHull3d hull(&points[0].m_x, sizeof(ndBigVector), points.GetCount(), ndFloat64(0.0f));
+			if (hull.GetCount())
+			{
+				ndFloat64 area;
+				hull.CalculateVolumeAndSurfaceArea(volume, area);
+				volume = dAbs(volume);
+				if (hullPoints)
+				{
+					hullPoints->SetCount(hull.GetVertexCount());
+					for (ndInt32 i = 0; i < hull.GetVertexCount(); i++)
+					{
+						(*hullPoints)[i] = hull.GetVertexPool()[i];
+					}
+				}
+			}
+		}
+		return volume;
+	}
+
+	// concavity of the solid in a cell, returns false if the cell is empty
+	static bool CalculateError(const ndConvexApproximationGrid& grid, const ndArray<ndBigVector>& triangleList, const ndArray<ndInt32>& triangles, const ndInt32* const cell, ndArray<ndBigVector>& points, ndFloat64& error)
+	{
+		error = ndFloat64(0.0f);
+		if (!grid.GetSolidCount(cell))
+		{
+			return false;
+		}
+		GetCellPoints(grid, triangleList, triangles, cell, points, nullptr);
+		error = dMax(CalculateHull(points, nullptr) - grid.GetVolume(cell), ndFloat64(0.0f));
+		return true;
+	}
+
+	void Init(const ndConvexApproximationGrid& grid, const ndArray<ndBigVector>& triangleList, const ndArray<ndInt32>& triangles, const ndInt32* const cell)
+	{
+		m_cells.SetCount(6);
+		for (ndInt32 i = 0; i < 6; i++)
+		{
+			m_cells[i] = cell[i];
+		}
+		grid.Shrink(cell, m_box);
+
+		ndArray<ndBigVector> points;
+		GetCellPoints(grid, triangleList, triangles, cell, points, &m_triangles);
+		m_volume = grid.GetVolume(cell);
+		m_error = dMax(CalculateHull(points, &m_hull) - m_volume, ndFloat64(0.0f));
+	}
+
+	// the cells of the partition this piece is made of, six integers each
+	ndArray<ndInt32> m_cells;
+	// the triangles that cross the cell
+	ndArray<ndInt32> m_triangles;
+	// vertices of the hull of the piece
+	ndArray<ndBigVector> m_hull;
+	ndFloat64 m_volume;
+	ndFloat64 m_error;
+	// bounds of the solid voxels of the cell
+	ndInt32 m_box[6];
+	bool m_canSplit;
+};
+
+ndShapeInstance* ndConvexApproximationCache::Find(ndUnsigned64 key) const
+{
+	ndScopeSpinLock lock(m_lock);
+	ndTree<ndShapeInstance*, ndUnsigned64>::ndNode* const node = m_entries.Find(key);
+	return node ? new ndShapeInstance(*node->GetInfo()) : nullptr;
+}
+
+void ndConvexApproximationCache::Add(ndUnsigned64 key, const ndShapeInstance& instance)
+{
+	ndScopeSpinLock lock(m_lock);
+	if (!m_entries.Find(key))
+	{
+		m_entries.Insert(new ndShapeInstance(instance), key);
+	}
+}
+
+ndConvexApproximationCache::ndConvexApproximationCache()
+	:ndClassAlloc()
+	,m_entries()
+	,m_lock()
+{
+}
+
+ndConvexApproximationCache::~ndConvexApproximationCache()
+{
+	Clear();
+}
+
+void ndConvexApproximationCache::Clear()
+{
+	ndScopeSpinLock lock(m_lock);
+	ndTree<ndShapeInstance*, ndUnsigned64>::Iterator it(m_entries);
+	for (it.Begin(); it; it++)
+	{
+		delete *it;
+	}
+	m_entries.RemoveAll();
+}
+
+ndShapeInstance* ndMeshEffect::CreateConvexApproximation(ndFloat32 maxConcavity, ndInt32 maxPieceCount, ndInt32 maxVertexPerHull, ndInt32 threadCount, ndConvexApproximationCache* const cache) const
+{
+	D_TRACKTIME();
+	ndUnsigned64 key = 0;
+	if (cache)
+	{
+		class ndKey
+		{
+			public:
+			ndFloat32 m_maxConcavity;
+			ndInt32 m_maxPieceCount;
+			ndInt32 m_maxVertexPerHull;
+			ndInt32 m_resolution;
+		};
+		ndKey params;
+		memset(&params, 0, sizeof(params));
+		params.m_maxConcavity = maxConcavity;
+		params.m_maxPieceCount = maxPieceCount;
+		params.m_maxVertexPerHull = maxVertexPerHull;
+		params.m_resolution = D_CONVEX_APPROXIMATION_RESOLUTION;
+		key = dCRC64(&params, sizeof(params), CalculateHash());
+		ndShapeInstance* const instance = cache->Find(key);
+		if (instance)
+		{
+			return instance;
+		}
+	}
+
+	// collect the faces as a triangle list
+	ndArray<ndBigVector> triangleList;
+	const ndInt32 mark = IncLRU();
+	ndPolyhedra::Iterator iter(*this);
+	for (iter.Begin(); iter; iter++)
+	{
+		ndEdge* const face = &(*iter);
+		if ((face->m_incidentFace > 0) && (face->m_mark != mark))
+		{
+			face->m_mark = mark;
+			const ndBigVector p0(m_points.m_vertex[face->m_incidentVertex] & ndBigVector::m_triplexMask);
+			for (ndEdge* ptr = face->m_next; ptr->m_next != face; ptr = ptr->m_next)
+			{
+				ptr->m_mark = mark;
+				ptr->m_next->m_mark = mark;
+				triangleList.PushBack(p0);
+				triangleList.PushBack(m_points.m_vertex[ptr->m_incidentVertex] & ndBigVector::m_triplexMask);
+				triangleList.PushBack(m_points.m_vertex[ptr->m_next->m_incidentVertex] & ndBigVector::m_triplexMask);
+			}
+		}
+	}
+	if (!triangleList.GetCount())
+	{
+		return nullptr;
+	}
+
+	ndBigVector pMin;
+	ndBigVector pMax;
+	CalculateAABB(pMin, pMax);
+	const ndConvexApproximationGrid grid(triangleList, pMin, pMax, D_CONVEX_APPROXIMATION_RESOLUTION);
+
+	const ndInt32 rootCell[6] = { 0, 0, 0, grid.m_dim[0], grid.m_dim[1], grid.m_dim[2] };
+	const ndFloat64 maxError = dMax(ndFloat64(maxConcavity), ndFloat64(0.0f)) * grid.GetVolume(rootCell);
+	maxPieceCount = dMax(maxPieceCount, 1);
+	ndJobThreadPool threadPool(dMax(threadCount, 1), "meshConvexApprox");
+
+	ndArray<ndConvexApproximationPiece*> pieces;
+	{
+		ndArray<ndInt32> triangles;
+		for (ndInt32 i = 0; i < triangleList.GetCount() / 3; i++)
+		{
+			triangles.PushBack(i);
+		}
+		pieces.PushBack(new ndConvexApproximationPiece());
+		pieces[0]->Init(grid, triangleList, triangles, rootCell);
+	}
+
+	// cut the piece with the largest error until the total error or the piece budget are met
+	class ndSplitContext
+	{
+		public:
+		const ndConvexApproximationGrid* m_grid;
+		const ndArray<ndBigVector>* m_triangleList;
+		const ndConvexApproximationPiece* m_piece;
+		const ndInt32* m_axis;
+		const ndInt32* m_position;
+		ndFloat64* m_cost;
+		ndInt32 m_count;
+		ndAtomic<ndInt32> m_index;
+	};
+
+	class ndEvaluateSplits: public ndJobThreadPool::ndBaseJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			ndSplitContext* const context = (ndSplitContext*)m_context;
+			const ndConvexApproximationPiece* const piece = context->m_piece;
+			ndArray<ndBigVector> points;
+			for (ndInt32 i = context->m_index.fetch_add(1); i < context->m_count; i = context->m_index.fetch_add(1))
+			{
+				ndInt32 cell0[6];
+				ndInt32 cell1[6];
+				for (ndInt32 j = 0; j < 6; j++)
+				{
+					cell0[j] = piece->m_cells[j];
+					cell1[j] = piece->m_cells[j];
+				}
+				cell0[context->m_axis[i] + 3] = context->m_position[i];
+				cell1[context->m_axis[i]] = context->m_position[i];
+
+				ndFloat64 error0;
+				ndFloat64 error1;
+				const bool valid0 = ndConvexApproximationPiece::CalculateError(*context->m_grid, *context->m_triangleList, piece->m_triangles, cell0, points, error0);
+				const bool valid1 = ndConvexApproximationPiece::CalculateError(*context->m_grid, *context->m_triangleList, piece->m_triangles, cell1, points, error1);
+				context->m_cost[i] = (valid0 && valid1) ? error0 + error1 : ndFloat64(-1.0f);
+			}
+		}
+	};
+
+	while (pieces.GetCount() < maxPieceCount)
+	{
+		ndInt32 pieceIndex = -1;
+		ndFloat64 pieceError = ndFloat64(0.0f);
+		ndFloat64 totalError = ndFloat64(0.0f);
+		for (ndInt32 i = 0; i < pieces.GetCount(); i++)
+		{
+			totalError += pieces[i]->m_error;
+			if (pieces[i]->m_canSplit && (pieces[i]->m_error > pieceError))
+			{
+				pieceIndex = i;
+				pieceError = pieces[i]->m_error;
+			}
+		}
+		if ((pieceIndex < 0) || (totalError <= maxError))
+		{
+			break;
+		}
+
+		ndConvexApproximationPiece* const piece = pieces[pieceIndex];
+		ndInt32 splitAxis[3 * D_CONVEX_APPROXIMATION_SPLIT_SAMPLES];
+		ndInt32 splitPosition[3 * D_CONVEX_APPROXIMATION_SPLIT_SAMPLES];
+		ndFloat64 splitCost[3 * D_CONVEX_APPROXIMATION_SPLIT_SAMPLES];
+		ndInt32 splitCount = 0;
+		for (ndInt32 i = 0; i < 3; i++)
+		{
+			const ndInt32 size = piece->m_box[i + 3] - piece->m_box[i];
+			const ndInt32 samples = dMin(size - 1, D_CONVEX_APPROXIMATION_SPLIT_SAMPLES);
+			for (ndInt32 j = 1; j <= samples; j++)
+			{
+				splitAxis[splitCount] = i;
+				splitPosition[splitCount] = piece->m_box[i] + (j * size) / (samples + 1);
+				splitCount++;
+			}
+		}
+
+		ndInt32 bestSplit = -1;
+		if (splitCount)
+		{
+			ndSplitContext context;
+			context.m_grid = &grid;
+			context.m_triangleList = &triangleList;
+			context.m_piece = piece;
+			context.m_axis = splitAxis;
+			context.m_position = splitPosition;
+			context.m_cost = splitCost;
+			context.m_count = splitCount;
+			context.m_index.store(0);
+			threadPool.SubmitJobs<ndEvaluateSplits>(&context);
+
+			for (ndInt32 i = 0; i < splitCount; i++)
+			{
+				if ((splitCost[i] >= ndFloat64(0.0f)) && ((bestSplit < 0) || (splitCost[i] < splitCost[bestSplit])))
+				{
+					bestSplit = i;
+				}
+			}
+		}
+
+		if ((bestSplit < 0) || (splitCost[bestSplit] >= piece->m_error))
+		{
+			piece->m_canSplit = false;
+			continue;
+		}
+
+		ndInt32 cell0[6];
+		ndInt32 cell1[6];
+		for (ndInt32 i = 0; i < 6; i++)
+		{
+			cell0[i] = piece->m_cells[i];
+			cell1[i] = piece->m_cells[i];
+		}
+		cell0[splitAxis[bestSplit] + 3] = splitPosition[bestSplit];
+		cell1[splitAxis[bestSplit]] = splitPosition[bestSplit];
+
+		ndConvexApproximationPiece* const piece0 = new ndConvexApproximationPiece();
+		ndConvexApproximationPiece* const piece1 = new ndConvexApproximationPiece();
+		piece0->Init(grid, triangleList, piece->m_triangles, cell0);
+		piece1->Init(grid, triangleList, piece->m_triangles, cell1);
+		pieces[pieceIndex] = piece0;
+		pieces.PushBack(piece1);
+		delete piece;
+	}
+
+	// merge the pairs of pieces that add the least error, while the total is under the limit.
+	class ndMergeContext
+	{
+		public:
+		ndConvexApproximationPiece** m_pieces;
+		const ndInt32* m_pairs;
+		ndFloat64* m_cost;
+		ndInt32 m_stride;
+		ndInt32 m_count;
+		ndAtomic<ndInt32> m_index;
+	};
+
+	class ndEvaluateMerges: public ndJobThreadPool::ndBaseJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			ndMergeContext* const context = (ndMergeContext*)m_context;
+			ndArray<ndBigVector> points;
+			for (ndInt32 i = context->m_index.fetch_add(1); i < context->m_count; i = context->m_index.fetch_add(1))
+			{
+				const ndInt32 i0 = context->m_pairs[i * 2 + 0];
+				const ndInt32 i1 = context->m_pairs[i * 2 + 1];
+				const ndConvexApproximationPiece* const piece0 = context->m_pieces[i0];
+				const ndConvexApproximationPiece* const piece1 = context->m_pieces[i1];
+				points.SetCount(0);
+				for (ndInt32 j = 0; j < piece0->m_hull.GetCount(); j++)
+				{
+					points.PushBack(piece0->m_hull[j]);
+				}
+				for (ndInt32 j = 0; j < piece1->m_hull.GetCount(); j++)
+				{
+					points.PushBack(piece1->m_hull[j]);
+				}
+				const ndFloat64 volume = ndConvexApproximationPiece::CalculateHull(points, nullptr);
+				context->m_cost[i0 * context->m_stride + i1] = dMax(volume - piece0->m_volume - piece1->m_volume, ndFloat64(0.0f));
+			}
+		}
+	};
+
+	const ndInt32 count = pieces.GetCount();
+	if (count > 1)
+	{
+		ndArray<ndInt32> pairs;
+		ndArray<ndFloat64> cost;
+		cost.SetCount(count * count);
+		for (ndInt32 i = 0; i < count; i++)
+		{
+			for (ndInt32 j = i + 1; j < count; j++)
+			{
+				pairs.PushBack(i);
+				pairs.PushBack(j);
+			}
+		}
+
+		ndFloat64 totalError = ndFloat64(0.0f);
+		for (ndInt32 i = 0; i < count; i++)
+		{
+			totalError += pieces[i]->m_error;
+		}
+
+		ndMergeContext context;
+		context.m_pieces = &pieces[0];
+		context.m_cost = &cost[0];
+		context.m_stride = count;
+		for (bool merged = true; merged; )
+		{
+			context.m_pairs = &pairs[0];
+			context.m_count = pairs.GetCount() / 2;
+			context.m_index.store(0);
+			threadPool.SubmitJobs<ndEvaluateMerges>(&context);
+
+			ndInt32 best0 = -1;
+			ndInt32 best1 = -1;
+			ndFloat64 bestCost = maxError - totalError;
+			for (ndInt32 i = 0; i < count; i++)
+			{
+				for (ndInt32 j = i + 1; (j < count) && pieces[i]; j++)
+				{
+					if (pieces[j])
+					{
+						const ndFloat64 errorIncrease = cost[i * count + j] - pieces[i]->m_error - pieces[j]->m_error;
+						if (errorIncrease <= bestCost)
+						{
+							best0 = i;
+							best1 = j;
+							bestCost = errorIncrease;
+						}
+					}
+				}
+			}
+
+			merged = best0 >= 0;
+			pairs.SetCount(0);
+			if (merged)
+			{
+				ndConvexApproximationPiece* const piece0 = pieces[best0];
+				ndConvexApproximationPiece* const piece1 = pieces[best1];
+				for (ndInt32 i = 0; i < piece1->m_cells.GetCount(); i++)
+				{
+					piece0->m_cells.PushBack(piece1->m_cells[i]);
+				}
+				for (ndInt32 i = 0; i < piece1->m_hull.GetCount(); i++)
+				{
+					piece0->m_hull.PushBack(piece1->m_hull[i]);
+				}
+				ndArray<ndBigVector> points(piece0->m_hull);
+				ndConvexApproximationPiece::CalculateHull(points, &piece0->m_hull);
+				totalError += bestCost;
+				piece0->m_volume += piece1->m_volume;
+				piece0->m_error = cost[best0 * count + best1];
+				delete piece1;
+				pieces[best1] = nullptr;
+
+				for (ndInt32 i = 0; i < count; i++)
+				{
+					if (pieces[i] && (i != best0))
+					{
+						pairs.PushBack(dMin(i, best0));
+						pairs.PushBack(dMax(i, best0));
+					}
+				}
+				merged = pairs.GetCount() > 0;
+			}
+		}
+	}
+
+	ndInt32 pieceCount = 0;
+	for (ndInt32 i = 0; i < count; i++)
+	{
+		if (pieces[i])
+		{
+			pieces[pieceCount] = pieces[i];
+			pieceCount++;
+		}
+	}
+	pieces.SetCount(pieceCount);
+
+	class ndHullContext
+	{
+		public:
+		ndConvexApproximationPiece** m_pieces;
+		ndShapeConvexHull** m_shapes;
+		ndBigVector* m_origins;
+		ndInt32 m_maxVertexCount;
+		ndInt32 m_count;
+		ndAtomic<ndInt32> m_index;
+	};
+
+	class ndBuildHulls: public ndJobThreadPool::ndBaseJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			ndHullContext* const context = (ndHullContext*)m_context;
+			for (ndInt32 i = context->m_index.fetch_add(1); i < context->m_count; i = context->m_index.fetch_add(1))
+			{
+				const ndArray<ndBigVector>& points = context->m_pieces[i]->m_hull;
+				context->m_shapes[i] = nullptr;
+				if (points.GetCount() >= 4)
+				{
+					ndBigVector origin(ndBigVector::m_zero);
+					for (ndInt32 j = 0; j < points.GetCount(); j++)
+					{
+						origin += points[j];
+					}
+					origin = origin.Scale(ndFloat64(1.0f) / ndFloat64(points.GetCount()));
+
+					ndStack<ndVector> buffer(points.GetCount());
+					for (ndInt32 j = 0; j < points.GetCount(); j++)
+					{
+						buffer[j] = ndVector(points[j] - origin);
+					}
+					ndShapeConvexHull* const shape = new ndShapeConvexHull(points.GetCount(), sizeof(ndVector), ndFloat32(0.0f), &buffer[0].m_x, context->m_maxVertexCount);
+					if (shape->GetConvexVertexCount())
+					{
+						context->m_shapes[i] = shape;
+						context->m_origins[i] = origin;
+					}
+					else
+					{
+						delete shape;
+					}
+				}
+			}
+		}
+	};
+
+	ndArray<ndShapeConvexHull*> shapes;
+	ndArray<ndBigVector> origins;
+	shapes.SetCount(pieceCount);
+	origins.SetCount(pieceCount);
+	{
+		ndHullContext context;
+		context.m_pieces = &pieces[0];
+		context.m_shapes = &shapes[0];
+		context.m_origins = &origins[0];
+		context.m_maxVertexCount = maxVertexPerHull;
+		context.m_count = pieceCount;
+		context.m_index.store(0);
+		threadPool.SubmitJobs<ndBuildHulls>(&context);
+	}
+
+	ndShapeInstance* instance = new ndShapeInstance(new ndShapeCompound());
+	ndShapeCompound* const compound = instance->GetShape()->GetAsShapeCompound();
+	ndInt32 childCount = 0;
+	compound->BeginAddRemove();
+	for (ndInt32 i = 0; i < pieceCount; i++)
+	{
+		if (shapes[i])
+		{
+			ndMatrix matrix(dGetIdentityMatrix());
+			matrix.m_posit = ndVector(origins[i]);
+			matrix.m_posit.m_w = ndFloat32(1.0f);
+			ndShapeInstance child(shapes[i]);
+			child.SetLocalMatrix(matrix);
+			compound->AddCollision(&child);
+			childCount++;
+		}
+		delete pieces[i];
+	}
+	compound->EndAddRemove();
+
+	if (!childCount)
+	{
+		delete instance;
+		instance = nullptr;
+	}
+	else if (cache)
+	{
+		cache->Add(key, *instance);
+	}
+	return instance;
+}
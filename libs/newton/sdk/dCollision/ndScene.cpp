@@ -39,7 +39,12 @@
 #define D_NARROW_PHASE_DIST			ndFloat32 (0.2f)
 #define D_CONTACT_TRANSLATION_ERROR	ndFloat32 (1.0e-3f)
 #define D_CONTACT_ANGULAR_ERROR		(ndFloat32 (0.25f * ndDegreeToRad))
+#define D_CONTACT_BIN_SHIFT			28
+#define D_CONTACT_BIN_INDEX_MASK	((1 << D_CONTACT_BIN_SHIFT) - 1)
+#define D_CONTACT_BIN_BATCH_COST	256
 
+// relative cost of a contact of each pair class, in the order of ndContactPairClass
+ndInt32 ndScene::m_contactPairCost[] = { 128, 96, 32, 16, 8, 8, 6, 4, 1 };
 ndVector ndScene::m_velocTol(ndFloat32(1.0e-16f));
 ndVector ndScene::m_angularContactError2(D_CONTACT_ANGULAR_ERROR * D_CONTACT_ANGULAR_ERROR);
 ndVector ndScene::m_linearContactError2(D_CONTACT_TRANSLATION_ERROR * D_CONTACT_TRANSLATION_ERROR);
@@ -194,7 +199,10 @@ ndScene::ndScene()
 	,m_scratchBuffer(1024)
 	,m_sceneBodyArray(1024)
 	,m_activeBodyArray(1024)
+	,m_awakeBodyArray(1024)
+	,m_wakeUpArray(256)
 	,m_activeConstraintArray(1024)
+	,m_contactEventArray()
 	,m_specialUpdateList()
 	,m_lock()
 	,m_rootNode(nullptr)
@@ -203,8 +211,14 @@ ndScene::ndScene()
 	,m_fitness()
 	,m_timestep(ndFloat32 (0.0f))
 	,m_lru(D_CONTACT_DELAY_FRAMES)
+	,m_sleepingBodyCount(0)
+	,m_sleepingContactCount(0)
 	,m_bodyListChanged(0)
-	,m_currentThreadsMem(0)
+	,m_speculativeContacts(0)
+	,m_deterministic(0)
+	,m_sleepingIslands(0)
+	,m_contactEvents(0)
+	,m_contactBinning(0)
 {
 	m_contactNotifyCallback->m_scene = this;
 }
@@ -222,10 +236,12 @@ void ndScene::CollisionOnlyUpdate()
 	D_TRACKTIME();
 	Begin();
 	m_lru = m_lru + 1;
+	m_contactEventArray.SetCount(0);
 	InitBodyArray();
 	BalanceScene();
 	FindCollidingPairs();
 	CalculateContacts();
+	UpdateContactEvents();
 	End();
 }
 
@@ -314,6 +330,21 @@ bool ndScene::RemoveBody(ndBodyKinematic* const body)
 		RemoveNode(node);
 	}
 
+	// contacts of a sleeping island are not in the contact array, 
+	// the island is woken so that they are deleted with the body.
+	if (body->m_sleepingIsland)
+	{
+		WakeIsland(body, false);
+	}
+	for (ndInt32 i = m_wakeUpArray.GetCount() - 1; i >= 0; --i)
+	{
+		if (m_wakeUpArray[i] == body)
+		{
+			m_wakeUpArray[i] = m_wakeUpArray[m_wakeUpArray.GetCount() - 1];
+			m_wakeUpArray.SetCount(m_wakeUpArray.GetCount() - 1);
+		}
+	}
+
 	ndBodyKinematic::ndContactMap& contactMap = body->GetContactMap();
 	while (contactMap.GetRoot())
 	{
@@ -764,6 +795,17 @@ void ndScene::UpdateAabb(ndInt32, ndBodyKinematic* const body)
 {
 	ndSceneBodyNode* const bodyNode = body->GetSceneBodyNode();
 	body->UpdateCollisionMatrix();
+	if (IsSpeculative(body))
+	{
+		// sweep the box along the body motion, so that the pair search 
+		// find all the bodies this body can reach during this step. 
+		const ndVector linearStep(body->m_veloc.Scale(m_timestep) & ndVector::m_triplexMask);
+		const ndFloat32 omegaMag2 = body->m_omega.DotProduct(body->m_omega & ndVector::m_triplexMask).GetScalar();
+		const ndFloat32 angularStep = ndSqrt(omegaMag2) * body->GetCollisionShape().GetBoxMaxRadius() * m_timestep;
+		const ndVector angularPadding(ndVector(angularStep) & ndVector::m_triplexMask);
+		body->m_minAabb = body->m_minAabb.GetMin(body->m_minAabb + linearStep) - angularPadding;
+		body->m_maxAabb = body->m_maxAabb.GetMax(body->m_maxAabb + linearStep) + angularPadding;
+	}
 		
 	dAssert(!bodyNode->GetLeft());
 	dAssert(!bodyNode->GetRight());
@@ -835,7 +877,16 @@ void ndScene::CalculateJointContacts(ndInt32 threadIndex, ndContact* const conta
 	dAssert(body1->GetScene() == this);
 
 	dAssert(m_contactNotifyCallback);
-	bool processContacts = m_contactNotifyCallback->OnAabbOverlap(contact, m_timestep);
+	bool processContacts = false;
+	const ndMaterial* const material = m_contactNotifyCallback->FindMaterialPair(body0->GetCollisionShape().m_shapeMaterial.m_userId, body1->GetCollisionShape().m_shapeMaterial.m_userId);
+	if (material)
+	{
+		processContacts = (material->m_flags & m_collisionEnable) ? true : false;
+	}
+	else
+	{
+		processContacts = m_contactNotifyCallback->OnAabbOverlap(contact, m_timestep);
+	}
 	if (processContacts)
 	{
 		dAssert(!body0->GetAsBodyTriggerVolume());
@@ -847,6 +898,10 @@ void ndScene::CalculateJointContacts(ndInt32 threadIndex, ndContact* const conta
 		contactSolver.m_separatingVector = contact->m_separatingVector;
 		contactSolver.m_contactBuffer = contactBuffer;
 		contactSolver.m_intersectionTestOnly = body0->m_contactTestOnly | body1->m_contactTestOnly;
+		if (!contactSolver.m_intersectionTestOnly && (IsSpeculative(body0) || IsSpeculative(body1)))
+		{
+			contactSolver.m_speculativeDistance = CalculateSpeculativeDistance(contact);
+		}
 		
 		ndInt32 count = contactSolver.CalculateContactsDiscrete ();
 		if (count)
@@ -888,6 +943,28 @@ void ndScene::CalculateJointContacts(ndInt32 threadIndex, ndContact* const conta
 	}
 }
 
+bool ndScene::IsSpeculative(const ndBodyKinematic* const body) const
+{
+	return (m_speculativeContacts | body->m_speculativeContacts) ? true : false;
+}
+
+ndFloat32 ndScene::CalculateSpeculativeDistance(const ndContact* const contact) const
+{
+	// the largest distance the two bodies can close during this step.
+	// contacts inside this distance are generated ahead of time, 
+	// and the solver only let the bodies approach as far as the gap.
+	const ndBodyKinematic* const body0 = contact->GetBody0();
+	const ndBodyKinematic* const body1 = contact->GetBody1();
+	const ndVector veloc((body1->m_veloc - body0->m_veloc) & ndVector::m_triplexMask);
+	const ndVector omega0(body0->m_omega & ndVector::m_triplexMask);
+	const ndVector omega1(body1->m_omega & ndVector::m_triplexMask);
+
+	const ndVector scale(ndFloat32(1.0f), body0->GetCollisionShape().GetBoxMaxRadius(), body1->GetCollisionShape().GetBoxMaxRadius(), ndFloat32(0.0f));
+	const ndVector velocMag2(veloc.DotProduct(veloc).GetScalar(), omega0.DotProduct(omega0).GetScalar(), omega1.DotProduct(omega1).GetScalar(), ndFloat32(0.0f));
+	const ndVector velocMag(velocMag2.GetMax(ndVector::m_epsilon).InvSqrt() * velocMag2 * scale);
+	return velocMag.AddHorizontal().GetScalar() * m_timestep;
+}
+
 void ndScene::ProcessContacts(ndInt32 threadIndex, ndInt32 contactCount, ndContactSolver* const contactSolver)
 {
 	ndContact* const contact = contactSolver->m_contact;
@@ -900,7 +977,15 @@ void ndScene::ProcessContacts(ndInt32 threadIndex, ndInt32 contactCount, ndConta
 	dAssert(body1);
 	dAssert(body0 != body1);
 
-	contact->m_material = m_contactNotifyCallback->GetMaterial(contact, body0->GetCollisionShape(), body1->GetCollisionShape());
+	const ndMaterial* const material = m_contactNotifyCallback->FindMaterialPair(body0->GetCollisionShape().m_shapeMaterial.m_userId, body1->GetCollisionShape().m_shapeMaterial.m_userId);
+	if (material)
+	{
+		contact->m_material = *material;
+	}
+	else
+	{
+		contact->m_material = m_contactNotifyCallback->GetMaterial(contact, body0->GetCollisionShape(), body1->GetCollisionShape());
+	}
 	const ndContactPoint* const contactArray = contactSolver->m_contactBuffer;
 	
 	ndInt32 count = 0;
@@ -1081,10 +1166,13 @@ void ndScene::ProcessContacts(ndInt32 threadIndex, ndInt32 contactCount, ndConta
 	}
 	
 	contact->m_maxDOF = ndUnsigned32(3 * contactPointList.GetCount());
-	m_contactNotifyCallback->OnContactCallback(threadIndex, contact, m_timestep);
+	if (!material || (contact->m_material.m_flags & m_contactCallbackEnable))
+	{
+		m_contactNotifyCallback->OnContactCallback(threadIndex, contact, m_timestep);
+	}
 }
 
-void ndScene::SubmitPairs(ndSceneNode* const leafNode, ndSceneNode* const node)
+void ndScene::SubmitPairs(ndInt32 threadIndex, ndSceneNode* const leafNode, ndSceneNode* const node)
 {
 	ndBodyKinematic* const body0 = leafNode->GetBody() ? leafNode->GetBody() : nullptr;
 	const ndVector boxP0(body0 ? body0->m_minAabb : leafNode->m_minBox);
@@ -1115,7 +1203,7 @@ void ndScene::SubmitPairs(ndSceneNode* const leafNode, ndSceneNode* const node)
 							const bool test = TestOverlaping(body0, body1);
 							if (test)
 							{
-								AddPair(body0, body1);
+								AddPair(threadIndex, body0, body1);
 							}
 						}
 					}
@@ -1238,7 +1326,7 @@ ndContact* ndScene::FindContactJoint(ndBodyKinematic* const body0, ndBodyKinemat
 	return contact;
 }
 
-void ndScene::AddPair(ndBodyKinematic* const body0, ndBodyKinematic* const body1)
+void ndScene::AddPair(ndInt32 threadIndex, ndBodyKinematic* const body0, ndBodyKinematic* const body1)
 {
 	ndContact* const contact = FindContactJoint(body0, body1);
 	if (!contact) 
@@ -1248,8 +1336,48 @@ void ndScene::AddPair(ndBodyKinematic* const body0, ndBodyKinematic* const body1
 		const bool isCollidable = bilateral ? bilateral->IsCollidable() : true;
 		if (isCollidable) 
 		{
-			m_contactArray.CreateContact(body0, body1);
+			if (m_deterministic && (body0->GetId() > body1->GetId()))
+			{
+				// the pair is oriented by the broad phase tree, 
+				// in deterministic mode orient it by body id instead.
+				m_contactArray.CreateContact(threadIndex, body1, body0);
+			}
+			else
+			{
+				m_contactArray.CreateContact(threadIndex, body0, body1);
+			}
+		}
+	}
+}
+
+void ndScene::SortNewContacts(ndInt32 start)
+{
+	D_TRACKTIME();
+	class CompareContacts
+	{
+		public:
+		ndInt32 Compare(const ndContact* const contactA, const ndContact* const contactB, void* const) const
+		{
+			const ndUnsigned64 keyA = (ndUnsigned64(contactA->GetBody0()->GetId()) << 32) + contactA->GetBody1()->GetId();
+			const ndUnsigned64 keyB = (ndUnsigned64(contactB->GetBody0()->GetId()) << 32) + contactB->GetBody1()->GetId();
+			if (keyA < keyB)
+			{
+				return -1;
+			}
+			else if (keyA > keyB)
+			{
+				return 1;
+			}
+			return 0;
 		}
+	};
+
+	// contacts surviving from previous frames are kept in a stable order, 
+	// so only contacts created concurrently during this update need sorting.
+	const ndInt32 count = m_contactArray.GetCount() - start;
+	if (count > 1)
+	{
+		ndSort<ndContact*, CompareContacts>(&m_contactArray[start], count);
 	}
 }
 
@@ -1268,22 +1396,21 @@ void ndScene::InitBodyArray()
 		virtual void Execute()
 		{
 			D_TRACKTIME();
+			const ndArray<ndBodyKinematic*>& awakeBodyArray = m_owner->m_awakeBodyArray;
 			ndArray<ndBodyKinematic*>& activeBodyArray = m_owner->m_activeBodyArray;
 
 			const ndInt32 threadIndex = GetThreadId();
-			const ndBodyListRun& run = m_owner->m_bodyListRuns[GetThreadId()];
-
 			ndBodyInfo& info = *((ndBodyInfo*)m_context);
 			ndInt32* const scan = &info.m_scan[threadIndex][0];
 			scan[0] = 0;
 			scan[1] = 0;
 
 			const ndFloat32 timestep = m_timestep;
-			ndBodyList::ndNode* node = run.m_begin;
-			for (ndInt32 i = 0; i < run.m_count; ++i)
+			const ndStartEnd startEnd(awakeBodyArray.GetCount(), threadIndex, m_owner->GetThreadCount());
+			for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
 			{
-				ndBodyKinematic* const body = node->GetInfo();
-				node = node->GetNext();
+				ndBodyKinematic* const body = awakeBodyArray[i];
+				dAssert(!body->m_sleepingIsland);
 				dAssert (!body->GetCollisionShape().GetShape()->GetAsShapeNull());
 				bool inScene = true;
 				if (!body->GetSceneBodyNode())
@@ -1294,9 +1421,8 @@ void ndScene::InitBodyArray()
 				dAssert(inScene && body->m_sceneNode);
 
 				body->ApplyExternalForces(threadIndex, timestep);
-				const ndInt32 index = i + run.m_start;
-				body->PrepareStep(index);
-				activeBodyArray[index] = body;
+				body->PrepareStep(i);
+				activeBodyArray[i] = body;
 
 				const ndInt32 key = body->m_equilibrium;
 				scan[key] ++;
@@ -1318,14 +1444,13 @@ void ndScene::InitBodyArray()
 			ndBodyKinematic** const sceneBodyArray = &m_owner->m_sceneBodyArray[0];
 
 			const ndInt32 threadIndex = GetThreadId();
-			const ndBodyListRun& run = m_owner->m_bodyListRuns[GetThreadId()];
-
 			ndBodyInfo& info = *((ndBodyInfo*)m_context);
 			ndInt32* const scan = &info.m_scan[threadIndex][0];
 
-			for (ndInt32 i = 0; i < run.m_count; ++i)
+			const ndStartEnd startEnd(activeBodyArray.GetCount(), threadIndex, m_owner->GetThreadCount());
+			for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
 			{
-				ndBodyKinematic* const body = activeBodyArray[i + run.m_start];
+				ndBodyKinematic* const body = activeBodyArray[i];
 				const ndInt32 key = body->m_equilibrium;
 				const ndInt32 index = scan[key];
 				sceneBodyArray[index] = body;
@@ -1334,44 +1459,14 @@ void ndScene::InitBodyArray()
 		}
 	};
 
-	if (m_bodyListChanged || (m_currentThreadsMem != GetThreadCount()))
+	if (m_bodyListChanged)
 	{
 		m_bodyListChanged = 0;
-		const ndInt32 threadCount = GetThreadCount();
-		if (m_bodyList.GetCount() < (2 * threadCount))
-		{
-			for (ndInt32 i = 0; i < threadCount; ++i)
-			{
-				m_bodyListRuns[i].m_count = 0;
-				m_bodyListRuns[i].m_start = 0;
-				m_bodyListRuns[i].m_begin = nullptr;
-			}
-			m_bodyListRuns[0].m_count = m_bodyList.GetCount();
-			m_bodyListRuns[0].m_begin = m_bodyList.GetFirst();
-		}
-		else
-		{
-			ndInt32 start = 0;
-			ndInt32 count = m_bodyList.GetCount() / threadCount;
-			ndBodyList::ndNode* node = m_bodyList.GetFirst();
-			for (ndInt32 i = 0; i < threadCount; ++i)
-			{
-				m_bodyListRuns[i].m_start = start;
-				m_bodyListRuns[i].m_count = count;
-				start += count;
-				m_bodyListRuns[i].m_begin = node;
-				for (ndInt32 j = 0; j < count; ++j)
-				{
-					node = node->GetNext();
-				}
-			}
-			m_bodyListRuns[threadCount - 1].m_count = m_bodyList.GetCount() - m_bodyListRuns[threadCount - 1].m_start;
-		}
-		m_currentThreadsMem = ndInt8(GetThreadCount());
+		BuildAwakeBodyArray();
 	}
 
 	ndBodyInfo info;
-	m_activeBodyArray.SetCount(m_bodyList.GetCount());
+	m_activeBodyArray.SetCount(m_awakeBodyArray.GetCount());
 	SubmitJobs<ndBuildBodyArray>(&info);
 
 	ndInt32 sum = 0;
@@ -1387,11 +1482,420 @@ void ndScene::InitBodyArray()
 	}
 
 	ndInt32 movingBodyCount = info.m_scan[0][1] - info.m_scan[0][0];
-	m_sceneBodyArray.SetCount(m_bodyList.GetCount());
+	m_sceneBodyArray.SetCount(m_activeBodyArray.GetCount());
 	SubmitJobs<ndClassifyMovingBodies>(&info);
 	m_sceneBodyArray.SetCount(movingBodyCount);
 }
 
+void ndScene::BuildAwakeBodyArray()
+{
+	D_TRACKTIME();
+	ndInt32 count = 0;
+	m_awakeBodyArray.SetCount(m_bodyList.GetCount());
+	for (ndBodyList::ndNode* node = m_bodyList.GetFirst(); node; node = node->GetNext())
+	{
+		ndBodyKinematic* const body = node->GetInfo();
+		if (!body->m_sleepingIsland)
+		{
+			m_awakeBodyArray[count] = body;
+			count++;
+		}
+	}
+	m_awakeBodyArray.SetCount(count);
+}
+
+void ndScene::SetSleepingIslands(bool state)
+{
+	if (!state)
+	{
+		WakeSleepingIslands();
+	}
+	m_sleepingIslands = state ? 1 : 0;
+}
+
+void ndScene::SetContactEvents(bool state)
+{
+	if (state != GetContactEvents())
+	{
+		// pairs already touching report a begin event when the events are enabled.
+		for (ndBodyList::ndNode* node = m_bodyList.GetFirst(); node; node = node->GetNext())
+		{
+			ndBodyKinematic::ndContactMap::Iterator it(node->GetInfo()->GetContactMap());
+			for (it.Begin(); it; it++)
+			{
+				ndContact* const contact = *it;
+				contact->m_isTouching = 0;
+			}
+		}
+		m_contactEventArray.SetCount(0);
+		for (ndInt32 i = 0; i < D_MAX_THREADS_COUNT; ++i)
+		{
+			m_contactEventBuffer[i].SetCount(0);
+		}
+	}
+	m_contactEvents = state ? 1 : 0;
+}
+
+void ndScene::UpdateContactEvents()
+{
+	D_TRACKTIME();
+	class ndCollectContactEvents : public ndBaseJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			const ndInt32 threadIndex = GetThreadId();
+			const ndContactArray& contactArray = m_owner->m_contactArray;
+			ndArray<ndContactEvent>& events = m_owner->m_contactEventBuffer[threadIndex];
+			const ndStartEnd startEnd(contactArray.GetCount(), threadIndex, m_owner->GetThreadCount());
+			for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+			{
+				ndContact* const contact = contactArray[i];
+				const ndUnsigned32 touching = (!contact->m_isDead && contact->IsActive() && contact->m_maxDOF) ? 1 : 0;
+				if (touching | contact->m_isTouching)
+				{
+					ndContactEvent event;
+					event.m_body0 = contact->GetBody0();
+					event.m_body1 = contact->GetBody1();
+					event.m_normalImpulse = ndFloat32(0.0f);
+					event.m_relativeSpeed = ndFloat32(0.0f);
+					event.m_type = touching ? (contact->m_isTouching ? ndContactEvent::m_persist : ndContactEvent::m_begin) : ndContactEvent::m_end;
+
+					const ndContactPointList& contactPoints = contact->GetContactPoints();
+					for (ndContactPointList::ndNode* node = touching ? contactPoints.GetFirst() : nullptr; node; node = node->GetNext())
+					{
+						const ndContactMaterial& contactPoint = node->GetInfo();
+						const ndVector veloc(event.m_body1->GetVelocityAtPoint(contactPoint.m_point) - event.m_body0->GetVelocityAtPoint(contactPoint.m_point));
+						event.m_normalImpulse += contactPoint.m_normal_Force.m_impact;
+						event.m_relativeSpeed = dMax(event.m_relativeSpeed, veloc.DotProduct(veloc).GetScalar());
+					}
+					event.m_relativeSpeed = ndSqrt(event.m_relativeSpeed);
+					contact->m_isTouching = touching;
+					events.PushBack(event);
+				}
+			}
+		}
+	};
+
+	class CompareEvents
+	{
+		public:
+		ndInt32 Compare(const ndContactEvent& eventA, const ndContactEvent& eventB, void* const) const
+		{
+			const ndUnsigned64 keyA = (ndUnsigned64(eventA.m_body0->GetId()) << 32) + eventA.m_body1->GetId();
+			const ndUnsigned64 keyB = (ndUnsigned64(eventB.m_body0->GetId()) << 32) + eventB.m_body1->GetId();
+			if (keyA < keyB)
+			{
+				return -1;
+			}
+			else if (keyA > keyB)
+			{
+				return 1;
+			}
+			return 0;
+		}
+	};
+
+	if (m_contactEvents)
+	{
+		SubmitJobs<ndCollectContactEvents>();
+
+		// merge the thread buffers, the end events of the 
+		// contacts freed by CalculateContacts are also there.
+		const ndInt32 start = m_contactEventArray.GetCount();
+		const ndInt32 threadCount = GetThreadCount();
+		for (ndInt32 i = 0; i < threadCount; ++i)
+		{
+			ndArray<ndContactEvent>& events = m_contactEventBuffer[i];
+			for (ndInt32 j = 0; j < events.GetCount(); ++j)
+			{
+				m_contactEventArray.PushBack(events[j]);
+			}
+			events.SetCount(0);
+		}
+
+		const ndInt32 count = m_contactEventArray.GetCount() - start;
+		if (m_deterministic && (count > 1))
+		{
+			ndSort<ndContactEvent, CompareEvents>(&m_contactEventArray[start], count);
+		}
+	}
+}
+
+void ndScene::WakeSleepingIsland(ndBodyKinematic* const body)
+{
+	// called from the body setters and from the collision update, 
+	// the island is moved to the awake set at a safe point of the update.
+	ndScopeSpinLock lock(m_lock);
+	if (body->m_sleepingIsland && !body->m_sleepingIslandMark)
+	{
+		body->m_sleepingIslandMark = 1;
+		m_wakeUpArray.PushBack(body);
+	}
+}
+
+void ndScene::WakeSleepingIslands()
+{
+	D_TRACKTIME();
+	if (m_sleepingBodyCount)
+	{
+		for (ndBodyList::ndNode* node = m_bodyList.GetFirst(); node; node = node->GetNext())
+		{
+			ndBodyKinematic* const body = node->GetInfo();
+			if (body->m_sleepingIsland)
+			{
+				WakeIsland(body, false);
+			}
+		}
+	}
+	dAssert(!m_sleepingBodyCount);
+	dAssert(!m_sleepingContactCount);
+	m_wakeUpArray.SetCount(0);
+}
+
+void ndScene::WakeRequestedIslands(bool addToActiveArrays)
+{
+	D_TRACKTIME();
+	class CompareBodies
+	{
+		public:
+		ndInt32 Compare(ndBodyKinematic* const bodyA, ndBodyKinematic* const bodyB, void* const) const
+		{
+			const ndUnsigned32 idA = bodyA->GetId();
+			const ndUnsigned32 idB = bodyB->GetId();
+			if (idA < idB)
+			{
+				return -1;
+			}
+			else if (idA > idB)
+			{
+				return 1;
+			}
+			return 0;
+		}
+	};
+
+	// the requests are pushed by concurrent threads, 
+	// they are sorted so that the wake order is deterministic.
+	if (m_wakeUpArray.GetCount() > 1)
+	{
+		ndSort<ndBodyKinematic*, CompareBodies>(&m_wakeUpArray[0], m_wakeUpArray.GetCount());
+	}
+	for (ndInt32 i = 0; i < m_wakeUpArray.GetCount(); ++i)
+	{
+		ndBodyKinematic* const body = m_wakeUpArray[i];
+		if (body->m_sleepingIsland)
+		{
+			WakeIsland(body, addToActiveArrays);
+		}
+	}
+	m_wakeUpArray.SetCount(0);
+}
+
+void ndScene::WakeIsland(ndBodyKinematic* const body, bool addToActiveArrays)
+{
+	dAssert(body->m_sleepingIsland);
+	body->m_sleepingIsland = 0;
+	body->m_sleepingIslandMark = 1;
+	m_bodyListChanged = 1;
+	m_scratchBuffer.SetCount(0);
+	m_scratchBuffer.PushBack(body);
+
+	// the island is traversed over the same connections that 
+	// made it go to sleep, and its contacts go back to the contact array.
+	for (ndInt32 i = 0; i < m_scratchBuffer.GetCount(); ++i)
+	{
+		ndBodyKinematic* const member = (ndBodyKinematic*)m_scratchBuffer[i];
+		m_sleepingBodyCount--;
+
+		if (addToActiveArrays)
+		{
+			// the island wakes after the body array was build, 
+			// the body catches up with the work it skipped.
+			member->ApplyExternalForces(0, m_timestep);
+			member->PrepareStep(m_activeBodyArray.GetCount());
+			m_activeBodyArray.PushBack(member);
+		}
+
+		ndBodyKinematic::ndContactMap::Iterator it(member->m_contactList);
+		for (it.Begin(); it; it++)
+		{
+			ndContact* const contact = *it;
+			ndBodyKinematic* const otherBody = (contact->GetBody0() == member) ? contact->GetBody1() : contact->GetBody0();
+			if (otherBody->m_sleepingIsland && contact->IsActive())
+			{
+				otherBody->m_sleepingIsland = 0;
+				otherBody->m_sleepingIslandMark = 1;
+				m_scratchBuffer.PushBack(otherBody);
+			}
+
+			if (contact->m_sleepingIsland)
+			{
+				contact->m_sleepingIsland = 0;
+				m_sleepingContactCount--;
+				m_contactArray.PushBack(contact);
+			}
+
+			// none of the contacts of the island were classified as active, 
+			// the ones between two members of the island are visited twice.
+			const bool isNewContact = !otherBody->m_sleepingIslandMark || (contact->GetBody0() == member);
+			if (addToActiveArrays && isNewContact && contact->IsActive() && contact->m_maxDOF)
+			{
+				m_activeConstraintArray.PushBack(contact);
+			}
+		}
+
+		for (ndJointList::ndNode* node = member->m_jointList.GetFirst(); node; node = node->GetNext())
+		{
+			ndJointBilateralConstraint* const joint = node->GetInfo();
+			ndBodyKinematic* const otherBody = (joint->GetBody0() == member) ? joint->GetBody1() : joint->GetBody0();
+			if (otherBody->m_sleepingIsland)
+			{
+				otherBody->m_sleepingIsland = 0;
+				otherBody->m_sleepingIslandMark = 1;
+				m_scratchBuffer.PushBack(otherBody);
+			}
+		}
+	}
+
+	for (ndInt32 i = 0; i < m_scratchBuffer.GetCount(); ++i)
+	{
+		ndBodyKinematic* const member = (ndBodyKinematic*)m_scratchBuffer[i];
+		member->m_sleepingIslandMark = 0;
+	}
+}
+
+void ndScene::UpdateSleepingIslands()
+{
+	D_TRACKTIME();
+	if (m_wakeUpArray.GetCount())
+	{
+		WakeRequestedIslands(false);
+	}
+
+	if (!m_sleepingIslands)
+	{
+		return;
+	}
+
+	if (m_bodyListChanged)
+	{
+		m_bodyListChanged = 0;
+		BuildAwakeBodyArray();
+	}
+
+	// an island goes to sleep when all its dynamics bodies are in equilibrium. 
+	// a sleeping island is not part of the body, contact and solver arrays, 
+	// so it costs nothing until something wakes it up.
+	ndInt32 sleepingBodyCount = 0;
+	m_scratchBuffer.SetCount(0);
+	for (ndInt32 i = 0; i < m_awakeBodyArray.GetCount(); ++i)
+	{
+		ndBodyKinematic* const body = m_awakeBodyArray[i];
+		if (!(body->m_equilibrium & body->m_isDynamics) || body->m_sleepingIslandMark || (body->m_invMass.m_w == ndFloat32(0.0f)))
+		{
+			continue;
+		}
+
+		bool isResting = true;
+		const ndInt32 start = m_scratchBuffer.GetCount();
+		body->m_sleepingIslandMark = 1;
+		m_scratchBuffer.PushBack(body);
+		for (ndInt32 j = start; j < m_scratchBuffer.GetCount(); ++j)
+		{
+			ndBodyKinematic* const member = (ndBodyKinematic*)m_scratchBuffer[j];
+			isResting = isResting && member->m_equilibrium && member->m_isDynamics && !member->m_skeletonContainer && !member->m_spetialUpdateNode;
+
+			ndBodyKinematic::ndContactMap::Iterator it(member->m_contactList);
+			for (it.Begin(); it; it++)
+			{
+				const ndContact* const contact = *it;
+				ndBodyKinematic* const otherBody = (contact->GetBody0() == member) ? contact->GetBody1() : contact->GetBody0();
+				// an island near a moving body stays awake
+				isResting = isResting && otherBody->m_equilibrium;
+				if (contact->IsActive() && !(otherBody->m_sleepingIsland | otherBody->m_sleepingIslandMark) && (otherBody->m_invMass.m_w > ndFloat32(0.0f)))
+				{
+					otherBody->m_sleepingIslandMark = 1;
+					m_scratchBuffer.PushBack(otherBody);
+				}
+			}
+
+			for (ndJointList::ndNode* node = member->m_jointList.GetFirst(); node; node = node->GetNext())
+			{
+				const ndJointBilateralConstraint* const joint = node->GetInfo();
+				ndBodyKinematic* const otherBody = (joint->GetBody0() == member) ? joint->GetBody1() : joint->GetBody0();
+				if (!(otherBody->m_sleepingIsland | otherBody->m_sleepingIslandMark) && (otherBody->m_invMass.m_w > ndFloat32(0.0f)))
+				{
+					otherBody->m_sleepingIslandMark = 1;
+					m_scratchBuffer.PushBack(otherBody);
+				}
+			}
+		}
+
+		if (isResting)
+		{
+			for (ndInt32 j = start; j < m_scratchBuffer.GetCount(); ++j)
+			{
+				ndBodyKinematic* const member = (ndBodyKinematic*)m_scratchBuffer[j];
+				member->m_sleepingIsland = 1;
+			}
+			sleepingBodyCount += m_scratchBuffer.GetCount() - start;
+		}
+	}
+
+	for (ndInt32 i = m_scratchBuffer.GetCount() - 1; i >= 0; --i)
+	{
+		ndBodyKinematic* const body = (ndBodyKinematic*)m_scratchBuffer[i];
+		body->m_sleepingIslandMark = 0;
+		if (body->m_sleepingIsland)
+		{
+			// only contacts between two sleeping bodies leave the contact array, 
+			// contacts with static and kinematic bodies stay so that they can wake the island.
+			ndBodyKinematic::ndContactMap::Iterator it(body->m_contactList);
+			for (it.Begin(); it; it++)
+			{
+				ndContact* const contact = *it;
+				ndBodyKinematic* const otherBody = (contact->GetBody0() == body) ? contact->GetBody1() : contact->GetBody0();
+				if (!contact->m_sleepingIsland && otherBody->m_sleepingIsland)
+				{
+					contact->m_sleepingIsland = 1;
+					m_sleepingContactCount++;
+				}
+			}
+		}
+	}
+
+	if (sleepingBodyCount)
+	{
+		m_sleepingBodyCount += sleepingBodyCount;
+
+		ndInt32 contactCount = 0;
+		for (ndInt32 i = 0; i < m_contactArray.GetCount(); ++i)
+		{
+			ndContact* const contact = m_contactArray[i];
+			if (!contact->m_sleepingIsland)
+			{
+				m_contactArray[contactCount] = contact;
+				contactCount++;
+			}
+		}
+		m_contactArray.SetCount(contactCount);
+
+		ndInt32 bodyCount = 0;
+		for (ndInt32 i = 0; i < m_awakeBodyArray.GetCount(); ++i)
+		{
+			ndBodyKinematic* const body = m_awakeBodyArray[i];
+			if (!body->m_sleepingIsland)
+			{
+				m_awakeBodyArray[bodyCount] = body;
+				bodyCount++;
+			}
+		}
+		m_awakeBodyArray.SetCount(bodyCount);
+	}
+}
+
 void ndScene::CalculateContacts()
 {
 	D_TRACKTIME();
@@ -1399,6 +1903,8 @@ void ndScene::CalculateContacts()
 	{
 		public:
 		ndInt32 m_digitScan[D_MAX_THREADS_COUNT][4];
+		ndInt32 m_deadStart;
+		ndInt32 m_deadCount;
 	};
 
 	class ndCalculateContacts : public ndBaseJob
@@ -1429,12 +1935,13 @@ void ndScene::CalculateContacts()
 			{
 				ndContact* const contact = activeContacts[i]->GetAsContact();
 				dAssert(contact);
-				if (!contact->m_isDead)
+				if (!contact->m_isDead && !m_owner->m_contactBinning)
 				{
 					m_owner->CalculateContacts(threadIndex, contact);
 				}
 				dstContacts[i] = contact;
-				const ndInt32 entry = (!contact->IsActive() | !contact->m_maxDOF) + contact->m_isDead * 2;
+				const ndInt32 sleeping = contact->GetBody0()->m_sleepingIsland | contact->GetBody1()->m_sleepingIsland;
+				const ndInt32 entry = (!contact->IsActive() | !contact->m_maxDOF | sleeping) + contact->m_isDead * 2;
 				const ndInt32 key = keyLookUp[entry];
 				scan[key] ++;
 			}
@@ -1464,7 +1971,9 @@ void ndScene::CalculateContacts()
 			for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
 			{
 				ndContact* const contact = srcContacts[i]->GetAsContact();
-				const ndInt32 entry = (!contact->IsActive() | !contact->m_maxDOF) + contact->m_isDead * 2;
+				// contacts of a sleeping body with static bodies are not solved
+				const ndInt32 sleeping = contact->GetBody0()->m_sleepingIsland | contact->GetBody1()->m_sleepingIsland;
+				const ndInt32 entry = (!contact->IsActive() | !contact->m_maxDOF | sleeping) + contact->m_isDead * 2;
 				const ndInt32 key = keyLookUp[entry];
 				const ndInt32 index = scan[key];
 				dstContacts[index] = contact;
@@ -1474,13 +1983,104 @@ void ndScene::CalculateContacts()
 		}
 	};
 
+	class ndWakeBodies : public ndBaseJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			ndContactArray& contactArray = m_owner->m_contactArray;
+			const ndStartEnd startEnd(contactArray.GetCount(), GetThreadId(), m_owner->GetThreadCount());
+			for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+			{
+				ndContact* const contact = contactArray[i];
+				if (contact->m_wakeBodies)
+				{
+					ndBodyKinematic* const body0 = contact->GetBody0();
+					ndBodyKinematic* const body1 = contact->GetBody1();
+					dAssert(body0->GetInvMass() > ndFloat32(0.0f));
+					contact->m_wakeBodies = 0;
+					body0->WakeUp();
+					if (body1->GetInvMass() > ndFloat32(0.0f))
+					{
+						body1->WakeUp();
+					}
+				}
+			}
+		}
+	};
+
+	class ndMarkDeadContacts : public ndBaseJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			ndContactInfo& info = *((ndContactInfo*)m_context);
+			ndContactArray& contactArray = m_owner->m_contactArray;
+			const ndInt32 start = info.m_deadStart;
+			const ndStartEnd startEnd(info.m_deadCount, GetThreadId(), m_owner->GetThreadCount());
+			for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+			{
+				ndContact* const contact = contactArray[start + i];
+				if (contact->m_isAttached)
+				{
+					const ndBodyKinematic* const body0 = contact->GetBody0();
+					const ndBodyKinematic* const body1 = contact->GetBody1();
+					contact->m_wakeBodies = (body0->m_equilibrium & body1->m_equilibrium) ? 0 : 1;
+				}
+			}
+		}
+	};
+
+	class ndFreeDeadContacts : public ndBaseJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			ndContactInfo& info = *((ndContactInfo*)m_context);
+			ndContactArray& contactArray = m_owner->m_contactArray;
+			const ndInt32 threadIndex = GetThreadId();
+			const ndInt32 start = info.m_deadStart;
+			const ndStartEnd startEnd(info.m_deadCount, threadIndex, m_owner->GetThreadCount());
+			for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+			{
+				ndContact* const contact = contactArray[start + i];
+				if (contact->m_isAttached)
+				{
+					if (contact->m_isTouching & m_owner->m_contactEvents)
+					{
+						ndContactEvent event;
+						event.m_body0 = contact->GetBody0();
+						event.m_body1 = contact->GetBody1();
+						event.m_normalImpulse = ndFloat32(0.0f);
+						event.m_relativeSpeed = ndFloat32(0.0f);
+						event.m_type = ndContactEvent::m_end;
+						m_owner->m_contactEventBuffer[threadIndex].PushBack(event);
+					}
+					contact->DetachBodies();
+				}
+				contactArray.FreeContact(threadIndex, contact);
+			}
+		}
+	};
+
 	m_activeConstraintArray.SetCount(0);
 	if (m_contactArray.GetCount())
 	{
 		ndContactInfo info;
 		m_scratchBuffer.SetCount(m_contactArray.GetCount());
 		m_activeConstraintArray.SetCount(m_contactArray.GetCount());
+		if (m_contactBinning)
+		{
+			CalculateBinnedContacts();
+		}
 		SubmitJobs<ndCalculateContacts>(&info);
+		if (m_deterministic)
+		{
+			SubmitJobs<ndWakeBodies>();
+		}
 
 		ndInt32 sum = 0;
 		ndInt32 threadCount = GetThreadCount();
@@ -1501,15 +2101,13 @@ void ndScene::CalculateContacts()
 		SubmitJobs<ndClasifyContacts>(&info);
 		if (deadContacts)
 		{
-			D_TRACKTIME();
-			// this could be parallelized, monitor it to see if is worth doing it.
-			const ndInt32 start = activeJoints + inactiveJoints;
-			for (ndInt32 i = 0; i < deadContacts; i++)
-			{
-				ndContact* const contact = m_contactArray[start + i];
-				m_contactArray.DeleteContact(contact);
-				delete contact;
-			}
+			// all dead contacts read the body states before any of them is detached, 
+			// so the result does not depend on the order or the thread count.
+			info.m_deadStart = activeJoints + inactiveJoints;
+			info.m_deadCount = deadContacts;
+			SubmitJobs<ndMarkDeadContacts>(&info);
+			SubmitJobs<ndFreeDeadContacts>(&info);
+			m_contactArray.TrimFreeLists(GetThreadCount());
 		}
 
 		m_activeConstraintArray.SetCount(activeJoints);
@@ -1517,7 +2115,7 @@ void ndScene::CalculateContacts()
 	}
 }
 
-void ndScene::FindCollidingPairs(ndBodyKinematic* const body)
+void ndScene::FindCollidingPairs(ndInt32 threadIndex, ndBodyKinematic* const body)
 {
 	ndSceneBodyNode* const bodyNode = body->GetSceneBodyNode();
 	for (ndSceneNode* ptr = bodyNode; ptr->m_parent; ptr = ptr->m_parent)
@@ -1527,12 +2125,12 @@ void ndScene::FindCollidingPairs(ndBodyKinematic* const body)
 		ndSceneNode* const sibling = parent->m_right;
 		if (sibling != ptr)
 		{
-			SubmitPairs(bodyNode, sibling);
+			SubmitPairs(threadIndex, bodyNode, sibling);
 		}
 	}
 }
 
-void ndScene::FindCollidingPairsForward(ndBodyKinematic* const body)
+void ndScene::FindCollidingPairsForward(ndInt32 threadIndex, ndBodyKinematic* const body)
 {
 	ndSceneBodyNode* const bodyNode = body->GetSceneBodyNode();
 	for (ndSceneNode* ptr = bodyNode; ptr->m_parent; ptr = ptr->m_parent)
@@ -1542,12 +2140,12 @@ void ndScene::FindCollidingPairsForward(ndBodyKinematic* const body)
 		ndSceneNode* const sibling = parent->m_right;
 		if (sibling != ptr)
 		{
-			SubmitPairs(bodyNode, sibling);
+			SubmitPairs(threadIndex, bodyNode, sibling);
 		}
 	}
 }
 
-void ndScene::FindCollidingPairsBackward(ndBodyKinematic* const body)
+void ndScene::FindCollidingPairsBackward(ndInt32 threadIndex, ndBodyKinematic* const body)
 {
 	ndSceneBodyNode* const bodyNode = body->GetSceneBodyNode();
 	for (ndSceneNode* ptr = bodyNode; ptr->m_parent; ptr = ptr->m_parent)
@@ -1557,7 +2155,7 @@ void ndScene::FindCollidingPairsBackward(ndBodyKinematic* const body)
 		ndSceneNode* const sibling = parent->m_left;
 		if (sibling != ptr)
 		{
-			SubmitPairs(bodyNode, sibling);
+			SubmitPairs(threadIndex, bodyNode, sibling);
 		}
 	}
 }
@@ -1571,12 +2169,13 @@ void ndScene::FindCollidingPairs()
 		virtual void Execute()
 		{
 			D_TRACKTIME();
+			const ndInt32 threadIndex = GetThreadId();
 			const ndArray<ndBodyKinematic*>& bodyArray = m_owner->GetActiveBodyArray();
-			const ndStartEnd startEnd(bodyArray.GetCount() - 1, GetThreadId(), m_owner->GetThreadCount());
+			const ndStartEnd startEnd(bodyArray.GetCount() - 1, threadIndex, m_owner->GetThreadCount());
 			for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
 			{
 				ndBodyKinematic* const body = bodyArray[i];
-				m_owner->FindCollidingPairs(body);
+				m_owner->FindCollidingPairs(threadIndex, body);
 			}
 		}
 	};
@@ -1587,13 +2186,13 @@ void ndScene::FindCollidingPairs()
 		virtual void Execute()
 		{
 			D_TRACKTIME();
-
+			const ndInt32 threadIndex = GetThreadId();
 			const ndArray<ndBodyKinematic*>& bodyArray = m_owner->m_sceneBodyArray;
-			const ndStartEnd startEnd(bodyArray.GetCount(), GetThreadId(), m_owner->GetThreadCount());
+			const ndStartEnd startEnd(bodyArray.GetCount(), threadIndex, m_owner->GetThreadCount());
 			for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
 			{
 				ndBodyKinematic* const body = bodyArray[i];
-				m_owner->FindCollidingPairsForward(body);
+				m_owner->FindCollidingPairsForward(threadIndex, body);
 			}
 		}
 	};
@@ -1604,13 +2203,13 @@ void ndScene::FindCollidingPairs()
 		virtual void Execute()
 		{
 			D_TRACKTIME();
-
+			const ndInt32 threadIndex = GetThreadId();
 			const ndArray<ndBodyKinematic*>& bodyArray = m_owner->m_sceneBodyArray;
-			const ndStartEnd startEnd(bodyArray.GetCount(), GetThreadId(), m_owner->GetThreadCount());
+			const ndStartEnd startEnd(bodyArray.GetCount(), threadIndex, m_owner->GetThreadCount());
 			for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
 			{
 				ndBodyKinematic* const body = bodyArray[i];
-				m_owner->FindCollidingPairsBackward(body);
+				m_owner->FindCollidingPairsBackward(threadIndex, body);
 			}
 		}
 	};
@@ -1629,7 +2228,10 @@ void ndScene::FindCollidingPairs()
 	m_sceneBodyArray.SetCount(count);
 #endif
 	
-	bool fullScan = (3 * m_sceneBodyArray.GetCount()) > m_activeBodyArray.GetCount();
+	const ndInt32 contactCount = m_contactArray.GetCount();
+	// the full scan only finds the pairs of a body from one side of the tree, 
+	// sleeping bodies are not in the active array so it can not be used with them.
+	bool fullScan = !m_sleepingBodyCount && ((3 * m_sceneBodyArray.GetCount()) > m_activeBodyArray.GetCount());
 
 	// uncomment line below to test full versus partial scan
 	//fullScan = true;
@@ -1642,6 +2244,13 @@ void ndScene::FindCollidingPairs()
 		SubmitJobs<ndFindCollidindPairsForward>();
 		SubmitJobs<ndFindCollidindPairsBackward>();
 	}
+
+	// the new contacts are buffered by each thread
+	m_contactArray.AddNewContacts(GetThreadCount());
+	if (m_deterministic)
+	{
+		SortNewContacts(contactCount);
+	}
 }
 
 void ndScene::UpdateTransform()
@@ -1736,11 +2345,20 @@ void ndScene::CalculateContacts(ndInt32 threadIndex, ndContact* const contact)
 
 		if (active ^ contact->IsActive())
 		{
-			dAssert(body0->GetInvMass() > ndFloat32(0.0f));
-			body0->m_equilibrium = 0;
-			if (body1->GetInvMass() > ndFloat32(0.0f))
+			if (m_deterministic)
+			{
+				// other contacts are reading the equilibrium state of these bodies 
+				// concurrently, in deterministic mode they are woken after the update.
+				contact->m_wakeBodies = 1;
+			}
+			else
 			{
-				body1->m_equilibrium = 0;
+				dAssert(body0->GetInvMass() > ndFloat32(0.0f));
+				body0->WakeUp();
+				if (body1->GetInvMass() > ndFloat32(0.0f))
+				{
+					body1->WakeUp();
+				}
 			}
 		}
 	}
@@ -1758,6 +2376,150 @@ void ndScene::CalculateContacts(ndInt32 threadIndex, ndContact* const contact)
 			contact->m_isDead = 1;
 		}
 	}
+
+	if ((body0->m_sleepingIsland | body1->m_sleepingIsland) && contact->IsActive() && !(body0->m_equilibrium & body1->m_equilibrium))
+	{
+		// a moving body is touching a sleeping island.
+		WakeSleepingIsland(body0->m_sleepingIsland ? body0 : body1);
+	}
+}
+
+ndScene::ndContactPairClass ndScene::GetContactPairClass(const ndContact* const contact) const
+{
+	const ndBodyKinematic* const body0 = contact->GetBody0();
+	const ndBodyKinematic* const body1 = contact->GetBody1();
+	if (contact->m_isDead || (body0->m_equilibrium & body1->m_equilibrium))
+	{
+		return m_restingPair;
+	}
+
+	ndShape* const shape0 = (ndShape*)body0->GetCollisionShape().GetShape();
+	ndShape* const shape1 = (ndShape*)body1->GetCollisionShape().GetShape();
+	if (shape0->GetAsShapeCompound() || shape1->GetAsShapeCompound())
+	{
+		return m_compoundPair;
+	}
+	if (!shape0->GetAsShapeConvex() || !shape1->GetAsShapeConvex())
+	{
+		return m_staticMeshPair;
+	}
+
+	const bool box0 = shape0->GetAsShapeBox() ? true : false;
+	const bool box1 = shape1->GetAsShapeBox() ? true : false;
+	const bool sphere0 = shape0->GetAsShapeSphere() ? true : false;
+	const bool sphere1 = shape1->GetAsShapeSphere() ? true : false;
+	const bool capsule0 = shape0->GetAsShapeCapsule() ? true : false;
+	const bool capsule1 = shape1->GetAsShapeCapsule() ? true : false;
+	if (sphere0 & sphere1)
+	{
+		return m_spherePair;
+	}
+	if ((sphere0 | capsule0) & (sphere1 | capsule1))
+	{
+		return (capsule0 & capsule1) ? m_capsulePair : m_sphereCapsulePair;
+	}
+	if ((sphere0 | box0) & (sphere1 | box1))
+	{
+		return (box0 & box1) ? m_boxPair : m_boxSpherePair;
+	}
+	return m_convexPair;
+}
+
+void ndScene::CalculateBinnedContacts()
+{
+	D_TRACKTIME();
+	// the contacts are sorted by pair class into m_contactBins, the class in 
+	// the high bits and the contact index in the low bits. The upper half of 
+	// the array is scratch for the sort, then holds the start of the batches.
+	class ndEvaluateKey
+	{
+		public:
+		ndUnsigned32 GetKey(const ndUnsigned32 item) const
+		{
+			return item >> D_CONTACT_BIN_SHIFT;
+		}
+	};
+
+	class ndBinContacts : public ndBaseJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			const ndContactArray& activeContacts = m_owner->m_contactArray;
+			ndUnsigned32* const bins = &m_owner->m_contactBins[0];
+			const ndStartEnd startEnd(activeContacts.GetCount(), GetThreadId(), m_owner->GetThreadCount());
+			for (ndInt32 i = startEnd.m_start; i < startEnd.m_end; ++i)
+			{
+				const ndContact* const contact = activeContacts[i]->GetAsContact();
+				bins[i] = (ndUnsigned32(m_owner->GetContactPairClass(contact)) << D_CONTACT_BIN_SHIFT) | ndUnsigned32(i);
+			}
+		}
+	};
+
+	class ndBatchInfo
+	{
+		public:
+		const ndUnsigned32* m_batchStart;
+		ndInt32 m_batchCount;
+		ndAtomic<ndInt32> m_index;
+	};
+
+	class ndCalculateBatches : public ndBaseJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			ndBatchInfo& info = *((ndBatchInfo*)m_context);
+			const ndContactArray& activeContacts = m_owner->m_contactArray;
+			const ndUnsigned32* const bins = &m_owner->m_contactBins[0];
+			const ndInt32 threadIndex = GetThreadId();
+			for (ndInt32 i = info.m_index.fetch_add(1); i < info.m_batchCount; i = info.m_index.fetch_add(1))
+			{
+				const ndInt32 start = ndInt32(info.m_batchStart[i]);
+				const ndInt32 end = ndInt32(info.m_batchStart[i + 1]);
+				for (ndInt32 j = start; j < end; ++j)
+				{
+					ndContact* const contact = activeContacts[ndInt32(bins[j] & D_CONTACT_BIN_INDEX_MASK)]->GetAsContact();
+					if (!contact->m_isDead)
+					{
+						m_owner->CalculateContacts(threadIndex, contact);
+					}
+				}
+			}
+		}
+	};
+
+	const ndInt32 contactCount = m_contactArray.GetCount();
+	dAssert(ndUnsigned32(contactCount) <= D_CONTACT_BIN_INDEX_MASK);
+	m_contactBins.SetCount(contactCount * 2 + 1);
+	ndUnsigned32* const bins = &m_contactBins[0];
+	ndUnsigned32* const batchStart = &m_contactBins[contactCount];
+
+	SubmitJobs<ndBinContacts>();
+	CountingSort<ndUnsigned32, 4, ndEvaluateKey>(bins, batchStart, contactCount, 0);
+
+	// each bin is cut in batches of about the same estimated cost, 
+	// the bins of expensive pairs come first, so the cheap batches 
+	// at the end balance the work of the threads.
+	ndInt32 batchCount = 0;
+	for (ndInt32 i = 0; i < contactCount; )
+	{
+		const ndUnsigned32 pairClass = bins[i] >> D_CONTACT_BIN_SHIFT;
+		const ndInt32 batchSize = dMax(D_CONTACT_BIN_BATCH_COST / m_contactPairCost[pairClass], 1);
+		batchStart[batchCount] = ndUnsigned32(i);
+		batchCount++;
+		const ndInt32 end = dMin(i + batchSize, contactCount);
+		for (i++; (i < end) && ((bins[i] >> D_CONTACT_BIN_SHIFT) == pairClass); i++);
+	}
+	batchStart[batchCount] = ndUnsigned32(contactCount);
+
+	ndBatchInfo info;
+	info.m_batchStart = batchStart;
+	info.m_batchCount = batchCount;
+	info.m_index.store(0);
+	SubmitJobs<ndCalculateBatches>(&info);
 }
 
 void ndScene::UpdateSpecial()
@@ -2004,12 +2766,25 @@ void ndScene::Cleanup()
 	m_sceneBodyArray.Resize(1024);
 	m_activeBodyArray.Resize(1024);
 	m_activeConstraintArray.Resize(1024);
+	m_awakeBodyArray.Resize(1024);
+	m_wakeUpArray.Resize(256);
 
 	m_contactArray.SetCount(0);
 	m_scratchBuffer.SetCount(0);
 	m_sceneBodyArray.SetCount(0);
 	m_activeBodyArray.SetCount(0);
 	m_activeConstraintArray.SetCount(0);
+	m_awakeBodyArray.SetCount(0);
+	m_wakeUpArray.SetCount(0);
+	m_contactEventArray.SetCount(0);
+	for (ndInt32 i = 0; i < D_MAX_THREADS_COUNT; ++i)
+	{
+		m_contactEventBuffer[i].SetCount(0);
+	}
+	dAssert(!m_sleepingBodyCount);
+	dAssert(!m_sleepingContactCount);
+	m_sleepingBodyCount = 0;
+	m_sleepingContactCount = 0;
 }
 
 void ndScene::AddNode(ndSceneNode* const newNode)
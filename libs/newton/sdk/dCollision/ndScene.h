@@ -68,6 +68,21 @@ class ndScene : public ndThreadPool
 	};
 
 	protected:
+	// the narrow phase bins, sorted from the most to the least expensive pairs
+	enum ndContactPairClass
+	{
+		m_compoundPair,
+		m_staticMeshPair,
+		m_convexPair,
+		m_boxPair,
+		m_boxSpherePair,
+		m_capsulePair,
+		m_sphereCapsulePair,
+		m_spherePair,
+		m_restingPair,
+		m_contactPairClassCount,
+	};
+
 	class ndSpliteInfo;
 	class ndFitnessList: public ndList <ndSceneTreeNode*, ndContainersFreeListAlloc<ndSceneTreeNode*>>
 	{
@@ -107,6 +122,33 @@ class ndScene : public ndThreadPool
 	ndFloat32 GetTimestep() const;
 	void SetTimestep(ndFloat32 timestep);
 
+	bool GetSpeculativeContacts() const;
+	void SetSpeculativeContacts(bool state);
+
+	bool GetDeterministic() const;
+	void SetDeterministic(bool state);
+
+	// when enabled, the narrow phase groups the contacts by the classes of the 
+	// two shapes and calculates each group as its own parallel batch.
+	bool GetContactBinning() const;
+	void SetContactBinning(bool state);
+
+	// off by default, when enabled the bodies of resting islands leave 
+	// the active arrays until something touches them.
+	bool GetSleepingIslands() const;
+	D_COLLISION_API void SetSleepingIslands(bool state);
+	ndInt32 GetSleepingBodyCount() const;
+	ndInt32 GetSleepingContactCount() const;
+
+	// when enabled, the begin, persist and end of each touching pair is 
+	// recorded after the solver, the array holds the events of the last update.
+	bool GetContactEvents() const;
+	D_COLLISION_API void SetContactEvents(bool state);
+	const ndArray<ndContactEvent>& GetContactEventArray() const;
+
+	D_COLLISION_API void WakeSleepingIslands();
+	D_COLLISION_API void WakeSleepingIsland(ndBodyKinematic* const body);
+
 	D_COLLISION_API virtual bool AddBody(ndBodyKinematic* const body);
 	D_COLLISION_API virtual bool RemoveBody(ndBodyKinematic* const body);
 
@@ -126,9 +168,9 @@ class ndScene : public ndThreadPool
 	bool ValidateContactCache(ndContact* const contact, const ndVector& timestep) const;
 	ndFloat32 CalculateSurfaceArea(const ndSceneNode* const node0, const ndSceneNode* const node1, ndVector& minBox, ndVector& maxBox) const;
 
-	D_COLLISION_API virtual void FindCollidingPairs(ndBodyKinematic* const body);
-	D_COLLISION_API virtual void FindCollidingPairsForward(ndBodyKinematic* const body);
-	D_COLLISION_API virtual void FindCollidingPairsBackward(ndBodyKinematic* const body);
+	D_COLLISION_API virtual void FindCollidingPairs(ndInt32 threadIndex, ndBodyKinematic* const body);
+	D_COLLISION_API virtual void FindCollidingPairsForward(ndInt32 threadIndex, ndBodyKinematic* const body);
+	D_COLLISION_API virtual void FindCollidingPairsBackward(ndInt32 threadIndex, ndBodyKinematic* const body);
 	void AddNode(ndSceneNode* const newNode);
 	void RemoveNode(ndSceneNode* const newNode);
 
@@ -154,9 +196,16 @@ class ndScene : public ndThreadPool
 	ndJointBilateralConstraint* FindBilateralJoint(ndBodyKinematic* const body0, ndBodyKinematic* const body1) const;
 
 	void UpdateFitness(ndFitnessList& fitness, ndFloat64& oldEntropy, ndSceneNode** const root);
-	void AddPair(ndBodyKinematic* const body0, ndBodyKinematic* const body1);
+	void AddPair(ndInt32 threadIndex, ndBodyKinematic* const body0, ndBodyKinematic* const body1);
 	bool TestOverlaping(const ndBodyKinematic* const body0, const ndBodyKinematic* const body1) const;
-	void SubmitPairs(ndSceneNode* const leaftNode, ndSceneNode* const node);
+	bool IsSpeculative(const ndBodyKinematic* const body) const;
+	ndFloat32 CalculateSpeculativeDistance(const ndContact* const contact) const;
+	ndContactPairClass GetContactPairClass(const ndContact* const contact) const;
+	void CalculateBinnedContacts();
+	void SubmitPairs(ndInt32 threadIndex, ndSceneNode* const leaftNode, ndSceneNode* const node);
+	void SortNewContacts(ndInt32 start);
+	void BuildAwakeBodyArray();
+	void WakeIsland(ndBodyKinematic* const body, bool addToActiveArrays);
 
 	void BodiesInAabb(ndBodiesInAabbNotify& callback, const ndSceneNode** stackPool, ndInt32 stack) const;
 	bool RayCast(ndRayCastNotify& callback, const ndSceneNode** stackPool, ndFloat32* const distance, ndInt32 stack, const ndFastRay& ray) const;
@@ -170,36 +219,42 @@ class ndScene : public ndThreadPool
 	D_COLLISION_API void UpdateTransform();
 	D_COLLISION_API void CalculateContacts();
 	D_COLLISION_API void FindCollidingPairs();
+	D_COLLISION_API void UpdateSleepingIslands();
+	D_COLLISION_API void UpdateContactEvents();
+	D_COLLISION_API void WakeRequestedIslands(bool addToActiveArrays);
 	D_COLLISION_API virtual void BalanceScene();
 	D_COLLISION_API virtual void ThreadFunction();
 
-	class ndBodyListRun
-	{
-		public:
-		ndBodyList::ndNode* m_begin;
-		ndInt32 m_count;
-		ndInt32 m_start;
-	};
-	
 	ndBodyList m_bodyList;
 	ndContactArray m_contactArray;
 
 	ndArray<void*> m_scratchBuffer;
+	ndArray<ndUnsigned32> m_contactBins;
 	ndArray<ndBodyKinematic*> m_sceneBodyArray;
 	ndArray<ndBodyKinematic*> m_activeBodyArray;
+	ndArray<ndBodyKinematic*> m_awakeBodyArray;
+	ndArray<ndBodyKinematic*> m_wakeUpArray;
 	ndArray<ndConstraint*> m_activeConstraintArray;
+	ndArray<ndContactEvent> m_contactEventArray;
+	ndArray<ndContactEvent> m_contactEventBuffer[D_MAX_THREADS_COUNT];
 	ndList<ndBodyKinematic*> m_specialUpdateList;
 	ndSpinLock m_lock;
-	ndBodyListRun m_bodyListRuns[D_MAX_THREADS_COUNT];
 	ndSceneNode* m_rootNode;
 	ndContactNotify* m_contactNotifyCallback;
 	ndFloat64 m_treeEntropy;
 	ndFitnessList m_fitness;
 	ndFloat32 m_timestep;
 	ndUnsigned32 m_lru;
+	ndInt32 m_sleepingBodyCount;
+	ndInt32 m_sleepingContactCount;
 	ndUnsigned8 m_bodyListChanged;
-	ndUnsigned8 m_currentThreadsMem;
+	ndUnsigned8 m_speculativeContacts;
+	ndUnsigned8 m_deterministic;
+	ndUnsigned8 m_sleepingIslands;
+	ndUnsigned8 m_contactEvents;
+	ndUnsigned8 m_contactBinning;
 
+	static ndInt32 m_contactPairCost[];
 	static ndVector m_velocTol;
 	static ndVector m_linearContactError2;
 	static ndVector m_angularContactError2;
@@ -283,6 +338,61 @@ inline void ndScene::SetTimestep(ndFloat32 timestep)
 	m_timestep = timestep;
 }
 
+inline bool ndScene::GetSpeculativeContacts() const
+{
+	return m_speculativeContacts ? true : false;
+}
+
+inline void ndScene::SetSpeculativeContacts(bool state)
+{
+	m_speculativeContacts = state ? 1 : 0;
+}
+
+inline bool ndScene::GetDeterministic() const
+{
+	return m_deterministic ? true : false;
+}
+
+inline void ndScene::SetDeterministic(bool state)
+{
+	m_deterministic = state ? 1 : 0;
+}
+
+inline bool ndScene::GetContactBinning() const
+{
+	return m_contactBinning ? true : false;
+}
+
+inline void ndScene::SetContactBinning(bool state)
+{
+	m_contactBinning = state ? 1 : 0;
+}
+
+inline bool ndScene::GetSleepingIslands() const
+{
+	return m_sleepingIslands ? true : false;
+}
+
+inline bool ndScene::GetContactEvents() const
+{
+	return m_contactEvents ? true : false;
+}
+
+inline const ndArray<ndContactEvent>& ndScene::GetContactEventArray() const
+{
+	return m_contactEventArray;
+}
+
+inline ndInt32 ndScene::GetSleepingBodyCount() const
+{
+	return m_sleepingBodyCount;
+}
+
+inline ndInt32 ndScene::GetSleepingContactCount() const
+{
+	return m_sleepingContactCount;
+}
+
 inline ndFloat32 ndScene::CalculateSurfaceArea(const ndSceneNode* const node0, const ndSceneNode* const node1, ndVector& minBox, ndVector& maxBox) const
 {
 	minBox = node0->m_minBox.GetMin(node1->m_minBox);
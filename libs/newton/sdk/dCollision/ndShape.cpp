@@ -22,6 +22,7 @@
 #include "ndCoreStdafx.h"
 #include "ndCollisionStdafx.h"
 #include "ndShape.h"
+#include "ndShapeRegistry.h"
 
 ndVector ndShape::m_flushZero(ndFloat32(1.0e-7f));
 
@@ -33,6 +34,7 @@ ndShape::ndShape(ndShapeID id)
 	,m_boxSize(ndVector::m_zero)
 	,m_boxOrigin(ndVector::m_zero)
 	,m_refCount(0)
+	,m_registryKey(0)
 	,m_collisionId(id)
 {
 }
@@ -46,6 +48,7 @@ ndShape::ndShape(const ndShape& source)
 	,m_boxSize(source.m_boxSize)
 	,m_boxOrigin(source.m_boxOrigin)
 	,m_refCount(0)
+	,m_registryKey(0)
 	,m_collisionId(source.m_collisionId)
 {
 }
@@ -53,6 +56,10 @@ ndShape::ndShape(const ndShape& source)
 ndShape::~ndShape()
 {
 	dAssert(m_refCount.load() == 0);
+	if (m_registryKey)
+	{
+		ndShapeRegistry::GetRegistry().Remove(this);
+	}
 }
 
 void ndShape::MassProperties()
@@ -233,6 +233,14 @@ class ndShape: public ndContainersFreeListAlloc<ndShape>
 
 	virtual ndInt32 GetConvexVertexCount() const;
 
+	// hash of the geometry of the shape, shapes with the same hash are interchangeable.
+	// shapes that can change after they are made return zero and are never shared.
+	virtual ndUnsigned64 CalculateHash() const;
+	// compares the data the hash is made from, the registry calls it 
+	// for shapes of the same class with the same hash.
+	virtual bool HasSameGeometry(const ndShape* const other) const;
+	virtual ndUnsigned64 GetSizeInBytes() const;
+
 	ndVector GetObbSize() const;
 	ndVector GetObbOrigin() const;
 	ndFloat32 GetUmbraClipSize() const;
@@ -270,9 +278,12 @@ class ndShape: public ndContainersFreeListAlloc<ndShape>
 	ndVector m_boxSize;
 	ndVector m_boxOrigin;
 	mutable ndAtomic<ndInt32> m_refCount;
+	mutable ndUnsigned64 m_registryKey;
 	ndShapeID m_collisionId;
 	static ndVector m_flushZero;
 
+	friend class ndShapeRegistry;
+
 } D_GCC_NEWTON_ALIGN_32;
 
 inline ndInt32 ndShape::GetConvexVertexCount() const
@@ -280,6 +291,21 @@ inline ndInt32 ndShape::GetConvexVertexCount() const
 	return 0;
 }
 
+inline ndUnsigned64 ndShape::CalculateHash() const
+{
+	return 0;
+}
+
+inline bool ndShape::HasSameGeometry(const ndShape* const) const
+{
+	return false;
+}
+
+inline ndUnsigned64 ndShape::GetSizeInBytes() const
+{
+	return sizeof(ndShape);
+}
+
 inline const ndShape* ndShape::AddRef() const
 {
 	m_refCount.fetch_add(1);
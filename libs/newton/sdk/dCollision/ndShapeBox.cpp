@@ -467,6 +467,11 @@ ndInt32 ndShapeBox::CalculatePlaneIntersection(const ndVector& normal, const ndV
 	return count;
 }
 
+ndUnsigned64 ndShapeBox::GetSizeInBytes() const
+{
+	return sizeof(ndShapeBox);
+}
+
 ndShapeInfo ndShapeBox::GetShapeInfo() const
 {
 	ndShapeInfo info(ndShapeConvex::GetShapeInfo());
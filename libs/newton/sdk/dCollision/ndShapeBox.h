@@ -40,6 +40,7 @@ class ndShapeBox: public ndShapeConvex
 	D_COLLISION_API virtual void MassProperties();
 
 	D_COLLISION_API virtual ndShapeInfo GetShapeInfo() const;
+	D_COLLISION_API virtual ndUnsigned64 GetSizeInBytes() const;
 	D_COLLISION_API virtual void CalculateAabb(const ndMatrix& matrix, ndVector& p0, ndVector& p1) const;
 	D_COLLISION_API virtual ndVector SupportVertexSpecialProjectPoint(const ndVector& point, const ndVector& dir) const;
 	D_COLLISION_API virtual ndVector SupportVertex(const ndVector& dir, ndInt32* const vertexIndex) const;
@@ -61,6 +62,8 @@ class ndShapeBox: public ndShapeConvex
 	static ndConvexSimplexEdge* m_edgeEdgeMap[];
 	static ndConvexSimplexEdge* m_vertexToEdgeMap[];
 
+	friend class ndContactSolver;
+
 } D_GCC_NEWTON_ALIGN_32;
 
 #endif 
@@ -207,6 +207,13 @@ void ndShapeCapsule::Init(ndFloat32 radio0, ndFloat32 radio1, ndFloat32 height)
 	SetVolumeAndCG();
 }
 
+ndUnsigned64 ndShapeCapsule::GetSizeInBytes() const
+{
+	return sizeof(ndShapeCapsule) +
+		ndUnsigned64(m_vertexCount) * sizeof(ndVector) +
+		ndUnsigned64(m_edgeCount) * sizeof(ndConvexSimplexEdge);
+}
+
 ndShapeInfo ndShapeCapsule::GetShapeInfo() const
 {
 	ndShapeInfo info(ndShapeConvex::GetShapeInfo());
@@ -38,6 +38,7 @@ class ndShapeCapsule : public ndShapeConvex
 	D_COLLISION_API void Init (ndFloat32 radio0, ndFloat32 radio1, ndFloat32 height);
 
 	D_COLLISION_API virtual ndShapeInfo GetShapeInfo() const;
+	D_COLLISION_API virtual ndUnsigned64 GetSizeInBytes() const;
 	D_COLLISION_API virtual void CalculateAabb(const ndMatrix& matrix, ndVector& p0, ndVector& p1) const;
 	D_COLLISION_API virtual void DebugShape(const ndMatrix& matrix, ndShapeDebugNotify& debugCallback) const;
 	D_COLLISION_API virtual ndVector SupportVertexSpecialProjectPoint(const ndVector& point, const ndVector& dir) const;
@@ -56,6 +57,8 @@ class ndShapeCapsule : public ndShapeConvex
 	ndFloat32 m_height;
 	ndFloat32 m_radius0;
 	ndFloat32 m_radius1;
+
+	friend class ndContactSolver;
 } D_GCC_NEWTON_ALIGN_32;
 
 #endif 
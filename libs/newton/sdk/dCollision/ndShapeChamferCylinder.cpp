@@ -167,6 +167,11 @@ void ndShapeChamferCylinder::Save(const ndLoadSaveBase::ndSaveDescriptor& desc)
 	xmlSaveParam(childNode, "height", m_height * ndFloat32(2.0f));
 }
 
+ndUnsigned64 ndShapeChamferCylinder::GetSizeInBytes() const
+{
+	return sizeof(ndShapeChamferCylinder);
+}
+
 ndShapeInfo ndShapeChamferCylinder::GetShapeInfo() const
 {
 	ndShapeInfo info(ndShapeConvex::GetShapeInfo());
@@ -177,6 +177,7 @@ ndShapeCompound::ndShapeCompound()
 	,m_root(nullptr)
 	,m_myInstance(nullptr)
 	,m_idIndex(0)
+	,m_revision(0)
 {
 }
 
@@ -189,6 +190,7 @@ ndShapeCompound::ndShapeCompound(const ndShapeCompound& source, const ndShapeIns
 	,m_root(nullptr)
 	,m_myInstance(myInstance)
 	,m_idIndex(0)
+	,m_revision(0)
 {
 	ndTreeArray::Iterator iter(source.m_array);
 	for (iter.Begin(); iter; iter++) 
@@ -287,6 +289,7 @@ ndShapeCompound::ndShapeCompound(const ndLoadSaveBase::ndLoadDescriptor&)
 	,m_root(nullptr)
 	,m_myInstance(nullptr)
 	,m_idIndex(0)
+	,m_revision(0)
 {
 	//do nothing here;
 	//sub shapes will be load in a post process pass,
@@ -824,6 +827,7 @@ ndShapeCompound::ndNodeBase* ndShapeCompound::BuildTopDownBig(ndNodeBase** const
 
 void ndShapeCompound::EndAddRemove()
 {
+	m_revision++;
 	if (m_root) 
 	{
 		//dgScopeSpinLock lock(&m_criticalSectionLock);
@@ -99,6 +99,9 @@ class ndShapeCompound: public ndShape
 	ndNodeBase* m_root;
 	const ndShapeInstance* m_myInstance;
 	ndInt32 m_idIndex;
+	// changes every time the tree is rebuilt, contacts 
+	// use it to know that their cached child pairs are stale.
+	ndUnsigned32 m_revision;
 
 	friend class ndBodyKinematic;
 	friend class ndShapeInstance;
@@ -129,6 +129,11 @@ void ndShapeCone::Init(ndFloat32 radius, ndFloat32 height)
 	SetVolumeAndCG();
 }
 
+ndUnsigned64 ndShapeCone::GetSizeInBytes() const
+{
+	return sizeof(ndShapeCone);
+}
+
 ndShapeInfo ndShapeCone::GetShapeInfo() const
 {
 	ndShapeInfo info(ndShapeConvex::GetShapeInfo());
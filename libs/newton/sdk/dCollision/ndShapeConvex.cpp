@@ -515,7 +515,7 @@ ndInt32 ndShapeConvex::CalculatePlaneIntersection(const ndVector& normal, const
 	dAssert(normal.m_w == ndFloat32(0.0f));
 	if (vertToEdgeMapping) 
 	{
-		ndInt32 edgeIndex;
+		ndInt32 edgeIndex = -1;
 		featureCount = 1;
 		support[0] = SupportVertex(normal, &edgeIndex);
 		edge = vertToEdgeMapping[edgeIndex];
@@ -743,6 +743,42 @@ ndInt32 ndShapeConvex::CalculatePlaneIntersection(const ndVector& normal, const
 	return count;
 }
 
+ndUnsigned64 ndShapeConvex::CalculateHash() const
+{
+	// the vertices of a convex are made from its dimensions, so they are all 
+	// it takes to tell two convex shapes of the same class apart.
+	if (!m_vertex || !m_vertexCount)
+	{
+		return 0;
+	}
+	ndUnsigned64 hash = dCRC64(&m_collisionId, sizeof(m_collisionId), 0);
+	for (ndInt32 i = 0; i < m_vertexCount; i++)
+	{
+		const ndFloat32 point[3] = { m_vertex[i].m_x, m_vertex[i].m_y, m_vertex[i].m_z };
+		hash = dCRC64(point, sizeof(point), hash);
+	}
+	return hash ? hash : 1;
+}
+
+bool ndShapeConvex::HasSameGeometry(const ndShape* const other) const
+{
+	const ndShapeConvex* const convex = ((ndShape*)other)->GetAsShapeConvex();
+	if (!convex || (convex->m_collisionId != m_collisionId) || (convex->m_vertexCount != m_vertexCount))
+	{
+		return false;
+	}
+	for (ndInt32 i = 0; i < m_vertexCount; i++)
+	{
+		const ndVector& p0 = m_vertex[i];
+		const ndVector& p1 = convex->m_vertex[i];
+		if ((p0.m_x != p1.m_x) || (p0.m_y != p1.m_y) || (p0.m_z != p1.m_z))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 ndShapeInfo ndShapeConvex::GetShapeInfo() const
 {
 	ndShapeInfo info(ndShape::GetShapeInfo());
@@ -25,6 +25,11 @@
 #include "ndShapeConvexHull.h"
 
 #define D_CONVEX_VERTEX_SPLITE_SIZE	48
+
+// a hull has about six half edges per vertex and the 
+// edge count of the shape has to fit in sixteen bits
+#define D_CONVEX_HULL_MAX_VERTEX_COUNT	8192
+
 D_CLASS_REFLECTION_IMPLEMENT_LOADER(ndShapeConvexHull)
 
 D_MSV_NEWTON_ALIGN_32
@@ -41,7 +46,7 @@ class ndShapeConvexHull::ndConvexBox
 } D_GCC_NEWTON_ALIGN_32;
 
 
-ndShapeConvexHull::ndShapeConvexHull (ndInt32 count, ndInt32 strideInBytes, ndFloat32 tolerance, const ndFloat32* const vertexArray)
+ndShapeConvexHull::ndShapeConvexHull (ndInt32 count, ndInt32 strideInBytes, ndFloat32 tolerance, const ndFloat32* const vertexArray, ndInt32 maxPointCount)
 	:ndShapeConvex(m_convexHull)
 	,m_supportTree(nullptr)
 	,m_faceArray(nullptr)
@@ -58,7 +63,7 @@ ndShapeConvexHull::ndShapeConvexHull (ndInt32 count, ndInt32 strideInBytes, ndFl
 	m_vertexCount = 0;
 	m_vertex = nullptr;
 	m_simplex = nullptr;
-	Create(count, strideInBytes, vertexArray, tolerance);
+	Create(count, strideInBytes, vertexArray, tolerance, maxPointCount);
 }
 
 ndShapeConvexHull::ndShapeConvexHull(const ndLoadSaveBase::ndLoadDescriptor& desc)
@@ -82,7 +87,7 @@ ndShapeConvexHull::ndShapeConvexHull(const ndLoadSaveBase::ndLoadDescriptor& des
 	const nd::TiXmlNode* const xmlNode = desc.m_rootNode;
 	ndArray<ndVector> array;
 	xmlGetFloatArray3(xmlNode, "vextexArray3", array);
-	Create(array.GetCount(), sizeof (ndVector), &array[0].m_x, ndFloat32 (0.0f));
+	Create(array.GetCount(), sizeof (ndVector), &array[0].m_x, ndFloat32 (0.0f), D_CONVEX_HULL_MAX_VERTEX_COUNT);
 }
 
 ndShapeConvexHull::~ndShapeConvexHull()
@@ -111,8 +116,9 @@ ndShapeConvexHull::~ndShapeConvexHull()
 	}
 }
 
-bool ndShapeConvexHull::Create(ndInt32 count, ndInt32 strideInBytes, const ndFloat32* const vertexArray, ndFloat32 tolerance)
+bool ndShapeConvexHull::Create(ndInt32 count, ndInt32 strideInBytes, const ndFloat32* const vertexArray, ndFloat32 tolerance, ndInt32 maxPointCount)
 {
+	maxPointCount = dMin(maxPointCount, D_CONVEX_HULL_MAX_VERTEX_COUNT);
 	ndInt32 stride = strideInBytes / sizeof(ndFloat32);
 	ndStack<ndBigVector> buffer(2 * count);
 	for (ndInt32 i = 0; i < count; i++) 
@@ -120,7 +126,7 @@ bool ndShapeConvexHull::Create(ndInt32 count, ndInt32 strideInBytes, const ndFlo
 		buffer[i] = ndVector(vertexArray[i * stride + 0], vertexArray[i * stride + 1], vertexArray[i * stride + 2], ndFloat32(0.0f));
 	}
 
-	ndConvexHull3d* convexHull = new ndConvexHull3d(&buffer[0].m_x, sizeof (ndBigVector), count, tolerance);
+	ndConvexHull3d* convexHull = new ndConvexHull3d(&buffer[0].m_x, sizeof (ndBigVector), count, tolerance, maxPointCount);
 	if (!convexHull->GetCount()) 
 	{
 		dAssert(0);
@@ -230,7 +236,7 @@ bool ndShapeConvexHull::Create(ndInt32 count, ndInt32 strideInBytes, const ndFlo
 				}
 			}
 			delete convexHull;
-			convexHull = new ndConvexHull3d(&buffer[0].m_x, sizeof(ndBigVector), count1, tolerance);
+			convexHull = new ndConvexHull3d(&buffer[0].m_x, sizeof(ndBigVector), count1, tolerance, maxPointCount);
 		}
 	}
 
@@ -911,11 +917,62 @@ inline ndVector ndShapeConvexHull::SupportVertexhierarchical(const ndVector& dir
 	return m_vertex[index];
 }
 
+inline ndVector ndShapeConvexHull::SupportVertexHillClimbing(const ndVector& dir, ndInt32* const vertexIndex) const
+{
+	// walk the hull edges starting from the vertex of a previous query, 
+	// on a convex hull a vertex with no better neighbor is the support vertex.
+	ndInt32 index = *vertexIndex;
+	const ndConvexSimplexEdge* edge = m_vertexToEdgeMapping[index];
+	dAssert(edge->m_vertex == index);
+	ndFloat32 side0 = m_vertex[index].DotProduct(dir).GetScalar();
+
+	// each vertex is visited at most once, so the walk is bounded by the edge count.
+	ndInt32 maxCount = m_edgeCount;
+	const ndConvexSimplexEdge* ptr = edge;
+	do
+	{
+		const ndConvexSimplexEdge* const twin = ptr->m_twin;
+		const ndFloat32 side1 = m_vertex[twin->m_vertex].DotProduct(dir).GetScalar();
+		if (side1 > side0)
+		{
+			index = twin->m_vertex;
+			side0 = side1;
+			edge = twin;
+			ptr = edge;
+		}
+		ptr = ptr->m_twin->m_next;
+		maxCount--;
+	} while ((ptr != edge) && maxCount);
+
+	if (ptr != edge)
+	{
+		// the walk ran out of steps before it could prove the vertex 
+		// is a maximum, the support is found by testing every vertex.
+		for (ndInt32 i = 0; i < m_vertexCount; i++)
+		{
+			const ndFloat32 side1 = m_vertex[i].DotProduct(dir).GetScalar();
+			if (side1 > side0)
+			{
+				index = i;
+				side0 = side1;
+			}
+		}
+	}
+
+	*vertexIndex = index;
+	return m_vertex[index];
+}
+
 ndVector ndShapeConvexHull::SupportVertex(const ndVector& dir, ndInt32* const vertexIndex) const
 {
 	dAssert(dir.m_w == ndFloat32(0.0f));
 	if (m_vertexCount > D_CONVEX_VERTEX_SPLITE_SIZE) 
 	{
+		// a valid vertex index is used as the starting point of a hill climbing search
+		if (vertexIndex && (*vertexIndex >= 0) && (*vertexIndex < m_vertexCount))
+		{
+			return SupportVertexHillClimbing(dir, vertexIndex);
+		}
 		return SupportVertexhierarchical(dir, vertexIndex);
 	}
 	else 
@@ -924,6 +981,17 @@ ndVector ndShapeConvexHull::SupportVertex(const ndVector& dir, ndInt32* const ve
 	}
 }
 
+ndUnsigned64 ndShapeConvexHull::GetSizeInBytes() const
+{
+	return
+		sizeof(ndShapeConvexHull) +
+		ndUnsigned64(m_vertexCount) * (sizeof(ndVector) + sizeof(ndConvexSimplexEdge*)) +
+		ndUnsigned64(m_edgeCount) * sizeof(ndConvexSimplexEdge) +
+		ndUnsigned64(m_faceCount) * sizeof(ndConvexSimplexEdge*) +
+		ndUnsigned64(m_supportTreeCount) * sizeof(ndConvexBox) +
+		ndUnsigned64(m_soaVertexCount) * 4 * sizeof(ndVector);
+}
+
 ndShapeInfo ndShapeConvexHull::GetShapeInfo() const
 {
 	ndShapeInfo info(ndShapeConvex::GetShapeInfo());
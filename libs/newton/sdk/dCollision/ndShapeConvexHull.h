@@ -32,20 +32,22 @@ class ndShapeConvexHull : public ndShapeConvex
 	public:
 	D_CLASS_REFLECTION(ndShapeConvexHull);
 	D_COLLISION_API ndShapeConvexHull(const ndLoadSaveBase::ndLoadDescriptor& desc);
-	D_COLLISION_API ndShapeConvexHull(ndInt32 count, ndInt32 strideInBytes, ndFloat32 tolerance, const ndFloat32* const vertexArray);
+	D_COLLISION_API ndShapeConvexHull(ndInt32 count, ndInt32 strideInBytes, ndFloat32 tolerance, const ndFloat32* const vertexArray, ndInt32 maxPointCount = 0x7fffffff);
 	D_COLLISION_API virtual ~ndShapeConvexHull();
 
 	protected:
 	ndShapeInfo GetShapeInfo() const;
+	virtual ndUnsigned64 GetSizeInBytes() const;
 	ndBigVector FaceNormal(const ndEdge *face, const ndBigVector* const pool) const;
 	bool RemoveCoplanarEdge(ndPolyhedra& convex, const ndBigVector* const hullVertexArray) const;
-	bool Create(ndInt32 count, ndInt32 strideInBytes, const ndFloat32* const vertexArray, ndFloat32 tolerance);
+	bool Create(ndInt32 count, ndInt32 strideInBytes, const ndFloat32* const vertexArray, ndFloat32 tolerance, ndInt32 maxPointCount);
 	virtual ndVector SupportVertex(const ndVector& dir, ndInt32* const vertexIndex) const;
 	D_COLLISION_API virtual void Save(const ndLoadSaveBase::ndSaveDescriptor& desc) const;
 
 	private:
 	ndVector SupportVertexBruteForce(const ndVector& dir, ndInt32* const vertexIndex) const;
 	ndVector SupportVertexhierarchical(const ndVector& dir, ndInt32* const vertexIndex) const;
+	ndVector SupportVertexHillClimbing(const ndVector& dir, ndInt32* const vertexIndex) const;
 	
 	void DebugShape(const ndMatrix& matrix, ndShapeDebugNotify& debugCallback) const;
 
@@ -544,7 +544,7 @@ ndInt32 ndShapeConvexPolygon::CalculateContactToConvexHullDescrete(const ndShape
 	const ndVector p0(hullMatrix.TransformVector(pointInHull));
 
 	ndFloat32 penetration = m_normal.DotProduct(m_localPoly[0] - p0).GetScalar() + contactSolver.m_skinThickness;
-	if (penetration < -(D_PENETRATION_TOL * ndFloat32(5.0f)))
+	if (penetration < -(D_PENETRATION_TOL * ndFloat32(5.0f) + contactSolver.m_speculativeDistance))
 	{
 		contactSolver.m_separatingVector = m_normal;
 		contactSolver.m_closestPoint0 = p0;
@@ -620,6 +620,8 @@ ndInt32 ndShapeConvexPolygon::CalculateContactToConvexHullDescrete(const ndShape
 		contactSolver.m_closestPoint0 = p0;
 		contactSolver.m_closestPoint1 = p0 + m_normal.Scale(penetration);
 
+		// speculative contacts keep the gap as a negative penetration
+		const ndFloat32 contactPenetration = (contactSolver.m_speculativeDistance > ndFloat32(0.0f)) ? penetration : dMax(ndFloat32(0.0f), penetration);
 		penetration = dMax(ndFloat32(0.0f), penetration);
 		dAssert(penetration >= ndFloat32(0.0f));
 		ndVector contactPoints[128];
@@ -635,7 +637,7 @@ ndInt32 ndShapeConvexPolygon::CalculateContactToConvexHullDescrete(const ndShape
 			contactsOut[i].m_normal = m_normal;
 			contactsOut[i].m_shapeId0 = hullId;
 			contactsOut[i].m_shapeId1 = m_faceId;
-			contactsOut[i].m_penetration = penetration;
+			contactsOut[i].m_penetration = contactPenetration;
 		}
 	}
 	else
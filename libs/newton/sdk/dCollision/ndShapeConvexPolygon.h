@@ -50,6 +50,7 @@ class ndShapeConvexPolygon: public ndShapeConvex
 	ndInt32 CalculateContactToConvexHullContinue(const ndShapeInstance* const parentMesh, ndContactSolver& proxy);
 
 	virtual ndFloat32 GetVolume() const;
+	virtual ndUnsigned64 CalculateHash() const;
 	virtual ndFloat32 GetBoxMinRadius() const;
 	virtual ndFloat32 GetBoxMaxRadius() const;
 	virtual ndVector SupportVertex(const ndVector& dir, ndInt32* const vertexIndex) const;
@@ -100,5 +101,10 @@ inline ndFloat32 ndShapeConvexPolygon::GetBoxMaxRadius() const
 	return GetBoxMinRadius();
 }
 
+inline ndUnsigned64 ndShapeConvexPolygon::CalculateHash() const
+{
+	return 0;
+}
+
 #endif
 
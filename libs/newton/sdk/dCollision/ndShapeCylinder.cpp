@@ -140,6 +140,11 @@ void ndShapeCylinder::Init(ndFloat32 radio0, ndFloat32 radio1, ndFloat32 height)
 	SetVolumeAndCG();
 }
 
+ndUnsigned64 ndShapeCylinder::GetSizeInBytes() const
+{
+	return sizeof(ndShapeCylinder);
+}
+
 ndShapeInfo ndShapeCylinder::GetShapeInfo() const
 {
 	ndShapeInfo info(ndShapeConvex::GetShapeInfo());
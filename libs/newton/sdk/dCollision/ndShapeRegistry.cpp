@@ -0,0 +1,205 @@
+/* Copyright (c) <2003-2021> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ndCoreStdafx.h"
+#include "ndCollisionStdafx.h"
+#include "ndShape.h"
+#include "ndShapeRegistry.h"
+
+ndShapeRegistry::ndShapeRegistry()
+	:ndClassAlloc()
+	,m_shapes()
+	,m_lock()
+	,m_count(0)
+{
+}
+
+ndShapeRegistry::~ndShapeRegistry()
+{
+	// shapes that outlive the registry must not try to leave it
+	ndScopeSpinLock lock(m_lock);
+	ndTree<ndShapeChain, ndUnsigned64>::Iterator it(m_shapes);
+	for (it.Begin(); it; it++)
+	{
+		const ndShapeChain& chain = *it;
+		for (ndShapeChain::ndNode* node = chain.GetFirst(); node; node = node->GetNext())
+		{
+			node->GetInfo()->m_registryKey = 0;
+		}
+	}
+	m_shapes.RemoveAll();
+	m_count = 0;
+}
+
+ndShapeRegistry& ndShapeRegistry::GetRegistry()
+{
+	static ndShapeRegistry registry;
+	return registry;
+}
+
+ndInt32 ndShapeRegistry::GetCount() const
+{
+	ndScopeSpinLock lock(m_lock);
+	return m_count;
+}
+
+ndShapeInstance ndShapeRegistry::Intern(ndShape* const shape)
+{
+	dAssert(shape);
+	const ndUnsigned64 key = shape->CalculateHash();
+	if (!key || shape->m_registryKey)
+	{
+		return ndShapeInstance(shape);
+	}
+
+	ndShape* registered = nullptr;
+	{
+		ndScopeSpinLock lock(m_lock);
+		ndTree<ndShapeChain, ndUnsigned64>::ndNode* node = m_shapes.Find(key);
+		if (!node)
+		{
+			node = m_shapes.Insert(ndShapeChain(), key);
+		}
+
+		// the hash only selects the chain, a shape is shared 
+		// when the class and the geometry are the same.
+		ndShapeChain& chain = node->GetInfo();
+		const char* const className = shape->SubClassName();
+		for (ndShapeChain::ndNode* entryNode = chain.GetFirst(); entryNode && !registered; )
+		{
+			ndShapeChain::ndNode* const nextNode = entryNode->GetNext();
+			ndShape* const entry = (ndShape*)entryNode->GetInfo();
+			if (!strcmp(entry->SubClassName(), className) && entry->HasSameGeometry(shape))
+			{
+				// take a reference, unless the shape is already being destroyed
+				for (ndInt32 count = entry->m_refCount.load(); count; count = entry->m_refCount.load())
+				{
+					if (entry->m_refCount.compare_exchange_weak(count, count + 1))
+					{
+						registered = entry;
+						break;
+					}
+				}
+				if (!registered)
+				{
+					entry->m_registryKey = 0;
+					chain.Remove(entryNode);
+					m_count--;
+				}
+			}
+			entryNode = nextNode;
+		}
+
+		if (!registered)
+		{
+			chain.Append(shape);
+			shape->m_registryKey = key;
+			m_count++;
+		}
+	}
+
+	if (!registered)
+	{
+		return ndShapeInstance(shape);
+	}
+
+	ndShapeInstance instance(registered);
+	registered->Release();
+	if (!shape->GetRefCount())
+	{
+		shape->AddRef();
+		shape->Release();
+	}
+	return instance;
+}
+
+void ndShapeRegistry::Remove(const ndShape* const shape)
+{
+	ndScopeSpinLock lock(m_lock);
+	if (shape->m_registryKey)
+	{
+		ndTree<ndShapeChain, ndUnsigned64>::ndNode* const node = m_shapes.Find(shape->m_registryKey);
+		if (node)
+		{
+			ndShapeChain& chain = node->GetInfo();
+			for (ndShapeChain::ndNode* entryNode = chain.GetFirst(); entryNode; entryNode = entryNode->GetNext())
+			{
+				if (entryNode->GetInfo() == shape)
+				{
+					chain.Remove(entryNode);
+					m_count--;
+					break;
+				}
+			}
+			if (!chain.GetCount())
+			{
+				m_shapes.Remove(node);
+			}
+		}
+		shape->m_registryKey = 0;
+	}
+}
+
+ndUnsigned64 ndShapeRegistry::GetSizeInBytes() const
+{
+	ndUnsigned64 size = 0;
+	ndScopeSpinLock lock(m_lock);
+	ndTree<ndShapeChain, ndUnsigned64>::Iterator it(m_shapes);
+	for (it.Begin(); it; it++)
+	{
+		const ndShapeChain& chain = *it;
+		for (ndShapeChain::ndNode* node = chain.GetFirst(); node; node = node->GetNext())
+		{
+			size += node->GetInfo()->GetSizeInBytes();
+		}
+	}
+	return size;
+}
+
+void ndShapeRegistry::GetMemoryReport(ndArray<ndMemoryReport>& report) const
+{
+	report.SetCount(0);
+	ndScopeSpinLock lock(m_lock);
+	ndTree<ndShapeChain, ndUnsigned64>::Iterator it(m_shapes);
+	for (it.Begin(); it; it++)
+	{
+		const ndShapeChain& chain = *it;
+		for (ndShapeChain::ndNode* node = chain.GetFirst(); node; node = node->GetNext())
+		{
+			ndShape* const shape = (ndShape*)node->GetInfo();
+			const char* const className = shape->SubClassName();
+			ndInt32 index = 0;
+			for (; (index < report.GetCount()) && strcmp(report[index].m_className, className); index++);
+			if (index == report.GetCount())
+			{
+				ndMemoryReport entry;
+				entry.m_className = className;
+				entry.m_sizeInBytes = 0;
+				entry.m_shapeCount = 0;
+				entry.m_referenceCount = 0;
+				report.PushBack(entry);
+			}
+			report[index].m_sizeInBytes += shape->GetSizeInBytes();
+			report[index].m_shapeCount++;
+			report[index].m_referenceCount += shape->GetRefCount();
+		}
+	}
+}
@@ -0,0 +1,77 @@
+/* Copyright (c) <2003-2021> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __ND_SHAPE_REGISTRY_H__ 
+#define __ND_SHAPE_REGISTRY_H__ 
+
+#include "ndCollisionStdafx.h"
+#include "ndShapeInstance.h"
+
+class ndShape;
+
+/// Process wide table of shared shapes keyed by the hash of their geometry.
+/// Intern returns an instance of the registered shape with the same geometry 
+/// as the one passed in, or registers it if there is none, so identical props 
+/// made by different loaders and scripts, in any world, share one shape and 
+/// shape memory grows with the unique geometry, not with the instance count.
+/// The registry does not keep shapes alive, a shape leaves it when its last 
+/// reference is released. Shapes that can change after they are made, like 
+/// compounds and heightfields, have no hash and are never shared.
+/// A hash hit is only shared after the class and the geometry are compared,
+/// shapes that collide on the hash are chained under the same key.
+class ndShapeRegistry: public ndClassAlloc
+{
+	public:
+	class ndMemoryReport
+	{
+		public:
+		const char* m_className;
+		ndUnsigned64 m_sizeInBytes;
+		ndInt32 m_shapeCount;
+		// number of references to the shapes of the class, instances included
+		ndInt32 m_referenceCount;
+	};
+
+	D_COLLISION_API static ndShapeRegistry& GetRegistry();
+
+	/// the shape is deleted if it is a copy of a registered shape and nothing else references it.
+	D_COLLISION_API ndShapeInstance Intern(ndShape* const shape);
+
+	D_COLLISION_API ndInt32 GetCount() const;
+	D_COLLISION_API ndUnsigned64 GetSizeInBytes() const;
+
+	/// one entry per shape class in the registry
+	D_COLLISION_API void GetMemoryReport(ndArray<ndMemoryReport>& report) const;
+
+	private:
+	ndShapeRegistry();
+	~ndShapeRegistry();
+	void Remove(const ndShape* const shape);
+
+	typedef ndList<const ndShape*> ndShapeChain;
+	ndTree<ndShapeChain, ndUnsigned64> m_shapes;
+	mutable ndSpinLock m_lock;
+	ndInt32 m_count;
+	friend class ndShape;
+};
+
+#endif 
+
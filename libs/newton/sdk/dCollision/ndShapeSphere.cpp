@@ -232,6 +232,11 @@ ndFloat32 ndShapeSphere::RayCast(ndRayCastNotify&, const ndVector& localP0, cons
 	return t;
 }
 
+ndUnsigned64 ndShapeSphere::GetSizeInBytes() const
+{
+	return sizeof(ndShapeSphere);
+}
+
 ndShapeInfo ndShapeSphere::GetShapeInfo() const
 {
 	ndShapeInfo info(ndShapeConvex::GetShapeInfo());
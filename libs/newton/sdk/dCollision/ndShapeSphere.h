@@ -42,6 +42,7 @@ class ndShapeSphere: public ndShapeConvex
 	D_COLLISION_API virtual void MassProperties();
 
 	D_COLLISION_API virtual ndShapeInfo GetShapeInfo() const;
+	D_COLLISION_API virtual ndUnsigned64 GetSizeInBytes() const;
 	D_COLLISION_API virtual void CalculateAabb(const ndMatrix& matrix, ndVector& p0, ndVector& p1) const;
 	D_COLLISION_API virtual void DebugShape(const ndMatrix& matrix, ndShapeDebugNotify& debugCallback) const;
 	D_COLLISION_API virtual ndVector SupportVertexSpecialProjectPoint(const ndVector& point, const ndVector& dir) const;
@@ -61,6 +62,8 @@ class ndShapeSphere: public ndShapeConvex
 	static ndVector m_unitSphere[];
 	static ndConvexSimplexEdge m_edgeArray[];
 
+	friend class ndContactSolver;
+
 } D_GCC_NEWTON_ALIGN_32;
 
 
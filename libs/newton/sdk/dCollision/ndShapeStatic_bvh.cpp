@@ -125,6 +125,23 @@ dIntersectStatus ndShapeStatic_bvh::GetTriangleCount(void* const context, const
 	return t_ContinueSearh;
 }
 
+ndUnsigned64 ndShapeStatic_bvh::CalculateHash() const
+{
+	const ndUnsigned64 hash = ndAabbPolygonSoup::CalculateHash();
+	return hash ? dCRC64(&m_collisionId, sizeof(m_collisionId), hash) : 0;
+}
+
+bool ndShapeStatic_bvh::HasSameGeometry(const ndShape* const other) const
+{
+	const ndShapeStatic_bvh* const bvh = ((ndShape*)other)->GetAsShapeStaticBVH();
+	return bvh && (bvh->m_collisionId == m_collisionId) && ndAabbPolygonSoup::HasSameGeometry(*bvh);
+}
+
+ndUnsigned64 ndShapeStatic_bvh::GetSizeInBytes() const
+{
+	return sizeof(ndShapeStatic_bvh) + ndAabbPolygonSoup::GetSizeInBytes();
+}
+
 ndShapeInfo ndShapeStatic_bvh::GetShapeInfo() const
 {
 	ndShapeInfo info(ndShapeStaticMesh::GetShapeInfo());
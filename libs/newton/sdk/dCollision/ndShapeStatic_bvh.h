@@ -33,6 +33,10 @@ class ndShapeStatic_bvh: public ndShapeStaticMesh, public ndAabbPolygonSoup
 	D_COLLISION_API ndShapeStatic_bvh(const ndLoadSaveBase::ndLoadDescriptor& desc);
 	D_COLLISION_API virtual ~ndShapeStatic_bvh();
 
+	D_COLLISION_API virtual ndUnsigned64 CalculateHash() const;
+	D_COLLISION_API virtual bool HasSameGeometry(const ndShape* const other) const;
+	D_COLLISION_API virtual ndUnsigned64 GetSizeInBytes() const;
+
 	void *operator new (size_t size);
 	void operator delete (void* ptr);
 
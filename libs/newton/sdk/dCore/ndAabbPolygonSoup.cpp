@@ -21,14 +21,24 @@
 
 #include "ndCoreStdafx.h"
 #include "ndTypes.h"
+#include "ndCRC.h"
 #include "ndHeap.h"
 #include "ndStack.h"
 #include "ndList.h"
 #include "ndMatrix.h"
+#include "ndProfiler.h"
+#include "ndThreadPool.h"
 #include "ndPolyhedra.h"
 #include "ndAabbPolygonSoup.h"
 #include "ndPolygonSoupBuilder.h"
 
+#if !(defined (WIN32) || defined(_WIN32) || defined (_M_ARM) || defined (_M_ARM64))
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/stat.h>
+	#include <sys/mman.h>
+#endif
+
 #define DG_STACK_DEPTH 512
 
 D_MSV_NEWTON_ALIGN_32
@@ -40,8 +50,6 @@ class ndAabbPolygonSoup::ndNodeBuilder: public ndAabbPolygonSoup::ndNode
 		,m_left (nullptr)
 		,m_right (nullptr)
 		,m_parent (nullptr)
-		,m_indexBox0(0)
-		,m_indexBox1(0)
 		,m_enumeration(-1)
 		,m_faceIndex(0)
 		,m_indexCount(0)
@@ -55,8 +63,6 @@ class ndAabbPolygonSoup::ndNodeBuilder: public ndAabbPolygonSoup::ndNode
 		,m_left (nullptr)
 		,m_right (nullptr)
 		,m_parent (nullptr)
-		,m_indexBox0(0)
-		,m_indexBox1(0)
 		,m_enumeration(-1)
 		,m_faceIndex(faceIndex)
 		,m_indexCount(indexCount)
@@ -83,8 +89,6 @@ class ndAabbPolygonSoup::ndNodeBuilder: public ndAabbPolygonSoup::ndNode
 		,m_left(left)
 		,m_right(right)
 		,m_parent(nullptr)
-		,m_indexBox0(0)
-		,m_indexBox1(0)
 		,m_enumeration(-1)
 		,m_faceIndex(0)
 		,m_indexCount(0)
@@ -126,14 +130,22 @@ class ndAabbPolygonSoup::ndNodeBuilder: public ndAabbPolygonSoup::ndNode
 	ndNodeBuilder* m_left;
 	ndNodeBuilder* m_right;
 	ndNodeBuilder* m_parent;
-	ndInt32 m_indexBox0;
-	ndInt32 m_indexBox1;
 	ndInt32 m_enumeration;
 	ndInt32 m_faceIndex;
 	ndInt32 m_indexCount;
 	const ndInt32* m_faceIndices;
 } D_GCC_NEWTON_ALIGN_32;
 
+class ndAabbPolygonSoup::ndSubTreeInfo
+{
+	public:
+	ndNodeBuilder* m_parent;
+	ndNodeBuilder* m_allocator;
+	ndInt32 m_firstBox;
+	ndInt32 m_lastBox;
+	bool m_isLeft;
+};
+
 class ndAabbPolygonSoup::ndSpliteInfo
 {
 	public:
@@ -247,8 +259,12 @@ class ndAabbPolygonSoup::ndSpliteInfo
 
 ndAabbPolygonSoup::ndAabbPolygonSoup ()
 	:ndPolygonSoupDatabase()
+	,m_aabbP0(ndVector::m_zero)
+	,m_aabbP1(ndVector::m_zero)
 	,m_aabb(nullptr)
 	,m_indices(nullptr)
+	,m_image(nullptr)
+	,m_imageSize(0)
 	,m_nodesCount(0)
 	,m_indexCount(0)
 {
@@ -256,13 +272,59 @@ ndAabbPolygonSoup::ndAabbPolygonSoup ()
 
 ndAabbPolygonSoup::~ndAabbPolygonSoup ()
 {
-	if (m_aabb) 
+	if (m_image)
+	{
+		UnmapImage();
+	}
+	else if (m_aabb) 
 	{
 		ndMemory::Free(m_aabb);
 		ndMemory::Free(m_indices);
 	}
 }
 
+ndUnsigned64 ndAabbPolygonSoup::CalculateHash() const
+{
+	ndUnsigned64 hash = 0;
+	const ndInt32 stride = m_strideInBytes / ndInt32(sizeof(ndFloat32));
+	for (ndInt32 i = 0; i < m_vertexCount; i++)
+	{
+		hash = dCRC64(&m_localVertex[i * stride], 3 * sizeof(ndFloat32), hash);
+	}
+	if (m_indexCount)
+	{
+		hash = dCRC64(m_indices, m_indexCount * sizeof(ndInt32), hash);
+	}
+	return hash;
+}
+
+bool ndAabbPolygonSoup::HasSameGeometry(const ndAabbPolygonSoup& other) const
+{
+	// compares the same data the hash is made from
+	if ((m_vertexCount != other.m_vertexCount) || (m_indexCount != other.m_indexCount))
+	{
+		return false;
+	}
+	const ndInt32 stride0 = m_strideInBytes / ndInt32(sizeof(ndFloat32));
+	const ndInt32 stride1 = other.m_strideInBytes / ndInt32(sizeof(ndFloat32));
+	for (ndInt32 i = 0; i < m_vertexCount; i++)
+	{
+		if (memcmp(&m_localVertex[i * stride0], &other.m_localVertex[i * stride1], 3 * sizeof(ndFloat32)))
+		{
+			return false;
+		}
+	}
+	return !m_indexCount || !memcmp(m_indices, other.m_indices, m_indexCount * sizeof(ndInt32));
+}
+
+ndUnsigned64 ndAabbPolygonSoup::GetSizeInBytes() const
+{
+	return
+		ndUnsigned64(m_nodesCount) * sizeof(ndNode) +
+		ndUnsigned64(m_indexCount) * sizeof(ndInt32) +
+		ndUnsigned64(m_vertexCount) * ndUnsigned64(m_strideInBytes);
+}
+
 void ndAabbPolygonSoup::ImproveNodeFitness (ndNodeBuilder* const node) const
 {
 	dAssert (node->m_left);
@@ -474,15 +536,8 @@ ndFloat32 ndAabbPolygonSoup::CalculateFaceMaxSize (const ndVector* const vertex,
 
 void ndAabbPolygonSoup::GetAABB (ndVector& p0, ndVector& p1) const
 {
-	if (m_aabb) 
-	{ 
-		GetNodeAabb (m_aabb, p0, p1);
-	} 
-	else 
-	{
-		p0 = ndVector::m_zero;
-		p1 = ndVector::m_zero;
-	}
+	p0 = m_aabbP0;
+	p1 = m_aabbP1;
 }
 
 void ndAabbPolygonSoup::CalculateAdjacendy ()
@@ -955,6 +1010,110 @@ ndAabbPolygonSoup::ndNodeBuilder* ndAabbPolygonSoup::BuildTopDown (ndNodeBuilder
 	}
 }
 
+ndAabbPolygonSoup::ndNodeBuilder* ndAabbPolygonSoup::SplitTopDown (ndNodeBuilder* const leafArray, ndInt32 firstBox, ndInt32 lastBox, ndNodeBuilder** const allocator, ndInt32 subTreeSize, ndArray<ndSubTreeInfo>& subTrees) const
+{
+	dAssert (lastBox > firstBox);
+	ndSpliteInfo info (&leafArray[firstBox], lastBox - firstBox + 1);
+
+	ndNodeBuilder* const parent = new (*allocator) ndNodeBuilder (info.m_p0, info.m_p1);
+	*allocator = *allocator + 1;
+
+	// same children order as the serial build, each deferred sub tree 
+	// reserves the (count - 1) interior nodes it is going to allocate.
+	const ndInt32 childRange[2][2] = { { firstBox + info.m_axis, lastBox }, { firstBox, firstBox + info.m_axis - 1 } };
+	for (ndInt32 i = 0; i < 2; i++)
+	{
+		const ndInt32 first = childRange[i][0];
+		const ndInt32 last = childRange[i][1];
+		if ((last - first + 1) > subTreeSize)
+		{
+			ndNodeBuilder* const child = SplitTopDown (leafArray, first, last, allocator, subTreeSize, subTrees);
+			child->m_parent = parent;
+			if (i)
+			{
+				parent->m_left = child;
+			}
+			else
+			{
+				parent->m_right = child;
+			}
+		}
+		else
+		{
+			ndSubTreeInfo subTree;
+			subTree.m_parent = parent;
+			subTree.m_allocator = *allocator;
+			subTree.m_firstBox = first;
+			subTree.m_lastBox = last;
+			subTree.m_isLeft = i ? true : false;
+			subTrees.PushBack(subTree);
+			*allocator = *allocator + (last - first);
+		}
+	}
+	return parent;
+}
+
+ndAabbPolygonSoup::ndNodeBuilder* ndAabbPolygonSoup::BuildTopDown (ndNodeBuilder* const leafArray, ndInt32 firstBox, ndInt32 lastBox, ndNodeBuilder** const allocator, ndInt32 threadCount) const
+{
+	D_TRACKTIME();
+	#define D_MIN_SUBTREE_SIZE (1024 * 2)
+	const ndInt32 boxCount = lastBox - firstBox + 1;
+	const ndInt32 subTreeSize = dMax (boxCount / (threadCount * 4), D_MIN_SUBTREE_SIZE);
+	if ((threadCount <= 1) || (boxCount <= subTreeSize * 2))
+	{
+		return BuildTopDown (leafArray, firstBox, lastBox, allocator);
+	}
+
+	class ndBuildContext
+	{
+		public:
+		const ndAabbPolygonSoup* m_me;
+		ndNodeBuilder* m_leafArray;
+		ndArray<ndSubTreeInfo>* m_subTrees;
+		ndAtomic<ndInt32> m_subTreeIndex;
+	};
+
+	class ndBuildSubTrees: public ndJobThreadPool::ndBaseJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			ndBuildContext* const context = (ndBuildContext*)m_context;
+			ndArray<ndSubTreeInfo>& subTrees = *context->m_subTrees;
+			for (ndInt32 i = context->m_subTreeIndex.fetch_add(1); i < subTrees.GetCount(); i = context->m_subTreeIndex.fetch_add(1))
+			{
+				const ndSubTreeInfo& subTree = subTrees[i];
+				ndNodeBuilder* allocator = subTree.m_allocator;
+				ndNodeBuilder* const node = context->m_me->BuildTopDown (context->m_leafArray, subTree.m_firstBox, subTree.m_lastBox, &allocator);
+				dAssert ((allocator - subTree.m_allocator) == (subTree.m_lastBox - subTree.m_firstBox));
+				node->m_parent = subTree.m_parent;
+				if (subTree.m_isLeft)
+				{
+					subTree.m_parent->m_left = node;
+				}
+				else
+				{
+					subTree.m_parent->m_right = node;
+				}
+			}
+		}
+	};
+
+	ndArray<ndSubTreeInfo> subTrees;
+	ndNodeBuilder* const root = SplitTopDown (leafArray, firstBox, lastBox, allocator, subTreeSize, subTrees);
+
+	ndBuildContext context;
+	context.m_me = this;
+	context.m_leafArray = leafArray;
+	context.m_subTrees = &subTrees;
+	context.m_subTreeIndex.store(0);
+
+	ndJobThreadPool threadPool(dMin (threadCount, subTrees.GetCount()), "soupBvh");
+	threadPool.SubmitJobs<ndBuildSubTrees>(&context);
+	return root;
+}
+
 void ndAabbPolygonSoup::Create (const ndPolygonSoupBuilder& builder)
 {
 	if (builder.m_faceVertexCount.GetCount() == 0) 
@@ -973,7 +1132,7 @@ void ndAabbPolygonSoup::Create (const ndPolygonSoupBuilder& builder)
 	}
 
 	m_indices = (ndInt32*) ndMemory::Malloc (sizeof (ndInt32) * m_indexCount);
-	ndStack<ndVector> tmpVertexArrayCount(builder.m_vertexPoints.GetCount() + builder.m_normalPoints.GetCount() + builder.m_faceVertexCount.GetCount() * 2 + 4);
+	ndStack<ndVector> tmpVertexArrayCount(builder.m_vertexPoints.GetCount() + builder.m_normalPoints.GetCount() + 4);
 
 	ndVector* const tmpVertexArray = &tmpVertexArrayCount[0];
 	for (ndInt32 i = 0; i < builder.m_vertexPoints.GetCount(); i ++) 
@@ -1006,7 +1165,7 @@ void ndAabbPolygonSoup::Create (const ndPolygonSoupBuilder& builder)
 	}
 
 	ndNodeBuilder* contructorAllocator = &constructor[allocatorIndex];
-	ndNodeBuilder* root = BuildTopDown (&constructor[0], 0, allocatorIndex - 1, &contructorAllocator);
+	ndNodeBuilder* root = BuildTopDown (&constructor[0], 0, allocatorIndex - 1, &contructorAllocator, builder.GetThreadCount());
 
 	dAssert (root);
 	dTrace(("*****->this is broken\n"));
@@ -1076,11 +1235,9 @@ void ndAabbPolygonSoup::Create (const ndPolygonSoupBuilder& builder)
 	}
 	dAssert(!list.GetCount());
 
-	ndInt32 aabbBase = builder.m_vertexPoints.GetCount() + builder.m_normalPoints.GetCount();
-
-	ndVector* const aabbPoints = &tmpVertexArray[aabbBase];
+	m_aabbP0 = root->m_p0 & ndVector::m_triplexMask;
+	m_aabbP1 = root->m_p1 & ndVector::m_triplexMask;
 
-	ndInt32 vertexIndex = 0;
 	ndInt32 aabbNodeIndex = 0;
 	list.Append(root);
 	ndInt32 indexMap = 0;
@@ -1110,13 +1267,13 @@ void ndAabbPolygonSoup::Create (const ndPolygonSoupBuilder& builder)
 				}
 			}
 
-			aabbPoints[vertexIndex + 0] = node->m_p0;
-			aabbPoints[vertexIndex + 1] = node->m_p1;
-
-			aabbNode.m_indexBox0 = aabbBase + vertexIndex;
-			aabbNode.m_indexBox1 = aabbBase + vertexIndex + 1;
-
-			vertexIndex += 2;
+			// nodes are visited breath first, so the parent box is already quantized. 
+			// the builder box is replaced by the decoded box, so that the children 
+			// are quantized relative to the same box that is seen at run time.
+			const ndVector parentP0 (node->m_parent ? node->m_parent->m_p0 : m_aabbP0);
+			const ndVector parentP1 (node->m_parent ? node->m_parent->m_p1 : m_aabbP1);
+			aabbNode.SetAabb (parentP0, parentP1, node->m_p0 & ndVector::m_triplexMask, node->m_p1 & ndVector::m_triplexMask);
+			aabbNode.GetAabb (parentP0, parentP1, node->m_p0, node->m_p1);
 		}
 		else
 		{
@@ -1161,10 +1318,7 @@ void ndAabbPolygonSoup::Create (const ndPolygonSoupBuilder& builder)
 		}
 	}
 
-	ndStack<ndInt32> indexArray (vertexIndex);
-	ndInt32 aabbPointCount = dVertexListToIndexList (&aabbPoints[0].m_x, sizeof (ndVector), 3, vertexIndex, &indexArray[0], ndFloat32 (1.0e-6f));
-
-	m_vertexCount = aabbBase + aabbPointCount;
+	m_vertexCount = builder.m_vertexPoints.GetCount() + builder.m_normalPoints.GetCount();
 	m_localVertex = (ndFloat32*) ndMemory::Malloc (sizeof (ndTriplex) * m_vertexCount);
 
 	ndTriplex* const dstPoints = (ndTriplex*)m_localVertex;
@@ -1175,41 +1329,247 @@ void ndAabbPolygonSoup::Create (const ndPolygonSoupBuilder& builder)
 		dstPoints[i].m_z = tmpVertexArray[i].m_z;
 	}
 
-	for (ndInt32 i = 0; i < m_nodesCount; i ++) 
-	{
-		ndNode& box = m_aabb[i];
-
-		ndInt32 j = box.m_indexBox0 - aabbBase;
-		box.m_indexBox0 = indexArray[j] + aabbBase;
-
-		j = box.m_indexBox1 - aabbBase;
-		box.m_indexBox1 = indexArray[j] + aabbBase;
-	}
-
 	if (builder.m_faceVertexCount.GetCount() == 1) 
 	{
 		m_aabb[0].m_right = ndNode::ndLeafNodePtr (0, 0);
 	}
 }
 
+// the serialized soup is a flat image: a fixed size header followed 
+// by the vertex, index and node arrays, each one starting at a 16 byte 
+// aligned offset. the file can be memory mapped and the arrays used in place.
+#define D_AABB_SOUP_IMAGE_MAGIC		0x76626e64
+#define D_AABB_SOUP_IMAGE_VERSION	1
+#define D_AABB_SOUP_IMAGE_ALIGN(x)	(((x) + 15) & -16)
+
+class ndAabbPolygonSoup::ndImageHeader
+{
+	public:
+	ndUnsigned32 m_magic;
+	ndUnsigned32 m_version;
+	ndInt32 m_vertexCount;
+	ndInt32 m_indexCount;
+	ndInt32 m_nodesCount;
+	ndInt32 m_nodeSizeInBytes;
+	ndInt32 m_vertexOffset;
+	ndInt32 m_indexOffset;
+	ndInt32 m_nodeOffset;
+	ndInt32 m_imageSizeInBytes;
+	ndInt32 m_padding[2];
+	ndFloat32 m_p0[4];
+	ndFloat32 m_p1[4];
+};
+
+// node layout used before the boxes were quantized
+class ndAabbPolygonSoup::ndLegacyNode
+{
+	public:
+	ndInt32 m_indexBox0;
+	ndInt32 m_indexBox1;
+	ndUnsigned32 m_left;
+	ndUnsigned32 m_right;
+};
+
 void ndAabbPolygonSoup::Serialize (const char* const path) const
 {
 	FILE* const file = fopen(path, "wb");
 	if (file)
 	{
-		fwrite(&m_vertexCount, sizeof(ndInt32), 1, file);
-		fwrite(&m_indexCount, sizeof(ndInt32), 1, file);
-		fwrite(&m_nodesCount, sizeof(ndInt32), 1, file);
+		ndImageHeader header;
+		memset(&header, 0, sizeof(header));
+		header.m_magic = D_AABB_SOUP_IMAGE_MAGIC;
+		header.m_version = D_AABB_SOUP_IMAGE_VERSION;
+		header.m_nodeSizeInBytes = sizeof(ndNode);
+		if (m_aabb)
+		{
+			header.m_vertexCount = m_vertexCount;
+			header.m_indexCount = m_indexCount;
+			header.m_nodesCount = m_nodesCount;
+		}
+		header.m_vertexOffset = D_AABB_SOUP_IMAGE_ALIGN(ndInt32(sizeof(ndImageHeader)));
+		header.m_indexOffset = D_AABB_SOUP_IMAGE_ALIGN(header.m_vertexOffset + ndInt32(sizeof(ndTriplex)) * header.m_vertexCount);
+		header.m_nodeOffset = D_AABB_SOUP_IMAGE_ALIGN(header.m_indexOffset + ndInt32(sizeof(ndInt32)) * header.m_indexCount);
+		header.m_imageSizeInBytes = D_AABB_SOUP_IMAGE_ALIGN(header.m_nodeOffset + ndInt32(sizeof(ndNode)) * header.m_nodesCount);
+		for (ndInt32 i = 0; i < 4; i++)
+		{
+			header.m_p0[i] = m_aabbP0[i];
+			header.m_p1[i] = m_aabbP1[i];
+		}
+
+		const char padding[16] = {0};
+		fwrite(&header, sizeof(ndImageHeader), 1, file);
+		fwrite(padding, size_t(header.m_vertexOffset - ndInt32(sizeof(ndImageHeader))), 1, file);
 		if (m_aabb)
 		{
-			fwrite(m_localVertex, sizeof(ndTriplex) * m_vertexCount, 1, file);
-			fwrite(m_indices, sizeof(ndInt32) * m_indexCount, 1, file);
-			fwrite(m_aabb, sizeof(ndNode) * m_nodesCount, 1, file);
+			const ndInt32 vertexSize = ndInt32(sizeof(ndTriplex)) * m_vertexCount;
+			const ndInt32 indexSize = ndInt32(sizeof(ndInt32)) * m_indexCount;
+			const ndInt32 nodeSize = ndInt32(sizeof(ndNode)) * m_nodesCount;
+			fwrite(m_localVertex, size_t(vertexSize), 1, file);
+			fwrite(padding, size_t(header.m_indexOffset - header.m_vertexOffset - vertexSize), 1, file);
+			fwrite(m_indices, size_t(indexSize), 1, file);
+			fwrite(padding, size_t(header.m_nodeOffset - header.m_indexOffset - indexSize), 1, file);
+			fwrite(m_aabb, size_t(nodeSize), 1, file);
+			fwrite(padding, size_t(header.m_imageSizeInBytes - header.m_nodeOffset - nodeSize), 1, file);
 		}
 		fclose(file);
 	}
 }
 
+void ndAabbPolygonSoup::UnmapImage()
+{
+	dAssert(m_image);
+#if (defined (WIN32) || defined(_WIN32) || defined (_M_ARM) || defined (_M_ARM64))
+	UnmapViewOfFile(m_image);
+#else
+	munmap(m_image, m_imageSize);
+#endif
+	// the arrays point inside the image
+	m_image = nullptr;
+	m_imageSize = 0;
+	m_localVertex = nullptr;
+	m_indices = nullptr;
+	m_aabb = nullptr;
+}
+
+// the image is mapped copy on write and the soup arrays point inside it,
+// so loading does not copy the data and face tags can still be edited.
+bool ndAabbPolygonSoup::MapImage(const char* const path)
+{
+	dAssert(!m_image);
+#if (defined (WIN32) || defined(_WIN32) || defined (_M_ARM) || defined (_M_ARM64))
+	HANDLE const file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file != INVALID_HANDLE_VALUE)
+	{
+		LARGE_INTEGER size;
+		if (GetFileSizeEx(file, &size) && (size.QuadPart > 0))
+		{
+			HANDLE const mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+			if (mapping)
+			{
+				void* const data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+				if (data)
+				{
+					m_image = (ndUnsigned8*)data;
+					m_imageSize = size_t(size.QuadPart);
+				}
+				// the view keeps the mapping alive
+				CloseHandle(mapping);
+			}
+		}
+		CloseHandle(file);
+	}
+#else
+	const int file = open(path, O_RDONLY);
+	if (file >= 0)
+	{
+		struct stat info;
+		if (!fstat(file, &info) && (info.st_size > 0))
+		{
+			void* const data = mmap(nullptr, size_t(info.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+			if (data != MAP_FAILED)
+			{
+				m_image = (ndUnsigned8*)data;
+				m_imageSize = size_t(info.st_size);
+			}
+		}
+		close(file);
+	}
+#endif
+
+	if (!m_image)
+	{
+		return false;
+	}
+
+	const ndImageHeader* const header = (ndImageHeader*)m_image;
+	const ndInt64 imageSize = ndInt64(m_imageSize);
+	bool valid = (m_imageSize >= sizeof(ndImageHeader));
+	valid = valid && (header->m_magic == D_AABB_SOUP_IMAGE_MAGIC);
+	valid = valid && (header->m_version == D_AABB_SOUP_IMAGE_VERSION);
+	valid = valid && (header->m_nodeSizeInBytes == ndInt32(sizeof(ndNode)));
+	valid = valid && (header->m_vertexCount >= 0) && (header->m_indexCount >= 0) && (header->m_nodesCount >= 0);
+	valid = valid && (header->m_vertexOffset >= 0) && (header->m_indexOffset >= 0) && (header->m_nodeOffset >= 0);
+	valid = valid && !(header->m_vertexOffset & 15) && !(header->m_indexOffset & 15) && !(header->m_nodeOffset & 15);
+	valid = valid && ((ndInt64(header->m_vertexOffset) + ndInt64(sizeof(ndTriplex)) * header->m_vertexCount) <= imageSize);
+	valid = valid && ((ndInt64(header->m_indexOffset) + ndInt64(sizeof(ndInt32)) * header->m_indexCount) <= imageSize);
+	valid = valid && ((ndInt64(header->m_nodeOffset) + ndInt64(sizeof(ndNode)) * header->m_nodesCount) <= imageSize);
+	valid = valid && (!header->m_vertexCount || (header->m_indexCount && header->m_nodesCount));
+	if (valid && header->m_vertexCount)
+	{
+		const ndInt32* const indices = (ndInt32*)&m_image[header->m_indexOffset];
+		const ndNode* const nodes = (ndNode*)&m_image[header->m_nodeOffset];
+		valid = ValidateImage(nodes, header->m_nodesCount, indices, header->m_indexCount, header->m_vertexCount);
+	}
+	if (!valid)
+	{
+		UnmapImage();
+		return false;
+	}
+
+	m_strideInBytes = sizeof(ndTriplex);
+	m_vertexCount = header->m_vertexCount;
+	m_indexCount = header->m_indexCount;
+	m_nodesCount = header->m_nodesCount;
+	m_aabbP0 = ndVector(header->m_p0[0], header->m_p0[1], header->m_p0[2], ndFloat32(0.0f));
+	m_aabbP1 = ndVector(header->m_p1[0], header->m_p1[1], header->m_p1[2], ndFloat32(0.0f));
+	if (m_vertexCount)
+	{
+		m_localVertex = (ndFloat32*)&m_image[header->m_vertexOffset];
+		m_indices = (ndInt32*)&m_image[header->m_indexOffset];
+		m_aabb = (ndNode*)&m_image[header->m_nodeOffset];
+	}
+	return true;
+}
+
+// the arrays of a mapped image are used without copying, so every node link 
+// and face index is checked once here and not on each query.
+bool ndAabbPolygonSoup::ValidateImage(const ndNode* const nodes, ndInt32 nodesCount, const ndInt32* const indices, ndInt32 indexCount, ndInt32 vertexCount)
+{
+	for (ndInt32 i = 0; i < nodesCount; i++)
+	{
+		const ndNode::ndLeafNodePtr* const children[] = {&nodes[i].m_left, &nodes[i].m_right};
+		for (ndInt32 j = 0; j < 2; j++)
+		{
+			const ndNode::ndLeafNodePtr& child = *children[j];
+			if (!child.IsLeaf())
+			{
+				// nodes are stored breadth first, a child always comes after its parent
+				if ((ndInt64(child.m_node) <= i) || (ndInt64(child.m_node) >= nodesCount))
+				{
+					return false;
+				}
+			}
+			else
+			{
+				const ndInt32 vCount = ndInt32(child.GetCount());
+				if (vCount)
+				{
+					// index format: i0, i1, i2, ... , id, normal, e0Normal, e1Normal, e2Normal, ..., faceSize
+					const ndInt64 start = ndInt64(child.GetIndex());
+					if ((start + 2 * vCount + 3) > indexCount)
+					{
+						return false;
+					}
+					const ndInt32* const face = &indices[start];
+					for (ndInt32 k = 0; k < vCount; k++)
+					{
+						const ndInt32 edgeNormal = face[vCount + 2 + k] & (~D_CONCAVE_EDGE_MASK);
+						if ((face[k] < 0) || (face[k] >= vertexCount) || (edgeNormal >= vertexCount))
+						{
+							return false;
+						}
+					}
+					if ((face[vCount + 1] < 0) || (face[vCount + 1] >= vertexCount))
+					{
+						return false;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
 void ndAabbPolygonSoup::Deserialize (const char* const path)
 {
 	FILE* const file = fopen(path, "rb");
@@ -1217,31 +1577,100 @@ void ndAabbPolygonSoup::Deserialize (const char* const path)
 	{
 		size_t readValues = 0; 
 		m_strideInBytes = sizeof(ndTriplex);
-		readValues = fread(&m_vertexCount, sizeof(ndInt32), 1, file);
-		readValues = fread(&m_indexCount, sizeof(ndInt32), 1, file);
-		readValues = fread(&m_nodesCount, sizeof(ndInt32), 1, file);
+		m_localVertex = nullptr;
+		m_indices = nullptr;
+		m_aabb = nullptr;
 
-		if (m_vertexCount) 
+		ndImageHeader header;
+		readValues = fread(&header, sizeof(ndImageHeader), 1, file);
+		if ((readValues == 1) && (header.m_magic == D_AABB_SOUP_IMAGE_MAGIC))
 		{
-			m_localVertex = (ndFloat32*)ndMemory::Malloc(sizeof(ndTriplex) * m_vertexCount);
-			m_indices = (ndInt32*)ndMemory::Malloc(sizeof(ndInt32) * m_indexCount);
-			m_aabb = (ndNode*)ndMemory::Malloc(sizeof(ndNode) * m_nodesCount);
-
-			readValues = fread(m_localVertex, sizeof(ndTriplex) * m_vertexCount, 1, file);
-			readValues = fread(m_indices, sizeof(ndInt32) * m_indexCount, 1, file);
-			readValues = fread(m_aabb, sizeof(ndNode) * m_nodesCount, 1, file);
+			// the image is used in place, a bad image loads as an empty soup
+			if (!MapImage(path))
+			{
+				m_vertexCount = 0;
+				m_indexCount = 0;
+				m_nodesCount = 0;
+			}
 		}
-		else 
+		else
 		{
-			m_localVertex = nullptr;
-			m_indices = nullptr;
-			m_aabb = nullptr;
+			// files saved before the image format, the node boxes were
+			// stored as vertex indices, so they are quantized here.
+			fseek(file, 0, SEEK_SET);
+			readValues = fread(&m_vertexCount, sizeof(ndInt32), 1, file);
+			readValues = fread(&m_indexCount, sizeof(ndInt32), 1, file);
+			readValues = fread(&m_nodesCount, sizeof(ndInt32), 1, file);
+			if (m_vertexCount) 
+			{
+				m_localVertex = (ndFloat32*)ndMemory::Malloc(sizeof(ndTriplex) * m_vertexCount);
+				m_indices = (ndInt32*)ndMemory::Malloc(sizeof(ndInt32) * m_indexCount);
+				m_aabb = (ndNode*)ndMemory::Malloc(sizeof(ndNode) * m_nodesCount);
+
+				ndStack<ndLegacyNode> legacyNodes(m_nodesCount);
+				readValues = fread(m_localVertex, sizeof(ndTriplex) * m_vertexCount, 1, file);
+				readValues = fread(m_indices, sizeof(ndInt32) * m_indexCount, 1, file);
+				readValues = fread(&legacyNodes[0], sizeof(ndLegacyNode) * m_nodesCount, 1, file);
+				QuantizeLegacyNodes(&legacyNodes[0]);
+			}
 		}
-
 		fclose(file);
 	}
 }
 
+void ndAabbPolygonSoup::QuantizeLegacyNodes(const ndLegacyNode* const legacyNodes)
+{
+	const ndTriplex* const vertexArray = (ndTriplex*)m_localVertex;
+	for (ndInt32 i = 0; i < m_nodesCount; i++)
+	{
+		m_aabb[i].m_left.m_node = legacyNodes[i].m_left;
+		m_aabb[i].m_right.m_node = legacyNodes[i].m_right;
+	}
+
+	m_aabbP0 = ndVector(&vertexArray[legacyNodes[0].m_indexBox0].m_x) & ndVector::m_triplexMask;
+	m_aabbP1 = ndVector(&vertexArray[legacyNodes[0].m_indexBox1].m_x) & ndVector::m_triplexMask;
+
+	ndInt32 stack = 1;
+	ndInt32 stackPool[DG_STACK_DEPTH];
+	ndVector stackBox[DG_STACK_DEPTH][2];
+	stackPool[0] = 0;
+	stackBox[0][0] = m_aabbP0;
+	stackBox[0][1] = m_aabbP1;
+	while (stack)
+	{
+		stack--;
+		const ndInt32 index = stackPool[stack];
+		const ndVector parentP0(stackBox[stack][0]);
+		const ndVector parentP1(stackBox[stack][1]);
+		const ndLegacyNode& legacyNode = legacyNodes[index];
+		ndNode* const node = &m_aabb[index];
+
+		const ndVector p0(ndVector(&vertexArray[legacyNode.m_indexBox0].m_x) & ndVector::m_triplexMask);
+		const ndVector p1(ndVector(&vertexArray[legacyNode.m_indexBox1].m_x) & ndVector::m_triplexMask);
+		node->SetAabb(parentP0, parentP1, p0, p1);
+
+		ndVector q0;
+		ndVector q1;
+		node->GetAabb(parentP0, parentP1, q0, q1);
+		if (!node->m_left.IsLeaf())
+		{
+			dAssert(stack < DG_STACK_DEPTH);
+			stackPool[stack] = ndInt32(node->m_left.GetNode(m_aabb) - m_aabb);
+			stackBox[stack][0] = q0;
+			stackBox[stack][1] = q1;
+			stack++;
+		}
+		if (!node->m_right.IsLeaf())
+		{
+			dAssert(stack < DG_STACK_DEPTH);
+			stackPool[stack] = ndInt32(node->m_right.GetNode(m_aabb) - m_aabb);
+			stackBox[stack][0] = q0;
+			stackBox[stack][1] = q1;
+			stack++;
+		}
+	}
+}
+
 ndVector ndAabbPolygonSoup::ForAllSectorsSupportVectex (const ndVector& dir) const
 {
 	ndVector supportVertex (ndFloat32 (0.0f));
@@ -1249,9 +1678,12 @@ ndVector ndAabbPolygonSoup::ForAllSectorsSupportVectex (const ndVector& dir) con
 	{
 		ndFloat32 aabbProjection[DG_STACK_DEPTH];
 		const ndNode *stackPool[DG_STACK_DEPTH];
+		ndVector stackBox[DG_STACK_DEPTH][2];
 
 		ndInt32 stack = 1;
 		stackPool[0] = m_aabb;
+		stackBox[0][0] = m_aabbP0;
+		stackBox[0][1] = m_aabbP1;
 		aabbProjection[0] = ndFloat32 (1.0e10f);
 		const ndTriplex* const boxArray = (ndTriplex*)m_localVertex;
 
@@ -1270,6 +1702,10 @@ ndVector ndAabbPolygonSoup::ForAllSectorsSupportVectex (const ndVector& dir) con
 				ndFloat32 backSupportDist = ndFloat32 (0.0f);
 				ndFloat32 frontSupportDist = ndFloat32 (0.0f);
 				const ndNode* const me = stackPool[stack];
+				const ndVector meP0 (stackBox[stack][0]);
+				const ndVector meP1 (stackBox[stack][1]);
+				ndVector backBox[2];
+				ndVector frontBox[2];
 				if (me->m_left.IsLeaf()) 
 				{
 					backSupportDist = ndFloat32 (-1.0e20f);
@@ -1298,16 +1734,9 @@ ndVector ndAabbPolygonSoup::ForAllSectorsSupportVectex (const ndVector& dir) con
 				} 
 				else 
 				{
-					ndVector box[2];
 					const ndNode* const node = me->m_left.GetNode(m_aabb);
-					box[0].m_x = boxArray[node->m_indexBox0].m_x;
-					box[0].m_y = boxArray[node->m_indexBox0].m_y;
-					box[0].m_z = boxArray[node->m_indexBox0].m_z;
-					box[1].m_x = boxArray[node->m_indexBox1].m_x;
-					box[1].m_y = boxArray[node->m_indexBox1].m_y;
-					box[1].m_z = boxArray[node->m_indexBox1].m_z;
-
-					ndVector supportPoint (box[ix].m_x, box[iy].m_y, box[iz].m_z, ndFloat32 (0.0));
+					node->GetAabb(meP0, meP1, backBox[0], backBox[1]);
+					ndVector supportPoint (backBox[ix].m_x, backBox[iy].m_y, backBox[iz].m_z, ndFloat32 (0.0));
 					backSupportDist = supportPoint.DotProduct(dir).GetScalar();
 				}
 
@@ -1338,16 +1767,9 @@ ndVector ndAabbPolygonSoup::ForAllSectorsSupportVectex (const ndVector& dir) con
 				} 
 				else 
 				{
-					ndVector box[2];
 					const ndNode* const node = me->m_right.GetNode(m_aabb);
-					box[0].m_x = boxArray[node->m_indexBox0].m_x;
-					box[0].m_y = boxArray[node->m_indexBox0].m_y;
-					box[0].m_z = boxArray[node->m_indexBox0].m_z;
-					box[1].m_x = boxArray[node->m_indexBox1].m_x;
-					box[1].m_y = boxArray[node->m_indexBox1].m_y;
-					box[1].m_z = boxArray[node->m_indexBox1].m_z;
-
-					ndVector supportPoint (box[ix].m_x, box[iy].m_y, box[iz].m_z, ndFloat32 (0.0f));
+					node->GetAabb(meP0, meP1, frontBox[0], frontBox[1]);
+					ndVector supportPoint (frontBox[ix].m_x, frontBox[iy].m_y, frontBox[iz].m_z, ndFloat32 (0.0f));
 					frontSupportDist = supportPoint.DotProduct(dir).GetScalar();
 				}
 
@@ -1357,6 +1779,8 @@ ndVector ndAabbPolygonSoup::ForAllSectorsSupportVectex (const ndVector& dir) con
 					{
 						aabbProjection[stack] = backSupportDist;
 						stackPool[stack] = me->m_left.GetNode(m_aabb);
+						stackBox[stack][0] = backBox[0];
+						stackBox[stack][1] = backBox[1];
 						stack++;
 					}
 
@@ -1364,6 +1788,8 @@ ndVector ndAabbPolygonSoup::ForAllSectorsSupportVectex (const ndVector& dir) con
 					{
 						aabbProjection[stack] = frontSupportDist;
 						stackPool[stack] = me->m_right.GetNode(m_aabb);
+						stackBox[stack][0] = frontBox[0];
+						stackBox[stack][1] = frontBox[1];
 						stack++;
 					}
 
@@ -1374,6 +1800,8 @@ ndVector ndAabbPolygonSoup::ForAllSectorsSupportVectex (const ndVector& dir) con
 					{
 						aabbProjection[stack] = frontSupportDist;
 						stackPool[stack] = me->m_right.GetNode(m_aabb);
+						stackBox[stack][0] = frontBox[0];
+						stackBox[stack][1] = frontBox[1];
 						stack++;
 					}
 
@@ -1381,6 +1809,8 @@ ndVector ndAabbPolygonSoup::ForAllSectorsSupportVectex (const ndVector& dir) con
 					{
 						aabbProjection[stack] = backSupportDist;
 						stackPool[stack] = me->m_left.GetNode(m_aabb);
+						stackBox[stack][0] = backBox[0];
+						stackBox[stack][1] = backBox[1];
 						stack++;
 					}
 				}
@@ -1393,6 +1823,7 @@ ndVector ndAabbPolygonSoup::ForAllSectorsSupportVectex (const ndVector& dir) con
 void ndAabbPolygonSoup::ForAllSectorsRayHit (const ndFastRay& raySrc, ndFloat32 maxParam, dRayIntersectCallback callback, void* const context) const
 {
 	const ndNode *stackPool[DG_STACK_DEPTH];
+	ndVector stackBox[DG_STACK_DEPTH][2];
 	ndFloat32 distance[DG_STACK_DEPTH];
 	ndFastRay ray (raySrc);
 
@@ -1400,7 +1831,9 @@ void ndAabbPolygonSoup::ForAllSectorsRayHit (const ndFastRay& raySrc, ndFloat32
 	const ndTriplex* const vertexArray = (ndTriplex*) m_localVertex;
 
 	stackPool[0] = m_aabb;
-	distance[0] = m_aabb->RayDistance(ray, vertexArray);
+	stackBox[0][0] = m_aabbP0;
+	stackBox[0][1] = m_aabbP1;
+	distance[0] = m_aabb->RayDistance(ray, m_aabbP0, m_aabbP1);
 	while (stack) 
 	{
 		stack --;
@@ -1412,6 +1845,8 @@ void ndAabbPolygonSoup::ForAllSectorsRayHit (const ndFastRay& raySrc, ndFloat32
 		else 
 		{
 			const ndNode *const me = stackPool[stack];
+			const ndVector meP0 (stackBox[stack][0]);
+			const ndVector meP1 (stackBox[stack][1]);
 			if (me->m_left.IsLeaf()) 
 			{
 				ndInt32 vCount = ndInt32 (me->m_left.GetCount());
@@ -1434,17 +1869,24 @@ void ndAabbPolygonSoup::ForAllSectorsRayHit (const ndFastRay& raySrc, ndFloat32
 			else 
 			{
 				const ndNode* const node = me->m_left.GetNode(m_aabb);
-				ndFloat32 dist1 = node->RayDistance(ray, vertexArray);
+				ndVector nodeP0;
+				ndVector nodeP1;
+				node->GetAabb(meP0, meP1, nodeP0, nodeP1);
+				ndFloat32 dist1 = node->RayDistance(ray, nodeP0, nodeP1);
 				if (dist1 < maxParam) 
 				{
 					ndInt32 j = stack;
 					for ( ; j && (dist1 > distance[j - 1]); j --) 
 					{
 						stackPool[j] = stackPool[j - 1];
+						stackBox[j][0] = stackBox[j - 1][0];
+						stackBox[j][1] = stackBox[j - 1][1];
 						distance[j] = distance[j - 1];
 					}
 					dAssert (stack < DG_STACK_DEPTH);
 					stackPool[j] = node;
+					stackBox[j][0] = nodeP0;
+					stackBox[j][1] = nodeP1;
 					distance[j] = dist1;
 					stack++;
 				}
@@ -1471,17 +1913,24 @@ void ndAabbPolygonSoup::ForAllSectorsRayHit (const ndFastRay& raySrc, ndFloat32
 			else 
 			{
 				const ndNode* const node = me->m_right.GetNode(m_aabb);
-				ndFloat32 dist1 = node->RayDistance(ray, vertexArray);
+				ndVector nodeP0;
+				ndVector nodeP1;
+				node->GetAabb(meP0, meP1, nodeP0, nodeP1);
+				ndFloat32 dist1 = node->RayDistance(ray, nodeP0, nodeP1);
 				if (dist1 < maxParam) 
 				{
 					ndInt32 j = stack;
 					for ( ; j && (dist1 > distance[j - 1]); j --) 
 					{
 						stackPool[j] = stackPool[j - 1];
+						stackBox[j][0] = stackBox[j - 1][0];
+						stackBox[j][1] = stackBox[j - 1][1];
 						distance[j] = distance[j - 1];
 					}
 					dAssert (stack < DG_STACK_DEPTH);
 					stackPool[j] = node;
+					stackBox[j][0] = nodeP0;
+					stackBox[j][1] = nodeP1;
 					distance[j] = dist1;
 					stack++;
 				}
@@ -1504,6 +1953,7 @@ void ndAabbPolygonSoup::ForAllSectors (const ndFastAabb& obbAabbInfo, const ndVe
 	{
 		ndFloat32 distance[DG_STACK_DEPTH];
 		const ndNode* stackPool[DG_STACK_DEPTH];
+		ndVector stackBox[DG_STACK_DEPTH][2];
 
 		const ndInt32 stride = sizeof (ndTriplex) / sizeof (ndFloat32);
 		const ndTriplex* const vertexArray = (ndTriplex*) m_localVertex;
@@ -1513,7 +1963,9 @@ void ndAabbPolygonSoup::ForAllSectors (const ndFastAabb& obbAabbInfo, const ndVe
 		{
 			ndInt32 stack = 1;
 			stackPool[0] = m_aabb;
-			distance[0] = m_aabb->BoxPenetration(obbAabbInfo, vertexArray);
+			stackBox[0][0] = m_aabbP0;
+			stackBox[0][1] = m_aabbP1;
+			distance[0] = m_aabb->BoxPenetration(obbAabbInfo, m_aabbP0, m_aabbP1);
 			if (distance[0] <= ndFloat32(0.0f)) 
 			{
 				obbAabbInfo.m_separationDistance = dMin(obbAabbInfo.m_separationDistance[0], -distance[0]);
@@ -1525,6 +1977,8 @@ void ndAabbPolygonSoup::ForAllSectors (const ndFastAabb& obbAabbInfo, const ndVe
 				if (dist > ndFloat32 (0.0f)) 
 				{
 					const ndNode* const me = stackPool[stack];
+					const ndVector meP0 (stackBox[stack][0]);
+					const ndVector meP1 (stackBox[stack][1]);
 					if (me->m_left.IsLeaf()) 
 					{
 						ndInt32 index = ndInt32 (me->m_left.GetIndex());
@@ -1554,17 +2008,24 @@ void ndAabbPolygonSoup::ForAllSectors (const ndFastAabb& obbAabbInfo, const ndVe
 					else 
 					{
 						const ndNode* const node = me->m_left.GetNode(m_aabb);
-						ndFloat32 dist1 = node->BoxPenetration(obbAabbInfo, vertexArray);
+						ndVector nodeP0;
+						ndVector nodeP1;
+						node->GetAabb(meP0, meP1, nodeP0, nodeP1);
+						ndFloat32 dist1 = node->BoxPenetration(obbAabbInfo, nodeP0, nodeP1);
 						if (dist1 > ndFloat32 (0.0f)) 
 						{
 							ndInt32 j = stack;
 							for ( ; j && (dist1 > distance[j - 1]); j --) 
 							{
 								stackPool[j] = stackPool[j - 1];
+								stackBox[j][0] = stackBox[j - 1][0];
+								stackBox[j][1] = stackBox[j - 1][1];
 								distance[j] = distance[j - 1];
 							}
 							dAssert (stack < DG_STACK_DEPTH);
 							stackPool[j] = node;
+							stackBox[j][0] = nodeP0;
+							stackBox[j][1] = nodeP1;
 							distance[j] = dist1;
 							stack++;
 						} 
@@ -1603,17 +2064,24 @@ void ndAabbPolygonSoup::ForAllSectors (const ndFastAabb& obbAabbInfo, const ndVe
 					else 
 					{
 						const ndNode* const node = me->m_right.GetNode(m_aabb);
-						ndFloat32 dist1 = node->BoxPenetration(obbAabbInfo, vertexArray);
+						ndVector nodeP0;
+						ndVector nodeP1;
+						node->GetAabb(meP0, meP1, nodeP0, nodeP1);
+						ndFloat32 dist1 = node->BoxPenetration(obbAabbInfo, nodeP0, nodeP1);
 						if (dist1 > ndFloat32 (0.0f)) 
 						{
 							ndInt32 j = stack;
 							for ( ; j && (dist1 > distance[j - 1]); j --) 
 							{
 								stackPool[j] = stackPool[j - 1];
+								stackBox[j][0] = stackBox[j - 1][0];
+								stackBox[j][1] = stackBox[j - 1][1];
 								distance[j] = distance[j - 1];
 							}
 							dAssert (stack < DG_STACK_DEPTH);
 							stackPool[j] = node;
+							stackBox[j][0] = nodeP0;
+							stackBox[j][1] = nodeP1;
 							distance[j] = dist1;
 							stack++;
 						} 
@@ -1631,13 +2099,17 @@ void ndAabbPolygonSoup::ForAllSectors (const ndFastAabb& obbAabbInfo, const ndVe
 			ndFastRay obbRay (ndVector::m_zero, obbAabbInfo.UnrotateVector(boxDistanceTravel));
 			ndInt32 stack = 1;
 			stackPool[0] = m_aabb;
-			distance [0] = m_aabb->BoxIntersect (ray, obbRay, obbAabbInfo, vertexArray);
+			stackBox[0][0] = m_aabbP0;
+			stackBox[0][1] = m_aabbP1;
+			distance [0] = m_aabb->BoxIntersect(ray, obbRay, obbAabbInfo, m_aabbP0, m_aabbP1);
 
 			while (stack) 
 			{
 				stack --;
 				const ndFloat32 dist = distance[stack];
 				const ndNode* const me = stackPool[stack];
+				const ndVector meP0 (stackBox[stack][0]);
+				const ndVector meP1 (stackBox[stack][1]);
 				if (dist < ndFloat32 (1.0f)) 
 				{
 					if (me->m_left.IsLeaf()) 
@@ -1664,17 +2136,24 @@ void ndAabbPolygonSoup::ForAllSectors (const ndFastAabb& obbAabbInfo, const ndVe
 					else 
 					{
 						const ndNode* const node = me->m_left.GetNode(m_aabb);
-						ndFloat32 dist1 = node->BoxIntersect (ray, obbRay, obbAabbInfo, vertexArray);
+						ndVector nodeP0;
+						ndVector nodeP1;
+						node->GetAabb(meP0, meP1, nodeP0, nodeP1);
+						ndFloat32 dist1 = node->BoxIntersect(ray, obbRay, obbAabbInfo, nodeP0, nodeP1);
 						if (dist1 < ndFloat32 (1.0f)) 
 						{
 							ndInt32 j = stack;
 							for ( ; j && (dist1 > distance[j - 1]); j --) 
 							{
 								stackPool[j] = stackPool[j - 1];
+								stackBox[j][0] = stackBox[j - 1][0];
+								stackBox[j][1] = stackBox[j - 1][1];
 								distance[j] = distance[j - 1];
 							}
 							dAssert (stack < DG_STACK_DEPTH);
 							stackPool[j] = node;
+							stackBox[j][0] = nodeP0;
+							stackBox[j][1] = nodeP1;
 							distance[j] = dist1;
 							stack++;
 						}
@@ -1703,17 +2182,24 @@ void ndAabbPolygonSoup::ForAllSectors (const ndFastAabb& obbAabbInfo, const ndVe
 					else 
 					{
 						const ndNode* const node = me->m_right.GetNode(m_aabb);
-						ndFloat32 dist1 = node->BoxIntersect (ray, obbRay, obbAabbInfo, vertexArray);
+						ndVector nodeP0;
+						ndVector nodeP1;
+						node->GetAabb(meP0, meP1, nodeP0, nodeP1);
+						ndFloat32 dist1 = node->BoxIntersect(ray, obbRay, obbAabbInfo, nodeP0, nodeP1);
 						if (dist1 < ndFloat32 (1.0f)) 
 						{
 							ndInt32 j = stack;
 							for ( ; j && (dist1 > distance[j - 1]); j --) 
 							{
 								stackPool[j] = stackPool[j - 1];
+								stackBox[j][0] = stackBox[j - 1][0];
+								stackBox[j][1] = stackBox[j - 1][1];
 								distance[j] = distance[j - 1];
 							}
 							dAssert (stack < DG_STACK_DEPTH);
 							stackPool[j] = node;
+							stackBox[j][0] = nodeP0;
+							stackBox[j][1] = nodeP1;
 							distance[j] = dist1;
 							stack ++;
 						}
@@ -1724,7 +2210,7 @@ void ndAabbPolygonSoup::ForAllSectors (const ndFastAabb& obbAabbInfo, const ndVe
 	}
 }
 
-void ndAabbPolygonSoup::ForThisSector(const ndAabbPolygonSoup::ndNode* const node, const ndFastAabb& obbAabbInfo, const ndVector& boxDistanceTravel, ndFloat32, dAaabbIntersectCallback callback, void* const context) const
+void ndAabbPolygonSoup::ForThisSector(const ndAabbPolygonSoup::ndNode* const node, const ndVector& nodeP0, const ndVector& nodeP1, const ndFastAabb& obbAabbInfo, const ndVector& boxDistanceTravel, ndFloat32, dAaabbIntersectCallback callback, void* const context) const
 {
 	dAssert(dAbs(dAbs(obbAabbInfo[0][0]) - obbAabbInfo.m_absDir[0][0]) < ndFloat32(1.0e-4f));
 	dAssert(dAbs(dAbs(obbAabbInfo[1][1]) - obbAabbInfo.m_absDir[1][1]) < ndFloat32(1.0e-4f));
@@ -1742,7 +2228,7 @@ void ndAabbPolygonSoup::ForThisSector(const ndAabbPolygonSoup::ndNode* const nod
 		dAssert(boxDistanceTravel.m_w == ndFloat32(0.0f));
 		if (boxDistanceTravel.DotProduct(boxDistanceTravel).GetScalar() < ndFloat32(1.0e-8f))
 		{
-			ndFloat32 dist = node->BoxPenetration(obbAabbInfo, vertexArray);
+			ndFloat32 dist = node->BoxPenetration(obbAabbInfo, nodeP0, nodeP1);
 			if (dist <= ndFloat32(0.0f))
 			{
 				obbAabbInfo.m_separationDistance = dMin(obbAabbInfo.m_separationDistance[0], dist);
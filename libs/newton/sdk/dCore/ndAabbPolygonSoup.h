@@ -25,6 +25,7 @@
 #include "ndCoreStdafx.h"
 #include "ndTypes.h"
 #include "ndUtils.h"
+#include "ndArray.h"
 #include "ndFastRay.h"
 #include "ndFastAabb.h"
 #include "ndIntersections.h"
@@ -35,6 +36,10 @@ class ndPolygonSoupBuilder;
 // index format: i0, i1, i2, ... , id, normal, e0Normal, e1Normal, e2Normal, ..., faceSize
 #define D_CONCAVE_EDGE_MASK	(1<<31)
 
+// node boxes are quantized to 16 bits per axis relative to the parent box
+#define D_AABB_SOUP_QUANTIZATION	ndFloat32 (65535.0f)
+
+D_MSV_NEWTON_ALIGN_32
 class ndAabbPolygonSoup: public ndPolygonSoupDatabase
 {
 	public:
@@ -95,28 +100,69 @@ class ndAabbPolygonSoup: public ndPolygonSoupDatabase
 		};
 
 		ndNode ()
-			:m_indexBox0(0)
-			,m_indexBox1(0)
-			,m_left(0)
+			:m_left(0)
 			,m_right(0)
 		{
+			m_lo[0] = 0;
+			m_lo[1] = 0;
+			m_lo[2] = 0;
+			m_hi[0] = 0;
+			m_hi[1] = 0;
+			m_hi[2] = 0;
+		}
+
+		// the box is stored with 16 bits per axis, as the distance from the faces of the parent box 
+		inline void GetAabb (const ndVector& parentP0, const ndVector& parentP1, ndVector& p0, ndVector& p1) const
+		{
+			const ndVector scale ((parentP1 - parentP0) * ndVector (ndFloat32 (1.0f) / D_AABB_SOUP_QUANTIZATION));
+			const ndVector lo = ndVector (ndFloat32 (m_lo[0]), ndFloat32 (m_lo[1]), ndFloat32 (m_lo[2]), ndFloat32 (0.0f));
+			const ndVector hi = ndVector (ndFloat32 (m_hi[0]), ndFloat32 (m_hi[1]), ndFloat32 (m_hi[2]), ndFloat32 (0.0f));
+			p0 = (parentP0 + lo * scale) & ndVector::m_triplexMask;
+			p1 = (parentP1 - hi * scale) & ndVector::m_triplexMask;
+		}
+
+		inline void SetAabb (const ndVector& parentP0, const ndVector& parentP1, const ndVector& p0, const ndVector& p1)
+		{
+			const ndVector scale ((parentP1 - parentP0) * ndVector (ndFloat32 (1.0f) / D_AABB_SOUP_QUANTIZATION));
+			for (ndInt32 i = 0; i < 3; i ++)
+			{
+				ndFloat32 lo = ndFloat32 (0.0f);
+				ndFloat32 hi = ndFloat32 (0.0f);
+				if (scale[i] > ndFloat32 (0.0f))
+				{
+					lo = dClamp (ndFloor ((p0[i] - parentP0[i]) / scale[i]), ndFloat32 (0.0f), D_AABB_SOUP_QUANTIZATION);
+					hi = dClamp (ndFloor ((parentP1[i] - p1[i]) / scale[i]), ndFloat32 (0.0f), D_AABB_SOUP_QUANTIZATION);
+				}
+				m_lo[i] = ndUnsigned16 (lo);
+				m_hi[i] = ndUnsigned16 (hi);
+			}
+
+			// rounding can move the decoded faces inside the real box, step them out until the box is conservative
+			ndVector q0;
+			ndVector q1;
+			GetAabb (parentP0, parentP1, q0, q1);
+			for (ndInt32 i = 0; i < 3; i ++)
+			{
+				while (m_lo[i] && (q0[i] > p0[i]))
+				{
+					m_lo[i] --;
+					GetAabb (parentP0, parentP1, q0, q1);
+				}
+				while (m_hi[i] && (q1[i] < p1[i]))
+				{
+					m_hi[i] --;
+					GetAabb (parentP0, parentP1, q0, q1);
+				}
+			}
 		}
 
-		inline ndFloat32 RayDistance (const ndFastRay& ray, const ndTriplex* const vertexArray) const
+		inline ndFloat32 RayDistance (const ndFastRay& ray, const ndVector& minBox, const ndVector& maxBox) const
 		{
-			ndVector minBox (&vertexArray[m_indexBox0].m_x);
-			ndVector maxBox (&vertexArray[m_indexBox1].m_x);
-			minBox = minBox & ndVector::m_triplexMask;
-			maxBox = maxBox & ndVector::m_triplexMask;
 			return ray.BoxIntersect(minBox, maxBox);
 		}
 
-		inline ndFloat32 BoxPenetration (const ndFastAabb& obb, const ndTriplex* const vertexArray) const
+		inline ndFloat32 BoxPenetration (const ndFastAabb& obb, const ndVector& p0, const ndVector& p1) const
 		{
-			ndVector p0 (&vertexArray[m_indexBox0].m_x);
-			ndVector p1 (&vertexArray[m_indexBox1].m_x);
-			p0 = p0 & ndVector::m_triplexMask;
-			p1 = p1 & ndVector::m_triplexMask;
 			ndVector minBox (p0 - obb.m_p1);
 			ndVector maxBox (p1 - obb.m_p0);
 			dAssert(maxBox.m_x >= minBox.m_x);
@@ -157,13 +203,8 @@ class ndAabbPolygonSoup: public ndPolygonSoupDatabase
 			return	dist.GetScalar();
 		}
 
-		inline ndFloat32 BoxIntersect (const ndFastRay& ray, const ndFastRay& obbRay, const ndFastAabb& obb, const ndTriplex* const vertexArray) const
+		inline ndFloat32 BoxIntersect (const ndFastRay& ray, const ndFastRay& obbRay, const ndFastAabb& obb, const ndVector& p0, const ndVector& p1) const
 		{
-			ndVector p0 (&vertexArray[m_indexBox0].m_x);
-			ndVector p1 (&vertexArray[m_indexBox1].m_x);
-			p0 = p0 & ndVector::m_triplexMask;
-			p1 = p1 & ndVector::m_triplexMask;
-
 			ndVector minBox (p0 - obb.m_p1);
 			ndVector maxBox (p1 - obb.m_p0);
 			ndFloat32 dist = ray.BoxIntersect(minBox, maxBox);
@@ -185,19 +226,27 @@ class ndAabbPolygonSoup: public ndPolygonSoupDatabase
 			return dist;
 		}
 
-		ndInt32 m_indexBox0;
-		ndInt32 m_indexBox1;
+		ndUnsigned16 m_lo[3];
+		ndUnsigned16 m_hi[3];
 		ndLeafNodePtr m_left;
 		ndLeafNodePtr m_right;
 	};
 
 	class ndSpliteInfo;
 	class ndNodeBuilder;
+	class ndSubTreeInfo;
+	class ndImageHeader;
+	class ndLegacyNode;
 
 	D_CORE_API virtual void GetAABB (ndVector& p0, ndVector& p1) const;
 	D_CORE_API virtual void Serialize (const char* const path) const;
 	D_CORE_API virtual void Deserialize (const char* const path);
 
+	// hash of the vertices and the faces, and the size of the soup data
+	D_CORE_API ndUnsigned64 CalculateHash() const;
+	D_CORE_API bool HasSameGeometry(const ndAabbPolygonSoup& other) const;
+	D_CORE_API ndUnsigned64 GetSizeInBytes() const;
+
 	protected:
 	D_CORE_API ndAabbPolygonSoup ();
 	D_CORE_API virtual ~ndAabbPolygonSoup ();
@@ -207,7 +256,7 @@ class ndAabbPolygonSoup: public ndPolygonSoupDatabase
 	D_CORE_API virtual ndVector ForAllSectorsSupportVectex(const ndVector& dir) const;
 	D_CORE_API virtual void ForAllSectorsRayHit (const ndFastRay& ray, ndFloat32 maxT, dRayIntersectCallback callback, void* const context) const;
 	D_CORE_API virtual void ForAllSectors (const ndFastAabb& obbAabb, const ndVector& boxDistanceTravel, ndFloat32 maxT, dAaabbIntersectCallback callback, void* const context) const;
-	D_CORE_API virtual void ForThisSector(const ndAabbPolygonSoup::ndNode* const node, const ndFastAabb& obbAabb, const ndVector& boxDistanceTravel, ndFloat32 maxT, dAaabbIntersectCallback callback, void* const context) const;
+	D_CORE_API virtual void ForThisSector(const ndAabbPolygonSoup::ndNode* const node, const ndVector& nodeP0, const ndVector& nodeP1, const ndFastAabb& obbAabb, const ndVector& boxDistanceTravel, ndFloat32 maxT, dAaabbIntersectCallback callback, void* const context) const;
 
 	public:
 	inline ndNode* GetRootNode() const
@@ -225,27 +274,36 @@ class ndAabbPolygonSoup: public ndPolygonSoupDatabase
 		return node->m_right.IsLeaf() ? nullptr : node->m_right.GetNode(m_aabb);
 	}
 
-	inline void GetNodeAabb(const ndNode* const node, ndVector& p0, ndVector& p1) const
+	// the box of the root node is the box of the soup, 
+	// the box of any other node is decoded from the box of its parent.
+	inline void GetNodeAabb(const ndNode* const node, const ndVector& parentP0, const ndVector& parentP1, ndVector& p0, ndVector& p1) const
 	{
-		p0 = ndVector (&((ndTriplex*)m_localVertex)[node->m_indexBox0].m_x);
-		p1 = ndVector (&((ndTriplex*)m_localVertex)[node->m_indexBox1].m_x);
-		p0 = p0 & ndVector::m_triplexMask;
-		p1 = p1 & ndVector::m_triplexMask;
+		node->GetAabb(parentP0, parentP1, p0, p1);
 	}
 
 	private:
 	ndNodeBuilder* BuildTopDown (ndNodeBuilder* const leafArray, ndInt32 firstBox, ndInt32 lastBox, ndNodeBuilder** const allocator) const;
+	ndNodeBuilder* BuildTopDown (ndNodeBuilder* const leafArray, ndInt32 firstBox, ndInt32 lastBox, ndNodeBuilder** const allocator, ndInt32 threadCount) const;
+	ndNodeBuilder* SplitTopDown (ndNodeBuilder* const leafArray, ndInt32 firstBox, ndInt32 lastBox, ndNodeBuilder** const allocator, ndInt32 subTreeSize, ndArray<ndSubTreeInfo>& subTrees) const;
 	ndFloat32 CalculateFaceMaxSize (const ndVector* const vertex, ndInt32 indexCount, const ndInt32* const indexArray) const;
 	static dIntersectStatus CalculateDisjointedFaceEdgeNormals (void* const context, const ndFloat32* const polygon, ndInt32 strideInBytes, const ndInt32* const indexArray, ndInt32 indexCount, ndFloat32 hitDistance);
 	static dIntersectStatus CalculateAllFaceEdgeNormals(void* const context, const ndFloat32* const polygon, ndInt32 strideInBytes, const ndInt32* const indexArray, ndInt32 indexCount, ndFloat32 hitDistance);
 	void ImproveNodeFitness (ndNodeBuilder* const node) const;
+	void QuantizeLegacyNodes (const ndLegacyNode* const legacyNodes);
+	bool MapImage (const char* const path);
+	static bool ValidateImage (const ndNode* const nodes, ndInt32 nodesCount, const ndInt32* const indices, ndInt32 indexCount, ndInt32 vertexCount);
+	void UnmapImage ();
 
+	ndVector m_aabbP0;
+	ndVector m_aabbP1;
 	ndNode* m_aabb;
 	ndInt32* m_indices;
+	ndUnsigned8* m_image;
+	size_t m_imageSize;
 	ndInt32 m_nodesCount;
 	ndInt32 m_indexCount;
 	friend class ndContactSolver;
-};
+} D_GCC_NEWTON_ALIGN_32;
 
 #endif
 
@@ -23,6 +23,7 @@
 #include "ndSort.h"
 #include "ndTree.h"
 #include "ndStack.h"
+#include "ndHeap.h"
 #include "ndGoogol.h"
 #include "ndConvexHull3d.h"
 #include "ndSmallDeterminant.h"
@@ -122,6 +123,31 @@ class dgConvexHull3dPointCluster: public ndConvexHull3dAABBTreeNode
 	ndInt32 m_indices[DG_CONVEXHULL_3D_VERTEX_CLUSTER_SIZE];
 };
 
+// face used while the hull is built, the faces live in a flat array and
+// link to their neighbors and to the points above them by index.
+class ndConvexHull3dFlatFace
+{
+	public:
+	ndBigPlane m_plane;
+	ndFloat64 m_maxDist;
+	ndInt32 m_index[3];
+	ndInt32 m_twin[3];
+	ndInt32 m_conflict;
+	ndInt32 m_farthest;
+	ndInt32 m_mark;
+	ndInt32 m_alive;
+};
+
+template<class T>
+static void ndConvexHull3dGrowScratch(ndArray<T>& array, ndInt32 count)
+{
+	if (count > array.GetCapacity())
+	{
+		array.Resize(count);
+	}
+	array.SetCount(count);
+}
+
 
 ndConvexHull3dFace::ndConvexHull3dFace()
 {
@@ -131,12 +157,8 @@ ndConvexHull3dFace::ndConvexHull3dFace()
 	m_twin[2] = nullptr;
 }
 
-ndFloat64 ndConvexHull3dFace::Evalue (const ndBigVector* const pointArray, const ndBigVector& point) const
+static ndFloat64 ndConvexHull3dEvalue (const ndBigVector& p0, const ndBigVector& p1, const ndBigVector& p2, const ndBigVector& point)
 {
-	const ndBigVector& p0 = pointArray[m_index[0]];
-	const ndBigVector& p1 = pointArray[m_index[1]];
-	const ndBigVector& p2 = pointArray[m_index[2]];
-
 	ndFloat64 matrix[3][3];
 	for (ndInt32 i = 0; i < 3; i ++) {
 		matrix[0][i] = p2[i] - p0[i];
@@ -168,6 +190,11 @@ ndFloat64 ndConvexHull3dFace::Evalue (const ndBigVector* const pointArray, const
 	return Determinant3x3(exactMatrix);
 }
 
+ndFloat64 ndConvexHull3dFace::Evalue (const ndBigVector* const pointArray, const ndBigVector& point) const
+{
+	return ndConvexHull3dEvalue (pointArray[m_index[0]], pointArray[m_index[1]], pointArray[m_index[2]], point);
+}
+
 ndBigPlane ndConvexHull3dFace::GetPlaneEquation (const ndBigVector* const pointArray) const
 {
 	const ndBigVector& p0 = pointArray[m_index[0]];
@@ -179,6 +206,25 @@ ndBigPlane ndConvexHull3dFace::GetPlaneEquation (const ndBigVector* const pointA
 }
 
 
+ndConvexHull3dScratch::ndConvexHull3dScratch()
+	:ndClassAlloc()
+	,m_points()
+	,m_treePool()
+	,m_faces()
+	,m_freeFaces()
+	,m_deleteList()
+	,m_coneList()
+	,m_stack()
+	,m_conflictNext()
+	,m_coneMap()
+	,m_conePlanes()
+{
+}
+
+ndConvexHull3dScratch::~ndConvexHull3dScratch()
+{
+}
+
 ndConvexHull3d::ndConvexHull3d ()
 	:ndList<ndConvexHull3dFace>()
 	,m_aabbP0(ndBigVector (ndFloat64 (0.0f)))
@@ -224,7 +270,7 @@ ndConvexHull3d::ndConvexHull3d(const ndConvexHull3d& source)
 	}
 }
 
-ndConvexHull3d::ndConvexHull3d(const ndFloat64* const vertexCloud, ndInt32 strideInBytes, ndInt32 count, ndFloat64 distTol, ndInt32 maxVertexCount)
+ndConvexHull3d::ndConvexHull3d(const ndFloat64* const vertexCloud, ndInt32 strideInBytes, ndInt32 count, ndFloat64 distTol, ndInt32 maxVertexCount, ndConvexHull3dScratch* const scratch)
 	:ndList<ndConvexHull3dFace>()
 	,m_aabbP0(ndBigVector::m_zero)
 	,m_aabbP1(ndBigVector::m_zero)
@@ -232,44 +278,52 @@ ndConvexHull3d::ndConvexHull3d(const ndFloat64* const vertexCloud, ndInt32 strid
 	,m_diag()
 	,m_points()
 {
-	BuildHull (vertexCloud, strideInBytes, count, distTol, maxVertexCount);
+	BuildHull (vertexCloud, strideInBytes, count, distTol, maxVertexCount, scratch);
 }
 
 ndConvexHull3d::~ndConvexHull3d(void)
 {
 }
 
-void ndConvexHull3d::BuildHull (const ndFloat64* const vertexCloud, ndInt32 strideInBytes, ndInt32 count, ndFloat64 distTol, ndInt32 maxVertexCount)
+void ndConvexHull3d::BuildHull (const ndFloat64* const vertexCloud, ndInt32 strideInBytes, ndInt32 count, ndFloat64 distTol, ndInt32 maxVertexCount, ndConvexHull3dScratch* const scratch)
 {
 	ndSetPrecisionDouble precision;
 
-	ndInt32 treeCount = count / (DG_CONVEXHULL_3D_VERTEX_CLUSTER_SIZE>>1);
-	if (treeCount < 4) 
-	{
-		treeCount = 4;
-	}
-	treeCount *= 2;
+	ndConvexHull3dScratch localScratch;
+	ndConvexHull3dScratch& work = scratch ? *scratch : localScratch;
 
-	ndStack<ndConvexHull3dVertex> points (count);
-	ndStack<dgConvexHull3dPointCluster> treePool (treeCount + 256);
-	count = InitVertexArray(&points[0], vertexCloud, strideInBytes, count, &treePool[0], treePool.GetSizeInBytes());
+	// the arrays only grow, so a reused scratch stops allocating
+	ndConvexHull3dGrowScratch(work.m_points, count);
+	ndConvexHull3dVertex* const points = &work.m_points[0];
 
 #ifdef	D_OLD_CONVEXHULL_3D
+	// the 3d hull does not use the point tree
+	count = InitVertexArray(points, vertexCloud, strideInBytes, count, nullptr, 0);
 	if (m_count >= 4) 
 	{
-		CalculateConvexHull3d (&treePool[0], &points[0], count, distTol, maxVertexCount);
+		CalculateConvexHull3d (points, count, distTol, maxVertexCount, work);
 	}
 #else
+	ndInt32 treeCount = count / (DG_CONVEXHULL_3D_VERTEX_CLUSTER_SIZE>>1);
+	if (treeCount < 4) 
+	{
+		treeCount = 4;
+	}
+	treeCount *= 2;
+
+	ndConvexHull3dGrowScratch(work.m_treePool, treeCount + 256);
+	dgConvexHull3dPointCluster* const treePool = &work.m_treePool[0];
+	count = InitVertexArray(points, vertexCloud, strideInBytes, count, treePool, ndInt32 (sizeof (dgConvexHull3dPointCluster)) * work.m_treePool.GetCount());
 	if (m_count >= 3) 
 	{
-		if (CheckFlatSurface(&treePool[0], &points[0], count, distTol, maxVertexCount))
+		if (CheckFlatSurface(treePool, points, count, distTol, maxVertexCount))
 		{
-			CalculateConvexHull2d(&treePool[0], &points[0], count, distTol, maxVertexCount);
+			CalculateConvexHull2d(treePool, points, count, distTol, maxVertexCount);
 		} 
 		else 
 		{
 			dAssert(m_count == 4);
-			CalculateConvexHull3d(&treePool[0], &points[0], count, distTol, maxVertexCount);
+			CalculateConvexHull3d(points, count, distTol, maxVertexCount, work);
 		}
 	}
 #endif
@@ -475,20 +529,33 @@ ndInt32 ndConvexHull3d::InitVertexArray(ndConvexHull3dVertex* const points, cons
 		m_count = 0;
 		return count;
 	}
+#ifdef D_OLD_CONVEXHULL_3D
+	// only the points of the starting tetrahedron are searched here, 
+	// a linear scan finds them without building the point tree.
+	ndBigVector minP ( ndFloat32 (1.0e15f));
+	ndBigVector maxP (-ndFloat32 (1.0e15f));
+	for (ndInt32 i = 0; i < count; i ++) 
+	{
+		minP = minP.GetMin(points[i]);
+		maxP = maxP.GetMax(points[i]);
+	}
+	m_aabbP0 = (minP - ndBigVector (ndFloat64 (1.0e-3f))) & ndBigVector::m_triplexMask;
+	m_aabbP1 = (maxP + ndBigVector (ndFloat64 (1.0e-3f))) & ndBigVector::m_triplexMask;
+#else
 	ndConvexHull3dAABBTreeNode* tree = BuildTree (nullptr, points, count, 0, (ndInt8**) &memoryPool, maxMemSize);
-
-	m_points.SetCount(count);
 	m_aabbP0 = tree->m_box[0];
 	m_aabbP1 = tree->m_box[1];
+#endif
 
-	ndBigVector boxSize (tree->m_box[1] - tree->m_box[0]);
+	m_points.SetCount(count);
+	ndBigVector boxSize (m_aabbP1 - m_aabbP0);
 	dAssert (boxSize.m_w == ndFloat32 (0.0f));
 	m_diag = ndFloat32 (sqrt (boxSize.DotProduct(boxSize).GetScalar()));
 
 #ifdef D_OLD_CONVEXHULL_3D
 	const ndNormalMap& normalMap = ndNormalMap::GetNormaMap();
 
-	ndInt32 index0 = SupportVertex (&tree, points, normalMap.m_normal[0]);
+	ndInt32 index0 = SupportVertex (points, count, normalMap.m_normal[0]);
 	m_points[0] = points[index0];
 	points[index0].m_mark = 1;
 
@@ -496,7 +563,7 @@ ndInt32 ndConvexHull3d::InitVertexArray(ndConvexHull3dVertex* const points, cons
 	ndBigVector e1 (ndBigVector::m_zero);
 	for (ndInt32 i = 1; i < normalMap.m_count; i ++) 
 	{
-		ndInt32 index = SupportVertex (&tree, points, normalMap.m_normal[i]);
+		ndInt32 index = SupportVertex (points, count, normalMap.m_normal[i]);
 		dAssert (index >= 0);
 
 		e1 = points[index] - m_points[0];
@@ -522,7 +589,7 @@ ndInt32 ndConvexHull3d::InitVertexArray(ndConvexHull3dVertex* const points, cons
 	ndBigVector normal (ndBigVector::m_zero);
 	for (ndInt32 i = 2; i < normalMap.m_count; i ++) 
 	{
-		ndInt32 index = SupportVertex (&tree, points, normalMap.m_normal[i]);
+		ndInt32 index = SupportVertex (points, count, normalMap.m_normal[i]);
 		dAssert (index >= 0);
 		e2 = points[index] - m_points[0];
 		normal = e1.CrossProduct(e2);
@@ -550,7 +617,7 @@ ndInt32 ndConvexHull3d::InitVertexArray(ndConvexHull3dVertex* const points, cons
 	validTetrahedrum = false;
 	ndBigVector e3(ndBigVector::m_zero);
 
-	index0 = SupportVertex (&tree, points, normal);
+	index0 = SupportVertex (points, count, normal);
 	e3 = points[index0] - m_points[0];
 	dAssert (e3.m_w == ndFloat32 (0.0f));
 	ndFloat64 err2 = normal.DotProduct(e3).GetScalar();
@@ -564,7 +631,7 @@ ndInt32 ndConvexHull3d::InitVertexArray(ndConvexHull3dVertex* const points, cons
 	if (!validTetrahedrum) 
 	{
 		ndVector n (normal.Scale(ndFloat64 (-1.0f)));
-		ndInt32 index = SupportVertex (&tree, points, n);
+		ndInt32 index = SupportVertex (points, count, n);
 		e3 = points[index] - m_points[0];
 		dAssert (e3.m_w == ndFloat32 (0.0f));
 		ndFloat64 error2 = normal.DotProduct(e3).GetScalar();
@@ -580,7 +647,7 @@ ndInt32 ndConvexHull3d::InitVertexArray(ndConvexHull3dVertex* const points, cons
 	{
 		for (ndInt32 i = 3; i < normalMap.m_count; i ++) 
 		{
-			ndInt32 index = SupportVertex (&tree, points, normalMap.m_normal[i]);
+			ndInt32 index = SupportVertex (points, count, normalMap.m_normal[i]);
 			dAssert (index >= 0);
 
 			//make sure the volume of the fist tetrahedral is no negative
@@ -671,6 +738,31 @@ ndFloat64 ndConvexHull3d::TetrahedrumVolume (const ndBigVector& p0, const ndBigV
 	return p3p0.DotProduct(p1p0.CrossProduct(p2p0)).GetScalar();
 }
 
+ndInt32 ndConvexHull3d::SupportVertex (const ndConvexHull3dVertex* const points, ndInt32 count, const ndBigVector& dirPlane) const
+{
+	const ndBigVector dir(dirPlane & ndBigPlane::m_triplexMask);
+	dAssert (dir.m_w == ndFloat32 (0.0f));
+
+	ndInt32 index = -1;
+	ndFloat64 maxProj = ndFloat64 (-1.0e20f);
+	for (ndInt32 i = 0; i < count; i ++) 
+	{
+		const ndConvexHull3dVertex& p = points[i];
+		if (!p.m_mark) 
+		{
+			dAssert (p.m_w == ndFloat32 (0.0f));
+			ndFloat64 dist = p.DotProduct(dir).GetScalar();
+			if (dist > maxProj) 
+			{
+				maxProj = dist;
+				index = i;
+			}
+		}
+	}
+	dAssert (index != -1);
+	return index;
+}
+
 ndInt32 ndConvexHull3d::SupportVertex (ndConvexHull3dAABBTreeNode** const treePointer, const ndConvexHull3dVertex* const points, const ndBigVector& dirPlane, const bool removeEntry) const
 {
 	#define DG_STACK_DEPTH_3D 64
@@ -881,213 +973,373 @@ void ndConvexHull3d::CalculateConvexHull2d(ndConvexHull3dAABBTreeNode*, ndConvex
 
 }
 
-void ndConvexHull3d::CalculateConvexHull3d (ndConvexHull3dAABBTreeNode* vertexTree, ndConvexHull3dVertex* const points, ndInt32 count, ndFloat64 distTol, ndInt32 maxVertexCount)
+void ndConvexHull3d::CalculateConvexHull3d (ndConvexHull3dVertex* const points, ndInt32 count, ndFloat64 distTol, ndInt32 maxVertexCount, ndConvexHull3dScratch& scratch)
 {
+	// quick hull with conflict lists. Every point outside the hull is kept in the list
+	// of the face it is farthest above, points that end inside the hull are dropped
+	// as soon as the faces that had them are deleted, so each point is only tested
+	// against the faces that replace the ones it was above.
 	distTol = dAbs (distTol) * m_diag;
-	ndNode* const f0Node = AddFace (0, 1, 2);
-	ndNode* const f1Node = AddFace (0, 2, 3);
-	ndNode* const f2Node = AddFace (2, 1, 3);
-	ndNode* const f3Node = AddFace (1, 0, 3);
-
-	ndConvexHull3dFace* const f0 = &f0Node->GetInfo();
-	ndConvexHull3dFace* const f1 = &f1Node->GetInfo();
-	ndConvexHull3dFace* const f2 = &f2Node->GetInfo();
-	ndConvexHull3dFace* const f3 = &f3Node->GetInfo();
-
-	f0->m_twin[0] = (ndList<ndConvexHull3dFace>::ndNode*)f3Node;
-	f0->m_twin[1] = (ndList<ndConvexHull3dFace>::ndNode*)f2Node;
-	f0->m_twin[2] = (ndList<ndConvexHull3dFace>::ndNode*)f1Node;
-
-	f1->m_twin[0] = (ndList<ndConvexHull3dFace>::ndNode*)f0Node;
-	f1->m_twin[1] = (ndList<ndConvexHull3dFace>::ndNode*)f2Node;
-	f1->m_twin[2] = (ndList<ndConvexHull3dFace>::ndNode*)f3Node;
-
-	f2->m_twin[0] = (ndList<ndConvexHull3dFace>::ndNode*)f0Node;
-	f2->m_twin[1] = (ndList<ndConvexHull3dFace>::ndNode*)f3Node;
-	f2->m_twin[2] = (ndList<ndConvexHull3dFace>::ndNode*)f1Node;
-
-	f3->m_twin[0] = (ndList<ndConvexHull3dFace>::ndNode*)f0Node;
-	f3->m_twin[1] = (ndList<ndConvexHull3dFace>::ndNode*)f1Node;
-	f3->m_twin[2] = (ndList<ndConvexHull3dFace>::ndNode*)f2Node;
-
-	ndList<ndNode*> boundaryFaces;
-
-	boundaryFaces.Append(f0Node);
-	boundaryFaces.Append(f1Node);
-	boundaryFaces.Append(f2Node);
-	boundaryFaces.Append(f3Node);
-	count -= 4;
-	maxVertexCount -= 4;
-	ndInt32 currentIndex = 4;
-
-	ndStack<ndNode*> stackPool(1024 + m_count);
-	ndStack<ndNode*> coneListPool(1024 + m_count);
-	ndStack<ndNode*> deleteListPool(1024 + m_count);
-
-	ndNode** const stack = &stackPool[0];
-	ndNode** const coneList = &stackPool[0];
-	ndNode** const deleteList = &deleteListPool[0];
 
-	while (boundaryFaces.GetCount() && count && (maxVertexCount > 0)) 
+	ndArray<ndConvexHull3dFlatFace>& faces = scratch.m_faces;
+	ndArray<ndInt32>& freeFaces = scratch.m_freeFaces;
+	ndArray<ndInt32>& deleteList = scratch.m_deleteList;
+	ndArray<ndInt32>& coneList = scratch.m_coneList;
+	ndArray<ndInt32>& stack = scratch.m_stack;
+	ndArray<ndBigVector>& conePlanes = scratch.m_conePlanes;
+	ndArray<ndInt32>& conflictNext = scratch.m_conflictNext;
+	ndArray<ndInt32>& coneMap = scratch.m_coneMap;
+	faces.SetCount(0);
+	freeFaces.SetCount(0);
+	deleteList.SetCount(0);
+	coneList.SetCount(0);
+	stack.SetCount(0);
+	conePlanes.SetCount(0);
+	ndConvexHull3dGrowScratch(conflictNext, count);
+	ndConvexHull3dGrowScratch(coneMap, count);
+
+	const ndBigVector padPlane(ndFloat64(0.0f), ndFloat64(0.0f), ndFloat64(0.0f), ndFloat64(-1.0e30f));
+
+	// the starting tetrahedron
+	const ndInt32 tetraIndex[4][3] = { { 0, 1, 2 }, { 0, 2, 3 }, { 2, 1, 3 }, { 1, 0, 3 } };
+	const ndInt32 tetraTwin[4][3] = { { 3, 2, 1 }, { 0, 2, 3 }, { 0, 3, 1 }, { 0, 1, 2 } };
+	for (ndInt32 i = 0; i < 4; i++)
 	{
-		// my definition of the optimal convex hull of a given vertex count,
-		// is the convex hull formed by a subset of the input vertex that minimizes the volume difference
-		// between the perfect hull formed from all input vertex and the hull of the sub set of vertex.
-		// When using a priority heap this algorithms will generate the an optimal of a fix vertex count.
-		// Since all Newton's tools do not have a limit on the point count of a convex hull, I can use either a stack or a queue.
-		// a stack maximize construction speed, a Queue tend to maximize the volume of the generated Hull approaching a perfect Hull.
-		// For now we use a queue.
-		// For general hulls it does not make a difference if we use a stack, queue, or a priority heap.
-		// perfect optimal hull only apply for when build hull of a limited vertex count.
-		//
-		// Also when building Hulls of a limited vertex count, this function runs in constant time.
-		// yes that is correct, it does not makes a difference if you build a N point hull from 100 vertex
-		// or from 100000 vertex input array.
-
-		#if 0
-			// using stack (faster)
-			dNode* const faceNode = boundaryFaces.GetFirst()->GetInfo();
-		#else
-			// using a queue (some what slower by better hull when reduced vertex count is desired)
-			ndNode* const faceNode = boundaryFaces.GetLast()->GetInfo();
-		#endif
-
-		ndConvexHull3dFace* const face = &faceNode->GetInfo();
-		ndBigPlane planeEquation (face->GetPlaneEquation (&m_points[0]));
-
-		ndInt32 index = SupportVertex (&vertexTree, points, planeEquation);
-		const ndBigVector& p = points[index];
-		ndFloat64 dist = planeEquation.Evalue(p);
-
-		if ((dist >= distTol) && (face->Evalue(&m_points[0], p) > ndFloat64(0.0f))) 
+		ndConvexHull3dFlatFace face;
+		for (ndInt32 j = 0; j < 3; j++)
 		{
-			dAssert (Sanity());
+			face.m_index[j] = tetraIndex[i][j];
+			face.m_twin[j] = tetraTwin[i][j];
+		}
+		ndBigPlane plane(m_points[face.m_index[0]], m_points[face.m_index[1]], m_points[face.m_index[2]]);
+		face.m_plane = plane.Scale(ndFloat64(1.0f) / sqrt(plane.DotProduct(plane & ndBigVector::m_triplexMask).GetScalar()));
+		face.m_maxDist = ndFloat64(0.0f);
+		face.m_conflict = -1;
+		face.m_farthest = -1;
+		face.m_mark = 0;
+		face.m_alive = 1;
+		faces.PushBack(face);
+		coneList.PushBack(i);
+	}
 
-			dAssert (faceNode);
-			stack[0] = faceNode;
+	// the planes of the new faces are kept in groups of four, so that
+	// a point can be tested against four faces with one vector operation.
+	class ndConePlanes
+	{
+		public:
+		static void Set(ndArray<ndBigVector>& conePlanes, const ndArray<ndConvexHull3dFlatFace>& faces, const ndArray<ndInt32>& coneList, const ndBigVector& padPlane)
+		{
+			const ndInt32 groups = (coneList.GetCount() + 3) >> 2;
+			conePlanes.SetCount(groups * 4);
+			for (ndInt32 i = 0; i < groups; i++)
+			{
+				ndBigVector plane[4];
+				for (ndInt32 j = 0; j < 4; j++)
+				{
+					const ndInt32 k = i * 4 + j;
+					plane[j] = (k < coneList.GetCount()) ? faces[coneList[k]].m_plane : padPlane;
+				}
+				conePlanes[i * 4 + 0] = ndBigVector(plane[0].m_x, plane[1].m_x, plane[2].m_x, plane[3].m_x);
+				conePlanes[i * 4 + 1] = ndBigVector(plane[0].m_y, plane[1].m_y, plane[2].m_y, plane[3].m_y);
+				conePlanes[i * 4 + 2] = ndBigVector(plane[0].m_z, plane[1].m_z, plane[2].m_z, plane[3].m_z);
+				conePlanes[i * 4 + 3] = ndBigVector(plane[0].m_w, plane[1].m_w, plane[2].m_w, plane[3].m_w);
+			}
+		}
 
-			ndInt32 stackIndex = 1;
-			ndInt32 deletedCount = 0;
+		// add the point to the conflict list of the face it is farthest above, if any.
+		static void Assign(ndInt32 pointIndex, const ndBigVector& point, ndFloat64 distTol, const ndArray<ndBigVector>& conePlanes, const ndArray<ndInt32>& coneList, ndArray<ndConvexHull3dFlatFace>& faces, ndInt32* const conflictNext)
+		{
+			const ndBigVector px(point.m_x);
+			const ndBigVector py(point.m_y);
+			const ndBigVector pz(point.m_z);
+			ndInt32 bestFace = -1;
+			ndFloat64 bestDist = distTol;
+			for (ndInt32 i = 0; i < conePlanes.GetCount(); i += 4)
+			{
+				const ndBigVector dist(conePlanes[i] * px + conePlanes[i + 1] * py + conePlanes[i + 2] * pz + conePlanes[i + 3]);
+				if (dist.GetMax().GetScalar() > bestDist)
+				{
+					for (ndInt32 j = 0; j < 4; j++)
+					{
+						if (dist[j] > bestDist)
+						{
+							bestDist = dist[j];
+							bestFace = coneList[i + j];
+						}
+					}
+				}
+			}
 
-			while (stackIndex) 
+			if (bestFace >= 0)
 			{
-				stackIndex --;
-				ndNode* const node1 = stack[stackIndex];
-				ndConvexHull3dFace* const face1 = &node1->GetInfo();
+				ndConvexHull3dFlatFace& face = faces[bestFace];
+				conflictNext[pointIndex] = face.m_conflict;
+				face.m_conflict = pointIndex;
+				if ((face.m_farthest < 0) || (bestDist > face.m_maxDist))
+				{
+					face.m_maxDist = bestDist;
+					face.m_farthest = pointIndex;
+				}
+			}
+		}
+	};
+
+	ndConePlanes::Set(conePlanes, faces, coneList, padPlane);
+	for (ndInt32 i = 0; i < count; i++)
+	{
+		if (!points[i].m_mark)
+		{
+			ndConePlanes::Assign(i, points[i], distTol, conePlanes, coneList, faces, &conflictNext[0]);
+		}
+	}
+
+	// the farthest point of all is added first, that is the vertex that removes the most
+	// volume from the difference between the perfect hull and the hull built so far.
+	// when the vertex count is limited this makes the best hull of that count, otherwise
+	// it keeps the number of points that end up inside the hull small.
+	class ndFaceHeap: public ndDownHeap<ndInt32, ndFloat64>
+	{
+		public:
+		ndFaceHeap(ndInt32 size)
+			:ndDownHeap<ndInt32, ndFloat64>(size)
+		{
+		}
 
-				if (!face1->m_mark && (face1->Evalue(&m_points[0], p) > ndFloat64(0.0f))) 
+		// faces that were deleted or got a new farthest point leave stale entries,
+		// when the heap is full they are dropped and the live faces pushed again.
+		void Add(const ndArray<ndConvexHull3dFlatFace>& faces, ndInt32 index)
+		{
+			if (GetCount() >= GetMaxCount())
+			{
+				Flush();
+				for (ndInt32 i = 0; (i < faces.GetCount()) && (GetCount() < GetMaxCount()); i++)
 				{
-					#ifdef _DEBUG
-					for (ndInt32 i = 0; i < deletedCount; i ++) 
+					if (faces[i].m_alive && (faces[i].m_farthest >= 0))
 					{
-						dAssert (deleteList[i] != node1);
+						Push(i, faces[i].m_maxDist);
 					}
-					#endif
+				}
+			}
+			else
+			{
+				Push(index, faces[index].m_maxDist);
+			}
+		}
+	};
+	ndFaceHeap heap(4 * dMin(maxVertexCount, count) + 64);
+	for (ndInt32 i = 0; i < 4; i++)
+	{
+		if (faces[i].m_farthest >= 0)
+		{
+			heap.Add(faces, i);
+		}
+	}
 
-					deleteList[deletedCount] = node1;
-					deletedCount ++;
-					dAssert (deletedCount < ndInt32 (deleteListPool.GetElementsCount()));
-					face1->m_mark = 1;
-					for (ndInt32 i = 0; i < 3; i ++) 
+	ndInt32 mark = 0;
+	ndInt32 currentIndex = 4;
+	maxVertexCount -= 4;
+	while (maxVertexCount > 0)
+	{
+		ndInt32 faceIndex = -1;
+		while (heap.GetCount() && (faceIndex < 0))
+		{
+			const ndInt32 index = heap[0];
+			const ndFloat64 dist = heap.Value();
+			heap.Pop();
+			const ndConvexHull3dFlatFace& face = faces[index];
+			if (face.m_alive && (face.m_farthest >= 0) && (face.m_maxDist == dist))
+			{
+				faceIndex = index;
+			}
+		}
+		if (faceIndex < 0)
+		{
+			break;
+		}
+
+		const ndInt32 pointIndex = faces[faceIndex].m_farthest;
+		const ndBigVector& p = points[pointIndex];
+		{
+			const ndConvexHull3dFlatFace& face = faces[faceIndex];
+			if (ndConvexHull3dEvalue(m_points[face.m_index[0]], m_points[face.m_index[1]], m_points[face.m_index[2]], p) <= ndFloat64(0.0f))
+			{
+				// the point is on the plane of the face, drop it and try the next one
+				ndConvexHull3dFlatFace& face1 = faces[faceIndex];
+				points[pointIndex].m_mark = 1;
+				ndInt32 conflict = face1.m_conflict;
+				face1.m_conflict = -1;
+				face1.m_farthest = -1;
+				face1.m_maxDist = ndFloat64(0.0f);
+				while (conflict >= 0)
+				{
+					const ndInt32 next = conflictNext[conflict];
+					if (conflict != pointIndex)
 					{
-						ndNode* const twinNode = (ndNode*)face1->m_twin[i];
-						dAssert (twinNode);
-						ndConvexHull3dFace* const twinFace = &twinNode->GetInfo();
-						if (!twinFace->m_mark) 
+						conflictNext[conflict] = face1.m_conflict;
+						face1.m_conflict = conflict;
+						const ndFloat64 dist = face1.m_plane.Evalue(points[conflict]);
+						if ((face1.m_farthest < 0) || (dist > face1.m_maxDist))
 						{
-							stack[stackIndex] = twinNode;
-							stackIndex ++;
-							dAssert (stackIndex < ndInt32 (stackPool.GetElementsCount()));
+							face1.m_maxDist = dist;
+							face1.m_farthest = conflict;
 						}
 					}
+					conflict = next;
 				}
+				if (face1.m_farthest >= 0)
+				{
+					heap.Add(faces, faceIndex);
+				}
+				continue;
 			}
+		}
 
-			m_points[currentIndex] = points[index];
-			points[index].m_mark = 1;
-
-			ndInt32 newCount = 0;
-			for (ndInt32 i = 0; i < deletedCount; i ++) 
+		// collect all the faces that can see the point
+		mark++;
+		deleteList.SetCount(0);
+		stack.PushBack(faceIndex);
+		while (stack.GetCount())
+		{
+			const ndInt32 index = stack[stack.GetCount() - 1];
+			stack.SetCount(stack.GetCount() - 1);
+			ndConvexHull3dFlatFace& face = faces[index];
+			if (face.m_mark != mark)
 			{
-				ndNode* const node1 = deleteList[i];
-				ndConvexHull3dFace* const face1 = &node1->GetInfo();
-				dAssert (face1->m_mark == 1);
-				for (ndInt32 j0 = 0; j0 < 3; j0 ++) 
+				face.m_mark = mark;
+				if ((index == faceIndex) || (ndConvexHull3dEvalue(m_points[face.m_index[0]], m_points[face.m_index[1]], m_points[face.m_index[2]], p) > ndFloat64(0.0f)))
 				{
-					ndNode* const twinNode = face1->m_twin[j0];
-					ndConvexHull3dFace* const twinFace = &twinNode->GetInfo();
-					if (!twinFace->m_mark) 
+					face.m_alive = 0;
+					deleteList.PushBack(index);
+					for (ndInt32 i = 0; i < 3; i++)
 					{
-						ndInt32 j1 = (j0 == 2) ? 0 : j0 + 1;
-						ndNode* const newNode = AddFace (currentIndex, face1->m_index[j0], face1->m_index[j1]);
-						boundaryFaces.Addtop(newNode);
-
-						ndConvexHull3dFace* const newFace = &newNode->GetInfo();
-						newFace->m_twin[1] = twinNode;
-						for (ndInt32 k = 0; k < 3; k ++) 
+						if (faces[face.m_twin[i]].m_mark != mark)
 						{
-							if (twinFace->m_twin[k] == node1) 
-							{
-								twinFace->m_twin[k] = newNode;
-							}
+							stack.PushBack(face.m_twin[i]);
 						}
-						coneList[newCount] = newNode;
-						newCount ++;
-						dAssert (newCount < ndInt32 (coneListPool.GetElementsCount()));
 					}
 				}
 			}
+		}
 
-			for (ndInt32 i = 0; i < newCount - 1; i ++) 
+		m_points[currentIndex] = points[pointIndex];
+		points[pointIndex].m_mark = 1;
+
+		// make a cone from the new point to the horizon edges
+		coneList.SetCount(0);
+		for (ndInt32 i = 0; i < deleteList.GetCount(); i++)
+		{
+			const ndInt32 deletedIndex = deleteList[i];
+			for (ndInt32 j0 = 0; j0 < 3; j0++)
 			{
-				ndNode* const nodeA = coneList[i];
-				ndConvexHull3dFace* const faceA = &nodeA->GetInfo();
-				dAssert (faceA->m_mark == 0);
-				for (ndInt32 j = i + 1; j < newCount; j ++) {
-					ndNode* const nodeB = coneList[j];
-					ndConvexHull3dFace* const faceB = &nodeB->GetInfo();
-					dAssert (faceB->m_mark == 0);
-					if (faceA->m_index[2] == faceB->m_index[1]) 
+				const ndInt32 twinIndex = faces[deletedIndex].m_twin[j0];
+				if (faces[twinIndex].m_alive)
+				{
+					ndInt32 newIndex;
+					if (freeFaces.GetCount())
 					{
-						faceA->m_twin[2] = nodeB;
-						faceB->m_twin[0] = nodeA;
-						break;
+						newIndex = freeFaces[freeFaces.GetCount() - 1];
+						freeFaces.SetCount(freeFaces.GetCount() - 1);
+					}
+					else
+					{
+						newIndex = faces.GetCount();
+						faces.SetCount(newIndex + 1);
 					}
-				}
 
-				for (ndInt32 j = i + 1; j < newCount; j ++) 
-				{
-					ndNode* const nodeB = coneList[j];
-					ndConvexHull3dFace* const faceB = &nodeB->GetInfo();
-					dAssert (faceB->m_mark == 0);
-					if (faceA->m_index[1] == faceB->m_index[2]) 
+					const ndInt32 j1 = (j0 == 2) ? 0 : j0 + 1;
+					ndConvexHull3dFlatFace& newFace = faces[newIndex];
+					const ndConvexHull3dFlatFace& deletedFace = faces[deletedIndex];
+					newFace.m_index[0] = currentIndex;
+					newFace.m_index[1] = deletedFace.m_index[j0];
+					newFace.m_index[2] = deletedFace.m_index[j1];
+					newFace.m_twin[0] = -1;
+					newFace.m_twin[1] = twinIndex;
+					newFace.m_twin[2] = -1;
+					newFace.m_maxDist = ndFloat64(0.0f);
+					newFace.m_conflict = -1;
+					newFace.m_farthest = -1;
+					newFace.m_mark = mark;
+					newFace.m_alive = 1;
+
+					ndBigPlane plane(m_points[newFace.m_index[0]], m_points[newFace.m_index[1]], m_points[newFace.m_index[2]]);
+					newFace.m_plane = plane.Scale(ndFloat64(1.0f) / sqrt(plane.DotProduct(plane & ndBigVector::m_triplexMask).GetScalar()));
+
+					ndConvexHull3dFlatFace& twinFace = faces[twinIndex];
+					for (ndInt32 k = 0; k < 3; k++)
 					{
-						faceA->m_twin[0] = nodeB;
-						faceB->m_twin[2] = nodeA;
-						break;
+						if (twinFace.m_twin[k] == deletedIndex)
+						{
+							twinFace.m_twin[k] = newIndex;
+						}
 					}
+					coneMap[newFace.m_index[1]] = newIndex;
+					coneList.PushBack(newIndex);
 				}
 			}
+		}
 
-			for (ndInt32 i = 0; i < deletedCount; i ++) 
+		// the horizon is a closed loop, so each cone face is linked
+		// to the one that starts where its horizon edge ends.
+		for (ndInt32 i = 0; i < coneList.GetCount(); i++)
+		{
+			ndConvexHull3dFlatFace& faceA = faces[coneList[i]];
+			const ndInt32 indexB = coneMap[faceA.m_index[2]];
+			faceA.m_twin[2] = indexB;
+			faces[indexB].m_twin[0] = coneList[i];
+		}
+
+		// the points of the deleted faces go to the new faces, or are inside the hull now
+		ndConePlanes::Set(conePlanes, faces, coneList, padPlane);
+		for (ndInt32 i = 0; i < deleteList.GetCount(); i++)
+		{
+			ndInt32 conflict = faces[deleteList[i]].m_conflict;
+			while (conflict >= 0)
 			{
-				ndNode* const node = deleteList[i];
-				boundaryFaces.Remove (node);
-				DeleteFace (node);
+				const ndInt32 next = conflictNext[conflict];
+				if (!points[conflict].m_mark)
+				{
+					ndConePlanes::Assign(conflict, points[conflict], distTol, conePlanes, coneList, faces, &conflictNext[0]);
+				}
+				conflict = next;
 			}
+			freeFaces.PushBack(deleteList[i]);
+		}
 
-			maxVertexCount --;
-			currentIndex ++;
-			count --;
-		} 
-		else 
+		for (ndInt32 i = 0; i < coneList.GetCount(); i++)
 		{
-			boundaryFaces.Remove (faceNode);
+			const ndInt32 index = coneList[i];
+			if (faces[index].m_farthest >= 0)
+			{
+				heap.Add(faces, index);
+			}
 		}
+
+		maxVertexCount --;
+		currentIndex ++;
 	}
 	m_count = currentIndex;
-}
 
+	// copy the faces to the list
+	ndStack<ndNode*> nodeMap(faces.GetCount());
+	for (ndInt32 i = 0; i < faces.GetCount(); i++)
+	{
+		const ndConvexHull3dFlatFace& face = faces[i];
+		nodeMap[i] = face.m_alive ? AddFace(face.m_index[0], face.m_index[1], face.m_index[2]) : nullptr;
+	}
+	for (ndInt32 i = 0; i < faces.GetCount(); i++)
+	{
+		const ndConvexHull3dFlatFace& face = faces[i];
+		if (face.m_alive)
+		{
+			ndConvexHull3dFace& listFace = nodeMap[i]->GetInfo();
+			for (ndInt32 j = 0; j < 3; j++)
+			{
+				listFace.m_twin[j] = nodeMap[face.m_twin[j]];
+			}
+		}
+	}
+	dAssert(Sanity());
+}
 
 void ndConvexHull3d::CalculateVolumeAndSurfaceArea (ndFloat64& volume, ndFloat64& surfaceArea) const
 {
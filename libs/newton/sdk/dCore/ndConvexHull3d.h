@@ -33,7 +33,9 @@
 #define D_OLD_CONVEXHULL_3D
 
 class ndConvexHull3dVertex;
+class ndConvexHull3dFlatFace;
 class ndConvexHull3dAABBTreeNode;
+class dgConvexHull3dPointCluster;
 
 class ndConvexHull3dFace
 {
@@ -56,6 +58,28 @@ class ndConvexHull3dFace
 	friend class ndConvexHull3d;
 };
 
+// working memory of a hull build, a thread that builds many 
+// hulls can keep one and pass it to each of them.
+class ndConvexHull3dScratch: public ndClassAlloc
+{
+	public:
+	D_CORE_API ndConvexHull3dScratch();
+	D_CORE_API ~ndConvexHull3dScratch();
+
+	private:
+	ndArray<ndConvexHull3dVertex> m_points;
+	ndArray<dgConvexHull3dPointCluster> m_treePool;
+	ndArray<ndConvexHull3dFlatFace> m_faces;
+	ndArray<ndInt32> m_freeFaces;
+	ndArray<ndInt32> m_deleteList;
+	ndArray<ndInt32> m_coneList;
+	ndArray<ndInt32> m_stack;
+	ndArray<ndInt32> m_conflictNext;
+	ndArray<ndInt32> m_coneMap;
+	ndArray<ndBigVector> m_conePlanes;
+	friend class ndConvexHull3d;
+};
+
 D_MSV_NEWTON_ALIGN_32
 class ndConvexHull3d: public ndList<ndConvexHull3dFace>
 {
@@ -65,7 +89,7 @@ class ndConvexHull3d: public ndList<ndConvexHull3dFace>
 
 	public:
 	D_CORE_API ndConvexHull3d(const ndConvexHull3d& source);
-	D_CORE_API ndConvexHull3d(const ndFloat64* const vertexCloud, ndInt32 strideInBytes, ndInt32 count, ndFloat64 distTol, ndInt32 maxVertexCount = 0x7fffffff);
+	D_CORE_API ndConvexHull3d(const ndFloat64* const vertexCloud, ndInt32 strideInBytes, ndInt32 count, ndFloat64 distTol, ndInt32 maxVertexCount = 0x7fffffff, ndConvexHull3dScratch* const scratch = nullptr);
 	D_CORE_API virtual ~ndConvexHull3d();
 
 	ndInt32 GetVertexCount() const;
@@ -79,7 +103,7 @@ class ndConvexHull3d: public ndList<ndConvexHull3dFace>
 
 	protected:
 	ndConvexHull3d();
-	void BuildHull (const ndFloat64* const vertexCloud, ndInt32 strideInBytes, ndInt32 count, ndFloat64 distTol, ndInt32 maxVertexCount);
+	void BuildHull (const ndFloat64* const vertexCloud, ndInt32 strideInBytes, ndInt32 count, ndFloat64 distTol, ndInt32 maxVertexCount, ndConvexHull3dScratch* const scratch);
 
 	virtual ndNode* AddFace (ndInt32 i0, ndInt32 i1, ndInt32 i2);
 	virtual void DeleteFace (ndNode* const node) ;
@@ -87,8 +111,9 @@ class ndConvexHull3d: public ndList<ndConvexHull3dFace>
 
 	bool CheckFlatSurface(ndConvexHull3dAABBTreeNode* vertexTree, ndConvexHull3dVertex* const points, ndInt32 count, ndFloat64 distTol, ndInt32 maxVertexCount);
 	void CalculateConvexHull2d (ndConvexHull3dAABBTreeNode* vertexTree, ndConvexHull3dVertex* const points, ndInt32 count, ndFloat64 distTol, ndInt32 maxVertexCount);
-	void CalculateConvexHull3d (ndConvexHull3dAABBTreeNode* vertexTree, ndConvexHull3dVertex* const points, ndInt32 count, ndFloat64 distTol, ndInt32 maxVertexCount);
+	void CalculateConvexHull3d (ndConvexHull3dVertex* const points, ndInt32 count, ndFloat64 distTol, ndInt32 maxVertexCount, ndConvexHull3dScratch& scratch);
 	
+	ndInt32 SupportVertex (const ndConvexHull3dVertex* const points, ndInt32 count, const ndBigVector& dir) const;
 	ndInt32 SupportVertex (ndConvexHull3dAABBTreeNode** const tree, const ndConvexHull3dVertex* const points, const ndBigVector& dir, const bool removeEntry = true) const;
 	ndFloat64 TetrahedrumVolume (const ndBigVector& p0, const ndBigVector& p1, const ndBigVector& p2, const ndBigVector& p3) const;
 
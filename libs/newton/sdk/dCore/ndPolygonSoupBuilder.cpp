@@ -29,6 +29,8 @@
 #include "ndList.h"
 #include "ndTree.h"
 #include "ndStack.h"
+#include "ndProfiler.h"
+#include "ndThreadPool.h"
 #include "ndPolyhedra.h"
 #include "ndPolygonSoupBuilder.h"
 
@@ -54,6 +56,15 @@ class ndPolygonSoupBuilder::dgFaceBucket: public ndList<dgFaceInfo>
 	}
 };
 
+class ndPolygonSoupBuilder::dgFacePartition
+{
+	public:
+	ndPolygonSoupBuilder* m_builder;
+	ndInt32 m_faceId;
+	ndInt32 m_faceStart;
+	ndInt32 m_faceCount;
+};
+
 class ndPolygonSoupBuilder::dgFaceMap: public ndTree<dgFaceBucket, ndInt32>
 {
 	public:
@@ -137,8 +148,14 @@ ndPolygonSoupBuilder::ndPolygonSoupBuilder ()
 	,m_normalIndex()
 	,m_vertexPoints()
 	,m_normalPoints()
+	,m_progressCallback(nullptr)
+	,m_progressUserData(nullptr)
+	,m_threadCount(1)
 {
 	m_run = DG_POINTS_RUN;
+#ifndef D_USE_THREAD_EMULATION
+	SetThreadCount(ndInt32 (std::thread::hardware_concurrency()));
+#endif
 }
 
 ndPolygonSoupBuilder::ndPolygonSoupBuilder (const ndPolygonSoupBuilder& source)
@@ -147,6 +164,9 @@ ndPolygonSoupBuilder::ndPolygonSoupBuilder (const ndPolygonSoupBuilder& source)
 	,m_normalIndex()
 	,m_vertexPoints(source.m_vertexPoints.GetCount())
 	,m_normalPoints()
+	,m_progressCallback(source.m_progressCallback)
+	,m_progressUserData(source.m_progressUserData)
+	,m_threadCount(source.m_threadCount)
 {
 	m_run = DG_POINTS_RUN;
 	m_faceVertexCount.SetCount(source.m_faceVertexCount.GetCount());
@@ -173,6 +193,25 @@ ndPolygonSoupBuilder::~ndPolygonSoupBuilder ()
 {
 }
 
+void ndPolygonSoupBuilder::SetThreadCount(ndInt32 count)
+{
+	m_threadCount = dClamp(count, 1, D_MAX_THREADS_COUNT);
+}
+
+void ndPolygonSoupBuilder::SetProgressCallback(ndPolygonSoupProgressCallback callback, void* const userData)
+{
+	m_progressCallback = callback;
+	m_progressUserData = userData;
+}
+
+void ndPolygonSoupBuilder::ReportProgress(ndFloat32 progress) const
+{
+	if (m_progressCallback)
+	{
+		m_progressCallback(progress, m_progressUserData);
+	}
+}
+
 void ndPolygonSoupBuilder::Begin()
 {
 	m_run = DG_POINTS_RUN;
@@ -537,17 +576,29 @@ void ndPolygonSoupBuilder::OptimizeByIndividualFaces()
 
 void ndPolygonSoupBuilder::End(bool optimize)
 {
+	D_TRACKTIME();
 	if (optimize) 
 	{
 		ndPolygonSoupBuilder copy (*this);
 		dgFaceMap faceMap (copy);
 
-		Begin();
+		// split the faces into independent partitions, optimize them 
+		// concurrently, and merge the result in partition order so that 
+		// the soup is the same regardless of the thread count.
+		ndArray<dgFaceInfo> faceArray;
+		ndArray<dgFacePartition> partitions;
 		dgFaceMap::Iterator iter (faceMap);
 		for (iter.Begin(); iter; iter ++) 
 		{
 			const dgFaceBucket& bucket = iter.GetNode()->GetInfo();
-			Optimize(iter.GetNode()->GetKey(), bucket, copy);
+			Optimize(iter.GetNode()->GetKey(), bucket, copy, faceArray, partitions);
+		}
+		OptimizePartitions(copy, faceArray, partitions);
+
+		Begin();
+		for (ndInt32 i = 0; i < partitions.GetCount(); i++)
+		{
+			AddPartition(partitions[i]);
 		}
 	}
 	Finalize();
@@ -593,17 +644,19 @@ void ndPolygonSoupBuilder::End(bool optimize)
 		dAssert(normalCount <= m_normalPoints.GetCount());
 		m_normalPoints.SetCount(normalCount);
 	}
+	ReportProgress(ndFloat32(1.0f));
 }
 
-void ndPolygonSoupBuilder::Optimize(ndInt32 faceId, const dgFaceBucket& faceBucket, const ndPolygonSoupBuilder& source)
+void ndPolygonSoupBuilder::Optimize(ndInt32 faceId, const dgFaceBucket& faceBucket, const ndPolygonSoupBuilder& source, ndArray<dgFaceInfo>& faceArray, ndArray<dgFacePartition>& partitions) const
 {
 	#define DG_MESH_PARTITION_SIZE (1024 * 4)
 
 	const ndInt32* const indexArray = &source.m_vertexIndex[0];
 	const ndBigVector* const points = &source.m_vertexPoints[0];
 
-	ndVector face[256];
-	ndInt32 faceIndex[256];
+	dgFacePartition partition;
+	partition.m_builder = nullptr;
+	partition.m_faceId = faceId;
 	if (faceBucket.GetCount() >= DG_MESH_PARTITION_SIZE) 
 	{
 		ndStack<dgFaceBucket::ndNode*> array(faceBucket.GetCount());
@@ -628,41 +681,15 @@ void ndPolygonSoupBuilder::Optimize(ndInt32 faceId, const dgFaceBucket& faceBuck
 
 			if (faceCount <= DG_MESH_PARTITION_SIZE) 
 			{
-				ndPolygonSoupBuilder tmpBuilder;
+				partition.m_faceStart = faceArray.GetCount();
+				partition.m_faceCount = faceCount;
 				for (ndInt32 i = 0; i < faceCount; i ++) 
 				{
 					const dgFaceInfo& faceInfo = array[faceStart + i]->GetInfo();
-
-					ndInt32 count1 = faceInfo.indexCount - 1;
-					ndInt32 start1 = faceInfo.indexStart;
-					dAssert (faceId == indexArray[start1 + count1]);
-					for (ndInt32 j = 0; j < count1; j ++) 
-					{
-						ndInt32 index = indexArray[start1 + j];
-						face[j] = points[index];
-						faceIndex[j] = j;
-					}
-					//ndInt32 faceIndexCount = count1;
-					//tmpBuilder.AddMesh (&face[0].m_x, count1, sizeof (ndVector), 1, &faceIndexCount, &faceIndex[0], &faceId, dGetIdentityMatrix()); 
-					tmpBuilder.AddFaceIndirect(&face[0].m_x, sizeof(ndVector), faceId, faceIndex, count1);
-				}
-				tmpBuilder.FinalizeAndOptimize (faceId);
-
-				ndInt32 faceIndexNumber = 0;
-				for (ndInt32 i = 0; i < tmpBuilder.m_faceVertexCount.GetCount(); i ++)
-				{
-					ndInt32 indexCount = tmpBuilder.m_faceVertexCount[i] - 1;
-					for (ndInt32 j = 0; j < indexCount; j ++) 
-					{
-						ndInt32 index = tmpBuilder.m_vertexIndex[faceIndexNumber + j];
-						face[j] = tmpBuilder.m_vertexPoints[index];
-						faceIndex[j] = j;
-					}
-					//ndInt32 faceArray = indexCount;
-					//AddMesh (&face[0].m_x, indexCount, sizeof (ndVector), 1, &faceArray, faceIndex, &faceId, dGetIdentityMatrix());
-					AddFaceIndirect(&face[0].m_x, sizeof(ndVector), faceId, faceIndex, indexCount);
-					faceIndexNumber += (indexCount + 1); 
+					dAssert (faceId == indexArray[faceInfo.indexStart + faceInfo.indexCount - 1]);
+					faceArray.PushBack(faceInfo);
 				}
+				partitions.PushBack(partition);
 			} 
 			else 
 			{
@@ -750,43 +777,115 @@ void ndPolygonSoupBuilder::Optimize(ndInt32 faceId, const dgFaceBucket& faceBuck
 	} 
 	else 
 	{
-		ndPolygonSoupBuilder tmpBuilder;
+		partition.m_faceStart = faceArray.GetCount();
+		partition.m_faceCount = faceBucket.GetCount();
 		for (dgFaceBucket::ndNode* node = faceBucket.GetFirst(); node; node = node->GetNext()) 
 		{
 			const dgFaceInfo& faceInfo = node->GetInfo();
+			dAssert (faceId == indexArray[faceInfo.indexStart + faceInfo.indexCount - 1]);
+			faceArray.PushBack(faceInfo);
+		}
+		partitions.PushBack(partition);
+	}
+}
 
-			ndInt32 count = faceInfo.indexCount - 1;
-			ndInt32 start = faceInfo.indexStart;
-			dAssert (faceId == indexArray[start + count]);
-			for (ndInt32 j = 0; j < count; j ++) 
+void ndPolygonSoupBuilder::OptimizePartitions(const ndPolygonSoupBuilder& source, const ndArray<dgFaceInfo>& faceArray, ndArray<dgFacePartition>& partitions) const
+{
+	D_TRACKTIME();
+	class ndOptimizeContext
+	{
+		public:
+		const ndPolygonSoupBuilder* m_me;
+		const ndPolygonSoupBuilder* m_source;
+		const ndArray<dgFaceInfo>* m_faceArray;
+		ndArray<dgFacePartition>* m_partitions;
+		ndAtomic<ndInt32> m_partitionIndex;
+		ndAtomic<ndInt32> m_partitionsDone;
+	};
+
+	class ndOptimizePartition: public ndJobThreadPool::ndBaseJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			ndOptimizeContext* const context = (ndOptimizeContext*)m_context;
+			const ndInt32* const indexArray = &context->m_source->m_vertexIndex[0];
+			const ndBigVector* const points = &context->m_source->m_vertexPoints[0];
+			const ndArray<dgFaceInfo>& faceArray = *context->m_faceArray;
+			ndArray<dgFacePartition>& partitions = *context->m_partitions;
+
+			// only the calling thread reports progress
+			const bool reportProgress = (GetThreadId() == (m_owner->GetCount() - 1));
+			const ndFloat32 scale = ndFloat32(0.9f) / ndFloat32(partitions.GetCount());
+
+			ndVector face[256];
+			ndInt32 faceIndex[256];
+			for (ndInt32 i = context->m_partitionIndex.fetch_add(1); i < partitions.GetCount(); i = context->m_partitionIndex.fetch_add(1))
 			{
-				ndInt32 index = indexArray[start + j];
-				face[j] = points[index];
-				faceIndex[j] = j;
+				dgFacePartition& partition = partitions[i];
+				ndPolygonSoupBuilder* const builder = new ndPolygonSoupBuilder;
+				for (ndInt32 j = 0; j < partition.m_faceCount; j++)
+				{
+					const dgFaceInfo& faceInfo = faceArray[partition.m_faceStart + j];
+					const ndInt32 count = faceInfo.indexCount - 1;
+					const ndInt32 start = faceInfo.indexStart;
+					for (ndInt32 k = 0; k < count; k++)
+					{
+						face[k] = points[indexArray[start + k]];
+						faceIndex[k] = k;
+					}
+					builder->AddFaceIndirect(&face[0].m_x, sizeof(ndVector), partition.m_faceId, faceIndex, count);
+				}
+				builder->FinalizeAndOptimize(partition.m_faceId);
+				partition.m_builder = builder;
+
+				const ndInt32 done = context->m_partitionsDone.fetch_add(1) + 1;
+				if (reportProgress)
+				{
+					context->m_me->ReportProgress(scale * ndFloat32(done));
+				}
 			}
-			//ndInt32 faceIndexCount = count;
-			//tmpBuilder.AddMesh (&face[0].m_x, count, sizeof (ndVector), 1, &faceIndexCount, &faceIndex[0], &faceId, dGetIdentityMatrix()); 
-			tmpBuilder.AddFaceIndirect(&face[0].m_x, sizeof(ndVector), faceId, faceIndex, count);
 		}
-		tmpBuilder.FinalizeAndOptimize (faceId);
+	};
+
+	if (partitions.GetCount())
+	{
+		ndOptimizeContext context;
+		context.m_me = this;
+		context.m_source = &source;
+		context.m_faceArray = &faceArray;
+		context.m_partitions = &partitions;
+		context.m_partitionIndex.store(0);
+		context.m_partitionsDone.store(0);
+
+		ndJobThreadPool threadPool(dMin(m_threadCount, partitions.GetCount()), "soupBuilder");
+		threadPool.SubmitJobs<ndOptimizePartition>(&context);
+	}
+}
+
+void ndPolygonSoupBuilder::AddPartition(const dgFacePartition& partition)
+{
+	ndVector face[256];
+	ndInt32 faceIndex[256];
+
+	ndPolygonSoupBuilder* const builder = partition.m_builder;
+	dAssert(builder);
 
-		ndInt32 faceIndexNumber = 0;
-		for (ndInt32 i = 0; i < tmpBuilder.m_faceVertexCount.GetCount(); i ++)
+	ndInt32 faceIndexNumber = 0;
+	for (ndInt32 i = 0; i < builder->m_faceVertexCount.GetCount(); i ++)
+	{
+		ndInt32 indexCount = builder->m_faceVertexCount[i] - 1;
+		for (ndInt32 j = 0; j < indexCount; j ++) 
 		{
-			ndInt32 indexCount = tmpBuilder.m_faceVertexCount[i] - 1;
-			for (ndInt32 j = 0; j < indexCount; j ++) 
-			{
-				ndInt32 index = tmpBuilder.m_vertexIndex[faceIndexNumber + j];
-				face[j] = tmpBuilder.m_vertexPoints[index];
-				faceIndex[j] = j;
-			}
-			//ndInt32 faceArray = indexCount;
-			//AddMesh (&face[0].m_x, indexCount, sizeof (ndVector), 1, &faceArray, faceIndex, &faceId, dGetIdentityMatrix());
-			AddFaceIndirect(&face[0].m_x, sizeof(ndVector), faceId, faceIndex, indexCount);
-		
-			faceIndexNumber += (indexCount + 1); 
+			ndInt32 index = builder->m_vertexIndex[faceIndexNumber + j];
+			face[j] = builder->m_vertexPoints[index];
+			faceIndex[j] = j;
 		}
+		AddFaceIndirect(&face[0].m_x, sizeof(ndVector), partition.m_faceId, faceIndex, indexCount);
+		faceIndexNumber += (indexCount + 1); 
 	}
+	delete builder;
 }
 
 ndInt32 ndPolygonSoupBuilder::FilterFace (ndInt32 count, ndInt32* const pool)
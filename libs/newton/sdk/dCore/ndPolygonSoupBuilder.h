@@ -34,6 +34,8 @@
 #include "ndVector.h"
 #include "ndMatrix.h"
 
+typedef void (*ndPolygonSoupProgressCallback) (ndFloat32 progress, void* const userData);
+
 class ndAdjacentdFace
 {
 	public:
@@ -48,6 +50,7 @@ class ndPolygonSoupBuilder: public ndClassAlloc
 	class dgFaceMap;
 	class dgFaceInfo;
 	class dgFaceBucket;
+	class dgFacePartition;
 	class dgPolySoupFilterAllocator;
 	public:
 
@@ -62,8 +65,15 @@ class ndPolygonSoupBuilder: public ndClassAlloc
 
 	D_CORE_API void SavePLY(const char* const fileName) const;
 
+	ndInt32 GetThreadCount() const;
+	D_CORE_API void SetThreadCount(ndInt32 count);
+	D_CORE_API void SetProgressCallback(ndPolygonSoupProgressCallback callback, void* const userData);
+
 	private:
-	void Optimize(ndInt32 faceId, const dgFaceBucket& faceBucket, const ndPolygonSoupBuilder& source);
+	void ReportProgress(ndFloat32 progress) const;
+	void Optimize(ndInt32 faceId, const dgFaceBucket& faceBucket, const ndPolygonSoupBuilder& source, ndArray<dgFaceInfo>& faceArray, ndArray<dgFacePartition>& partitions) const;
+	void OptimizePartitions(const ndPolygonSoupBuilder& source, const ndArray<dgFaceInfo>& faceArray, ndArray<dgFacePartition>& partitions) const;
+	void AddPartition(const dgFacePartition& partition);
 
 	void Finalize();
 	void OptimizeByIndividualFaces();
@@ -106,8 +116,16 @@ class ndPolygonSoupBuilder: public ndClassAlloc
 	ndIndexArray m_normalIndex;
 	ndVertexArray m_vertexPoints;
 	ndVertexArray m_normalPoints;
+	ndPolygonSoupProgressCallback m_progressCallback;
+	void* m_progressUserData;
+	ndInt32 m_threadCount;
 	ndInt32 m_run;
 };
 
+inline ndInt32 ndPolygonSoupBuilder::GetThreadCount() const
+{
+	return m_threadCount;
+}
+
 #endif
 
@@ -21,3 +21,279 @@
 
 #include "ndCoreStdafx.h"
 #include "ndTypes.h"
+#include "ndUtils.h"
+#include "ndMemory.h"
+#include "ndProfiler.h"
+
+#define D_TRACE_MAX_THREADS			256
+#define D_TRACE_EVENTS_PER_THREAD	(1<<16)
+#define D_TRACE_THREAD_NAME_SIZE	64
+
+class ndTraceEvent
+{
+	public:
+	const char* m_name;
+	ndUnsigned64 m_beginTime;
+	ndUnsigned64 m_endTime;
+};
+
+class ndTraceThreadBuffer
+{
+	public:
+	ndTraceThreadBuffer(ndInt32 threadIndex)
+		:m_head(0)
+		,m_generation(0)
+		,m_threadIndex(threadIndex)
+	{
+		m_events = (ndTraceEvent*)ndMemory::Malloc(D_TRACE_EVENTS_PER_THREAD * sizeof(ndTraceEvent));
+		sprintf(m_name, "thread_%d", threadIndex);
+	}
+
+	~ndTraceThreadBuffer()
+	{
+		ndMemory::Free(m_events);
+	}
+
+	// only the owner thread writes events, the reader 
+	// sees all the events written before the store of m_head.
+	void AddEvent(const char* const name, ndUnsigned64 beginTime, ndUnsigned64 endTime, ndUnsigned32 generation)
+	{
+		ndUnsigned64 head = m_head.load();
+		if (m_generation.load() != generation)
+		{
+			head = 0;
+			m_head.store(0);
+			m_generation.store(generation);
+		}
+		ndTraceEvent& event = m_events[head & (D_TRACE_EVENTS_PER_THREAD - 1)];
+		event.m_name = name;
+		event.m_beginTime = beginTime;
+		event.m_endTime = endTime;
+		m_head.store(head + 1);
+	}
+
+	ndTraceEvent* m_events;
+	ndAtomic<ndUnsigned64> m_head;
+	ndAtomic<ndUnsigned32> m_generation;
+	ndInt32 m_threadIndex;
+	char m_name[D_TRACE_THREAD_NAME_SIZE];
+};
+
+class ndTraceRegistry
+{
+	public:
+	ndTraceRegistry()
+		:m_lock()
+		,m_generation(0)
+		,m_capturing(false)
+		,m_droppedZones(0)
+		,m_threadCount(0)
+		,m_freeCount(0)
+		,m_timeBase(std::chrono::steady_clock::now())
+	{
+	}
+
+	~ndTraceRegistry()
+	{
+		for (ndInt32 i = 0; i < m_threadCount; ++i)
+		{
+			m_threads[i]->~ndTraceThreadBuffer();
+			ndMemory::Free(m_threads[i]);
+		}
+	}
+
+	ndUnsigned64 GetTimeStamp() const
+	{
+		// zero means not capturing, so time stamps start at one.
+		const std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+		return ndUnsigned64(std::chrono::duration_cast<std::chrono::nanoseconds>(time - m_timeBase).count()) + 1;
+	}
+
+	ndTraceThreadBuffer* GetThreadBuffer();
+
+	// a buffer released by a thread that exited is handed to the next new 
+	// thread, its zones are kept and the new thread continues the same track.
+	ndTraceThreadBuffer* AcquireThreadBuffer()
+	{
+		ndScopeSpinLock lock(m_lock);
+		if (m_freeCount)
+		{
+			m_freeCount--;
+			ndTraceThreadBuffer* const buffer = m_freeThreads[m_freeCount];
+			sprintf(buffer->m_name, "thread_%d", buffer->m_threadIndex);
+			return buffer;
+		}
+		if (m_threadCount < D_TRACE_MAX_THREADS)
+		{
+			ndTraceThreadBuffer* const buffer = (ndTraceThreadBuffer*)ndMemory::Malloc(sizeof(ndTraceThreadBuffer));
+			m_threads[m_threadCount] = new (buffer) ndTraceThreadBuffer(m_threadCount);
+			m_threadCount++;
+			return buffer;
+		}
+		return nullptr;
+	}
+
+	void ReleaseThreadBuffer(ndTraceThreadBuffer* const buffer)
+	{
+		ndScopeSpinLock lock(m_lock);
+		dAssert(m_freeCount < D_TRACE_MAX_THREADS);
+		m_freeThreads[m_freeCount] = buffer;
+		m_freeCount++;
+	}
+
+	bool Save(const char* const fileName)
+	{
+		FILE* const file = fopen(fileName, "wb");
+		if (!file)
+		{
+			return false;
+		}
+
+		ndScopeSpinLock lock(m_lock);
+		const ndUnsigned32 generation = m_generation.load();
+
+		bool first = true;
+		fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+		for (ndInt32 i = 0; i < m_threadCount; ++i)
+		{
+			const ndTraceThreadBuffer* const buffer = m_threads[i];
+			fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"", first ? "" : ",\n", buffer->m_threadIndex);
+			for (const char* ptr = buffer->m_name; *ptr; ++ptr)
+			{
+				if ((*ptr == '"') || (*ptr == '\\'))
+				{
+					fputc('\\', file);
+				}
+				fputc(*ptr, file);
+			}
+			fprintf(file, "\"}}");
+			first = false;
+
+			if (buffer->m_generation.load() != generation)
+			{
+				continue;
+			}
+
+			const ndUnsigned64 head = buffer->m_head.load();
+			const ndUnsigned64 count = dMin(head, ndUnsigned64(D_TRACE_EVENTS_PER_THREAD));
+			for (ndUnsigned64 j = head - count; j < head; ++j)
+			{
+				const ndTraceEvent& event = buffer->m_events[j & (D_TRACE_EVENTS_PER_THREAD - 1)];
+				const ndUnsigned64 duration = event.m_endTime - event.m_beginTime;
+				fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"newton\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%llu.%03llu,\"dur\":%llu.%03llu}",
+					event.m_name, buffer->m_threadIndex,
+					(unsigned long long)(event.m_beginTime / 1000), (unsigned long long)(event.m_beginTime % 1000),
+					(unsigned long long)(duration / 1000), (unsigned long long)(duration % 1000));
+			}
+		}
+		fprintf(file, "\n],\"otherData\":{\"droppedZones\":\"%llu\"}}\n", (unsigned long long)m_droppedZones.load());
+		fclose(file);
+		return true;
+	}
+
+	ndSpinLock m_lock;
+	ndAtomic<ndUnsigned32> m_generation;
+	ndAtomic<bool> m_capturing;
+	ndAtomic<ndUnsigned64> m_droppedZones;
+	ndInt32 m_threadCount;
+	ndInt32 m_freeCount;
+	std::chrono::steady_clock::time_point m_timeBase;
+	ndTraceThreadBuffer* m_threads[D_TRACE_MAX_THREADS];
+	ndTraceThreadBuffer* m_freeThreads[D_TRACE_MAX_THREADS];
+};
+
+static ndTraceRegistry& GetTraceRegistry()
+{
+	static ndTraceRegistry registry;
+	return registry;
+}
+
+// returns the thread buffer to the registry when the thread exits
+class ndTraceThreadOwner
+{
+	public:
+	ndTraceThreadOwner()
+		:m_buffer(nullptr)
+	{
+	}
+
+	~ndTraceThreadOwner()
+	{
+		if (m_buffer)
+		{
+			GetTraceRegistry().ReleaseThreadBuffer(m_buffer);
+		}
+	}
+
+	ndTraceThreadBuffer* m_buffer;
+};
+
+ndTraceThreadBuffer* ndTraceRegistry::GetThreadBuffer()
+{
+	static thread_local ndTraceThreadOwner owner;
+	if (!owner.m_buffer)
+	{
+		owner.m_buffer = AcquireThreadBuffer();
+	}
+	return owner.m_buffer;
+}
+
+void ndTraceCapture::Start()
+{
+	ndTraceRegistry& registry = GetTraceRegistry();
+	// a new generation makes each thread discard its old zones on the next write
+	registry.m_generation.fetch_add(1);
+	registry.m_droppedZones.store(0);
+	registry.m_capturing.store(true);
+}
+
+void ndTraceCapture::Stop()
+{
+	GetTraceRegistry().m_capturing.store(false);
+}
+
+bool ndTraceCapture::IsCapturing()
+{
+	return GetTraceRegistry().m_capturing.load();
+}
+
+ndUnsigned64 ndTraceCapture::GetDroppedZones()
+{
+	return GetTraceRegistry().m_droppedZones.load();
+}
+
+bool ndTraceCapture::SaveChromeTrace(const char* const fileName)
+{
+	return GetTraceRegistry().Save(fileName);
+}
+
+void ndTraceCapture::SetThreadName(const char* const threadName)
+{
+	ndTraceThreadBuffer* const buffer = GetTraceRegistry().GetThreadBuffer();
+	if (buffer)
+	{
+		strncpy(buffer->m_name, threadName, D_TRACE_THREAD_NAME_SIZE - 1);
+		buffer->m_name[D_TRACE_THREAD_NAME_SIZE - 1] = 0;
+	}
+}
+
+ndUnsigned64 ndTraceCapture::BeginZone()
+{
+	const ndTraceRegistry& registry = GetTraceRegistry();
+	return registry.m_capturing.load() ? registry.GetTimeStamp() : 0;
+}
+
+void ndTraceCapture::EndZone(const char* const zoneName, ndUnsigned64 beginTime)
+{
+	ndTraceRegistry& registry = GetTraceRegistry();
+	const ndUnsigned64 endTime = registry.GetTimeStamp();
+	ndTraceThreadBuffer* const buffer = registry.GetThreadBuffer();
+	if (buffer)
+	{
+		buffer->AddEvent(zoneName, beginTime, endTime, registry.m_generation.load());
+	}
+	else
+	{
+		registry.m_droppedZones.fetch_add(1);
+	}
+}
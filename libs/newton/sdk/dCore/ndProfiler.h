@@ -28,10 +28,75 @@
 // to make a profile build use Use CMAKE to create a profile configuration
 // or make a configuration that define macro D_PROFILER
 
+// to capture traces without the tracy server define macro D_TRACE_CAPTURE,
+// the zones are recorded in memory and saved with ndTraceCapture::SaveChromeTrace
+
+/// In process recorder of D_TRACKTIME zones.
+/// each thread writes the zones to its own ring buffer without locks,
+/// when the buffer is full the oldest zones are overwritten. 
+/// The buffer of a thread that exits is reused by the next new thread.
+/// The capture is saved in chrome trace json format, which can be 
+/// loaded by chrome://tracing and by the perfetto ui.
+class ndTraceCapture
+{
+	public:
+	/// Discard all recorded zones and start recording.
+	D_CORE_API static void Start();
+
+	/// Stop recording, the recorded zones are kept until the next Start.
+	D_CORE_API static void Stop();
+
+	/// Return true if zones are being recorded.
+	D_CORE_API static bool IsCapturing();
+
+	/// Return the number of zones lost since Start because all the thread 
+	/// buffers were taken by live threads.
+	D_CORE_API static ndUnsigned64 GetDroppedZones();
+
+	/// Save the recorded zones. 
+	/// It should be called after Stop or between updates, zones recorded 
+	/// while the file is being written may be lost.
+	D_CORE_API static bool SaveChromeTrace(const char* const fileName);
+
+	/// Name the calling thread, this is what D_SET_TRACK_NAME calls.
+	D_CORE_API static void SetThreadName(const char* const threadName);
+
+	/// Return the start time stamp of a zone, zero if not capturing.
+	D_CORE_API static ndUnsigned64 BeginZone();
+
+	/// Record a zone that started at time stamp beginTime.
+	D_CORE_API static void EndZone(const char* const zoneName, ndUnsigned64 beginTime);
+};
+
+class ndTraceZone
+{
+	public:
+	ndTraceZone(const char* const zoneName)
+		:m_name(zoneName)
+		,m_beginTime(ndTraceCapture::BeginZone())
+	{
+	}
+
+	~ndTraceZone()
+	{
+		if (m_beginTime)
+		{
+			ndTraceCapture::EndZone(m_name, m_beginTime);
+		}
+	}
+
+	private:
+	const char* m_name;
+	ndUnsigned64 m_beginTime;
+};
+
 #ifdef D_PROFILER
 	#include <dTracyProfiler.h>
 	#define D_TRACKTIME() dProfilerZoneScoped(__FUNCTION__)
 	#define D_SET_TRACK_NAME(trackName) dProfilerSetTrackName(trackName)
+#elif defined (D_TRACE_CAPTURE)
+	#define D_TRACKTIME() ndTraceZone ___ndTraceZone(__FUNCTION__)
+	#define D_SET_TRACK_NAME(trackName) ndTraceCapture::SetThreadName(trackName)
 #else
 	#define D_TRACKTIME() 
 	#define D_SET_TRACK_NAME(trackName)
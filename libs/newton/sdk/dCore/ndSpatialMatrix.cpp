@@ -72,18 +72,14 @@ ndSpatialMatrix ndSpatialMatrix::Inverse(ndInt32 rows) const
 			}
 		}
 
+		// eliminate full rows at once, the entries to the left of the pivot
+		// are already zero so the simd row update is the same as the scalar one.
 		for (ndInt32 j = i + 1; j < rows; j++) 
 		{
-			ndFloat64 scale = tmp[j][i] / tmp[i][i];
+			const ndFloat64 scale = -tmp[j][i] / tmp[i][i];
+			tmp[j] = tmp[j] + tmp[i].Scale(scale);
+			inv[j] = inv[j] + inv[i].Scale(scale);
 			tmp[j][i] = ndFloat64(0.0f);
-			for (ndInt32 k = i + 1; k < rows; k++) 
-			{
-				tmp[j][k] -= scale * tmp[i][k];
-			}
-			for (ndInt32 k = 0; k <= i; k++) 
-			{
-				inv[j][k] -= scale * inv[i][k];
-			}
 		}
 	}
 
@@ -92,17 +88,10 @@ ndSpatialMatrix ndSpatialMatrix::Inverse(ndInt32 rows) const
 		ndSpatialVector acc(ndFloat64(0.0f));
 		for (ndInt32 j = i + 1; j < rows; j++) 
 		{
-			ndFloat64 pivot = tmp[i][j];
-			for (ndInt32 k = 0; k < rows; k++) 
-			{
-				acc[k] += pivot * inv[j][k];
-			}
-		}
-		ndFloat64 den = ndFloat64(1.0f) / tmp[i][i];
-		for (ndInt32 k = 0; k < rows; k++) 
-		{
-			inv[i][k] = den * (inv[i][k] - acc[k]);
+			acc = acc + inv[j].Scale(tmp[i][j]);
 		}
+		const ndFloat64 den = ndFloat64(1.0f) / tmp[i][i];
+		inv[i] = (inv[i] + acc.Scale(ndFloat64(-1.0f))).Scale(den);
 	}
 
 
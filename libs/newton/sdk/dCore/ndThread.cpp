@@ -83,8 +83,12 @@ void ndThread::SetName(const char* const name)
 void ndThread::Finish()
 {
 #ifndef D_USE_THREAD_EMULATION
-	Terminate();
-	join();
+	// a thread can be finished early, before the owner destructor finishes it again.
+	if (joinable())
+	{
+		Terminate();
+		join();
+	}
 #endif
 }
 
@@ -204,3 +204,22 @@ void ndThreadPool::Release()
 {
 	ndSyncMutex::Release();
 }
+
+ndJobThreadPool::ndJobThreadPool(ndInt32 threadCount, const char* const name)
+	:ndThreadPool(name)
+{
+	SetCount(threadCount);
+	Begin();
+}
+
+ndJobThreadPool::~ndJobThreadPool()
+{
+	End();
+	Finish();
+}
+
+void ndJobThreadPool::ThreadFunction()
+{
+	// the pool only executes the jobs submitted to it
+	dAssert(0);
+}
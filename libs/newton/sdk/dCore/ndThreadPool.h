@@ -130,9 +130,47 @@ class ndThreadPool: public ndSyncMutex, public ndThread
 	ndThreadLockFreeUpdate m_lockFreeJobs[D_MAX_THREADS_COUNT];
 };
 
+// a pool that is started on construction and only runs the jobs 
+// submitted to it, for tools that split one task over worker threads.
+class ndJobThreadPool: public ndThreadPool
+{
+	public:
+	class ndBaseJob: public ndThreadPoolJob
+	{
+		public:
+		ndJobThreadPool* m_owner;
+		void* m_context;
+	};
+
+	D_CORE_API ndJobThreadPool(ndInt32 threadCount, const char* const name);
+	D_CORE_API virtual ~ndJobThreadPool();
+
+	template <class T>
+	void SubmitJobs(void* const context);
+
+	private:
+	virtual void ThreadFunction();
+};
+
 inline ndInt32 ndThreadPool::GetCount() const
 {
 	return m_count + 1;
 }
 
+template <class T>
+void ndJobThreadPool::SubmitJobs(void* const context)
+{
+	T extJob[D_MAX_THREADS_COUNT];
+	ndThreadPoolJob* extJobPtr[D_MAX_THREADS_COUNT];
+
+	const ndInt32 threadCount = GetCount();
+	for (ndInt32 i = 0; i < threadCount; i++)
+	{
+		extJob[i].m_owner = this;
+		extJob[i].m_context = context;
+		extJobPtr[i] = &extJob[i];
+	}
+	ExecuteJobs(extJobPtr);
+}
+
 #endif
@@ -127,6 +127,10 @@
 // alternatively the end application can use a command line option to enable this define
 //#define D_PROFILER
 
+// uncomment out D_TRACE_CAPTURE to record profiler traces in memory without the profiler,
+// the traces are saved with ndTraceCapture::SaveChromeTrace
+//#define D_TRACE_CAPTURE
+
 // uncomment this for Scalar floating point 
 // alternatively the end application can use a command line option to enable this define
 //#define D_SCALAR_VECTOR_CLASS
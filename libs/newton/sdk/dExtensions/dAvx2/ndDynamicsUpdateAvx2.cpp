@@ -2610,14 +2610,22 @@ void ndDynamicsUpdateAvx2::Update()
 	m_timestep = m_world->GetScene()->GetTimestep();
 
 	BuildIsland();
+	m_world->RecordPhaseTime(ndWorldStatistics::m_solverBuildIsland);
 	if (GetIslands().GetCount())
 	{
 		IntegrateUnconstrainedBodies();
+		m_world->RecordPhaseTime(ndWorldStatistics::m_solverIntegrateUnconstrainedBodies);
 		InitWeights();
+		m_world->RecordPhaseTime(ndWorldStatistics::m_solverInitWeights);
 		InitBodyArray();
+		m_world->RecordPhaseTime(ndWorldStatistics::m_solverInitBodyArray);
 		InitJacobianMatrix();
+		m_world->RecordPhaseTime(ndWorldStatistics::m_solverInitJacobianMatrix);
 		CalculateForces();
+		m_world->RecordPhaseTime(ndWorldStatistics::m_solverCalculateForces);
 		IntegrateBodies();
+		m_world->RecordPhaseTime(ndWorldStatistics::m_solverIntegrateBodies);
 		DetermineSleepStates();
+		m_world->RecordPhaseTime(ndWorldStatistics::m_solverDetermineSleepStates);
 	}
 }
@@ -1559,17 +1559,25 @@ void ndDynamicsUpdateOpencl::Update()
 		m_timestep = m_world->GetScene()->GetTimestep();
 
 		BuildIsland();
+		m_world->RecordPhaseTime(ndWorldStatistics::m_solverBuildIsland);
 		dInt32 count = GetActiveBodies().GetCount();
 		if (count)
 		{
 			IntegrateUnconstrainedBodies();
+			m_world->RecordPhaseTime(ndWorldStatistics::m_solverIntegrateUnconstrainedBodies);
 			InitWeights();
+			m_world->RecordPhaseTime(ndWorldStatistics::m_solverInitWeights);
 			InitBodyArray();
+			m_world->RecordPhaseTime(ndWorldStatistics::m_solverInitBodyArray);
 			InitJacobianMatrix();
+			m_world->RecordPhaseTime(ndWorldStatistics::m_solverInitJacobianMatrix);
 			CalculateForces();
+			m_world->RecordPhaseTime(ndWorldStatistics::m_solverCalculateForces);
 			IntegrateBodies();
+			m_world->RecordPhaseTime(ndWorldStatistics::m_solverIntegrateBodies);
 			//FinishGpuUpdate();
 			DetermineSleepStates();
+			m_world->RecordPhaseTime(ndWorldStatistics::m_solverDetermineSleepStates);
 		}
 	}
 	else
@@ -89,6 +89,10 @@ void ndBodyDynamic::SetForce(const ndVector& force)
 		dAssert(deltaAccel.m_w == ndFloat32(0.0f));
 		ndFloat32 deltaAccel2 = deltaAccel.DotProduct(deltaAccel).GetScalar();
 		m_equilibrium = (deltaAccel2 < D_ERR_TOLERANCE2);
+		if (!m_equilibrium && m_sleepingIsland)
+		{
+			WakeSleepingIsland();
+		}
 	}
 }
 
@@ -106,6 +110,10 @@ void ndBodyDynamic::SetTorque(const ndVector& torque)
 		dAssert(deltaAlpha.m_w == ndFloat32(0.0f));
 		ndFloat32 deltaAlpha2 = deltaAlpha.DotProduct(deltaAlpha).GetScalar();
 		m_equilibrium = (deltaAlpha2 < D_ERR_TOLERANCE2);
+		if (!m_equilibrium && m_sleepingIsland)
+		{
+			WakeSleepingIsland();
+		}
 	}
 }
 
@@ -179,7 +187,7 @@ void ndBodyDynamic::AddImpulse(const ndVector& pointDeltaVeloc, const ndVector&
 		m_impulseForce += changeOfMomentum.Scale(1.0f / timestep);
 		m_impulseTorque += globalContact.CrossProduct(m_impulseForce);
 
-		m_equilibrium = false;
+		WakeUp();
 		//Unfreeze();
 	}
 }
@@ -194,7 +202,7 @@ void ndBodyDynamic::ApplyImpulsePair(const ndVector& linearImpulse, const ndVect
 		m_impulseForce += linearImpulse.Scale(1.0f / timestep);
 		m_impulseTorque += angularImpulse.Scale(1.0f / timestep);
 
-		m_equilibrium = false;
+		WakeUp();
 	}
 }
 
@@ -223,7 +231,7 @@ void ndBodyDynamic::ApplyImpulsesAtPoint(ndInt32 count, const ndVector* const im
 		m_impulseForce += impulse.Scale(1.0f / timestep);
 		m_impulseTorque += angularImpulse.Scale(1.0f / timestep);
 
-		m_equilibrium = false;
+		WakeUp();
 	}
 }
 
@@ -89,6 +89,8 @@ class ndBodyDynamic: public ndBodyKinematic
 	friend class ndDynamicsUpdateSoa;
 	friend class ndDynamicsUpdateAvx2;
 	friend class ndDynamicsUpdateOpencl;
+	friend class ndWorld;
+	friend class ndLoadSave;
 } D_GCC_NEWTON_ALIGN_32 ;
 
 class ndBodySentinel : public ndBodyDynamic
@@ -40,6 +40,7 @@ ndDynamicsUpdate::ndDynamicsUpdate(ndWorld* const world)
 	,m_tempInternalForces(D_DEFAULT_BUFFER_SIZE)
 	,m_bodyIslandOrder(D_DEFAULT_BUFFER_SIZE)
 	,m_jointBodyPairIndexBuffer(D_DEFAULT_BUFFER_SIZE)
+	,m_activeSkeletons(256)
 	,m_world(world)
 	,m_timestep(ndFloat32(0.0f))
 	,m_invTimestep(ndFloat32(0.0f))
@@ -73,6 +74,47 @@ void ndDynamicsUpdate::Clear()
 	m_tempInternalForces.Resize(D_DEFAULT_BUFFER_SIZE);
 	m_jointForcesIndex.Resize(D_DEFAULT_BUFFER_SIZE);
 	m_jointBodyPairIndexBuffer.Resize(D_DEFAULT_BUFFER_SIZE);
+	m_activeSkeletons.Resize(256);
+}
+
+void ndDynamicsUpdate::BuildActiveSkeletonArray()
+{
+	D_TRACKTIME();
+	class CompareSkeletons
+	{
+		public:
+		ndInt32 Compare(const ndSkeletonContainer* const skeletonA, const ndSkeletonContainer* const skeletonB, void* const) const
+		{
+			const ndInt32 costA = skeletonA->GetFactorizationCost();
+			const ndInt32 costB = skeletonB->GetFactorizationCost();
+			if (costA < costB)
+			{
+				return 1;
+			}
+			if (costA > costB)
+			{
+				return -1;
+			}
+			return 0;
+		}
+	};
+
+	// resting skeletons do not factorize, the rest are sorted from the most
+	// expensive to the cheapest so that threads pulling skeletons from a shared 
+	// counter finish at about the same time.
+	m_activeSkeletons.SetCount(0);
+	for (ndSkeletonList::ndNode* node = m_world->GetSkeletonList().GetFirst(); node; node = node->GetNext())
+	{
+		ndSkeletonContainer* const skeleton = &node->GetInfo();
+		if (!skeleton->IsResting())
+		{
+			m_activeSkeletons.PushBack(skeleton);
+		}
+	}
+	if (m_activeSkeletons.GetCount() > 1)
+	{
+		ndSort<ndSkeletonContainer*, CompareSkeletons>(&m_activeSkeletons[0], m_activeSkeletons.GetCount());
+	}
 }
 
 void ndDynamicsUpdate::SortBodyJointScan()
@@ -346,7 +388,12 @@ void ndDynamicsUpdate::SortJointsScan()
 	for (ndJointList::ndNode* node = jointList.GetFirst(); node; node = node->GetNext())
 	{
 		ndJointBilateralConstraint* const joint = node->GetInfo();
-		if (joint->IsActive())
+		const ndBodyKinematic* const body0 = joint->GetBody0();
+		const ndBodyKinematic* const body1 = joint->GetBody1();
+		// joints of sleeping islands are not part of the step
+		dAssert(!body0->m_sleepingIsland || body1->m_sleepingIsland || (body1->GetInvMass() == ndFloat32(0.0f)));
+		dAssert(!body1->m_sleepingIsland || body0->m_sleepingIsland || (body0->GetInvMass() == ndFloat32(0.0f)));
+		if (joint->IsActive() && !(body0->m_sleepingIsland | body1->m_sleepingIsland))
 		{
 			jointArray[jointCount] = joint;
 			jointCount++;
@@ -1543,34 +1590,30 @@ void ndDynamicsUpdate::InitSkeletons()
 		virtual void Execute()
 		{
 			D_TRACKTIME();
-			const ndInt32 threadIndex = GetThreadId();
 			ndWorld* const world = m_owner->GetWorld();
 			ndDynamicsUpdate* const me = world->m_solver;
-			ndSkeletonList::ndNode* node = world->GetSkeletonList().GetFirst();
-			for (ndInt32 i = 0; i < threadIndex; ++i)
-			{
-				node = node ? node->GetNext() : nullptr;
-			}
+			ndAtomic<ndInt32>& skeletonIndex = *((ndAtomic<ndInt32>*)m_context);
 
 			ndArray<ndRightHandSide>& rightHandSide = me->m_rightHandSide;
 			const ndArray<ndLeftHandSide>& leftHandSide = me->m_leftHandSide;
+			const ndArray<ndSkeletonContainer*>& skeletonArray = me->m_activeSkeletons;
 
-			const ndInt32 threadCount = m_owner->GetThreadCount();
-			while (node)
+			const ndInt32 count = skeletonArray.GetCount();
+			for (ndInt32 i = skeletonIndex.fetch_add(1); i < count; i = skeletonIndex.fetch_add(1))
 			{
-				ndSkeletonContainer* const skeleton = &node->GetInfo();
+				ndSkeletonContainer* const skeleton = skeletonArray[i];
 				skeleton->InitMassMatrix(&leftHandSide[0], &rightHandSide[0]);
-
-				for (ndInt32 i = 0; i < threadCount; ++i)
-				{
-					node = node ? node->GetNext() : nullptr;
-				}
 			}
 		}
 	};
 
-	ndScene* const scene = m_world->GetScene();
-	scene->SubmitJobs<ndInitSkeletons>();
+	BuildActiveSkeletonArray();
+	if (m_activeSkeletons.GetCount())
+	{
+		ndScene* const scene = m_world->GetScene();
+		ndAtomic<ndInt32> skeletonIndex(0);
+		scene->SubmitJobs<ndInitSkeletons>(&skeletonIndex);
+	}
 }
 
 void ndDynamicsUpdate::UpdateSkeletons()
@@ -1582,35 +1625,30 @@ void ndDynamicsUpdate::UpdateSkeletons()
 		virtual void Execute()
 		{
 			D_TRACKTIME();
-			const ndInt32 threadIndex = GetThreadId();
 			ndWorld* const world = m_owner->GetWorld();
 			ndDynamicsUpdate* const me = world->m_solver;
-			ndSkeletonList::ndNode* node = world->GetSkeletonList().GetFirst();
-			for (ndInt32 i = 0; i < threadIndex; ++i)
-			{
-				node = node ? node->GetNext() : nullptr;
-			}
+			ndAtomic<ndInt32>& skeletonIndex = *((ndAtomic<ndInt32>*)m_context);
 
 			ndJacobian* const internalForces = &me->GetInternalForces()[0];
 			const ndArray<ndBodyKinematic*>& activeBodies = m_owner->ndScene::GetActiveBodyArray();
 			const ndBodyKinematic** const bodyArray = (const ndBodyKinematic**)&activeBodies[0];
+			const ndArray<ndSkeletonContainer*>& skeletonArray = me->m_activeSkeletons;
 
-			const ndInt32 threadCount = m_owner->GetThreadCount();
-			while (node)
+			const ndInt32 count = skeletonArray.GetCount();
+			for (ndInt32 i = skeletonIndex.fetch_add(1); i < count; i = skeletonIndex.fetch_add(1))
 			{
-				ndSkeletonContainer* const skeleton = &node->GetInfo();
+				ndSkeletonContainer* const skeleton = skeletonArray[i];
 				skeleton->CalculateJointForce(bodyArray, internalForces);
-
-				for (ndInt32 i = 0; i < threadCount; ++i)
-				{
-					node = node ? node->GetNext() : nullptr;
-				}
 			}
 		}
 	};
 
-	ndScene* const scene = m_world->GetScene();
-	scene->SubmitJobs<ndUpdateSkeletons>();
+	if (m_activeSkeletons.GetCount())
+	{
+		ndScene* const scene = m_world->GetScene();
+		ndAtomic<ndInt32> skeletonIndex(0);
+		scene->SubmitJobs<ndUpdateSkeletons>(&skeletonIndex);
+	}
 }
 
 void ndDynamicsUpdate::CalculateJointsForce()
@@ -1884,14 +1922,22 @@ void ndDynamicsUpdate::Update()
 	m_timestep = m_world->GetScene()->GetTimestep();
 
 	BuildIsland();
+	m_world->RecordPhaseTime(ndWorldStatistics::m_solverBuildIsland);
 	if (GetIslands().GetCount())
 	{
 		IntegrateUnconstrainedBodies();
+		m_world->RecordPhaseTime(ndWorldStatistics::m_solverIntegrateUnconstrainedBodies);
 		InitWeights();
+		m_world->RecordPhaseTime(ndWorldStatistics::m_solverInitWeights);
 		InitBodyArray();
+		m_world->RecordPhaseTime(ndWorldStatistics::m_solverInitBodyArray);
 		InitJacobianMatrix();
+		m_world->RecordPhaseTime(ndWorldStatistics::m_solverInitJacobianMatrix);
 		CalculateForces();
+		m_world->RecordPhaseTime(ndWorldStatistics::m_solverCalculateForces);
 		IntegrateBodies();
+		m_world->RecordPhaseTime(ndWorldStatistics::m_solverIntegrateBodies);
 		DetermineSleepStates();
+		m_world->RecordPhaseTime(ndWorldStatistics::m_solverDetermineSleepStates);
 	}
 }
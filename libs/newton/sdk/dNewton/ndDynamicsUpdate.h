@@ -126,6 +126,7 @@ class ndDynamicsUpdate : public ndClassAlloc
 	virtual void Update();
 	void SortJointsScan();
 	void SortBodyJointScan();
+	void BuildActiveSkeletonArray();
 	ndBodyKinematic* FindRootAndSplit(ndBodyKinematic* const body);
 
 	ndVector m_velocTol;
@@ -137,6 +138,7 @@ class ndDynamicsUpdate : public ndClassAlloc
 	ndArray<ndJacobian> m_tempInternalForces;
 	ndArray<ndBodyKinematic*> m_bodyIslandOrder;
 	ndArray<ndJointBodyPairIndex> m_jointBodyPairIndexBuffer;
+	ndArray<ndSkeletonContainer*> m_activeSkeletons;
 
 	ndWorld* m_world;
 	ndFloat32 m_timestep;
@@ -1417,34 +1417,30 @@ void ndDynamicsUpdateSoa::InitSkeletons()
 		virtual void Execute()
 		{
 			D_TRACKTIME();
-			const ndInt32 threadIndex = GetThreadId();
 			ndWorld* const world = m_owner->GetWorld();
 			ndDynamicsUpdateSoa* const me = (ndDynamicsUpdateSoa*)world->m_solver;
-			ndSkeletonList::ndNode* node = world->GetSkeletonList().GetFirst();
-			for (ndInt32 i = 0; i < threadIndex; ++i)
-			{
-				node = node ? node->GetNext() : nullptr;
-			}
+			ndAtomic<ndInt32>& skeletonIndex = *((ndAtomic<ndInt32>*)m_context);
 
 			ndArray<ndRightHandSide>& rightHandSide = me->m_rightHandSide;
 			const ndArray<ndLeftHandSide>& leftHandSide = me->m_leftHandSide;
+			const ndArray<ndSkeletonContainer*>& skeletonArray = me->m_activeSkeletons;
 
-			const ndInt32 threadCount = m_owner->GetThreadCount();
-			while (node)
+			const ndInt32 count = skeletonArray.GetCount();
+			for (ndInt32 i = skeletonIndex.fetch_add(1); i < count; i = skeletonIndex.fetch_add(1))
 			{
-				ndSkeletonContainer* const skeleton = &node->GetInfo();
+				ndSkeletonContainer* const skeleton = skeletonArray[i];
 				skeleton->InitMassMatrix(&leftHandSide[0], &rightHandSide[0]);
-
-				for (ndInt32 i = 0; i < threadCount; ++i)
-				{
-					node = node ? node->GetNext() : nullptr;
-				}
 			}
 		}
 	};
 
-	ndScene* const scene = m_world->GetScene();
-	scene->SubmitJobs<ndInitSkeletons>();
+	BuildActiveSkeletonArray();
+	if (m_activeSkeletons.GetCount())
+	{
+		ndScene* const scene = m_world->GetScene();
+		ndAtomic<ndInt32> skeletonIndex(0);
+		scene->SubmitJobs<ndInitSkeletons>(&skeletonIndex);
+	}
 }
 
 void ndDynamicsUpdateSoa::UpdateSkeletons()
@@ -1456,35 +1452,30 @@ void ndDynamicsUpdateSoa::UpdateSkeletons()
 		virtual void Execute()
 		{
 			D_TRACKTIME();
-			const ndInt32 threadIndex = GetThreadId();
 			ndWorld* const world = m_owner->GetWorld();
 			ndDynamicsUpdateSoa* const me = (ndDynamicsUpdateSoa*)world->m_solver;
-			ndSkeletonList::ndNode* node = world->GetSkeletonList().GetFirst();
-			for (ndInt32 i = 0; i < threadIndex; ++i)
-			{
-				node = node ? node->GetNext() : nullptr;
-			}
+			ndAtomic<ndInt32>& skeletonIndex = *((ndAtomic<ndInt32>*)m_context);
 
 			ndJacobian* const internalForces = &me->GetInternalForces()[0];
 			const ndArray<ndBodyKinematic*>& activeBodies = m_owner->ndScene::GetActiveBodyArray();
 			const ndBodyKinematic** const bodyArray = (const ndBodyKinematic**)&activeBodies[0];
+			const ndArray<ndSkeletonContainer*>& skeletonArray = me->m_activeSkeletons;
 
-			const ndInt32 threadCount = m_owner->GetThreadCount();
-			while (node)
+			const ndInt32 count = skeletonArray.GetCount();
+			for (ndInt32 i = skeletonIndex.fetch_add(1); i < count; i = skeletonIndex.fetch_add(1))
 			{
-				ndSkeletonContainer* const skeleton = &node->GetInfo();
+				ndSkeletonContainer* const skeleton = skeletonArray[i];
 				skeleton->CalculateJointForce(bodyArray, internalForces);
-
-				for (ndInt32 i = 0; i < threadCount; ++i)
-				{
-					node = node ? node->GetNext() : nullptr;
-				}
 			}
 		}
 	};
 
-	ndScene* const scene = m_world->GetScene();
-	scene->SubmitJobs<ndUpdateSkeletons>();
+	if (m_activeSkeletons.GetCount())
+	{
+		ndScene* const scene = m_world->GetScene();
+		ndAtomic<ndInt32> skeletonIndex(0);
+		scene->SubmitJobs<ndUpdateSkeletons>(&skeletonIndex);
+	}
 }
 
 void ndDynamicsUpdateSoa::CalculateJointsAcceleration()
@@ -2149,14 +2140,22 @@ void ndDynamicsUpdateSoa::Update()
 	m_timestep = m_world->GetScene()->GetTimestep();
 
 	BuildIsland();
+	m_world->RecordPhaseTime(ndWorldStatistics::m_solverBuildIsland);
 	if (GetIslands().GetCount())
 	{
 		IntegrateUnconstrainedBodies();
+		m_world->RecordPhaseTime(ndWorldStatistics::m_solverIntegrateUnconstrainedBodies);
 		InitWeights();
+		m_world->RecordPhaseTime(ndWorldStatistics::m_solverInitWeights);
 		InitBodyArray();
+		m_world->RecordPhaseTime(ndWorldStatistics::m_solverInitBodyArray);
 		InitJacobianMatrix();
+		m_world->RecordPhaseTime(ndWorldStatistics::m_solverInitJacobianMatrix);
 		CalculateForces();
+		m_world->RecordPhaseTime(ndWorldStatistics::m_solverCalculateForces);
 		IntegrateBodies();
+		m_world->RecordPhaseTime(ndWorldStatistics::m_solverIntegrateBodies);
 		DetermineSleepStates();
+		m_world->RecordPhaseTime(ndWorldStatistics::m_solverDetermineSleepStates);
 	}
 }
@@ -0,0 +1,688 @@
+/* Copyright (c) <2003-2021> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ndCoreStdafx.h"
+#include "ndNewtonStdafx.h"
+#include "ndWorld.h"
+#include "ndMeshEffect.h"
+#include "ndBodyDynamic.h"
+#include "ndShapeInstance.h"
+#include "ndFractureAsset.h"
+#include "ndShapeConvexHull.h"
+
+#define D_FRACTURE_IMAGE_MAGIC		0x7266646e
+#define D_FRACTURE_IMAGE_VERSION	1
+#define D_FRACTURE_IMAGE_ALIGN(x)	(((x) + 15) & -16)
+
+class ndFractureAsset::ndImageHeader
+{
+	public:
+	ndUnsigned32 m_magic;
+	ndUnsigned32 m_version;
+	ndInt32 m_pieceCount;
+	ndInt32 m_vertexCount;
+	ndInt32 m_linkCount;
+	ndInt32 m_pieceSizeInBytes;
+	ndInt32 m_pieceOffset;
+	ndInt32 m_vertexOffset;
+	ndInt32 m_linkOffset;
+	ndInt32 m_imageSizeInBytes;
+	ndFloat32 m_volume;
+	ndInt32 m_padding;
+	ndFloat32 m_centerOfMass[4];
+};
+
+class ndFractureFace
+{
+	public:
+	ndVector m_normal;
+	ndVector m_minBox;
+	ndVector m_maxBox;
+	ndFloat32 m_dist;
+	ndFloat32 m_area;
+};
+
+class ndFractureFaceCollector: public ndShapeDebugNotify
+{
+	public:
+	ndFractureFaceCollector(ndArray<ndFractureFace>& faces)
+		:ndShapeDebugNotify()
+		,m_faces(faces)
+	{
+	}
+
+	virtual void DrawPolygon(ndInt32 vertexCount, const ndVector* const faceArray, const ndEdgeType* const)
+	{
+		ndVector normal(ndVector::m_zero);
+		ndVector minBox(faceArray[0] & ndVector::m_triplexMask);
+		ndVector maxBox(minBox);
+		const ndVector p0(faceArray[0] & ndVector::m_triplexMask);
+		ndVector e0((faceArray[1] & ndVector::m_triplexMask) - p0);
+		for (ndInt32 i = 2; i < vertexCount; ++i)
+		{
+			const ndVector e1((faceArray[i] & ndVector::m_triplexMask) - p0);
+			normal += e0.CrossProduct(e1);
+			e0 = e1;
+		}
+		for (ndInt32 i = 1; i < vertexCount; ++i)
+		{
+			minBox = minBox.GetMin(faceArray[i] & ndVector::m_triplexMask);
+			maxBox = maxBox.GetMax(faceArray[i] & ndVector::m_triplexMask);
+		}
+
+		const ndFloat32 mag2 = normal.DotProduct(normal).GetScalar();
+		if (mag2 > ndFloat32(1.0e-12f))
+		{
+			ndFractureFace face;
+			face.m_area = ndFloat32(0.5f) * ndSqrt(mag2);
+			face.m_normal = normal.Normalize();
+			face.m_dist = face.m_normal.DotProduct(p0).GetScalar();
+			face.m_minBox = minBox;
+			face.m_maxBox = maxBox;
+			m_faces.PushBack(face);
+		}
+	}
+
+	ndArray<ndFractureFace>& m_faces;
+};
+
+ndFractureAsset::ndFractureAsset()
+	:ndClassAlloc()
+	,m_pieces()
+	,m_vertex()
+	,m_links()
+	,m_shapes()
+	,m_centerOfMass(ndVector::m_zero)
+	,m_volume(ndFloat32(0.0f))
+	,m_threadCount(1)
+{
+#ifndef D_USE_THREAD_EMULATION
+	SetThreadCount(ndInt32(std::thread::hardware_concurrency()));
+#endif
+}
+
+ndFractureAsset::~ndFractureAsset()
+{
+	Clear();
+}
+
+void ndFractureAsset::SetThreadCount(ndInt32 count)
+{
+	m_threadCount = dClamp(count, 1, D_MAX_THREADS_COUNT);
+}
+
+void ndFractureAsset::Clear()
+{
+	for (ndInt32 i = 0; i < m_shapes.GetCount(); ++i)
+	{
+		delete m_shapes[i];
+	}
+	m_shapes.SetCount(0);
+	m_pieces.SetCount(0);
+	m_vertex.SetCount(0);
+	m_links.SetCount(0);
+	m_centerOfMass = ndVector::m_zero;
+	m_volume = ndFloat32(0.0f);
+}
+
+void ndFractureAsset::CreateShapes()
+{
+	dAssert(!m_shapes.GetCount());
+	for (ndInt32 i = 0; i < m_pieces.GetCount(); ++i)
+	{
+		const ndPiece& piece = m_pieces[i];
+		ndShapeConvexHull* const hull = new ndShapeConvexHull(piece.m_vertexCount, sizeof(ndTriplex), ndFloat32(0.0f), &m_vertex[piece.m_vertexStart].m_x);
+		ndShapeInstance* const instance = new ndShapeInstance(hull);
+
+		ndMatrix matrix(dGetIdentityMatrix());
+		matrix.m_posit = piece.m_origin;
+		matrix.m_posit.m_w = ndFloat32(1.0f);
+		instance->SetLocalMatrix(matrix);
+		m_shapes.PushBack(instance);
+	}
+}
+
+bool ndFractureAsset::Build(const ndShapeInstance& outerShape, const ndArray<ndVector>& pointCloud, const ndShapeInstance* const innerShape)
+{
+	D_TRACKTIME();
+	Clear();
+
+	// the cells are clipped against the outer shape and carved by
+	// the inner shape, if any, one cell per job.
+	ndArray<ndMeshEffect*> rawPieces;
+	ndMeshEffect outerMesh(outerShape);
+	if (innerShape)
+	{
+		ndMeshEffect innerMesh(*innerShape);
+		outerMesh.CreateVoronoiConvexPieces(rawPieces, pointCloud, 0, dGetIdentityMatrix(), &innerMesh, m_threadCount);
+	}
+	else
+	{
+		outerMesh.CreateVoronoiConvexPieces(rawPieces, pointCloud, 0, dGetIdentityMatrix(), nullptr, m_threadCount);
+	}
+
+	// only the hull vertices are baked, the mass properties are
+	// taken from the shapes rebuilt from them, same as after loading.
+	for (ndInt32 j = 0; j < rawPieces.GetCount(); ++j)
+	{
+		ndMeshEffect* const pieceMesh = rawPieces[j];
+		ndShapeInstance* const hull = pieceMesh->CreateConvexCollision(ndFloat32(0.0f));
+		if (hull)
+		{
+			const ndShapeInfo info(hull->GetShapeInfo());
+			ndPiece piece;
+			piece.m_origin = hull->GetLocalMatrix().m_posit & ndVector::m_triplexMask;
+			piece.m_centerOfMass = ndVector::m_zero;
+			piece.m_inertia = ndVector::m_zero;
+			piece.m_vertexStart = m_vertex.GetCount();
+			piece.m_vertexCount = info.m_convexhull.m_vertexCount;
+			piece.m_linkStart = 0;
+			piece.m_linkCount = 0;
+			for (ndInt32 i = 0; i < info.m_convexhull.m_vertexCount; ++i)
+			{
+				const ndVector& p = info.m_convexhull.m_vertex[i];
+				ndTriplex point;
+				point.m_x = p.m_x;
+				point.m_y = p.m_y;
+				point.m_z = p.m_z;
+				m_vertex.PushBack(point);
+			}
+			m_pieces.PushBack(piece);
+			delete hull;
+		}
+		delete pieceMesh;
+	}
+
+	CreateShapes();
+
+	ndVector minBox(ndFloat32(1.0e10f));
+	ndVector maxBox(ndFloat32(-1.0e10f));
+	ndVector centerOfMass(ndVector::m_zero);
+	for (ndInt32 i = 0; i < m_pieces.GetCount(); ++i)
+	{
+		ndPiece& piece = m_pieces[i];
+		const ndShapeInstance* const shape = m_shapes[i];
+		const ndMatrix inertia(shape->CalculateInertia());
+		const ndFloat32 volume = shape->GetVolume();
+		piece.m_centerOfMass = inertia.m_posit & ndVector::m_triplexMask;
+		piece.m_inertia = ndVector(inertia[0][0], inertia[1][1], inertia[2][2], volume);
+		centerOfMass += piece.m_centerOfMass.Scale(volume);
+		m_volume += volume;
+
+		ndVector p0;
+		ndVector p1;
+		shape->CalculateAabb(dGetIdentityMatrix(), p0, p1);
+		minBox = minBox.GetMin(p0);
+		maxBox = maxBox.GetMax(p1);
+	}
+
+	if (m_volume > ndFloat32(0.0f))
+	{
+		const ndFloat32 invVolume = ndFloat32(1.0f) / m_volume;
+		m_centerOfMass = centerOfMass.Scale(invVolume) & ndVector::m_triplexMask;
+		for (ndInt32 i = 0; i < m_pieces.GetCount(); ++i)
+		{
+			m_pieces[i].m_inertia.m_w *= invVolume;
+		}
+
+		const ndVector size((maxBox - minBox) & ndVector::m_triplexMask);
+		const ndFloat32 tolerance = dMax(ndFloat32(1.0e-3f) * ndSqrt(size.DotProduct(size).GetScalar()), ndFloat32(1.0e-4f));
+		CalculateLinks(tolerance);
+	}
+
+	return m_pieces.GetCount() > 0;
+}
+
+void ndFractureAsset::CalculateLinks(ndFloat32 tolerance)
+{
+	// two pieces are linked if they have faces on the same plane, facing
+	// each other and with overlapping bounds, the link strength is the
+	// area of the smaller of the two faces.
+	class ndPair
+	{
+		public:
+		ndInt32 m_piece0;
+		ndInt32 m_piece1;
+		ndFloat32 m_area;
+	};
+
+	ndArray<ndFractureFace> faces;
+	ndArray<ndInt32> faceStart;
+	ndArray<ndVector> pieceBox;
+	ndFractureFaceCollector collector(faces);
+	for (ndInt32 i = 0; i < m_pieces.GetCount(); ++i)
+	{
+		faceStart.PushBack(faces.GetCount());
+		m_shapes[i]->DebugShape(dGetIdentityMatrix(), collector);
+
+		ndVector p0;
+		ndVector p1;
+		m_shapes[i]->CalculateAabb(dGetIdentityMatrix(), p0, p1);
+		pieceBox.PushBack(p0 - ndVector(tolerance));
+		pieceBox.PushBack(p1 + ndVector(tolerance));
+	}
+	faceStart.PushBack(faces.GetCount());
+
+	ndArray<ndPair> pairs;
+	const ndVector padding(tolerance);
+	for (ndInt32 i = 0; i < m_pieces.GetCount(); ++i)
+	{
+		for (ndInt32 j = i + 1; j < m_pieces.GetCount(); ++j)
+		{
+			if (!dOverlapTest(pieceBox[i * 2], pieceBox[i * 2 + 1], pieceBox[j * 2], pieceBox[j * 2 + 1]))
+			{
+				continue;
+			}
+
+			ndFloat32 area = ndFloat32(0.0f);
+			for (ndInt32 k0 = faceStart[i]; k0 < faceStart[i + 1]; ++k0)
+			{
+				const ndFractureFace& face0 = faces[k0];
+				for (ndInt32 k1 = faceStart[j]; k1 < faceStart[j + 1]; ++k1)
+				{
+					const ndFractureFace& face1 = faces[k1];
+					const ndFloat32 cosAngle = face0.m_normal.DotProduct(face1.m_normal).GetScalar();
+					if ((cosAngle < ndFloat32(-0.999f)) && (dAbs(face0.m_dist + face1.m_dist) < tolerance))
+					{
+						if (dOverlapTest(face0.m_minBox - padding, face0.m_maxBox + padding, face1.m_minBox - padding, face1.m_maxBox + padding))
+						{
+							area = dMax(area, dMin(face0.m_area, face1.m_area));
+						}
+					}
+				}
+			}
+
+			if (area > ndFloat32(0.0f))
+			{
+				ndPair pair;
+				pair.m_piece0 = i;
+				pair.m_piece1 = j;
+				pair.m_area = area;
+				pairs.PushBack(pair);
+			}
+		}
+	}
+
+	for (ndInt32 i = 0; i < pairs.GetCount(); ++i)
+	{
+		m_pieces[pairs[i].m_piece0].m_linkCount++;
+		m_pieces[pairs[i].m_piece1].m_linkCount++;
+	}
+
+	ndInt32 linkCount = 0;
+	for (ndInt32 i = 0; i < m_pieces.GetCount(); ++i)
+	{
+		m_pieces[i].m_linkStart = linkCount;
+		linkCount += m_pieces[i].m_linkCount;
+		m_pieces[i].m_linkCount = 0;
+	}
+
+	// pairs are sorted by the first piece, so each piece gets its links sorted too
+	m_links.SetCount(linkCount);
+	for (ndInt32 i = 0; i < pairs.GetCount(); ++i)
+	{
+		const ndPair& pair = pairs[i];
+		ndPiece& piece0 = m_pieces[pair.m_piece0];
+		ndPiece& piece1 = m_pieces[pair.m_piece1];
+		ndLink& link0 = m_links[piece0.m_linkStart + piece0.m_linkCount];
+		ndLink& link1 = m_links[piece1.m_linkStart + piece1.m_linkCount];
+		link0.m_piece = pair.m_piece1;
+		link0.m_area = pair.m_area;
+		link1.m_piece = pair.m_piece0;
+		link1.m_area = pair.m_area;
+		piece0.m_linkCount++;
+		piece1.m_linkCount++;
+	}
+}
+
+ndInt32 ndFractureAsset::CalculateIslands(const ndUnsigned8* const detached, ndInt32* const islandOut) const
+{
+	// union find with the output as the parent array, every
+	// piece is joined to the lowest index root of its group.
+	const ndInt32 count = m_pieces.GetCount();
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		islandOut[i] = i;
+	}
+
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		if (detached && detached[i])
+		{
+			continue;
+		}
+		const ndPiece& piece = m_pieces[i];
+		for (ndInt32 j = 0; j < piece.m_linkCount; ++j)
+		{
+			const ndInt32 other = m_links[piece.m_linkStart + j].m_piece;
+			if ((other < i) && !(detached && detached[other]))
+			{
+				ndInt32 root0 = i;
+				while (islandOut[root0] != root0)
+				{
+					root0 = islandOut[root0];
+				}
+				ndInt32 root1 = other;
+				while (islandOut[root1] != root1)
+				{
+					root1 = islandOut[root1];
+				}
+				if (root0 < root1)
+				{
+					islandOut[root1] = root0;
+				}
+				else
+				{
+					islandOut[root0] = root1;
+				}
+			}
+		}
+	}
+
+	// roots have a lower index than the pieces of their group, so a forward
+	// pass can replace each root with its island, encoded as a negative
+	// number until all pieces are visited.
+	ndInt32 islandCount = 0;
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		if (detached && detached[i])
+		{
+			islandOut[i] = -1;
+		}
+		else if (islandOut[i] == i)
+		{
+			islandOut[i] = -(islandCount + 2);
+			islandCount++;
+		}
+		else
+		{
+			ndInt32 root = islandOut[i];
+			while (islandOut[root] >= 0)
+			{
+				root = islandOut[root];
+			}
+			islandOut[i] = islandOut[root];
+		}
+	}
+
+	for (ndInt32 i = 0; i < count; ++i)
+	{
+		if (islandOut[i] != -1)
+		{
+			islandOut[i] = -islandOut[i] - 2;
+		}
+	}
+	return islandCount;
+}
+
+bool ndFractureAsset::Serialize(const char* const path) const
+{
+	FILE* const file = fopen(path, "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	ndImageHeader header;
+	memset(&header, 0, sizeof(header));
+	header.m_magic = D_FRACTURE_IMAGE_MAGIC;
+	header.m_version = D_FRACTURE_IMAGE_VERSION;
+	header.m_pieceCount = m_pieces.GetCount();
+	header.m_vertexCount = m_vertex.GetCount();
+	header.m_linkCount = m_links.GetCount();
+	header.m_pieceSizeInBytes = sizeof(ndPiece);
+	header.m_pieceOffset = D_FRACTURE_IMAGE_ALIGN(ndInt32(sizeof(ndImageHeader)));
+	header.m_vertexOffset = D_FRACTURE_IMAGE_ALIGN(header.m_pieceOffset + ndInt32(sizeof(ndPiece)) * header.m_pieceCount);
+	header.m_linkOffset = D_FRACTURE_IMAGE_ALIGN(header.m_vertexOffset + ndInt32(sizeof(ndTriplex)) * header.m_vertexCount);
+	header.m_imageSizeInBytes = D_FRACTURE_IMAGE_ALIGN(header.m_linkOffset + ndInt32(sizeof(ndLink)) * header.m_linkCount);
+	header.m_volume = m_volume;
+	for (ndInt32 i = 0; i < 4; ++i)
+	{
+		header.m_centerOfMass[i] = m_centerOfMass[i];
+	}
+
+	const char padding[16] = { 0 };
+	const ndInt32 pieceSize = ndInt32(sizeof(ndPiece)) * header.m_pieceCount;
+	const ndInt32 vertexSize = ndInt32(sizeof(ndTriplex)) * header.m_vertexCount;
+	const ndInt32 linkSize = ndInt32(sizeof(ndLink)) * header.m_linkCount;
+	fwrite(&header, sizeof(ndImageHeader), 1, file);
+	fwrite(padding, size_t(header.m_pieceOffset - ndInt32(sizeof(ndImageHeader))), 1, file);
+	if (pieceSize)
+	{
+		fwrite(&m_pieces[0], size_t(pieceSize), 1, file);
+	}
+	fwrite(padding, size_t(header.m_vertexOffset - header.m_pieceOffset - pieceSize), 1, file);
+	if (vertexSize)
+	{
+		fwrite(&m_vertex[0], size_t(vertexSize), 1, file);
+	}
+	fwrite(padding, size_t(header.m_linkOffset - header.m_vertexOffset - vertexSize), 1, file);
+	if (linkSize)
+	{
+		fwrite(&m_links[0], size_t(linkSize), 1, file);
+	}
+	fwrite(padding, size_t(header.m_imageSizeInBytes - header.m_linkOffset - linkSize), 1, file);
+	fclose(file);
+	return true;
+}
+
+static bool ndCheckImageSection(ndInt32 offset, ndInt32 count, ndInt64 itemSize, ndInt64 fileSize)
+{
+	// the section must be inside the file and after the header
+	if ((count < 0) || (offset < ndInt32(sizeof(ndFractureAsset::ndImageHeader))))
+	{
+		return false;
+	}
+	return (ndInt64(offset) + ndInt64(count) * itemSize) <= fileSize;
+}
+
+bool ndFractureAsset::ValidatePieces() const
+{
+	const ndInt64 vertexCount = m_vertex.GetCount();
+	const ndInt64 linkCount = m_links.GetCount();
+	for (ndInt32 i = 0; i < m_pieces.GetCount(); ++i)
+	{
+		// CreateShapes builds a hull from the piece vertex range
+		const ndPiece& piece = m_pieces[i];
+		if ((piece.m_vertexStart < 0) || (piece.m_vertexCount < 4) || ((ndInt64(piece.m_vertexStart) + piece.m_vertexCount) > vertexCount))
+		{
+			return false;
+		}
+		if ((piece.m_linkStart < 0) || (piece.m_linkCount < 0) || ((ndInt64(piece.m_linkStart) + piece.m_linkCount) > linkCount))
+		{
+			return false;
+		}
+	}
+
+	for (ndInt32 i = 0; i < m_links.GetCount(); ++i)
+	{
+		const ndInt32 piece = m_links[i].m_piece;
+		if ((piece < 0) || (piece >= m_pieces.GetCount()))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ndFractureAsset::Deserialize(const char* const path)
+{
+	FILE* const file = fopen(path, "rb");
+	if (!file)
+	{
+		return false;
+	}
+
+	Clear();
+	fseek(file, 0, SEEK_END);
+	const ndInt64 fileSize = ndInt64(ftell(file));
+	fseek(file, 0, SEEK_SET);
+
+	ndImageHeader header;
+	size_t readValues = fread(&header, sizeof(ndImageHeader), 1, file);
+	bool ok = (readValues == 1) && (header.m_magic == D_FRACTURE_IMAGE_MAGIC) && (header.m_version == D_FRACTURE_IMAGE_VERSION) && (header.m_pieceSizeInBytes == ndInt32(sizeof(ndPiece)));
+
+	// the counts come from the file, they are checked against 
+	// its size before any array is allocated with them.
+	ok = ok && ndCheckImageSection(header.m_pieceOffset, header.m_pieceCount, ndInt64(sizeof(ndPiece)), fileSize);
+	ok = ok && ndCheckImageSection(header.m_vertexOffset, header.m_vertexCount, ndInt64(sizeof(ndTriplex)), fileSize);
+	ok = ok && ndCheckImageSection(header.m_linkOffset, header.m_linkCount, ndInt64(sizeof(ndLink)), fileSize);
+	if (ok)
+	{
+		m_pieces.SetCount(header.m_pieceCount);
+		m_vertex.SetCount(header.m_vertexCount);
+		m_links.SetCount(header.m_linkCount);
+		m_volume = header.m_volume;
+		m_centerOfMass = ndVector(header.m_centerOfMass[0], header.m_centerOfMass[1], header.m_centerOfMass[2], ndFloat32(0.0f));
+		if (header.m_pieceCount)
+		{
+			fseek(file, header.m_pieceOffset, SEEK_SET);
+			ok = ok && (fread(&m_pieces[0], sizeof(ndPiece) * size_t(header.m_pieceCount), 1, file) == 1);
+		}
+		if (header.m_vertexCount)
+		{
+			fseek(file, header.m_vertexOffset, SEEK_SET);
+			ok = ok && (fread(&m_vertex[0], sizeof(ndTriplex) * size_t(header.m_vertexCount), 1, file) == 1);
+		}
+		if (header.m_linkCount)
+		{
+			fseek(file, header.m_linkOffset, SEEK_SET);
+			ok = ok && (fread(&m_links[0], sizeof(ndLink) * size_t(header.m_linkCount), 1, file) == 1);
+		}
+	}
+	fclose(file);
+
+	// all the ranges are checked before any shape is made
+	ok = ok && ValidatePieces();
+	if (ok)
+	{
+		CreateShapes();
+	}
+	else
+	{
+		Clear();
+	}
+	return ok;
+}
+
+ndFracturePool::ndFracturePool(ndWorld* const world, const ndFractureAsset* const asset, ndInt32 capacity, const ndVector& gravity)
+	:ndClassAlloc()
+	,m_bodies()
+	,m_freeSlots()
+	,m_freeCount()
+	,m_slots()
+	,m_world(world)
+	,m_asset(asset)
+	,m_capacity(capacity)
+{
+	dAssert(capacity > 0);
+	for (ndInt32 i = 0; i < asset->GetPieceCount(); ++i)
+	{
+		const ndShapeInstance& shape = asset->GetPieceShape(i);
+		for (ndInt32 j = 0; j < capacity; ++j)
+		{
+			const ndInt32 slot = m_bodies.GetCount();
+			ndBodyDynamic* const body = new ndBodyDynamic();
+			body->SetNotifyCallback(new ndBodyNotify(gravity));
+			body->SetCollisionShape(shape);
+			m_bodies.PushBack(body);
+			m_freeSlots.PushBack(slot);
+			m_slots.Insert(slot, body->GetId());
+		}
+		m_freeCount.PushBack(capacity);
+	}
+}
+
+ndFracturePool::~ndFracturePool()
+{
+	for (ndInt32 i = 0; i < m_bodies.GetCount(); ++i)
+	{
+		ndBodyDynamic* const body = m_bodies[i];
+		if (body->GetScene())
+		{
+			m_world->RemoveBody(body);
+		}
+		delete body;
+	}
+}
+
+ndInt32 ndFracturePool::Activate(const ndMatrix& matrix, const ndVector& veloc, const ndVector& omega, ndFloat32 mass, const ndInt32* const pieces, ndInt32 count, ndBodyDynamic** const bodiesOut)
+{
+	D_TRACKTIME();
+	const ndVector com(matrix.TransformVector(m_asset->GetCenterOfMass()));
+	const ndInt32 pieceCount = pieces ? count : m_asset->GetPieceCount();
+
+	ndInt32 activeCount = 0;
+	for (ndInt32 i = 0; i < pieceCount; ++i)
+	{
+		const ndInt32 index = pieces ? pieces[i] : i;
+		dAssert((index >= 0) && (index < m_asset->GetPieceCount()));
+		if (m_freeCount[index])
+		{
+			m_freeCount[index]--;
+			const ndInt32 slot = m_freeSlots[index * m_capacity + m_freeCount[index]];
+			ndBodyDynamic* const body = m_bodies[slot];
+
+			const ndFractureAsset::ndPiece& piece = m_asset->GetPiece(index);
+			const ndFloat32 pieceMass = mass * piece.m_inertia.m_w;
+			ndVector massMatrix(piece.m_inertia.Scale(pieceMass));
+			massMatrix.m_w = pieceMass;
+			body->SetMassMatrix(massMatrix);
+			body->SetCentreOfMass(piece.m_centerOfMass);
+			body->SetMatrix(matrix);
+
+			const ndVector center(matrix.TransformVector(piece.m_centerOfMass));
+			body->SetOmega(omega);
+			body->SetVelocity(veloc + omega.CrossProduct(center - com));
+			m_world->AddBody(body);
+
+			bodiesOut[activeCount] = body;
+			activeCount++;
+		}
+	}
+	return activeCount;
+}
+
+ndInt32 ndFracturePool::Activate(const ndBodyKinematic* const intactBody, const ndInt32* const pieces, ndInt32 count, ndBodyDynamic** const bodiesOut)
+{
+	// the intact body must use the shape the asset was built from,
+	// so its matrix is also the matrix of the asset space.
+	const ndMatrix& matrix = intactBody->GetMatrix();
+	const ndVector omega(intactBody->GetOmega());
+	const ndVector bodyCom(matrix.TransformVector(intactBody->GetCentreOfMass()));
+	const ndVector assetCom(matrix.TransformVector(m_asset->GetCenterOfMass()));
+	const ndVector veloc(intactBody->GetVelocity() + omega.CrossProduct(assetCom - bodyCom));
+	return Activate(matrix, veloc, omega, intactBody->GetMassMatrix().m_w, pieces, count, bodiesOut);
+}
+
+void ndFracturePool::Release(ndBodyDynamic* const body)
+{
+	ndTree<ndInt32, ndUnsigned32>::ndNode* const node = m_slots.Find(body->GetId());
+	dAssert(node);
+	if (node && body->GetScene())
+	{
+		m_world->RemoveBody(body);
+		const ndInt32 slot = node->GetInfo();
+		const ndInt32 index = slot / m_capacity;
+		m_freeSlots[index * m_capacity + m_freeCount[index]] = slot;
+		m_freeCount[index]++;
+	}
+}
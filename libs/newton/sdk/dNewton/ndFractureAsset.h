@@ -0,0 +1,222 @@
+/* Copyright (c) <2003-2021> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __ND_FRACTURE_ASSET_H__
+#define __ND_FRACTURE_ASSET_H__
+
+#include "ndNewtonStdafx.h"
+
+class ndWorld;
+class ndBodyDynamic;
+class ndShapeInstance;
+class ndBodyKinematic;
+
+/// Precomputed fracture of a solid.
+/// Build cuts the outer shape into voronoi cells of a point cloud, and
+/// bakes the convex hull, mass properties and face neighbors of every piece.
+/// That is the only place where mesh and hull work is done, the result can
+/// be written to a compact binary image with Serialize and loaded back with
+/// Deserialize, so an application can bake its assets offline.
+/// The piece shapes are created once when the asset is built or loaded,
+/// and are shared by all the bodies an ndFracturePool makes from it.
+class ndFractureAsset: public ndClassAlloc
+{
+	public:
+	class ndImageHeader;
+
+	D_MSV_NEWTON_ALIGN_32
+	class ndPiece
+	{
+		public:
+		// position of the hull in the space of the intact solid
+		ndVector m_origin;
+		ndVector m_centerOfMass;
+		// principal inertia for a unit mass, w is the piece mass fraction
+		ndVector m_inertia;
+		ndInt32 m_vertexStart;
+		ndInt32 m_vertexCount;
+		ndInt32 m_linkStart;
+		ndInt32 m_linkCount;
+	} D_GCC_NEWTON_ALIGN_32;
+
+	class ndLink
+	{
+		public:
+		ndInt32 m_piece;
+		// area of the face shared by the two pieces
+		ndFloat32 m_area;
+	};
+
+	D_NEWTON_API ndFractureAsset();
+	D_NEWTON_API ~ndFractureAsset();
+
+	D_NEWTON_API bool Build(const ndShapeInstance& outerShape, const ndArray<ndVector>& pointCloud, const ndShapeInstance* const innerShape = nullptr);
+	D_NEWTON_API bool Serialize(const char* const path) const;
+	D_NEWTON_API bool Deserialize(const char* const path);
+
+	/// number of threads Build uses to cut the cells, defaults to the hardware threads.
+	ndInt32 GetThreadCount() const;
+	D_NEWTON_API void SetThreadCount(ndInt32 count);
+
+	ndInt32 GetPieceCount() const;
+	const ndPiece& GetPiece(ndInt32 index) const;
+	const ndLink* GetLinks(ndInt32 index) const;
+	const ndShapeInstance& GetPieceShape(ndInt32 index) const;
+	const ndVector& GetCenterOfMass() const;
+	ndFloat32 GetVolume() const;
+	ndUnsigned64 GetSizeInBytes() const;
+
+	/// label the groups of pieces that are still connected by shared faces,
+	/// detached pieces are not part of any group and get -1.
+	/// detached can be nullptr, returns the number of groups.
+	D_NEWTON_API ndInt32 CalculateIslands(const ndUnsigned8* const detached, ndInt32* const islandOut) const;
+
+	private:
+	void Clear();
+	void CreateShapes();
+	bool ValidatePieces() const;
+	void CalculateLinks(ndFloat32 tolerance);
+
+	ndArray<ndPiece> m_pieces;
+	ndArray<ndTriplex> m_vertex;
+	ndArray<ndLink> m_links;
+	ndArray<ndShapeInstance*> m_shapes;
+	ndVector m_centerOfMass;
+	ndFloat32 m_volume;
+	ndInt32 m_threadCount;
+};
+
+/// Bodies for the pieces of an ndFractureAsset, allocated up front.
+/// Every piece gets capacity bodies with its shape and a default
+/// notification already set, Activate takes them from the pool and adds
+/// them to the world, so a solid can shatter in the middle of a frame
+/// without building shapes or allocating bodies.
+/// Release gives a body back. A piece whose bodies are all in use is skipped.
+/// The pool owns its bodies and must be destroyed before the world.
+class ndFracturePool: public ndClassAlloc
+{
+	public:
+	D_NEWTON_API ndFracturePool(ndWorld* const world, const ndFractureAsset* const asset, ndInt32 capacity, const ndVector& gravity);
+	D_NEWTON_API ~ndFracturePool();
+
+	ndWorld* GetWorld() const;
+	const ndFractureAsset* GetAsset() const;
+	ndInt32 GetCapacity() const;
+	ndInt32 GetFreeCount(ndInt32 piece) const;
+
+	/// bodies can be configured once after the pool is created,
+	/// for example to set a different notification.
+	ndInt32 GetBodyCount() const;
+	ndBodyDynamic* GetBody(ndInt32 index) const;
+
+	/// add the pieces to the world at the location of the intact solid,
+	/// with the rigid motion of a solid of the given mass, veloc is the
+	/// velocity of the solid center of mass. pieces can be nullptr to
+	/// activate them all, returns the number of bodies written to bodiesOut.
+	D_NEWTON_API ndInt32 Activate(const ndMatrix& matrix, const ndVector& veloc, const ndVector& omega, ndFloat32 mass, const ndInt32* const pieces, ndInt32 count, ndBodyDynamic** const bodiesOut);
+	D_NEWTON_API ndInt32 Activate(const ndBodyKinematic* const intactBody, const ndInt32* const pieces, ndInt32 count, ndBodyDynamic** const bodiesOut);
+	D_NEWTON_API void Release(ndBodyDynamic* const body);
+
+	private:
+	ndArray<ndBodyDynamic*> m_bodies;
+	ndArray<ndInt32> m_freeSlots;
+	ndArray<ndInt32> m_freeCount;
+	ndTree<ndInt32, ndUnsigned32> m_slots;
+	ndWorld* m_world;
+	const ndFractureAsset* m_asset;
+	ndInt32 m_capacity;
+};
+
+inline ndInt32 ndFractureAsset::GetPieceCount() const
+{
+	return m_pieces.GetCount();
+}
+
+inline const ndFractureAsset::ndPiece& ndFractureAsset::GetPiece(ndInt32 index) const
+{
+	return m_pieces[index];
+}
+
+inline const ndFractureAsset::ndLink* ndFractureAsset::GetLinks(ndInt32 index) const
+{
+	const ndPiece& piece = m_pieces[index];
+	return piece.m_linkCount ? &m_links[piece.m_linkStart] : nullptr;
+}
+
+inline const ndShapeInstance& ndFractureAsset::GetPieceShape(ndInt32 index) const
+{
+	return *m_shapes[index];
+}
+
+inline ndInt32 ndFractureAsset::GetThreadCount() const
+{
+	return m_threadCount;
+}
+
+inline const ndVector& ndFractureAsset::GetCenterOfMass() const
+{
+	return m_centerOfMass;
+}
+
+inline ndFloat32 ndFractureAsset::GetVolume() const
+{
+	return m_volume;
+}
+
+inline ndUnsigned64 ndFractureAsset::GetSizeInBytes() const
+{
+	return
+		ndUnsigned64(m_pieces.GetCount()) * sizeof(ndPiece) +
+		ndUnsigned64(m_vertex.GetCount()) * sizeof(ndTriplex) +
+		ndUnsigned64(m_links.GetCount()) * sizeof(ndLink);
+}
+
+inline ndWorld* ndFracturePool::GetWorld() const
+{
+	return m_world;
+}
+
+inline const ndFractureAsset* ndFracturePool::GetAsset() const
+{
+	return m_asset;
+}
+
+inline ndInt32 ndFracturePool::GetCapacity() const
+{
+	return m_capacity;
+}
+
+inline ndInt32 ndFracturePool::GetFreeCount(ndInt32 piece) const
+{
+	return m_freeCount[piece];
+}
+
+inline ndInt32 ndFracturePool::GetBodyCount() const
+{
+	return m_bodies.GetCount();
+}
+
+inline ndBodyDynamic* ndFracturePool::GetBody(ndInt32 index) const
+{
+	return m_bodies[index];
+}
+
+#endif
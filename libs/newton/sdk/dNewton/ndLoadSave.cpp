@@ -26,6 +26,17 @@
 #include "ndLoadSave.h"
 #include "ndBodyDynamic.h"
 
+#if !(defined (WIN32) || defined(_WIN32) || defined (_M_ARM) || defined (_M_ARM64))
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/stat.h>
+	#include <sys/mman.h>
+#endif
+
+#define D_SNAPSHOT_MAGIC	0x6e73646e
+#define D_SNAPSHOT_VERSION	1
+#define D_SNAPSHOT_ALIGN	16
+
 D_CLASS_REFLECTION_IMPLEMENT_LOADER(ndWordSettings);
 
 class ndLoadSaveInfo
@@ -96,6 +107,306 @@ class ndLoadSaveInfo
 	ndTree<ndInt32, const ndJointBilateralConstraint*> m_jointMap;
 };
 
+// snapshot file layout: a header followed by 16 bytes aligned sections. 
+// the shapes, joints, models and any body that is not a plain kinematic 
+// or dynamic body are saved as one compact xml document, the shapes are 
+// unique by their shape cache hash id, and the plain bodies are saved as 
+// binary arrays so that loading them does not parse any text.
+class ndSnapshotSection
+{
+	public:
+	ndUnsigned32 m_offset;
+	ndInt32 m_count;
+};
+
+class ndSnapshotHeader
+{
+	public:
+	ndUnsigned32 m_magic;
+	ndUnsigned32 m_version;
+	ndUnsigned32 m_size;
+	ndInt32 m_bodyCount;
+	ndSnapshotSection m_xml;
+	ndSnapshotSection m_hashId;
+	ndSnapshotSection m_flags;
+	ndSnapshotSection m_notify;
+	ndSnapshotSection m_matrix;
+	ndSnapshotSection m_veloc;
+	ndSnapshotSection m_omega;
+	ndSnapshotSection m_centreOfMass;
+	ndSnapshotSection m_massMatrix;
+	ndSnapshotSection m_dampCoef;
+	ndSnapshotSection m_limits;
+	ndSnapshotSection m_instance;
+};
+
+// only the value fields of the shape material, the user data 
+// slot usually holds a pointer, so it is not saved and loads as null.
+class ndSnapshotShapeMaterial
+{
+	public:
+	ndSnapshotShapeMaterial()
+	{
+	}
+
+	ndSnapshotShapeMaterial(const ndShapeMaterial& material)
+	{
+		m_userId = material.m_userId;
+		for (ndInt32 i = 0; i < ndInt32(sizeof(m_userParam) / sizeof(m_userParam[0])); i++)
+		{
+			m_userParam[i] = material.m_userParam[i].m_intData;
+		}
+	}
+
+	ndShapeMaterial GetMaterial() const
+	{
+		ndShapeMaterial material;
+		material.m_userId = m_userId;
+		for (ndInt32 i = 0; i < ndInt32(sizeof(m_userParam) / sizeof(m_userParam[0])); i++)
+		{
+			material.m_userParam[i].m_intData = m_userParam[i];
+		}
+		return material;
+	}
+
+	ndInt64 m_userId;
+	ndUnsigned64 m_userParam[sizeof(ndShapeMaterial::m_userParam) / sizeof(ndShapeMaterial::m_userParam[0])];
+};
+
+class ndSnapshotShapeInstance
+{
+	public:
+	ndMatrix m_localMatrix;
+	ndMatrix m_aligmentMatrix;
+	ndVector m_scale;
+	ndSnapshotShapeMaterial m_material;
+	ndFloat32 m_skinThickness;
+	ndInt32 m_collisionMode;
+	ndInt32 m_shapeHashId;
+	ndInt32 m_padding[3];
+};
+
+class ndSnapshotBodies
+{
+	public:
+	enum ndFlags
+	{
+		m_dynamicBody = 1 << 0,
+		m_autoSleep = 1 << 1,
+		m_speculativeContacts = 1 << 2,
+	};
+
+	ndArray<ndInt32> m_hashId;
+	ndArray<ndInt32> m_flags;
+	ndArray<ndInt32> m_notify;
+	ndArray<ndMatrix> m_matrix;
+	ndArray<ndVector> m_veloc;
+	ndArray<ndVector> m_omega;
+	ndArray<ndVector> m_centreOfMass;
+	ndArray<ndVector> m_massMatrix;
+	ndArray<ndVector> m_dampCoef;
+	ndArray<ndVector> m_limits;
+	ndArray<ndSnapshotShapeInstance> m_instance;
+	ndTree<ndInt32, ndUnsigned64> m_notifyMap;
+};
+
+class ndSnapshotWriter: public ndArray<ndUnsigned8>
+{
+	public:
+	template <class T>
+	ndSnapshotSection Append(const ndArray<T>& array)
+	{
+		return Append(array.GetCount() ? &array[0] : nullptr, array.GetCount(), ndInt32(sizeof(T)));
+	}
+
+	ndSnapshotSection Append(const void* const data, ndInt32 count, ndInt32 strideInBytes)
+	{
+		while (GetCount() & (D_SNAPSHOT_ALIGN - 1))
+		{
+			PushBack(0);
+		}
+
+		ndSnapshotSection section;
+		section.m_offset = ndUnsigned32(GetCount());
+		section.m_count = count;
+
+		const ndInt32 size = count * strideInBytes;
+		SetCount(GetCount() + size);
+		if (size)
+		{
+			memcpy(&(*this)[ndInt32(section.m_offset)], data, size_t(size));
+		}
+		return section;
+	}
+};
+
+// the snapshot file is mapped to memory, sections are read in place.
+class ndSnapshotImage
+{
+	public:
+	ndSnapshotImage(const char* const path)
+		:m_data(nullptr)
+		,m_size(0)
+	{
+#if (defined (WIN32) || defined(_WIN32) || defined (_M_ARM) || defined (_M_ARM64))
+		FILE* const file = fopen(path, "rb");
+		if (file)
+		{
+			fseek(file, 0, SEEK_END);
+			const long size = ftell(file);
+			fseek(file, 0, SEEK_SET);
+			if (size > 0)
+			{
+				ndUnsigned8* const data = (ndUnsigned8*)ndMemory::Malloc(size_t(size));
+				if (fread(data, size_t(size), 1, file) == 1)
+				{
+					m_data = data;
+					m_size = size_t(size);
+				}
+				else
+				{
+					ndMemory::Free(data);
+				}
+			}
+			fclose(file);
+		}
+#else
+		const int file = open(path, O_RDONLY);
+		if (file >= 0)
+		{
+			struct stat info;
+			if (!fstat(file, &info) && (info.st_size > 0))
+			{
+				void* const data = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+				if (data != MAP_FAILED)
+				{
+					m_data = (const ndUnsigned8*)data;
+					m_size = size_t(info.st_size);
+				}
+			}
+			close(file);
+		}
+#endif
+	}
+
+	~ndSnapshotImage()
+	{
+		if (m_data)
+		{
+#if (defined (WIN32) || defined(_WIN32) || defined (_M_ARM) || defined (_M_ARM64))
+			ndMemory::Free((void*)m_data);
+#else
+			munmap((void*)m_data, m_size);
+#endif
+		}
+	}
+
+	const ndSnapshotHeader* GetHeader() const
+	{
+		if (m_size < sizeof(ndSnapshotHeader))
+		{
+			return nullptr;
+		}
+		const ndSnapshotHeader* const header = (ndSnapshotHeader*)m_data;
+		if ((header->m_magic != D_SNAPSHOT_MAGIC) || (header->m_version != D_SNAPSHOT_VERSION) || (header->m_size != m_size))
+		{
+			return nullptr;
+		}
+		return header;
+	}
+
+	// returns null if the section is misaligned, holds fewer than 
+	// minCount items or does not fit in the image.
+	template <class T>
+	const T* GetSection(const ndSnapshotSection& section, ndInt32 minCount) const
+	{
+		if ((section.m_offset & (D_SNAPSHOT_ALIGN - 1)) || (section.m_count < minCount) || (section.m_count < 0))
+		{
+			return nullptr;
+		}
+		const ndUnsigned64 end = ndUnsigned64(section.m_offset) + ndUnsigned64(section.m_count) * sizeof(T);
+		if (end > ndUnsigned64(m_size))
+		{
+			return nullptr;
+		}
+		return (const T*)&m_data[section.m_offset];
+	}
+
+	const ndUnsigned8* m_data;
+	size_t m_size;
+};
+
+static void SnapshotXmlString(const char* const string, bool escape, ndArray<char>& text)
+{
+	for (const char* ptr = string; *ptr; ptr++)
+	{
+		const char* replace = nullptr;
+		if (escape)
+		{
+			switch (*ptr)
+			{
+				case '&': replace = "&amp;"; break;
+				case '<': replace = "&lt;"; break;
+				case '>': replace = "&gt;"; break;
+				case '"': replace = "&quot;"; break;
+			}
+		}
+		if (replace)
+		{
+			for (const char* ptr1 = replace; *ptr1; ptr1++)
+			{
+				text.PushBack(*ptr1);
+			}
+		}
+		else
+		{
+			text.PushBack(*ptr);
+		}
+	}
+}
+
+// writes the node with no white spaces, this is much more compact 
+// than what the tinyxml printer produces.
+static void SnapshotXmlNode(const nd::TiXmlNode* const node, ndArray<char>& text)
+{
+	const nd::TiXmlElement* const element = node->ToElement();
+	if (!element)
+	{
+		if (node->ToText())
+		{
+			SnapshotXmlString(node->Value(), true, text);
+		}
+		return;
+	}
+
+	text.PushBack('<');
+	SnapshotXmlString(element->Value(), false, text);
+	for (const nd::TiXmlAttribute* attribute = element->FirstAttribute(); attribute; attribute = attribute->Next())
+	{
+		text.PushBack(' ');
+		SnapshotXmlString(attribute->Name(), false, text);
+		SnapshotXmlString("=\"", false, text);
+		SnapshotXmlString(attribute->Value(), true, text);
+		text.PushBack('"');
+	}
+
+	if (element->FirstChild())
+	{
+		text.PushBack('>');
+		for (const nd::TiXmlNode* child = element->FirstChild(); child; child = child->NextSibling())
+		{
+			SnapshotXmlNode(child, text);
+		}
+		SnapshotXmlString("</", false, text);
+		SnapshotXmlString(element->Value(), false, text);
+		text.PushBack('>');
+	}
+	else
+	{
+		SnapshotXmlString("/>", false, text);
+	}
+}
+
 ndWordSettings::ndWordSettings(const ndLoadSaveBase::ndLoadDescriptor&)
 	:ndClassAlloc()
 	,m_subSteps(2)
@@ -164,7 +475,8 @@ void ndLoadSave::LoadShapes(const nd::TiXmlNode* const rootNode,
 				ndInt32 hashId;
 				const nd::TiXmlElement* const element = (nd::TiXmlElement*) node;
 				element->Attribute("hashId", &hashId);
-				ndShapeLoaderCache::ndNode* const shapeMapNode = shapesMap.Insert(ndShapeInstance(shape), hashId);
+				// identical shapes of this and of earlier loads share the same shape
+				ndShapeLoaderCache::ndNode* const shapeMapNode = shapesMap.Insert(ndShapeRegistry::GetRegistry().Intern(shape), hashId);
 				ndShapeCompound* const compound = ((ndShape*)shapeMapNode->GetInfo().GetShape())->GetAsShapeCompound();
 				if (compound)
 				{
@@ -272,6 +584,92 @@ void ndLoadSave::LoadModels(const nd::TiXmlNode* const rootNode, const char* con
 	}
 }
 
+bool ndLoadSave::LoadSnapshotBodies(const ndSnapshotImage& image, const nd::TiXmlNode* const rootNode, 
+	const char* const assetPath, const ndShapeLoaderCache& shapesMap)
+{
+	const ndSnapshotHeader* const header = image.GetHeader();
+	const ndInt32 count = header->m_bodyCount;
+	const ndInt32* const hashId = image.GetSection<ndInt32>(header->m_hashId, count);
+	const ndInt32* const flags = image.GetSection<ndInt32>(header->m_flags, count);
+	const ndInt32* const notify = image.GetSection<ndInt32>(header->m_notify, count);
+	const ndMatrix* const matrix = image.GetSection<ndMatrix>(header->m_matrix, count);
+	const ndVector* const veloc = image.GetSection<ndVector>(header->m_veloc, count);
+	const ndVector* const omega = image.GetSection<ndVector>(header->m_omega, count);
+	const ndVector* const centreOfMass = image.GetSection<ndVector>(header->m_centreOfMass, count);
+	const ndVector* const massMatrix = image.GetSection<ndVector>(header->m_massMatrix, count);
+	const ndVector* const dampCoef = image.GetSection<ndVector>(header->m_dampCoef, count);
+	const ndVector* const limits = image.GetSection<ndVector>(header->m_limits, count);
+	const ndSnapshotShapeInstance* const instance = image.GetSection<ndSnapshotShapeInstance>(header->m_instance, count);
+	if ((count < 0) || !hashId || !flags || !notify || !matrix || !veloc || !omega || !centreOfMass || !massMatrix || !dampCoef || !limits || !instance)
+	{
+		return false;
+	}
+
+	ndArray<const nd::TiXmlNode*> notifyNodes;
+	const nd::TiXmlNode* const notifies = rootNode->FirstChild("ndNotifies");
+	if (notifies)
+	{
+		for (const nd::TiXmlNode* node = notifies->FirstChild(); node; node = node->NextSibling())
+		{
+			notifyNodes.PushBack(node);
+		}
+	}
+
+	// every reference is checked before any body is created, 
+	// so that a bad file does not leave a partial scene behind.
+	for (ndInt32 i = 0; i < count; i++)
+	{
+		if (!shapesMap.Find(instance[i].m_shapeHashId) || (notify[i] >= notifyNodes.GetCount()))
+		{
+			return false;
+		}
+	}
+
+	ndLoadSaveBase::ndLoadDescriptor notifyDesc;
+	notifyDesc.m_assetPath = assetPath;
+	notifyDesc.m_shapeMap = &shapesMap;
+
+	for (ndInt32 i = 0; i < count; i++)
+	{
+		const bool isDynamic = (flags[i] & ndSnapshotBodies::m_dynamicBody) ? true : false;
+		ndBodyKinematic* const body = isDynamic ? new ndBodyDynamic() : new ndBodyKinematic();
+
+		const ndSnapshotShapeInstance& instanceInfo = instance[i];
+		ndShapeInstance shapeInstance(shapesMap.Find(instanceInfo.m_shapeHashId)->GetInfo());
+		shapeInstance.m_localMatrix = instanceInfo.m_localMatrix;
+		shapeInstance.m_aligmentMatrix = instanceInfo.m_aligmentMatrix;
+		shapeInstance.m_skinThickness = instanceInfo.m_skinThickness;
+		shapeInstance.m_collisionMode = instanceInfo.m_collisionMode ? true : false;
+		shapeInstance.m_shapeMaterial = instanceInfo.m_material.GetMaterial();
+		shapeInstance.SetScale(instanceInfo.m_scale);
+
+		body->SetMatrix(matrix[i]);
+		body->SetCentreOfMass(centreOfMass[i]);
+		body->SetVelocity(veloc[i]);
+		body->SetOmega(omega[i]);
+		body->SetAutoSleep((flags[i] & ndSnapshotBodies::m_autoSleep) ? true : false);
+		body->SetSpeculativeContacts((flags[i] & ndSnapshotBodies::m_speculativeContacts) ? true : false);
+		body->SetCollisionShape(shapeInstance);
+		body->SetMassMatrix(massMatrix[i]);
+		body->m_maxAngleStep = limits[i].m_x;
+		body->m_maxLinearSpeed = limits[i].m_y;
+		if (isDynamic)
+		{
+			((ndBodyDynamic*)body)->m_dampCoef = dampCoef[i];
+		}
+
+		if (notify[i] >= 0)
+		{
+			const nd::TiXmlNode* const node = notifyNodes[notify[i]];
+			notifyDesc.m_rootNode = node;
+			ndBodyNotify* const notifyCallback = D_CLASS_REFLECTION_LOAD_NODE(ndBodyNotify, node->Value(), notifyDesc);
+			body->SetNotifyCallback(notifyCallback);
+		}
+		m_bodyMap.Insert(body, hashId[i]);
+	}
+	return true;
+}
+
 void ndLoadSave::SaveSceneSettings(ndLoadSaveInfo& info) const
 {
 	ndLoadSaveBase::ndSaveDescriptor descriptor;
@@ -307,6 +705,42 @@ void ndLoadSave::SaveShapes(ndLoadSaveInfo& info)
 	}
 }
 
+ndInt32 ndLoadSave::GetShapeHash(ndLoadSaveInfo& info, const ndShape* const shape) const
+{
+	ndTree<ndInt32, const ndShape*>::ndNode* shapeNode0 = info.m_shapeMap.Find(shape);
+	if (!shapeNode0)
+	{
+		ndShapeCompound* const compound = ((ndShape*)shape)->GetAsShapeCompound();
+		if (compound)
+		{
+			ndShapeCompound::ndTreeArray::Iterator iter(compound->GetTree());
+			for (iter.Begin(); iter; iter++)
+			{
+				ndShapeCompound::ndNodeBase* const node = iter.GetNode()->GetInfo();
+				ndShapeInstance* const instance = node->GetShape();
+				ndShape* const subShape = instance->GetShape();
+				ndTree<ndInt32, const ndShape*>::ndNode* subShapeNode = info.m_shapeMap.Find(subShape);
+				if (!subShapeNode)
+				{
+					info.m_shapeMap.Insert(info.m_shapeMap.GetCount(), subShape);
+				}
+			}
+		}
+		shapeNode0 = info.m_shapeMap.Insert(info.m_shapeMap.GetCount(), shape);
+	}
+	return shapeNode0->GetInfo();
+}
+
+ndInt32 ndLoadSave::GetBodyHash(ndLoadSaveInfo& info, const ndBodyKinematic* const body) const
+{
+	ndTree<ndInt32, const ndBodyKinematic*>::ndNode* bodyHashNode = info.m_bodyMap.Find(body);
+	if (!bodyHashNode)
+	{
+		bodyHashNode = info.m_bodyMap.Insert(info.m_bodyMap.GetCount() + 1, body);
+	}
+	return bodyHashNode->GetInfo();
+}
+
 void ndLoadSave::SaveBodies(ndLoadSaveInfo& info)
 {
 	ndLoadSaveBase::ndSaveDescriptor descriptor;
@@ -317,38 +751,84 @@ void ndLoadSave::SaveBodies(ndLoadSaveInfo& info)
 	for (ndBodyList::ndNode* bodyNode = info.m_bodyList->GetFirst(); bodyNode; bodyNode = bodyNode->GetNext())
 	{
 		ndBodyKinematic* const body = bodyNode->GetInfo();
+		descriptor.m_shapeNodeHash = GetShapeHash(info, body->GetCollisionShape().GetShape());
+		descriptor.m_nodeNodeHash = GetBodyHash(info, body);
+		body->Save(descriptor);
+	}
+}
+
+void ndLoadSave::SaveSnapshotBodies(ndLoadSaveInfo& info, ndSnapshotBodies& bodies, nd::TiXmlElement* const notifiesNode)
+{
+	ndLoadSaveBase::ndSaveDescriptor descriptor;
+	descriptor.m_assetPath = info.m_assetPath;
+	descriptor.m_assetName = info.m_assetName;
+	descriptor.m_rootNode = info.m_bodiesNode;
+
+	ndArray<char> notifyText;
+	for (ndBodyList::ndNode* bodyNode = info.m_bodyList->GetFirst(); bodyNode; bodyNode = bodyNode->GetNext())
+	{
+		ndBodyKinematic* const body = bodyNode->GetInfo();
+		descriptor.m_shapeNodeHash = GetShapeHash(info, body->GetCollisionShape().GetShape());
+		descriptor.m_nodeNodeHash = GetBodyHash(info, body);
 
-		ndShape* const shape = body->GetCollisionShape().GetShape();
-		ndTree<ndInt32, const ndShape*>::ndNode* shapeNode0 = info.m_shapeMap.Find(shape);
-		if (!shapeNode0)
+		const char* const className = body->SubClassName();
+		ndBodyDynamic* const dynamicBody = strcmp(className, ndBodyDynamic::ClassName()) ? nullptr : body->GetAsBodyDynamic();
+		if (!dynamicBody && strcmp(className, ndBodyKinematic::ClassName()))
 		{
-			ndShapeCompound* const compound = shape->GetAsShapeCompound();
-			if (compound)
-			{
-				ndShapeCompound::ndTreeArray::Iterator iter(compound->GetTree());
-				for (iter.Begin(); iter; iter++)
-				{
-					ndShapeCompound::ndNodeBase* const node = iter.GetNode()->GetInfo();
-					ndShapeInstance* const instance = node->GetShape();
-					ndShape* const subShape = instance->GetShape();
-					ndTree<ndInt32, const ndShape*>::ndNode* subShapeNode = info.m_shapeMap.Find(subShape);
-					if (!subShapeNode)
-					{
-						info.m_shapeMap.Insert(info.m_shapeMap.GetCount(), subShape);
-					}
-				}
-			}
-			shapeNode0 = info.m_shapeMap.Insert(info.m_shapeMap.GetCount(), shape);
+			// any other body class saves itself to the xml document
+			body->Save(descriptor);
+			continue;
 		}
-		descriptor.m_shapeNodeHash = shapeNode0->GetInfo();
 
-		ndTree<ndInt32, const ndBodyKinematic*>::ndNode* bodyHashNode = info.m_bodyMap.Find(body);
-		if (!bodyHashNode)
+		// notify objects are often identical, save only the unique ones.
+		ndInt32 notifyIndex = -1;
+		ndBodyNotify* const notify = body->GetNotifyCallback();
+		if (notify)
 		{
-			bodyHashNode = info.m_bodyMap.Insert(info.m_bodyMap.GetCount() + 1, body);
+			nd::TiXmlElement notifyNode("bodyNotifyClass");
+			notify->Save(ndLoadSaveBase::ndSaveDescriptor(descriptor, &notifyNode));
+			notifyText.SetCount(0);
+			SnapshotXmlNode(notifyNode.FirstChild(), notifyText);
+			notifyText.PushBack(0);
+
+			const ndUnsigned64 key = dCRC64(&notifyText[0], notifyText.GetCount(), 0);
+			ndTree<ndInt32, ndUnsigned64>::ndNode* notifyMapNode = bodies.m_notifyMap.Find(key);
+			if (!notifyMapNode)
+			{
+				notifyMapNode = bodies.m_notifyMap.Insert(bodies.m_notifyMap.GetCount(), key);
+				notifiesNode->LinkEndChild(notifyNode.FirstChild()->Clone());
+			}
+			notifyIndex = notifyMapNode->GetInfo();
 		}
-		descriptor.m_nodeNodeHash = bodyHashNode->GetInfo();
-		body->Save(descriptor);
+
+		ndInt32 flags = body->GetAutoSleep() ? ndSnapshotBodies::m_autoSleep : 0;
+		flags |= body->GetSpeculativeContacts() ? ndSnapshotBodies::m_speculativeContacts : 0;
+		flags |= dynamicBody ? ndSnapshotBodies::m_dynamicBody : 0;
+
+		const ndShapeInstance& shapeInstance = body->GetCollisionShape();
+		ndSnapshotShapeInstance instance;
+		instance.m_localMatrix = shapeInstance.m_localMatrix;
+		instance.m_aligmentMatrix = shapeInstance.m_aligmentMatrix;
+		instance.m_scale = shapeInstance.m_scale;
+		instance.m_material = ndSnapshotShapeMaterial(shapeInstance.m_shapeMaterial);
+		instance.m_skinThickness = shapeInstance.m_skinThickness;
+		instance.m_collisionMode = shapeInstance.m_collisionMode ? 1 : 0;
+		instance.m_shapeHashId = descriptor.m_shapeNodeHash;
+		instance.m_padding[0] = 0;
+		instance.m_padding[1] = 0;
+		instance.m_padding[2] = 0;
+
+		bodies.m_hashId.PushBack(descriptor.m_nodeNodeHash);
+		bodies.m_flags.PushBack(flags);
+		bodies.m_notify.PushBack(notifyIndex);
+		bodies.m_matrix.PushBack(body->GetMatrix());
+		bodies.m_veloc.PushBack(body->GetVelocity());
+		bodies.m_omega.PushBack(body->GetOmega());
+		bodies.m_centreOfMass.PushBack(body->GetCentreOfMass());
+		bodies.m_massMatrix.PushBack(body->GetMassMatrix());
+		bodies.m_dampCoef.PushBack(dynamicBody ? dynamicBody->m_dampCoef : ndVector::m_zero);
+		bodies.m_limits.PushBack(ndVector(body->m_maxAngleStep, body->m_maxLinearSpeed, ndFloat32(0.0f), ndFloat32(0.0f)));
+		bodies.m_instance.PushBack(instance);
 	}
 }
 
@@ -560,3 +1040,144 @@ void ndLoadSave::SaveModel(const char* const path, const ndModel* const model)
 	setlocale(LC_ALL, oldloc);
 }
 
+bool ndLoadSave::LoadSnapshot(const char* const path)
+{
+	ndSnapshotImage image(path);
+	const ndSnapshotHeader* const header = image.GetHeader();
+	if (!header)
+	{
+		return false;
+	}
+
+	char* const oldloc = setlocale(LC_ALL, 0);
+	setlocale(LC_ALL, "C");
+
+	const char* const xml = image.GetSection<char>(header->m_xml, 1);
+	if (!xml || xml[header->m_xml.m_count - 1])
+	{
+		setlocale(LC_ALL, oldloc);
+		return false;
+	}
+
+	nd::TiXmlDocument doc;
+	doc.Parse(xml);
+	if (doc.Error() || !doc.FirstChild("ndWorld"))
+	{
+		setlocale(LC_ALL, oldloc);
+		return false;
+	}
+
+	char assetPath[1024];
+	strcpy(assetPath, path);
+
+	char* namePtr = strrchr(assetPath, '/');
+	if (!namePtr)
+	{
+		namePtr = strrchr(assetPath, '\\');
+	}
+	if (!namePtr)
+	{
+		namePtr = assetPath;
+	}
+	namePtr[0] = 0;
+
+	const nd::TiXmlElement* const worldNode = doc.RootElement();
+	ndShapeLoaderCache shapesMap;
+
+	ndBodySentinel sentinel;
+	m_bodyMap.Insert(&sentinel, 0);
+
+	LoadSceneSettings(worldNode, assetPath);
+	LoadShapes(worldNode, assetPath, shapesMap);
+	if (!LoadSnapshotBodies(image, worldNode, assetPath, shapesMap))
+	{
+		m_bodyMap.Remove(0);
+		setlocale(LC_ALL, oldloc);
+		return false;
+	}
+	LoadBodies(worldNode, assetPath, shapesMap);
+	LoadJoints(worldNode, assetPath);
+	LoadModels(worldNode, assetPath);
+	setlocale(LC_ALL, oldloc);
+
+	m_bodyMap.Remove(0);
+	return true;
+}
+
+void ndLoadSave::SaveSnapshot(const char* const path, const ndWorld* const world, const ndWordSettings* const setting)
+{
+	ndLoadSaveInfo info;
+	info.ExtensionAndFilePath(path);
+	strcat(info.m_fileName, "s");
+
+	char* const oldloc = setlocale(LC_ALL, 0);
+	setlocale(LC_ALL, "C");
+
+	nd::TiXmlElement worldNode("ndWorld");
+	nd::TiXmlElement* const notifiesNode = new nd::TiXmlElement("ndNotifies");
+
+	info.m_worldNode = &worldNode;
+	info.m_settingsNode = new nd::TiXmlElement("ndSettings");
+	info.m_shapesNode = new nd::TiXmlElement("ndShapes");
+	info.m_bodiesNode = new nd::TiXmlElement("ndBodies");
+	info.m_jointsNode = new nd::TiXmlElement("ndJoints");
+	info.m_modelsNode = new nd::TiXmlElement("ndModels");
+
+	worldNode.LinkEndChild(info.m_settingsNode);
+	worldNode.LinkEndChild(info.m_shapesNode);
+	worldNode.LinkEndChild(info.m_bodiesNode);
+	worldNode.LinkEndChild(info.m_jointsNode);
+	worldNode.LinkEndChild(info.m_modelsNode);
+	worldNode.LinkEndChild(notifiesNode);
+
+	info.m_setting = setting;
+	info.m_bodyList = &world->GetBodyList();
+	info.m_jointList = &world->GetJointList();
+	info.m_modelList = &world->GetModelList();
+
+	info.m_bodyMap.Insert(0, nullptr);
+	SaveSceneSettings(info);
+	SaveModels(info);
+	SaveJoints(info);
+	info.m_bodyMap.Remove((ndBodyKinematic*)nullptr);
+
+	ndSnapshotBodies bodies;
+	SaveSnapshotBodies(info, bodies, notifiesNode);
+	SaveShapes(info);
+
+	ndArray<char> xmlText;
+	SnapshotXmlNode(&worldNode, xmlText);
+	xmlText.PushBack(0);
+	setlocale(LC_ALL, oldloc);
+
+	ndSnapshotHeader header;
+	memset(&header, 0, sizeof(header));
+
+	ndSnapshotWriter writer;
+	writer.Append(&header, 1, sizeof(header));
+	header.m_xml = writer.Append(xmlText);
+	header.m_bodyCount = bodies.m_hashId.GetCount();
+	header.m_hashId = writer.Append(bodies.m_hashId);
+	header.m_flags = writer.Append(bodies.m_flags);
+	header.m_notify = writer.Append(bodies.m_notify);
+	header.m_matrix = writer.Append(bodies.m_matrix);
+	header.m_veloc = writer.Append(bodies.m_veloc);
+	header.m_omega = writer.Append(bodies.m_omega);
+	header.m_centreOfMass = writer.Append(bodies.m_centreOfMass);
+	header.m_massMatrix = writer.Append(bodies.m_massMatrix);
+	header.m_dampCoef = writer.Append(bodies.m_dampCoef);
+	header.m_limits = writer.Append(bodies.m_limits);
+	header.m_instance = writer.Append(bodies.m_instance);
+
+	header.m_magic = D_SNAPSHOT_MAGIC;
+	header.m_version = D_SNAPSHOT_VERSION;
+	header.m_size = ndUnsigned32(writer.GetCount());
+	memcpy(&writer[0], &header, sizeof(header));
+
+	FILE* const file = fopen(info.m_fileName, "wb");
+	if (file)
+	{
+		fwrite(&writer[0], size_t(writer.GetCount()), 1, file);
+		fclose(file);
+	}
+}
@@ -26,6 +26,8 @@
 
 class ndWorld;
 class ndLoadSaveInfo;
+class ndSnapshotImage;
+class ndSnapshotBodies;
 
 class ndWordSettings : public ndClassAlloc
 {
@@ -62,18 +64,25 @@ class ndLoadSave: public ndClassAlloc
 	D_NEWTON_API void SaveModel(const char* const path, const ndModel* const model);
 	D_NEWTON_API void SaveScene(const char* const path, const ndWorld* const world, const ndWordSettings* const setting);
 
+	D_NEWTON_API bool LoadSnapshot(const char* const path);
+	D_NEWTON_API void SaveSnapshot(const char* const path, const ndWorld* const world, const ndWordSettings* const setting);
+
 	private:
+	ndInt32 GetShapeHash(ndLoadSaveInfo& info, const ndShape* const shape) const;
+	ndInt32 GetBodyHash(ndLoadSaveInfo& info, const ndBodyKinematic* const body) const;
 	void SaveSceneSettings(ndLoadSaveInfo& info) const;
 	void SaveShapes(ndLoadSaveInfo& info);
 	void SaveBodies(ndLoadSaveInfo& info);
 	void SaveJoints(ndLoadSaveInfo& info);
 	void SaveModels(ndLoadSaveInfo& info);
+	void SaveSnapshotBodies(ndLoadSaveInfo& info, ndSnapshotBodies& bodies, nd::TiXmlElement* const notifiesNode);
 	
 	void LoadSceneSettings(const nd::TiXmlNode* const rootNode, const char* const assetPath);
 	void LoadShapes(const nd::TiXmlNode* const rootNode, const char* const assetPath, ndShapeLoaderCache& shapesMap);
 	void LoadBodies(const nd::TiXmlNode* const rootNode, const char* const assetPath, const ndShapeLoaderCache& shapesMap);
 	void LoadJoints(const nd::TiXmlNode* const rootNode, const char* const assetPath);
 	void LoadModels(const nd::TiXmlNode* const rootNode, const char* const assetPath);
+	bool LoadSnapshotBodies(const ndSnapshotImage& image, const nd::TiXmlNode* const rootNode, const char* const assetPath, const ndShapeLoaderCache& shapesMap);
 
 	public:
 	ndWordSettings* m_setting;
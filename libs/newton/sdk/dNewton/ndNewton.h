@@ -64,6 +64,10 @@
 #include <ndJointPdActuator.h>
 #include <ndJointFollowPath.h>
 #include <ndBodyParticleSet.h>
+#include <ndWorldSnapshot.h>
+#include <ndWorldPartition.h>
+#include <ndFractureAsset.h>
+#include <ndWorldStatistics.h>
 #include <ndJointDoubleHinge.h>
 #include <ndJointFixDistance.h>
 #include <ndMultiBodyVehicle.h>
@@ -41,6 +41,11 @@ ndSkeletonContainer::ndNode::ndNode()
 	,m_dof(0)
 	,m_swapJacobianBodiesIndex(0)
 {
+	m_cachedMass = ndFloat32(0.0f);
+	m_cachedBoundMask = 0;
+	m_cachedRowCount = 0;
+	m_factorized = 0;
+	m_refactored = 1;
 }
 
 ndSkeletonContainer::ndNode::~ndNode()
@@ -68,15 +73,14 @@ inline ndInt32 ndSkeletonContainer::ndNode::GetAuxiliaryRows(const ndRightHandSi
 	return rowCount;
 }
 
-inline void ndSkeletonContainer::ndNode::CalculateInertiaMatrix(ndSpatialMatrix* const bodyMassArray) const
+inline void ndSkeletonContainer::ndNode::CalculateInertiaMatrix(const ndMatrix& inertia)
 {
-	ndSpatialMatrix& bodyMass = bodyMassArray[m_index];
+	ndSpatialMatrix& bodyMass = m_bodyMass;
 	
 	bodyMass = ndSpatialMatrix(ndFloat32(0.0f));
 	if (m_body->GetInvMass() != ndFloat32(0.0f)) 
 	{
 		const ndFloat32 mass = m_body->GetMassMatrix().m_w;
-		ndMatrix inertia (m_body->CalculateInertiaMatrix());
 		for (ndInt32 i = 0; i < 3; i++) 
 		{
 			bodyMass[i][i] = mass;
@@ -88,13 +92,109 @@ inline void ndSkeletonContainer::ndNode::CalculateInertiaMatrix(ndSpatialMatrix*
 	}
 }
 
-inline void ndSkeletonContainer::ndNode::GetJacobians(const ndLeftHandSide* const leftHandSide, const ndRightHandSide* const rightHandSide, ndSpatialMatrix* const jointMassArray)
+inline bool ndSkeletonContainer::ndNode::IsFactorizationValid(const ndLeftHandSide* const leftHandSide, const ndRightHandSide* const rightHandSide, const ndMatrix& inertia, ndFloat32 tolerance) const
+{
+	if (!m_factorized || (tolerance <= ndFloat32(0.0f)))
+	{
+		return false;
+	}
+
+	// the body diagonal accumulates the children joint mass,
+	// so any refactored child invalidates the parent.
+	for (ndNode* child = m_child; child; child = child->m_sibling)
+	{
+		if (child->m_refactored)
+		{
+			return false;
+		}
+	}
+
+	const ndFloat32 mass = m_body->GetMassMatrix().m_w;
+	if (dAbs(mass - m_cachedMass) > tolerance * mass)
+	{
+		return false;
+	}
+
+	const ndVector inertiaTol(tolerance * dMax(dMax(inertia[0][0], inertia[1][1]), inertia[2][2]));
+	ndVector inertiaError((inertia[0] - m_cachedInertia[0]).Abs());
+	inertiaError = inertiaError.GetMax((inertia[1] - m_cachedInertia[1]).Abs());
+	inertiaError = inertiaError.GetMax((inertia[2] - m_cachedInertia[2]).Abs());
+	if ((inertiaError > inertiaTol).GetSignMask() & 0x07)
+	{
+		return false;
+	}
+
+	if (m_joint)
+	{
+		const ndInt32 count = m_joint->m_rowCount;
+		if (count != m_cachedRowCount)
+		{
+			return false;
+		}
+
+		const ndVector jacobianTol(tolerance);
+		ndVector jacobianError(ndVector::m_zero);
+		const ndInt32 first = m_joint->m_rowStart;
+		for (ndInt32 i = 0; i < count; i++)
+		{
+			const ndRightHandSide* const rhs = &rightHandSide[first + i];
+			const ndLeftHandSide* const row = &leftHandSide[first + i];
+			const ndJacobianPair& jacobian = m_cachedJacobian[i];
+			const ndUnsigned8 bound = ((rhs->m_lowerBoundFrictionCoefficent <= ndFloat32(-D_MAX_SKELETON_LCP_VALUE)) && (rhs->m_upperBoundFrictionCoefficent >= ndFloat32(D_MAX_SKELETON_LCP_VALUE))) ? 0 : 1;
+			if (bound != ((m_cachedBoundMask >> i) & 1))
+			{
+				return false;
+			}
+
+			if (dAbs(rhs->m_diagDamp - m_cachedDiagDamp[i]) > tolerance * m_cachedDiagDamp[i])
+			{
+				return false;
+			}
+
+			jacobianError = jacobianError.GetMax((row->m_Jt.m_jacobianM0.m_linear - jacobian.m_jacobianM0.m_linear).Abs());
+			jacobianError = jacobianError.GetMax((row->m_Jt.m_jacobianM0.m_angular - jacobian.m_jacobianM0.m_angular).Abs());
+			jacobianError = jacobianError.GetMax((row->m_Jt.m_jacobianM1.m_linear - jacobian.m_jacobianM1.m_linear).Abs());
+			jacobianError = jacobianError.GetMax((row->m_Jt.m_jacobianM1.m_angular - jacobian.m_jacobianM1.m_angular).Abs());
+		}
+		if ((jacobianError > jacobianTol).GetSignMask() & 0x07)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+inline void ndSkeletonContainer::ndNode::SaveFactorizationState(const ndLeftHandSide* const leftHandSide, const ndRightHandSide* const rightHandSide, const ndMatrix& inertia)
+{
+	m_factorized = 1;
+	m_cachedInertia = inertia;
+	m_cachedMass = m_body->GetMassMatrix().m_w;
+	m_cachedRowCount = 0;
+	m_cachedBoundMask = 0;
+	if (m_joint)
+	{
+		const ndInt32 count = m_joint->m_rowCount;
+		const ndInt32 first = m_joint->m_rowStart;
+		m_cachedRowCount = ndInt8(count);
+		for (ndInt32 i = 0; i < count; i++)
+		{
+			const ndRightHandSide* const rhs = &rightHandSide[first + i];
+			const ndLeftHandSide* const row = &leftHandSide[first + i];
+			const ndUnsigned8 bound = ((rhs->m_lowerBoundFrictionCoefficent <= ndFloat32(-D_MAX_SKELETON_LCP_VALUE)) && (rhs->m_upperBoundFrictionCoefficent >= ndFloat32(D_MAX_SKELETON_LCP_VALUE))) ? 0 : 1;
+			m_cachedBoundMask = ndUnsigned8(m_cachedBoundMask | (bound << i));
+			m_cachedDiagDamp[i] = rhs->m_diagDamp;
+			m_cachedJacobian[i] = row->m_Jt;
+		}
+	}
+}
+
+inline void ndSkeletonContainer::ndNode::GetJacobians(const ndLeftHandSide* const leftHandSide, const ndRightHandSide* const rightHandSide)
 {
 	dAssert(m_parent);
 
 	ndSpatialMatrix& bodyJt = m_data.m_body.m_jt;
 	ndSpatialMatrix& jointJ = m_data.m_joint.m_jt;
-	ndSpatialMatrix& jointMass = jointMassArray[m_index];
+	ndSpatialMatrix& jointMass = m_jointMass;
 
 	const ndInt32 start = m_joint->m_rowStart;
 	const ndSpatialVector zero(ndSpatialVector::m_zero);
@@ -138,14 +238,14 @@ inline void ndSkeletonContainer::ndNode::GetJacobians(const ndLeftHandSide* cons
 	}
 }
 
-inline void ndSkeletonContainer::ndNode::CalculateBodyDiagonal(ndNode* const child, ndSpatialMatrix* const bodyMassArray, const ndSpatialMatrix* const jointMassArray)
+inline void ndSkeletonContainer::ndNode::CalculateBodyDiagonal(ndNode* const child)
 {
 	dAssert(child->m_joint);
 
 	ndSpatialMatrix copy(ndFloat32(0.0f));
 	const ndInt32 dof = child->m_dof;
 	const ndSpatialMatrix& jacobianMatrix = child->m_data.m_joint.m_jt;
-	const ndSpatialMatrix& childDiagonal = jointMassArray[child->m_index];
+	const ndSpatialMatrix& childDiagonal = child->m_jointMass;
 	for (ndInt32 i = 0; i < dof; i++) 
 	{
 		const ndSpatialVector& jacobian = jacobianMatrix[i];
@@ -157,7 +257,7 @@ inline void ndSkeletonContainer::ndNode::CalculateBodyDiagonal(ndNode* const chi
 		}
 	}
 
-	ndSpatialMatrix& bodyMass = bodyMassArray[m_index];
+	ndSpatialMatrix& bodyMass = m_bodyMass;
 	for (ndInt32 i = 0; i < dof; i++) 
 	{
 		const ndSpatialVector& Jacobian = copy[i];
@@ -170,9 +270,9 @@ inline void ndSkeletonContainer::ndNode::CalculateBodyDiagonal(ndNode* const chi
 	}
 }
 
-inline void ndSkeletonContainer::ndNode::CalculateJointDiagonal(const ndSpatialMatrix* const bodyMassArray, ndSpatialMatrix* const jointMassArray)
+inline void ndSkeletonContainer::ndNode::CalculateJointDiagonal()
 {
-	const ndSpatialMatrix& bodyMass = bodyMassArray[m_index];
+	const ndSpatialMatrix& bodyMass = m_bodyMass;
 	const ndSpatialMatrix& bodyJt = m_data.m_body.m_jt;
 
 	ndSpatialMatrix tmp;
@@ -181,7 +281,7 @@ inline void ndSkeletonContainer::ndNode::CalculateJointDiagonal(const ndSpatialM
 		tmp[i] = bodyMass.VectorTimeMatrix(bodyJt[i]);
 	}
 
-	ndSpatialMatrix& jointMass = jointMassArray[m_index];
+	ndSpatialMatrix& jointMass = m_jointMass;
 	for (ndInt32 i = 0; i < m_dof; i++) 
 	{
 		ndFloat64 a = bodyJt[i].DotProduct(tmp[i]);
@@ -223,9 +323,17 @@ inline void ndSkeletonContainer::ndNode::CalculateJacobianBlock()
 	}
 }
 
-ndInt32 ndSkeletonContainer::ndNode::Factorize(const ndLeftHandSide* const leftHandSide, const ndRightHandSide* const rightHandSide, ndSpatialMatrix* const bodyMassArray, ndSpatialMatrix* const jointMassArray)
+ndInt32 ndSkeletonContainer::ndNode::Factorize(const ndLeftHandSide* const leftHandSide, const ndRightHandSide* const rightHandSide, ndFloat32 tolerance)
 {
-	CalculateInertiaMatrix(bodyMassArray);
+	const ndMatrix inertia(m_body->CalculateInertiaMatrix());
+	if (IsFactorizationValid(leftHandSide, rightHandSide, inertia, tolerance))
+	{
+		m_refactored = 0;
+		return m_joint ? m_joint->m_rowCount - m_dof : 0;
+	}
+
+	m_refactored = 1;
+	CalculateInertiaMatrix(inertia);
 
 	ndInt32 boundedDof = 0;
 	m_ordinals = m_ordinalInit;
@@ -254,16 +362,16 @@ ndInt32 ndSkeletonContainer::ndNode::Factorize(const ndLeftHandSide* const leftH
 		dAssert(m_dof >= 0);
 		dAssert(m_dof <= 6);
 		boundedDof += m_joint->m_rowCount - count;
-		GetJacobians(leftHandSide, rightHandSide, jointMassArray);
+		GetJacobians(leftHandSide, rightHandSide);
 	}
 	
 	ndSpatialMatrix& bodyInvMass = m_data.m_body.m_invMass;
-	const ndSpatialMatrix& bodyMass = bodyMassArray[m_index];
+	const ndSpatialMatrix& bodyMass = m_bodyMass;
 	if (m_body->GetInvMass() != ndFloat32(0.0f)) 
 	{
 		for (ndNode* child = m_child; child; child = child->m_sibling) 
 		{
-			CalculateBodyDiagonal(child, bodyMassArray, jointMassArray);
+			CalculateBodyDiagonal(child);
 		}
 		bodyInvMass = bodyMass.Inverse(6);
 	}
@@ -280,9 +388,14 @@ ndInt32 ndSkeletonContainer::ndNode::Factorize(const ndLeftHandSide* const leftH
 		{
 			bodyJt[i] = bodyInvMass.VectorTimeMatrix(bodyJt[i]);
 		}
-		CalculateJointDiagonal(bodyMassArray, jointMassArray);
+		CalculateJointDiagonal();
 		CalculateJacobianBlock();
 	}
+
+	if (tolerance > ndFloat32(0.0f))
+	{
+		SaveFactorizationState(leftHandSide, rightHandSide, inertia);
+	}
 	return boundedDof;
 }
 
@@ -817,6 +930,97 @@ void ndSkeletonContainer::RebuildMassMatrix(const ndFloat32* const diagDamp) con
 	}
 }
 
+inline ndFloat32 ndSkeletonContainer::DotProduct(ndInt32 size, const ndFloat32* const a, const ndFloat32* const b)
+{
+	ndInt32 i = 0;
+	ndVector acc(ndVector::m_zero);
+	for (; i < (size & -4); i += 4)
+	{
+		acc = acc + ndVector(&a[i]) * ndVector(&b[i]);
+	}
+	ndFloat32 dot = acc.AddHorizontal().GetScalar();
+	for (; i < size; i++)
+	{
+		dot += a[i] * b[i];
+	}
+	return dot;
+}
+
+bool ndSkeletonContainer::CholeskyFactorization(ndInt32 size, ndInt32 stride, ndFloat32* const matrix)
+{
+	// row oriented Cholesky factorization processed in blocks of four rows, 
+	// each row of the already factored part is loaded once and applied 
+	// to all the rows of the block using four wide simd accumulators.
+	ndFloat32* const invDiagonal = dAlloca(ndFloat32, size);
+	for (ndInt32 n = 0; n < size; n += 4)
+	{
+		const ndInt32 blockRows = dMin(size - n, 4);
+		ndFloat32* rows[4];
+		for (ndInt32 r = 0; r < 4; r++)
+		{
+			rows[r] = &matrix[stride * (n + dMin(r, blockRows - 1))];
+		}
+
+		for (ndInt32 j = 0; j < n; j++)
+		{
+			const ndFloat32* const rowJ = &matrix[stride * j];
+			ndVector acc0(ndVector::m_zero);
+			ndVector acc1(ndVector::m_zero);
+			ndVector acc2(ndVector::m_zero);
+			ndVector acc3(ndVector::m_zero);
+			ndInt32 k = 0;
+			for (; k < (j & -4); k += 4)
+			{
+				const ndVector x(&rowJ[k]);
+				acc0 = acc0 + ndVector(&rows[0][k]) * x;
+				acc1 = acc1 + ndVector(&rows[1][k]) * x;
+				acc2 = acc2 + ndVector(&rows[2][k]) * x;
+				acc3 = acc3 + ndVector(&rows[3][k]) * x;
+			}
+			ndFloat32 s[4];
+			s[0] = acc0.AddHorizontal().GetScalar();
+			s[1] = acc1.AddHorizontal().GetScalar();
+			s[2] = acc2.AddHorizontal().GetScalar();
+			s[3] = acc3.AddHorizontal().GetScalar();
+			for (; k < j; k++)
+			{
+				const ndFloat32 x = rowJ[k];
+				for (ndInt32 r = 0; r < 4; r++)
+				{
+					s[r] += rows[r][k] * x;
+				}
+			}
+			for (ndInt32 r = 0; r < blockRows; r++)
+			{
+				rows[r][j] = invDiagonal[j] * (rows[r][j] - s[r]);
+			}
+		}
+
+		for (ndInt32 r = 0; r < blockRows; r++)
+		{
+			ndFloat32* const rowN = rows[r];
+			for (ndInt32 j = n; j < n + r; j++)
+			{
+				rowN[j] = invDiagonal[j] * (rowN[j] - DotProduct(j, rowN, &matrix[stride * j]));
+			}
+
+			const ndInt32 i = n + r;
+			const ndFloat32 diag = rowN[i] - DotProduct(i, rowN, rowN);
+			if (diag < ndFloat32(1.0e-6f))
+			{
+				return false;
+			}
+			rowN[i] = ndSqrt(diag);
+			invDiagonal[i] = ndFloat32(1.0f) / rowN[i];
+			for (ndInt32 j = i + 1; j < size; j++)
+			{
+				rowN[j] = ndFloat32(0.0f);
+			}
+		}
+	}
+	return true;
+}
+
 void ndSkeletonContainer::FactorizeMatrix(ndInt32 size, ndInt32 stride, ndFloat32* const matrix, ndFloat32* const diagDamp) const
 {
 	D_TRACKTIME();
@@ -831,7 +1035,7 @@ void ndSkeletonContainer::FactorizeMatrix(ndInt32 size, ndInt32 stride, ndFloat3
 		srcLine += stride;
 	}
 
-	while (!dCholeskyFactorization(size, stride, matrix))
+	while (!CholeskyFactorization(size, stride, matrix))
 	{
 		srcLine = 0;
 		dstLine = 0;
@@ -1019,7 +1223,7 @@ void ndSkeletonContainer::InitLoopMassMatrix()
 			for (ndInt32 j = i; j < boundedSize; j++) 
 			{
 				const ndFloat32* const row1 = &m_massMatrix11[(m_blockSize + j) * m_auxiliaryRowCount];
-				ndFloat32 elem = row1[m_blockSize + i] + dDotProduct(m_blockSize, acc, row1);
+				ndFloat32 elem = row1[m_blockSize + i] + DotProduct(m_blockSize, acc, row1);
 				arow[j] = elem;
 				m_massMatrix11[(m_blockSize + j) * m_auxiliaryRowCount + m_blockSize + i] = elem;
 			}
@@ -1149,7 +1353,7 @@ void ndSkeletonContainer::SolveLcp0(ndInt32 stride, ndInt32 size, const ndFloat3
 	for (ndInt32 i = 0; i < size; i++)
 	{
 		const ndFloat32* const row = &matrix[base];
-		residual[i] = b[i] - dDotProduct(size, row, x);
+		residual[i] = b[i] - DotProduct(size, row, x);
 		base += stride;
 	}
 
@@ -1242,7 +1446,7 @@ void ndSkeletonContainer::SolveLcp(ndInt32 stride, ndInt32 size, const ndFloat32
 	for (ndInt32 i = 0; i < size; i++)
 	{
 		const ndFloat32* const row = &matrix[base];
-		residual[i] = b[i] - dDotProduct(size, row, x);
+		residual[i] = b[i] - DotProduct(size, row, x);
 		base += stride;
 	}
 
@@ -1292,7 +1496,7 @@ void ndSkeletonContainer::SolveBlockLcp(ndInt32 size, ndInt32 blockSize, const n
 			ndInt32 base = blockSize * size;
 			for (ndInt32 i = blockSize; i < size; i++) 
 			{
-				b[i] -= dDotProduct(blockSize, &m_massMatrix11[base], x);
+				b[i] -= DotProduct(blockSize, &m_massMatrix11[base], x);
 				base += size;
 			}
 
@@ -1373,7 +1577,7 @@ void ndSkeletonContainer::SolveAuxiliary(ndJacobian* const internalForces, const
 	for (ndInt32 i = 0; i < m_auxiliaryRowCount; i++) 
 	{
 		ndFloat32* const matrixRow10 = &m_massMatrix10[i * primaryCount];
-		b[i] -= dDotProduct(primaryCount, matrixRow10, f);
+		b[i] -= DotProduct(primaryCount, matrixRow10, f);
 	}
 
 	const ndInt32* const normalIndex = &m_frictionIndex[primaryCount];
@@ -1416,17 +1620,19 @@ void ndSkeletonContainer::InitMassMatrix(const ndLeftHandSide* const leftHandSid
 	m_consideredCloseLoop = consideredCloseLoop ? 1 : 0;
 
 	const ndInt32 nodeCount = m_nodeList.GetCount();
-	ndSpatialMatrix* const bodyMassArray = dAlloca(ndSpatialMatrix, nodeCount);
-	ndSpatialMatrix* const jointMassArray = dAlloca(ndSpatialMatrix, nodeCount);
 	if (m_nodesOrder)
 	{
+		// nodes are sorted children first, so each node knows 
+		// if any of its children had to be refactored.
+		const ndScene* const scene = m_nodesOrder[0]->m_body->GetScene();
+		const ndFloat32 tolerance = scene ? scene->GetWorld()->GetSkeletonFactorizationTolerance() : ndFloat32(0.0f);
 		for (ndInt32 i = 0; i < nodeCount - 1; i++)
 		{
 			ndNode* const node = m_nodesOrder[i];
 			rowCount += node->m_joint->m_rowCount;
-			auxiliaryCount += node->Factorize(leftHandSide, rightHandSide, bodyMassArray, jointMassArray);
+			auxiliaryCount += node->Factorize(leftHandSide, rightHandSide, tolerance);
 		}
-		m_nodesOrder[nodeCount - 1]->Factorize(leftHandSide, rightHandSide, bodyMassArray, jointMassArray);
+		m_nodesOrder[nodeCount - 1]->Factorize(leftHandSide, rightHandSide, tolerance);
 	}
 
 	m_rowCount = ndInt16(rowCount);
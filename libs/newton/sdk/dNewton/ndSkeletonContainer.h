@@ -65,13 +65,15 @@ class ndSkeletonContainer
 		public:
 		ndNode();
 		~ndNode();
-		ndInt32 Factorize(const ndLeftHandSide* const leftHandSide, const ndRightHandSide* const rightHandSide, ndSpatialMatrix* const bodyMassArray, ndSpatialMatrix* const jointMassArray);
+		ndInt32 Factorize(const ndLeftHandSide* const leftHandSide, const ndRightHandSide* const rightHandSide, ndFloat32 tolerance);
 
 		inline void CalculateJacobianBlock();
-		inline void CalculateInertiaMatrix(ndSpatialMatrix* const bodyMassArray) const;
-		inline void CalculateJointDiagonal(const ndSpatialMatrix* const bodyMassArray, ndSpatialMatrix* const jointMassArray);
-		inline void CalculateBodyDiagonal(ndNode* const child, ndSpatialMatrix* const bodyMassArray, const ndSpatialMatrix* const jointMassArray);
-		inline void GetJacobians(const ndLeftHandSide* const leftHandSide, const ndRightHandSide* const rightHandSide, ndSpatialMatrix* const jointMassArray);
+		inline void CalculateJointDiagonal();
+		inline void CalculateBodyDiagonal(ndNode* const child);
+		inline void CalculateInertiaMatrix(const ndMatrix& inertia);
+		inline void GetJacobians(const ndLeftHandSide* const leftHandSide, const ndRightHandSide* const rightHandSide);
+		inline void SaveFactorizationState(const ndLeftHandSide* const leftHandSide, const ndRightHandSide* const rightHandSide, const ndMatrix& inertia);
+		inline bool IsFactorizationValid(const ndLeftHandSide* const leftHandSide, const ndRightHandSide* const rightHandSide, const ndMatrix& inertia, ndFloat32 tolerance) const;
 
 		inline void BodyDiagInvTimeSolution(ndForcePair& force);
 		inline void JointDiagInvTimeSolution(ndForcePair& force);
@@ -82,6 +84,20 @@ class ndSkeletonContainer
 		inline void JointJacobianTimeSolutionBackward(ndForcePair& force, const ndForcePair& parentForce) const;
 
 		ndBodyJointMatrixDataPair m_data;
+		ndSpatialMatrix m_bodyMass;
+		ndSpatialMatrix m_jointMass;
+
+		// state used to factorize this node, a node whose inputs did not move
+		// more than the world tolerance keeps the previous factorization.
+		ndMatrix m_cachedInertia;
+		ndJacobianPair m_cachedJacobian[8];
+		ndFloat32 m_cachedDiagDamp[8];
+		ndFloat32 m_cachedMass;
+		ndUnsigned8 m_cachedBoundMask;
+		ndInt8 m_cachedRowCount;
+		ndInt8 m_factorized;
+		ndInt8 m_refactored;
+
 		ndBodyKinematic* m_body;
 		ndJointBilateralConstraint* m_joint;
 		ndNode* m_parent;
@@ -122,6 +138,8 @@ class ndSkeletonContainer
 	void InitMassMatrix(const ndLeftHandSide* const matrixRow, ndRightHandSide* const rightHandSide, bool m_consideredCloseLoop = true);
 
 	void CheckSleepState();
+	bool IsResting() const;
+	ndInt32 GetFactorizationCost() const;
 
 	private:
 	void InitLoopMassMatrix();
@@ -131,6 +149,8 @@ class ndSkeletonContainer
 	void RebuildMassMatrix(const ndFloat32* const diagDamp) const;
 	void CalculateLoopMassMatrixCoefficients(ndFloat32* const diagDamp);
 	void FactorizeMatrix(ndInt32 size, ndInt32 stride, ndFloat32* const matrix, ndFloat32* const diagDamp) const;
+	static bool CholeskyFactorization(ndInt32 size, ndInt32 stride, ndFloat32* const matrix);
+	static inline ndFloat32 DotProduct(ndInt32 size, const ndFloat32* const a, const ndFloat32* const b);
 	void SolveAuxiliary(ndJacobian* const internalForces, const ndForcePair* const accel, ndForcePair* const force) const;
 	void SolveBlockLcp(ndInt32 size, ndInt32 blockSize, const ndFloat32* const x0, ndFloat32* const x, ndFloat32* const b, const ndFloat32* const low, const ndFloat32* const high, const ndInt32* const normalIndex) const;
 	void SolveLcp(ndInt32 stride, ndInt32 size, const ndFloat32* const matrix, const ndFloat32* const x0, ndFloat32* const x, const ndFloat32* const b, const ndFloat32* const low, const ndFloat32* const high, const ndInt32* const normalIndex) const;
@@ -171,6 +191,19 @@ inline ndSkeletonContainer::ndNode* ndSkeletonContainer::GetRoot() const
 	return m_skeleton;
 }
 
+inline bool ndSkeletonContainer::IsResting() const
+{
+	return m_isResting ? true : false;
+}
+
+inline ndInt32 ndSkeletonContainer::GetFactorizationCost() const
+{
+	// tree factorization is linear in the node count, 
+	// the loop joints add a dense block on top of it.
+	const ndInt32 loopCount = m_loopCount + m_dynamicsLoopCount;
+	return m_nodeList.GetCount() + loopCount * loopCount * 6;
+}
+
 #endif
 
 
@@ -108,13 +108,19 @@ ndWorld::ndWorld()
 	,m_averageTimestepAcc(ndFloat32(0.0f))
 	,m_averageFramesCount(ndFloat32(0.0f))
 	,m_lastExecutionTime(ndFloat32(0.0f))
+	,m_skeletonFactorizationTolerance(ndFloat32(0.0f))
+	,m_statistics()
+	,m_lastStatistics()
 	,m_subSteps(1)
 	,m_solverMode(ndStandardSolver)
 	,m_solverIterations(4)
 	,m_frameIndex(0)
+	,m_worldHash(0)
 	,m_transformsLock()
 	,m_inUpdate(false)
 	,m_collisionUpdate(true)
+	,m_collectStatistics(false)
+	,m_recordStatistics(false)
 {
 	// start the engine thread;
 	m_scene = new ndWorldDefaultScene(this);
@@ -149,7 +155,12 @@ ndWorld::ndWorld()
 	m_sleepTable[D_SLEEP_ENTRIES - 1].m_maxOmega = 0.1f;
 	m_sleepTable[D_SLEEP_ENTRIES - 1].m_steps = steps;
 
-	ndBody::m_uniqueIdCount = 0;
+	// ids restart only when no body is alive, 
+	// so that bodies of other worlds keep unique ids.
+	if (!ndBody::m_liveBodyCount)
+	{
+		ndBody::m_uniqueIdCount = 0;
+	}
 	m_sentinelBody = new ndBodySentinel;
 }
 
@@ -192,8 +203,12 @@ void ndWorld::CleanUp()
 		delete body;
 	}
 
-	ndBody::m_uniqueIdCount = 1;
 	m_scene->Cleanup();
+	if (ndBody::m_liveBodyCount == 1)
+	{
+		// only the sentinel is left
+		ndBody::m_uniqueIdCount = 1;
+	}
 }
 
 void ndWorld::SelectSolver(ndSolverModes solverMode)
@@ -419,6 +434,12 @@ void ndWorld::ThreadFunction()
 	const bool collisionUpdate = m_collisionUpdate;
 	m_inUpdate = true;
 
+	m_recordStatistics = m_collectStatistics;
+	if (m_recordStatistics)
+	{
+		m_statistics.BeginUpdate(m_frameIndex);
+	}
+
 	if (collisionUpdate)
 	{
 		m_collisionUpdate = true;
@@ -430,6 +451,7 @@ void ndWorld::ThreadFunction()
 		D_TRACKTIME();
 		m_scene->Begin();
 		m_collisionUpdate = true;
+		m_scene->m_contactEventArray.SetCount(0);
 		m_scene->BalanceScene();
 
 		ndInt32 const steps = m_subSteps;
@@ -442,10 +464,26 @@ void ndWorld::ThreadFunction()
 		m_scene->SetTimestep(m_timestep);
 		
 		UpdateTransformsLock();
+		if (m_recordStatistics)
+		{
+			m_statistics.Lap();
+		}
 		UpdateTransforms();
+		if (m_recordStatistics)
+		{
+			m_statistics.m_updateTransformsTime = m_statistics.Lap();
+		}
+		if (m_scene->GetDeterministic())
+		{
+			m_worldHash = CalculateWorldHash();
+		}
 		PostModelTransform();
 		m_inUpdate = false;
 		PostUpdate(m_timestep);
+		if (m_recordStatistics)
+		{
+			m_statistics.m_postUpdateTime = m_statistics.Lap();
+		}
 		UpdateTransformsUnlock();
 
 		m_scene->End();
@@ -454,6 +492,490 @@ void ndWorld::ThreadFunction()
 	m_frameIndex++;
 	m_lastExecutionTime = (dGetTimeInMicroseconds() - timeAcc) * ndFloat32(1.0e-6f);
 	CalculateAverageUpdateTime();
+
+	if (m_recordStatistics)
+	{
+		m_statistics.m_updateTime = m_lastExecutionTime;
+		m_statistics.m_memoryUsed = ndMemory::GetMemoryUsed();
+		m_lastStatistics = m_statistics;
+		m_recordStatistics = false;
+	}
+}
+
+ndUnsigned64 ndWorld::CalculateWorldHash() const
+{
+	D_TRACKTIME();
+	ndUnsigned64 hash = 0;
+	const ndBodyList& bodyList = GetBodyList();
+	for (ndBodyList::ndNode* node = bodyList.GetFirst(); node; node = node->GetNext())
+	{
+		const ndBodyKinematic* const body = node->GetInfo();
+		const ndUnsigned32 id = body->GetId();
+		const ndMatrix& matrix = body->GetMatrix();
+		const ndVector& veloc = body->GetVelocity();
+		const ndVector& omega = body->GetOmega();
+		hash = dCRC64(&id, sizeof(id), hash);
+		hash = dCRC64(&matrix[0][0], sizeof(ndMatrix), hash);
+		hash = dCRC64(&veloc[0], 3 * sizeof(ndFloat32), hash);
+		hash = dCRC64(&omega[0], 3 * sizeof(ndFloat32), hash);
+	}
+	return hash;
+}
+
+void ndWorld::SaveSnapshot(ndWorldSnapshot& snapshot) const
+{
+	D_TRACKTIME();
+	Sync();
+
+	snapshot.m_frameIndex = m_frameIndex;
+	snapshot.m_sceneLru = m_scene->m_lru;
+	snapshot.m_checksum = CalculateWorldHash();
+
+	const ndBodyList& bodyList = GetBodyList();
+	snapshot.m_bodies.SetCount(bodyList.GetCount());
+	snapshot.m_bodiesRest.SetCount(0);
+	snapshot.m_bodiesDynamic.SetCount(0);
+	ndInt32 bodyIndex = 0;
+	for (ndBodyList::ndNode* node = bodyList.GetFirst(); node; node = node->GetNext())
+	{
+		ndBodyKinematic* const body = node->GetInfo();
+		ndWorldSnapshot::ndBodyState& state = snapshot.m_bodies[bodyIndex];
+		bodyIndex++;
+
+		state.m_matrix = body->m_matrix;
+		state.m_rotation = body->m_rotation;
+		state.m_veloc = body->m_veloc;
+		state.m_omega = body->m_omega;
+		state.m_accel = body->m_accel;
+		state.m_alpha = body->m_alpha;
+		state.m_globalCentreOfMass = body->m_globalCentreOfMass;
+		state.m_minAabb = body->m_minAabb;
+		state.m_maxAabb = body->m_maxAabb;
+		state.m_body = body;
+		state.m_id = body->GetId();
+		state.m_sleepingCounter = body->m_sleepingCounter;
+		state.m_equilibrium = body->m_equilibrium;
+		state.m_equilibrium0 = body->m_equilibrium0;
+		state.m_islandSleep = body->m_islandSleep;
+		state.m_sleepingIsland = ndUnsigned8(body->m_sleepingIsland);
+		state.m_wakeRequest = ndUnsigned8(body->m_sleepingIslandMark);
+
+		// the broad phase box only grows when the body leaves it,
+		// contacts test it for overlap, so it is part of the state.
+		state.m_sceneMinBox = state.m_minAabb;
+		state.m_sceneMaxBox = state.m_maxAabb;
+		const ndSceneBodyNode* const bodyNode = body->GetSceneBodyNode();
+		if (bodyNode)
+		{
+			bodyNode->GetAabb(state.m_sceneMinBox, state.m_sceneMaxBox);
+		}
+
+		const ndBodyDynamic* const dynBody = body->GetAsBodyDynamic();
+		state.m_restState = -1;
+		if (body->m_equilibrium)
+		{
+			state.m_restState = snapshot.m_bodiesRest.GetCount();
+			ndWorldSnapshot::ndBodyRestState restState;
+			restState.m_collisionMatrix = body->m_shapeInstance.GetGlobalMatrix();
+			restState.m_invWorldInertiaMatrix = body->m_invWorldInertiaMatrix;
+			restState.m_gyroAlpha = body->m_gyroAlpha;
+			restState.m_gyroTorque = body->m_gyroTorque;
+			restState.m_savedExternalForce = dynBody ? dynBody->m_savedExternalForce : ndVector::m_zero;
+			restState.m_savedExternalTorque = dynBody ? dynBody->m_savedExternalTorque : ndVector::m_zero;
+			snapshot.m_bodiesRest.PushBack(restState);
+		}
+
+		state.m_dynamicState = -1;
+		if (dynBody)
+		{
+			state.m_dynamicState = snapshot.m_bodiesDynamic.GetCount();
+			ndWorldSnapshot::ndBodyDynamicState dynState;
+			dynState.m_externalForce = dynBody->m_externalForce;
+			dynState.m_externalTorque = dynBody->m_externalTorque;
+			dynState.m_impulseForce = dynBody->m_impulseForce;
+			dynState.m_impulseTorque = dynBody->m_impulseTorque;
+			snapshot.m_bodiesDynamic.PushBack(dynState);
+		}
+	}
+
+	// only the rows a joint uses are saved
+	const ndJointList& jointList = GetJointList();
+	snapshot.m_joints.SetCount(jointList.GetCount());
+	snapshot.m_jointForces.SetCount(0);
+	ndInt32 jointIndex = 0;
+	for (ndJointList::ndNode* node = jointList.GetFirst(); node; node = node->GetNext())
+	{
+		ndJointBilateralConstraint* const joint = node->GetInfo();
+		ndWorldSnapshot::ndJointState& state = snapshot.m_joints[jointIndex];
+		jointIndex++;
+
+		state.m_forceBody0 = joint->m_forceBody0;
+		state.m_torqueBody0 = joint->m_torqueBody0;
+		state.m_forceBody1 = joint->m_forceBody1;
+		state.m_torqueBody1 = joint->m_torqueBody1;
+		state.m_joint = joint;
+		state.m_forceStart = snapshot.m_jointForces.GetCount();
+		state.m_forceCount = joint->m_maxDof;
+		for (ndInt32 i = 0; i < state.m_forceCount; ++i)
+		{
+			snapshot.m_jointForces.PushBack(joint->m_jointForce[i]);
+		}
+	}
+
+	// contacts are saved in the order of the contact array, 
+	// so that a restored world runs the solver in the same order.
+	// the contacts of sleeping islands are not in the array, they go last.
+	ndArray<const ndContact*> contactArray;
+	contactArray.SetCount(m_scene->m_contactArray.GetCount() + m_scene->GetSleepingContactCount());
+	for (ndInt32 i = 0; i < m_scene->m_contactArray.GetCount(); ++i)
+	{
+		contactArray[i] = m_scene->m_contactArray[i];
+	}
+	ndInt32 sleepingContactCount = m_scene->m_contactArray.GetCount();
+	if (m_scene->GetSleepingContactCount())
+	{
+		for (ndBodyList::ndNode* node = bodyList.GetFirst(); node; node = node->GetNext())
+		{
+			ndBodyKinematic* const body = node->GetInfo();
+			if (body->m_sleepingIsland)
+			{
+				ndBodyKinematic::ndContactMap::Iterator it(body->m_contactList);
+				for (it.Begin(); it; it++)
+				{
+					const ndContact* const contact = *it;
+					if (contact->m_sleepingIsland && (contact->m_body0 == body))
+					{
+						contactArray[sleepingContactCount] = contact;
+						sleepingContactCount++;
+					}
+				}
+			}
+		}
+	}
+	dAssert(sleepingContactCount == contactArray.GetCount());
+
+	snapshot.m_contacts.SetCount(contactArray.GetCount());
+	snapshot.m_contactPoints.SetCount(0);
+	snapshot.m_childCaches.SetCount(0);
+	snapshot.m_childPairs.SetCount(0);
+	for (ndInt32 i = 0; i < contactArray.GetCount(); ++i)
+	{
+		const ndContact* const contact = contactArray[i];
+		ndWorldSnapshot::ndContactState& state = snapshot.m_contacts[i];
+		dAssert(!contact->m_isDead);
+
+		state.m_positAcc = contact->m_positAcc;
+		state.m_rotationAcc = contact->m_rotationAcc;
+		state.m_separatingVector = contact->m_separatingVector;
+		state.m_material = contact->m_material;
+		state.m_body0 = contact->m_body0;
+		state.m_body1 = contact->m_body1;
+		state.m_timeOfImpact = contact->m_timeOfImpact;
+		state.m_separationDistance = contact->m_separationDistance;
+		state.m_contactPruningTolereance = contact->m_contactPruningTolereance;
+		state.m_supportVertexCache[0] = contact->m_supportVertexCache[0];
+		state.m_supportVertexCache[1] = contact->m_supportVertexCache[1];
+		state.m_maxDOF = contact->m_maxDOF;
+		state.m_sceneLru = contact->m_sceneLru;
+		state.m_active = contact->m_active;
+		state.m_isIntersetionTestOnly = ndUnsigned8(contact->m_isIntersetionTestOnly);
+		state.m_skeletonIntraCollision = ndUnsigned8(contact->m_skeletonIntraCollision);
+		state.m_skeletonSelftCollision = ndUnsigned8(contact->m_skeletonSelftCollision);
+		state.m_sleepingIsland = ndUnsigned8(contact->m_sleepingIsland);
+		state.m_isTouching = ndUnsigned8(contact->m_isTouching);
+		state.m_pointStart = snapshot.m_contactPoints.GetCount();
+		state.m_pointCount = contact->m_contacPointsList.GetCount();
+		for (ndContactPointList::ndNode* pointNode = contact->m_contacPointsList.GetFirst(); pointNode; pointNode = pointNode->GetNext())
+		{
+			snapshot.m_contactPoints.PushBack(pointNode->GetInfo());
+		}
+
+		state.m_childCache = -1;
+		const ndContactChildCache* const childCache = contact->m_childCache;
+		if (childCache)
+		{
+			state.m_childCache = snapshot.m_childCaches.GetCount();
+			ndWorldSnapshot::ndChildCacheState cacheState;
+			cacheState.m_matrix = childCache->m_matrix;
+			cacheState.m_scale0 = childCache->m_scale0;
+			cacheState.m_scale1 = childCache->m_scale1;
+			cacheState.m_shape0 = childCache->m_shape0;
+			cacheState.m_shape1 = childCache->m_shape1;
+			cacheState.m_margin = childCache->m_margin;
+			cacheState.m_revision0 = childCache->m_revision0;
+			cacheState.m_revision1 = childCache->m_revision1;
+			cacheState.m_pairStart = snapshot.m_childPairs.GetCount();
+			cacheState.m_pairCount = childCache->m_pairs.GetCount();
+			for (ndInt32 j = 0; j < cacheState.m_pairCount; ++j)
+			{
+				snapshot.m_childPairs.PushBack(childCache->m_pairs[j]);
+			}
+			snapshot.m_childCaches.PushBack(cacheState);
+		}
+	}
+}
+
+bool ndWorld::RestoreSnapshot(const ndWorldSnapshot& snapshot)
+{
+	D_TRACKTIME();
+	Sync();
+
+	// the snapshot stores pointers, it can only be restored 
+	// if the world still has the same bodies and joints.
+	const ndBodyList& bodyList = GetBodyList();
+	const ndJointList& jointList = GetJointList();
+	if ((bodyList.GetCount() != snapshot.m_bodies.GetCount()) || (jointList.GetCount() != snapshot.m_joints.GetCount()))
+	{
+		return false;
+	}
+
+	ndInt32 bodyIndex = 0;
+	for (ndBodyList::ndNode* node = bodyList.GetFirst(); node; node = node->GetNext())
+	{
+		const ndWorldSnapshot::ndBodyState& state = snapshot.m_bodies[bodyIndex];
+		bodyIndex++;
+		if ((state.m_body != node->GetInfo()) || (state.m_id != node->GetInfo()->GetId()))
+		{
+			return false;
+		}
+	}
+
+	ndInt32 jointIndex = 0;
+	for (ndJointList::ndNode* node = jointList.GetFirst(); node; node = node->GetNext())
+	{
+		const ndWorldSnapshot::ndJointState& state = snapshot.m_joints[jointIndex];
+		jointIndex++;
+		if ((state.m_joint != node->GetInfo()) || (state.m_forceCount != ndInt32(node->GetInfo()->m_maxDof)))
+		{
+			return false;
+		}
+	}
+
+	// attaching contacts wakes bodies up, so the contact cache 
+	// is restored before the body states.
+	m_scene->WakeSleepingIslands();
+
+	// contacts still alive are reused, the ones that 
+	// are not in the snapshot are deleted at the end.
+	ndContactArray& contactArray = m_scene->m_contactArray;
+	const ndInt32 liveContactCount = contactArray.GetCount();
+	for (ndInt32 i = 0; i < liveContactCount; ++i)
+	{
+		contactArray[i]->m_isDead = 1;
+	}
+
+	ndArray<ndContact*> restoredContacts;
+	restoredContacts.SetCount(snapshot.m_contacts.GetCount());
+	ndInt32 awakeContactCount = 0;
+	for (ndInt32 i = 0; i < snapshot.m_contacts.GetCount(); ++i)
+	{
+		const ndWorldSnapshot::ndContactState& state = snapshot.m_contacts[i];
+		ndContact* contact = state.m_body0->FindContact(state.m_body1);
+		if (contact && (contact->m_body0 != state.m_body0))
+		{
+			contactArray.DeleteContact(contact);
+			contact = nullptr;
+		}
+
+		if (contact)
+		{
+			contact->m_isDead = 0;
+			contact->m_wakeBodies = 0;
+			contact->m_contacPointsList.RemoveAll();
+		}
+		else
+		{
+			contact = contactArray.CreateContact(state.m_body0, state.m_body1);
+		}
+		dAssert(contact->m_body0 == state.m_body0);
+		restoredContacts[i] = contact;
+
+		contact->m_positAcc = state.m_positAcc;
+		contact->m_rotationAcc = state.m_rotationAcc;
+		contact->m_separatingVector = state.m_separatingVector;
+		contact->m_material = state.m_material;
+		contact->m_timeOfImpact = state.m_timeOfImpact;
+		contact->m_separationDistance = state.m_separationDistance;
+		contact->m_contactPruningTolereance = state.m_contactPruningTolereance;
+		contact->m_supportVertexCache[0] = state.m_supportVertexCache[0];
+		contact->m_supportVertexCache[1] = state.m_supportVertexCache[1];
+		contact->m_maxDOF = state.m_maxDOF;
+		contact->m_sceneLru = state.m_sceneLru;
+		contact->m_active = state.m_active;
+		contact->m_isIntersetionTestOnly = state.m_isIntersetionTestOnly;
+		contact->m_skeletonIntraCollision = state.m_skeletonIntraCollision;
+		contact->m_skeletonSelftCollision = state.m_skeletonSelftCollision;
+		contact->m_sleepingIsland = state.m_sleepingIsland;
+		contact->m_isTouching = state.m_isTouching;
+		awakeContactCount += state.m_sleepingIsland ? 0 : 1;
+		for (ndInt32 j = 0; j < state.m_pointCount; ++j)
+		{
+			contact->m_contacPointsList.Append(snapshot.m_contactPoints[state.m_pointStart + j]);
+		}
+
+		if (state.m_childCache >= 0)
+		{
+			const ndWorldSnapshot::ndChildCacheState& cacheState = snapshot.m_childCaches[state.m_childCache];
+			if (!contact->m_childCache)
+			{
+				contact->m_childCache = new ndContactChildCache();
+			}
+			ndContactChildCache* const childCache = contact->m_childCache;
+			childCache->m_matrix = cacheState.m_matrix;
+			childCache->m_scale0 = cacheState.m_scale0;
+			childCache->m_scale1 = cacheState.m_scale1;
+			childCache->m_shape0 = cacheState.m_shape0;
+			childCache->m_shape1 = cacheState.m_shape1;
+			childCache->m_margin = cacheState.m_margin;
+			childCache->m_revision0 = cacheState.m_revision0;
+			childCache->m_revision1 = cacheState.m_revision1;
+			childCache->m_pairs.SetCount(cacheState.m_pairCount);
+			for (ndInt32 j = 0; j < cacheState.m_pairCount; ++j)
+			{
+				childCache->m_pairs[j] = snapshot.m_childPairs[cacheState.m_pairStart + j];
+			}
+		}
+		else if (contact->m_childCache)
+		{
+			delete contact->m_childCache;
+			contact->m_childCache = nullptr;
+		}
+	}
+
+	for (ndInt32 i = 0; i < liveContactCount; ++i)
+	{
+		ndContact* const contact = contactArray[i];
+		if (contact->m_isDead)
+		{
+			contactArray.DeleteContact(contact);
+			contactArray.FreeContact(contact);
+		}
+	}
+
+	// the contacts of sleeping islands are the tail of the saved array
+	contactArray.SetCount(restoredContacts.GetCount());
+	for (ndInt32 i = 0; i < restoredContacts.GetCount(); ++i)
+	{
+		contactArray[i] = restoredContacts[i];
+	}
+	m_scene->m_sleepingContactCount = contactArray.GetCount() - awakeContactCount;
+	contactArray.SetCount(awakeContactCount);
+
+	for (ndInt32 i = 0; i < snapshot.m_bodies.GetCount(); ++i)
+	{
+		const ndWorldSnapshot::ndBodyState& state = snapshot.m_bodies[i];
+		ndBodyKinematic* const body = state.m_body;
+
+		body->m_matrix = state.m_matrix;
+		body->m_rotation = state.m_rotation;
+		body->m_veloc = state.m_veloc;
+		body->m_omega = state.m_omega;
+		body->m_accel = state.m_accel;
+		body->m_alpha = state.m_alpha;
+		body->m_globalCentreOfMass = state.m_globalCentreOfMass;
+		body->m_sleepingCounter = state.m_sleepingCounter;
+		body->m_equilibrium = state.m_equilibrium;
+		body->m_equilibrium0 = state.m_equilibrium0;
+		body->m_islandSleep = state.m_islandSleep;
+		body->m_sleepingIsland = state.m_sleepingIsland;
+		m_scene->m_sleepingBodyCount += state.m_sleepingIsland;
+
+		if (state.m_dynamicState >= 0)
+		{
+			const ndWorldSnapshot::ndBodyDynamicState& dynState = snapshot.m_bodiesDynamic[state.m_dynamicState];
+			ndBodyDynamic* const dynBody = body->GetAsBodyDynamic();
+			dAssert(dynBody);
+			dynBody->m_externalForce = dynState.m_externalForce;
+			dynBody->m_externalTorque = dynState.m_externalTorque;
+			dynBody->m_impulseForce = dynState.m_impulseForce;
+			dynBody->m_impulseTorque = dynState.m_impulseTorque;
+		}
+
+		// the collision matrix lags the body matrix of resting bodies, 
+		// so it is restored rather than recalculated, moving bodies 
+		// recalculate it and their inertia before they are used.
+		if (state.m_restState >= 0)
+		{
+			const ndWorldSnapshot::ndBodyRestState& restState = snapshot.m_bodiesRest[state.m_restState];
+			body->m_shapeInstance.SetGlobalMatrix(restState.m_collisionMatrix);
+			body->m_invWorldInertiaMatrix = restState.m_invWorldInertiaMatrix;
+			body->m_gyroAlpha = restState.m_gyroAlpha;
+			body->m_gyroTorque = restState.m_gyroTorque;
+			ndBodyDynamic* const dynBody = body->GetAsBodyDynamic();
+			if (dynBody)
+			{
+				dynBody->m_savedExternalForce = restState.m_savedExternalForce;
+				dynBody->m_savedExternalTorque = restState.m_savedExternalTorque;
+			}
+		}
+		else
+		{
+			body->m_shapeInstance.SetGlobalMatrix(body->m_shapeInstance.GetLocalMatrix() * body->m_matrix);
+			body->UpdateInvInertiaMatrix();
+		}
+		body->m_transformIsDirty = 1;
+		body->m_minAabb = state.m_minAabb;
+		body->m_maxAabb = state.m_maxAabb;
+
+		// resting bodies do not update their aabb, 
+		// so the broad phase has to see the saved box now.
+		ndSceneBodyNode* const bodyNode = body->GetSceneBodyNode();
+		if (bodyNode)
+		{
+			bodyNode->m_minBox = state.m_sceneMinBox;
+			bodyNode->m_maxBox = state.m_sceneMaxBox;
+			if (!m_scene->m_rootNode->GetAsSceneBodyNode())
+			{
+				for (ndSceneNode* parent = bodyNode->m_parent; parent; parent = parent->m_parent)
+				{
+					ndVector minBox;
+					ndVector maxBox;
+					const ndFloat32 area = m_scene->CalculateSurfaceArea(parent->GetLeft(), parent->GetRight(), minBox, maxBox);
+					if (dBoxInclusionTest(minBox, maxBox, parent->m_minBox, parent->m_maxBox))
+					{
+						break;
+					}
+					parent->m_minBox = minBox;
+					parent->m_maxBox = maxBox;
+					parent->m_surfaceArea = area;
+				}
+			}
+		}
+	}
+
+	for (ndInt32 i = 0; i < snapshot.m_joints.GetCount(); ++i)
+	{
+		const ndWorldSnapshot::ndJointState& state = snapshot.m_joints[i];
+		ndJointBilateralConstraint* const joint = state.m_joint;
+		joint->m_forceBody0 = state.m_forceBody0;
+		joint->m_torqueBody0 = state.m_torqueBody0;
+		joint->m_forceBody1 = state.m_forceBody1;
+		joint->m_torqueBody1 = state.m_torqueBody1;
+		for (ndInt32 j = 0; j < state.m_forceCount; ++j)
+		{
+			joint->m_jointForce[j] = snapshot.m_jointForces[state.m_forceStart + j];
+		}
+	}
+
+	// sleeping bodies are not visited by the transform update
+	m_scene->m_bodyListChanged = 1;
+	for (ndInt32 i = 0; i < snapshot.m_bodies.GetCount(); ++i)
+	{
+		const ndWorldSnapshot::ndBodyState& state = snapshot.m_bodies[i];
+		if (state.m_sleepingIsland)
+		{
+			m_scene->UpdateTransformNotify(0, state.m_body);
+			if (state.m_wakeRequest)
+			{
+				m_scene->WakeSleepingIsland(state.m_body);
+			}
+		}
+	}
+
+	m_scene->m_lru = snapshot.m_sceneLru;
+	m_frameIndex = snapshot.m_frameIndex;
+	m_worldHash = snapshot.m_checksum;
+	return true;
 }
 
 void ndWorld::CalculateAverageUpdateTime()
@@ -475,11 +997,19 @@ void ndWorld::SubStepUpdate(ndFloat32 timestep)
 {
 	D_TRACKTIME();
 
+	if (m_recordStatistics)
+	{
+		m_statistics.BeginSubStep();
+	}
+
 	// do the a pre-physics step
 	m_scene->m_lru = m_scene->m_lru + 1;
 	m_scene->SetTimestep(timestep);
 
+	m_scene->UpdateSleepingIslands();
+	RecordPhaseTime(ndWorldStatistics::m_updateSleepingIslands);
 	UpdateSkeletons();
+	RecordPhaseTime(ndWorldStatistics::m_updateSkeletons);
 	m_scene->InitBodyArray();
 
 	ndBodyKinematic* sentinelBody = m_sentinelBody;
@@ -496,25 +1026,99 @@ void ndWorld::SubStepUpdate(ndFloat32 timestep)
 	sentinelBody->m_weigh = ndFloat32(0.0f);
 	m_scene->GetActiveBodyArray().PushBack(sentinelBody);
 
+	RecordPhaseTime(ndWorldStatistics::m_initBodyArray);
+
 	// update the collision system
 	m_scene->FindCollidingPairs();
+	RecordPhaseTime(ndWorldStatistics::m_findCollidingPairs);
 	m_scene->CalculateContacts();
+	if (m_scene->m_wakeUpArray.GetCount())
+	{
+		// islands touched by moving bodies join the step, 
+		// they go in front of the sentinel body.
+		m_scene->GetActiveBodyArray().SetCount(m_scene->GetActiveBodyArray().GetCount() - 1);
+		m_scene->WakeRequestedIslands(true);
+		sentinelBody->m_index = m_scene->GetActiveBodyArray().GetCount();
+		m_scene->GetActiveBodyArray().PushBack(sentinelBody);
+	}
+	RecordPhaseTime(ndWorldStatistics::m_calculateContacts);
 
 	// update all special bodies.
 	m_scene->UpdateSpecial();
+	RecordPhaseTime(ndWorldStatistics::m_updateSpecial);
 
 	// Update Particle base physics
 	ParticleUpdate();
+	RecordPhaseTime(ndWorldStatistics::m_particleUpdate);
 
 	// Update all models
 	ModelUpdate();
+	RecordPhaseTime(ndWorldStatistics::m_modelUpdate);
 
 	// calculate internal forces, integrate bodies and update matrices.
+	// the solver records the time of each of its stages
 	dAssert(m_solver);
 	m_solver->Update();
 
+	m_scene->UpdateContactEvents();
+	RecordPhaseTime(ndWorldStatistics::m_contactEvents);
+
 	// second pass on models
 	ModelPostUpdate();
+	RecordPhaseTime(ndWorldStatistics::m_modelPostUpdate);
+
+	if (m_recordStatistics)
+	{
+		CollectSubStepStatistics();
+	}
+}
+
+void ndWorld::CollectSubStepStatistics()
+{
+	D_TRACKTIME();
+	dAssert(m_statistics.m_subStepCount > 0);
+	ndWorldStatistics::ndSubStep& subStep = m_statistics.m_subSteps[m_statistics.m_subStepCount - 1];
+
+	// the last entry of the active body array is the sentinel body
+	const ndArray<ndBodyKinematic*>& bodyArray = m_scene->GetActiveBodyArray();
+	for (ndInt32 i = bodyArray.GetCount() - 2; i >= 0; --i)
+	{
+		const ndBodyKinematic* const body = bodyArray[i];
+		if (!body->m_isStatic)
+		{
+			subStep.m_bodyCount++;
+			subStep.m_sleepingBodyCount += body->m_equilibrium ? 1 : 0;
+		}
+	}
+
+	// the solver leaves in the active array only the constraints it solved
+	const ndArray<ndConstraint*>& constraintArray = m_scene->GetActiveContactArray();
+	if (m_solver->GetIslands().GetCount())
+	{
+		for (ndInt32 i = constraintArray.GetCount() - 1; i >= 0; --i)
+		{
+			ndConstraint* const constraint = constraintArray[i];
+			subStep.m_solverRowCount += constraint->m_rowCount;
+			if (constraint->GetAsContact())
+			{
+				subStep.m_activeContactCount++;
+			}
+			else
+			{
+				subStep.m_activeJointCount++;
+			}
+		}
+	}
+
+	// bodies and contacts of sleeping islands are not in the active arrays
+	subStep.m_bodyCount += m_scene->GetSleepingBodyCount();
+	subStep.m_sleepingBodyCount += m_scene->GetSleepingBodyCount();
+
+	subStep.m_islandCount = m_solver->GetIslands().GetCount();
+	subStep.m_contactCount = m_scene->GetContactArray().GetCount() + m_scene->GetSleepingContactCount();
+
+	// the counting is not part of any phase
+	m_statistics.Lap();
 }
 
 void ndWorld::ParticleUpdate()
@@ -658,6 +1262,7 @@ void ndWorld::UpdateSkeletons()
 			m_skeletonList.Remove(m_skeletonList.GetFirst());
 		}
 
+		m_scene->WakeSleepingIslands();
 		m_scene->InitBodyArray();
 
 		// build connectivity graph and reset of all joint dirty state
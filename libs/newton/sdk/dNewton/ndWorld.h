@@ -26,6 +26,8 @@
 #include "ndJointList.h"
 #include "ndModelList.h"
 #include "ndSkeletonList.h"
+#include "ndWorldSnapshot.h"
+#include "ndWorldStatistics.h"
 #include "ndBodyParticleSetList.h"
 
 class ndWorld;
@@ -102,12 +104,42 @@ class ndWorld: public ndClassAlloc
 	ndInt32 GetSolverIterations() const;
 	void SetSolverIterations(ndInt32 iterations);
 
+	bool GetSpeculativeContacts() const;
+	void SetSpeculativeContacts(bool state);
+
+	bool GetDeterministic() const;
+	void SetDeterministic(bool state);
+
+	bool GetContactBinning() const;
+	void SetContactBinning(bool state);
+
+	bool GetSleepingIslands() const;
+	void SetSleepingIslands(bool state);
+	void WakeSleepingIslands();
+
+	bool GetContactEvents() const;
+	void SetContactEvents(bool state);
+	const ndArray<ndContactEvent>& GetContactEventArray() const;
+
+	ndUnsigned64 GetWorldHash() const;
+	D_NEWTON_API ndUnsigned64 CalculateWorldHash() const;
+
+	D_NEWTON_API void SaveSnapshot(ndWorldSnapshot& snapshot) const;
+	D_NEWTON_API bool RestoreSnapshot(const ndWorldSnapshot& snapshot);
+
+	ndFloat32 GetSkeletonFactorizationTolerance() const;
+	void SetSkeletonFactorizationTolerance(ndFloat32 tolerance);
+
 	ndScene* GetScene() const;
 
 	ndFloat32 GetUpdateTime() const;
 	ndUnsigned32 GetFrameIndex() const;
 	ndFloat32 GetAverageUpdateTime() const;
 
+	bool GetStatisticsEnabled() const;
+	void SetStatisticsEnabled(bool state);
+	const ndWorldStatistics& GetStatistics() const;
+
 	ndContactNotify* GetContactNotify() const;
 	void SetContactNotify(ndContactNotify* const notify);
 
@@ -151,6 +183,8 @@ class ndWorld: public ndClassAlloc
 	void ParticleUpdate();
 	void CalculateAverageUpdateTime();
 	void SubStepUpdate(ndFloat32 timestep);
+	void RecordPhaseTime(ndWorldStatistics::ndPhase phase);
+	void CollectSubStepStatistics();
 
 	bool SkeletonJointTest(ndJointBilateralConstraint* const jointA) const;
 	static ndInt32 CompareJointByInvMass(const ndJointBilateralConstraint* const jointA, const ndJointBilateralConstraint* const jointB, void* notUsed);
@@ -172,16 +206,22 @@ class ndWorld: public ndClassAlloc
 	ndFloat32 m_averageTimestepAcc;
 	ndFloat32 m_averageFramesCount;
 	ndFloat32 m_lastExecutionTime;
+	ndFloat32 m_skeletonFactorizationTolerance;
 
 	dgSolverProgressiveSleepEntry m_sleepTable[D_SLEEP_ENTRIES];
+	ndWorldStatistics m_statistics;
+	ndWorldStatistics m_lastStatistics;
 
 	ndInt32 m_subSteps;
 	ndSolverModes m_solverMode;
 	ndInt32 m_solverIterations;
 	ndUnsigned32 m_frameIndex;
+	ndUnsigned64 m_worldHash;
 	std::mutex m_transformsLock;
 	bool m_inUpdate;
 	bool m_collisionUpdate;
+	bool m_collectStatistics;
+	bool m_recordStatistics;
 
 	friend class ndScene;
 	friend class ndDynamicsUpdate;
@@ -189,6 +229,7 @@ class ndWorld: public ndClassAlloc
 	friend class ndDynamicsUpdateSoa;
 	friend class ndDynamicsUpdateAvx2;
 	friend class ndDynamicsUpdateOpencl;
+	friend class ndWorldPartition;
 } D_GCC_NEWTON_ALIGN_32;
 
 inline void ndWorld::Sync() const
@@ -231,6 +272,108 @@ inline void ndWorld::SetSolverIterations(ndInt32 iterations)
 	m_solverIterations = ndUnsigned32(dMax(4, iterations));
 }
 
+inline bool ndWorld::GetSpeculativeContacts() const
+{
+	return m_scene->GetSpeculativeContacts();
+}
+
+inline void ndWorld::SetSpeculativeContacts(bool state)
+{
+	m_scene->SetSpeculativeContacts(state);
+}
+
+inline bool ndWorld::GetDeterministic() const
+{
+	return m_scene->GetDeterministic();
+}
+
+// in deterministic mode new contacts are sorted by body id, body pairs 
+// are oriented by id and bodies woken by contacts are updated after all 
+// contacts are calculated, so that a simulation produces bit identical 
+// results regardless of the number of worker threads. 
+inline void ndWorld::SetDeterministic(bool state)
+{
+	m_scene->SetDeterministic(state);
+}
+
+inline bool ndWorld::GetContactBinning() const
+{
+	return m_scene->GetContactBinning();
+}
+
+// when enabled, the narrow phase sorts the contacts by the classes of the two 
+// shapes, sphere-sphere, box-box, convex-mesh, compound and so on, and each bin 
+// is calculated as a parallel batch, the expensive bins first and in smaller 
+// chunks, so that similar pairs run together and the threads end at the same time.
+// the contacts are the same as with the default per contact update.
+inline void ndWorld::SetContactBinning(bool state)
+{
+	Sync();
+	m_scene->SetContactBinning(state);
+}
+
+inline bool ndWorld::GetSleepingIslands() const
+{
+	return m_scene->GetSleepingIslands();
+}
+
+// when enabled, islands of resting bodies are taken out of the update 
+// and cost nothing until a moving body touches them, a joint is attached 
+// or removed, or the application sets a velocity, a matrix or a force.
+// sleeping bodies do not get OnApplyExternalForce callbacks and their 
+// contacts are not in GetContactList. it is enabled by default.
+inline void ndWorld::SetSleepingIslands(bool state)
+{
+	Sync();
+	m_scene->SetSleepingIslands(state);
+}
+
+inline void ndWorld::WakeSleepingIslands()
+{
+	Sync();
+	m_scene->WakeSleepingIslands();
+}
+
+inline bool ndWorld::GetContactEvents() const
+{
+	return m_scene->GetContactEvents();
+}
+
+// when enabled, each update records a begin, persist or end event for every 
+// touching pair, with the normal impulse of the step. it replaces reading 
+// the contacts in OnContactCallback from inside the collision update.
+inline void ndWorld::SetContactEvents(bool state)
+{
+	Sync();
+	m_scene->SetContactEvents(state);
+}
+
+// the events of the last update, call Sync before reading them.
+inline const ndArray<ndContactEvent>& ndWorld::GetContactEventArray() const
+{
+	return m_scene->GetContactEventArray();
+}
+
+// hash of the state of all bodies at the end of the last update, 
+// only calculated in deterministic mode, call Sync before reading it.
+inline ndUnsigned64 ndWorld::GetWorldHash() const
+{
+	return m_worldHash;
+}
+
+inline ndFloat32 ndWorld::GetSkeletonFactorizationTolerance() const
+{
+	return m_skeletonFactorizationTolerance;
+}
+
+// a tolerance of zero refactors every skeleton each substep, a positive value 
+// let skeleton nodes whose joint jacobians, inertia and regularizer moved less 
+// than the tolerance reuse the previous factorization.
+inline void ndWorld::SetSkeletonFactorizationTolerance(ndFloat32 tolerance)
+{
+	m_skeletonFactorizationTolerance = dMax(tolerance, ndFloat32(0.0f));
+}
+
 inline ndContactNotify* ndWorld::GetContactNotify() const
 {
 	return m_scene->GetContactNotify();
@@ -287,6 +430,30 @@ inline ndFloat32 ndWorld::GetAverageUpdateTime() const
 	return m_averageUpdateTime;
 }
 
+inline bool ndWorld::GetStatisticsEnabled() const
+{
+	return m_collectStatistics;
+}
+
+inline void ndWorld::SetStatisticsEnabled(bool state)
+{
+	m_collectStatistics = state;
+}
+
+// statistics of the last completed update, call Sync before reading them.
+inline const ndWorldStatistics& ndWorld::GetStatistics() const
+{
+	return m_lastStatistics;
+}
+
+inline void ndWorld::RecordPhaseTime(ndWorldStatistics::ndPhase phase)
+{
+	if (m_recordStatistics)
+	{
+		m_statistics.Lap(phase);
+	}
+}
+
 inline ndUnsigned32 ndWorld::GetFrameIndex() const
 {
 	return m_frameIndex;
@@ -0,0 +1,465 @@
+/* Copyright (c) <2003-2021> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ndCoreStdafx.h"
+#include "ndNewtonStdafx.h"
+#include "ndWorld.h"
+#include "ndWorldPartition.h"
+#include "ndJointBilateralConstraint.h"
+
+#define D_PARTITION_GHOST_MARGIN	ndFloat32 (2.0f)
+
+ndWorldPartitionCell::ndWorldPartitionCell(ndWorld* const world, ndInt32 x, ndInt32 z, ndFloat32 size)
+	:ndClassAlloc()
+	,m_minBox(ndFloat32(x) * size, ndFloat32(-1.0e10f), ndFloat32(z) * size, ndFloat32(0.0f))
+	,m_maxBox(ndFloat32(x + 1) * size, ndFloat32(1.0e10f), ndFloat32(z + 1) * size, ndFloat32(0.0f))
+	,m_world(world)
+	,m_x(x)
+	,m_z(z)
+	,m_active(true)
+{
+}
+
+ndWorldPartition::ndWorldPartition(ndFloat32 cellSize)
+	:ndThreadPool("newtonPartition")
+	,m_cells()
+	,m_bodies()
+	,m_activeCells()
+	,m_cellIndex(0)
+	,m_cellSize(dMax(cellSize, ndFloat32(1.0f)))
+	,m_invCellSize(ndFloat32(1.0f) / m_cellSize)
+	,m_ghostMargin(dMin(D_PARTITION_GHOST_MARGIN, m_cellSize * ndFloat32(0.5f)))
+	,m_timestep(ndFloat32(0.0f))
+	,m_frameIndex(0)
+{
+}
+
+ndWorldPartition::~ndWorldPartition()
+{
+	Sync();
+	Finish();
+
+	// the cell worlds delete their bodies and proxies
+	m_bodies.RemoveAll();
+	while (m_cells.GetRoot())
+	{
+		DeleteCell(m_cells.GetRoot()->GetInfo());
+	}
+}
+
+ndWorld* ndWorldPartition::CreateCellWorld()
+{
+	// each cell is stepped by one thread of the partition.
+	ndWorld* const world = new ndWorld();
+	world->SetThreadCount(1);
+	return world;
+}
+
+ndWorldPartitionCell* ndWorldPartition::FindCell(const ndVector& point) const
+{
+	const ndInt32 x = GetCellIndex(point.m_x);
+	const ndInt32 z = GetCellIndex(point.m_z);
+	ndCellMap::ndNode* const node = m_cells.Find(GetCellKey(x, z));
+	return node ? node->GetInfo() : nullptr;
+}
+
+ndWorldPartitionCell* ndWorldPartition::FindCreateCell(const ndVector& point)
+{
+	const ndInt32 x = GetCellIndex(point.m_x);
+	const ndInt32 z = GetCellIndex(point.m_z);
+	const ndUnsigned64 key = GetCellKey(x, z);
+	ndCellMap::ndNode* node = m_cells.Find(key);
+	if (!node)
+	{
+		// the cell is only stepped by the partition threads, 
+		// so the update thread of its scene is not needed.
+		ndWorld* const world = CreateCellWorld();
+		world->GetScene()->Finish();
+
+		ndWorldPartitionCell* const cell = new ndWorldPartitionCell(world, x, z, m_cellSize);
+		node = m_cells.Insert(cell, key);
+
+		// static bodies have to check if they need a proxy in the new cell
+		ndBodyMap::Iterator it(m_bodies);
+		for (it.Begin(); it; it++)
+		{
+			ndBodyEntry& entry = it.GetNode()->GetInfo();
+			entry.m_dirty = true;
+		}
+	}
+	return node->GetInfo();
+}
+
+ndWorldPartitionCell* ndWorldPartition::GetBodyCell(const ndBodyKinematic* const body) const
+{
+	ndBodyMap::ndNode* const node = m_bodies.Find(body->GetId());
+	return node ? node->GetInfo().m_cell : nullptr;
+}
+
+bool ndWorldPartition::AddBody(ndBodyKinematic* const body)
+{
+	Sync();
+	bool wasFound = false;
+	ndBodyMap::ndNode* const node = m_bodies.Insert(ndBodyEntry(), body->GetId(), wasFound);
+	if (wasFound)
+	{
+		return false;
+	}
+
+	ndWorldPartitionCell* const cell = FindCreateCell(body->GetMatrix().m_posit);
+	ndBodyEntry& entry = node->GetInfo();
+	entry.m_body = body;
+	entry.m_cell = cell;
+	entry.m_dirty = true;
+	cell->m_active = true;
+	return cell->m_world->AddBody(body);
+}
+
+void ndWorldPartition::RemoveBody(ndBodyKinematic* const body)
+{
+	Sync();
+	ndBodyMap::ndNode* const node = m_bodies.Find(body->GetId());
+	if (node)
+	{
+		ndBodyEntry& entry = node->GetInfo();
+		RemoveProxies(entry);
+		entry.m_cell->m_world->RemoveBody(body);
+		entry.m_cell->m_active = true;
+		m_bodies.Remove(node);
+	}
+}
+
+void ndWorldPartition::DeleteBody(ndBodyKinematic* const body)
+{
+	Sync();
+	ndBodyMap::ndNode* const node = m_bodies.Find(body->GetId());
+	if (node)
+	{
+		ndBodyEntry& entry = node->GetInfo();
+		ndWorld* const world = entry.m_cell->m_world;
+		RemoveProxies(entry);
+		entry.m_cell->m_active = true;
+		m_bodies.Remove(node);
+		world->DeleteBody(body);
+	}
+}
+
+bool ndWorldPartition::AddJoint(ndJointBilateralConstraint* const joint)
+{
+	Sync();
+	ndBodyMap::ndNode* const node0 = m_bodies.Find(joint->GetBody0()->GetId());
+	if (!node0)
+	{
+		return false;
+	}
+	ndWorldPartitionCell* const cell = node0->GetInfo().m_cell;
+
+	ndBodyKinematic* const body1 = joint->GetBody1();
+	ndBodyMap::ndNode* const node1 = body1 ? m_bodies.Find(body1->GetId()) : nullptr;
+	if (node1 && (node1->GetInfo().m_cell != cell))
+	{
+		// a joint can only connect bodies of the same world, body1 is 
+		// moved to the cell of body0 unless other joints hold it in its cell.
+		if (body1->GetJointList().GetCount())
+		{
+			return false;
+		}
+		MoveBody(node1->GetInfo(), cell);
+	}
+	cell->m_active = true;
+	cell->m_world->AddJoint(joint);
+	return true;
+}
+
+void ndWorldPartition::RemoveJoint(ndJointBilateralConstraint* const joint)
+{
+	Sync();
+	ndBodyMap::ndNode* const node = m_bodies.Find(joint->GetBody0()->GetId());
+	dAssert(node);
+	node->GetInfo().m_cell->m_world->RemoveJoint(joint);
+}
+
+void ndWorldPartition::DeleteCell(ndWorldPartitionCell* const cell)
+{
+	Sync();
+
+	// forget the bodies of the cell, and the proxies that live in it.
+	ndBodyMap::Iterator it(m_bodies);
+	for (it.Begin(); it; )
+	{
+		ndBodyMap::ndNode* const node = it.GetNode();
+		it++;
+		ndBodyEntry& entry = node->GetInfo();
+		if (entry.m_cell == cell)
+		{
+			RemoveProxies(entry);
+			m_bodies.Remove(node);
+		}
+		else
+		{
+			for (ndInt32 i = entry.m_proxies.GetCount() - 1; i >= 0; --i)
+			{
+				if (entry.m_proxies[i].m_cell == cell)
+				{
+					entry.m_proxies[i] = entry.m_proxies[entry.m_proxies.GetCount() - 1];
+					entry.m_proxies.SetCount(entry.m_proxies.GetCount() - 1);
+				}
+			}
+		}
+	}
+
+	for (ndInt32 i = m_activeCells.GetCount() - 1; i >= 0; --i)
+	{
+		if (m_activeCells[i] == cell)
+		{
+			m_activeCells[i] = m_activeCells[m_activeCells.GetCount() - 1];
+			m_activeCells.SetCount(m_activeCells.GetCount() - 1);
+		}
+	}
+
+	m_cells.Remove(GetCellKey(cell->m_x, cell->m_z));
+
+	delete cell->m_world;
+	delete cell;
+}
+
+void ndWorldPartition::RemoveProxies(ndBodyEntry& entry)
+{
+	for (ndInt32 i = 0; i < entry.m_proxies.GetCount(); ++i)
+	{
+		ndProxy& proxy = entry.m_proxies[i];
+		proxy.m_cell->m_world->DeleteBody(proxy.m_body);
+		proxy.m_cell->m_active = true;
+	}
+	entry.m_proxies.SetCount(0);
+}
+
+bool ndWorldPartition::IsMoving(const ndBodyKinematic* const body) const
+{
+	if (body->GetInvMass() == ndFloat32(0.0f))
+	{
+		// static and kinematic bodies move only if they have a velocity
+		const ndVector veloc(body->GetVelocity());
+		const ndVector omega(body->GetOmega());
+		return (veloc.DotProduct(veloc & ndVector::m_triplexMask).GetScalar() + omega.DotProduct(omega & ndVector::m_triplexMask).GetScalar()) > ndFloat32(0.0f);
+	}
+	return !body->GetSleepState();
+}
+
+void ndWorldPartition::MoveBody(ndBodyEntry& entry, ndWorldPartitionCell* const cell)
+{
+	ndBodyKinematic* const body = entry.m_body;
+	dAssert(entry.m_cell != cell);
+	entry.m_cell->m_world->RemoveBody(body);
+	entry.m_cell->m_active = true;
+	entry.m_cell = cell;
+	entry.m_dirty = true;
+	cell->m_world->AddBody(body);
+	cell->m_active = true;
+}
+
+void ndWorldPartition::UpdateProxies(ndBodyEntry& entry, bool isMoving)
+{
+	ndBodyKinematic* const body = entry.m_body;
+	ndVector minBox;
+	ndVector maxBox;
+	const ndShapeInstance& shape = body->GetCollisionShape();
+	shape.CalculateAabb(shape.GetLocalMatrix() * body->GetMatrix(), minBox, maxBox);
+
+	const ndInt32 x0 = GetCellIndex(minBox.m_x - m_ghostMargin);
+	const ndInt32 z0 = GetCellIndex(minBox.m_z - m_ghostMargin);
+	const ndInt32 x1 = GetCellIndex(maxBox.m_x + m_ghostMargin);
+	const ndInt32 z1 = GetCellIndex(maxBox.m_z + m_ghostMargin);
+
+	// remove the proxies of the cells the body no longer reaches
+	for (ndInt32 i = entry.m_proxies.GetCount() - 1; i >= 0; --i)
+	{
+		ndProxy& proxy = entry.m_proxies[i];
+		const ndWorldPartitionCell* const cell = proxy.m_cell;
+		if ((cell == entry.m_cell) || (cell->m_x < x0) || (cell->m_x > x1) || (cell->m_z < z0) || (cell->m_z > z1))
+		{
+			proxy.m_cell->m_world->DeleteBody(proxy.m_body);
+			proxy.m_cell->m_active = true;
+			entry.m_proxies[i] = entry.m_proxies[entry.m_proxies.GetCount() - 1];
+			entry.m_proxies.SetCount(entry.m_proxies.GetCount() - 1);
+		}
+	}
+
+	// add proxies to the cells that exist and do not have one
+	for (ndInt32 x = x0; x <= x1; ++x)
+	{
+		for (ndInt32 z = z0; z <= z1; ++z)
+		{
+			ndCellMap::ndNode* const node = m_cells.Find(GetCellKey(x, z));
+			ndWorldPartitionCell* const cell = node ? node->GetInfo() : nullptr;
+			if (cell && (cell != entry.m_cell))
+			{
+				bool hasProxy = false;
+				for (ndInt32 i = 0; (i < entry.m_proxies.GetCount()) && !hasProxy; ++i)
+				{
+					hasProxy = (entry.m_proxies[i].m_cell == cell);
+				}
+				if (!hasProxy)
+				{
+					ndProxy proxy;
+					proxy.m_body = new ndBodyKinematic();
+					proxy.m_body->SetCollisionShape(shape);
+					proxy.m_body->SetMatrix(body->GetMatrix());
+					proxy.m_cell = cell;
+					cell->m_world->AddBody(proxy.m_body);
+					cell->m_active = true;
+					entry.m_proxies.PushBack(proxy);
+				}
+			}
+		}
+	}
+
+	// proxies are infinitely massive bodies that follow the body
+	for (ndInt32 i = 0; i < entry.m_proxies.GetCount(); ++i)
+	{
+		ndProxy& proxy = entry.m_proxies[i];
+		proxy.m_body->SetMatrix(body->GetMatrix());
+		proxy.m_body->SetVelocity(isMoving ? body->GetVelocity() : ndVector::m_zero);
+		proxy.m_body->SetOmega(isMoving ? body->GetOmega() : ndVector::m_zero);
+		proxy.m_cell->m_active = proxy.m_cell->m_active || isMoving;
+	}
+}
+
+void ndWorldPartition::UpdateBodies()
+{
+	D_TRACKTIME();
+	const ndFloat32 hysteresis = m_ghostMargin * ndFloat32(0.5f);
+	ndBodyMap::Iterator it(m_bodies);
+	for (it.Begin(); it; it++)
+	{
+		ndBodyEntry& entry = it.GetNode()->GetInfo();
+		ndBodyKinematic* const body = entry.m_body;
+		if (IsMoving(body))
+		{
+			entry.m_cell->m_active = true;
+			const ndVector& posit = body->GetMatrix().m_posit;
+			const ndWorldPartitionCell* const cell = entry.m_cell;
+			const bool outside = 
+				(posit.m_x < (cell->m_minBox.m_x - hysteresis)) || (posit.m_x > (cell->m_maxBox.m_x + hysteresis)) ||
+				(posit.m_z < (cell->m_minBox.m_z - hysteresis)) || (posit.m_z > (cell->m_maxBox.m_z + hysteresis));
+			if (outside && !body->GetJointList().GetCount())
+			{
+				MoveBody(entry, FindCreateCell(posit));
+			}
+			UpdateProxies(entry, true);
+			entry.m_dirty = false;
+		}
+		else if (entry.m_dirty)
+		{
+			UpdateProxies(entry, false);
+			entry.m_dirty = false;
+		}
+	}
+}
+
+void ndWorldPartition::StepCells()
+{
+	D_TRACKTIME();
+	class ndStepCells: public ndThreadPoolJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			ndWorldPartition* const me = m_owner;
+			const ndInt32 count = me->m_activeCells.GetCount();
+			for (ndInt32 i = me->m_cellIndex.fetch_add(1); i < count; i = me->m_cellIndex.fetch_add(1))
+			{
+				// step the cell world in this thread, it has no update thread.
+				ndWorld* const world = me->m_activeCells[i]->m_world;
+				world->m_timestep = me->m_timestep;
+				world->m_collisionUpdate = false;
+				world->ThreadFunction();
+			}
+		}
+		ndWorldPartition* m_owner;
+	};
+
+	class ndCompareCells
+	{
+		public:
+		ndInt32 Compare(const ndWorldPartitionCell* const cellA, const ndWorldPartitionCell* const cellB, void* const) const
+		{
+			const ndInt32 countA = cellA->m_world->GetBodyList().GetCount();
+			const ndInt32 countB = cellB->m_world->GetBodyList().GetCount();
+			if (countA > countB)
+			{
+				return -1;
+			}
+			else if (countA < countB)
+			{
+				return 1;
+			}
+			return 0;
+		}
+	};
+
+	// the largest cells start first, so that the small 
+	// ones fill the gaps at the end of the update.
+	ndSort<ndWorldPartitionCell*, ndCompareCells>(&m_activeCells[0], m_activeCells.GetCount());
+
+	ndStepCells extJob[D_MAX_THREADS_COUNT];
+	ndThreadPoolJob* extJobPtr[D_MAX_THREADS_COUNT];
+	for (ndInt32 i = 0; i < GetThreadCount(); i++)
+	{
+		extJob[i].m_owner = this;
+		extJobPtr[i] = &extJob[i];
+	}
+
+	m_cellIndex.store(0);
+	Begin();
+	ExecuteJobs(extJobPtr);
+	End();
+}
+
+void ndWorldPartition::ThreadFunction()
+{
+	D_TRACKTIME();
+	UpdateBodies();
+
+	m_activeCells.SetCount(0);
+	ndCellMap::Iterator it(m_cells);
+	for (it.Begin(); it; it++)
+	{
+		ndWorldPartitionCell* const cell = it.GetNode()->GetInfo();
+		if (cell->m_active)
+		{
+			m_activeCells.PushBack(cell);
+		}
+	}
+
+	if (m_activeCells.GetCount())
+	{
+		StepCells();
+	}
+
+	// a cell sleeps until one of its bodies or proxies is awake 
+	for (ndInt32 i = 0; i < m_activeCells.GetCount(); ++i)
+	{
+		m_activeCells[i]->m_active = false;
+	}
+	m_frameIndex++;
+}
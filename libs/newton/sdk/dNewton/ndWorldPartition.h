@@ -0,0 +1,259 @@
+/* Copyright (c) <2003-2021> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef __ND_WORLD_PARTITION_H__
+#define __ND_WORLD_PARTITION_H__
+
+#include "ndNewtonStdafx.h"
+
+class ndWorld;
+class ndBodyKinematic;
+class ndWorldPartition;
+class ndJointBilateralConstraint;
+
+/// One square region of an ndWorldPartition.
+/// Each cell runs its own ndWorld, with its own scene tree and solver.
+/// The cell world has no update thread, it is stepped by the partition 
+/// threads, so ndWorld::Update must not be called on it.
+class ndWorldPartitionCell: public ndClassAlloc
+{
+	public:
+	ndWorld* GetWorld() const;
+	ndInt32 GetX() const;
+	ndInt32 GetZ() const;
+	bool IsSleeping() const;
+	void GetBox(ndVector& minBox, ndVector& maxBox) const;
+
+	private:
+	ndWorldPartitionCell(ndWorld* const world, ndInt32 x, ndInt32 z, ndFloat32 size);
+
+	ndVector m_minBox;
+	ndVector m_maxBox;
+	ndWorld* m_world;
+	ndInt32 m_x;
+	ndInt32 m_z;
+	bool m_active;
+
+	friend class ndWorldPartition;
+};
+
+/// A world split on the x z plane into square cells that are simulated 
+/// as independent ndWorld instances.
+/// A body lives in the cell that contains its origin, and migrates to the 
+/// next cell when it moves past the cell boundary by more than half the 
+/// ghost margin. Bodies closer than the ghost margin to a neighbor cell are 
+/// mirrored there by a kinematic proxy, so the bodies of that cell collide 
+/// with it. The interaction across a cell boundary is one way: each side 
+/// sees the other as infinitely massive.
+/// Bodies connected by joints must be in the same cell and do not migrate, 
+/// AddJoint fails if the bodies are held by joints in different cells.
+/// Cells without awake bodies or proxies are not stepped, the awake cells 
+/// are stepped as jobs of the partition thread pool, largest first.
+/// Cells are created on demand, and can be deleted with DeleteCell to 
+/// stream a region out.
+D_MSV_NEWTON_ALIGN_32
+class ndWorldPartition: public ndThreadPool
+{
+	public:
+	D_NEWTON_API ndWorldPartition(ndFloat32 cellSize);
+	D_NEWTON_API virtual ~ndWorldPartition();
+
+	void Sync();
+	void Update(ndFloat32 timestep);
+
+	ndInt32 GetThreadCount() const;
+	void SetThreadCount(ndInt32 count);
+
+	ndFloat32 GetCellSize() const;
+	ndFloat32 GetGhostMargin() const;
+	void SetGhostMargin(ndFloat32 margin);
+
+	D_NEWTON_API bool AddBody(ndBodyKinematic* const body);
+	D_NEWTON_API void RemoveBody(ndBodyKinematic* const body);
+	D_NEWTON_API void DeleteBody(ndBodyKinematic* const body);
+
+	D_NEWTON_API bool AddJoint(ndJointBilateralConstraint* const joint);
+	D_NEWTON_API void RemoveJoint(ndJointBilateralConstraint* const joint);
+
+	D_NEWTON_API ndWorldPartitionCell* FindCell(const ndVector& point) const;
+	D_NEWTON_API ndWorldPartitionCell* GetBodyCell(const ndBodyKinematic* const body) const;
+	D_NEWTON_API void DeleteCell(ndWorldPartitionCell* const cell);
+
+	ndInt32 GetCellCount() const;
+	ndInt32 GetActiveCellCount() const;
+	ndUnsigned32 GetFrameIndex() const;
+
+	protected:
+	/// called every time a cell is created, an application can
+	/// override it to configure the solver and notifications of the cell world.
+	D_NEWTON_API virtual ndWorld* CreateCellWorld();
+
+	private:
+	class ndProxy
+	{
+		public:
+		ndBodyKinematic* m_body;
+		ndWorldPartitionCell* m_cell;
+	};
+
+	class ndBodyEntry
+	{
+		public:
+		ndBodyEntry()
+			:m_proxies()
+			,m_body(nullptr)
+			,m_cell(nullptr)
+			,m_dirty(true)
+		{
+		}
+
+		ndArray<ndProxy> m_proxies;
+		ndBodyKinematic* m_body;
+		ndWorldPartitionCell* m_cell;
+		bool m_dirty;
+	};
+
+	class ndCellMap: public ndTree<ndWorldPartitionCell*, ndUnsigned64, ndContainersFreeListAlloc<ndWorldPartitionCell*>>
+	{
+	};
+
+	class ndBodyMap: public ndTree<ndBodyEntry, ndUnsigned32, ndContainersFreeListAlloc<ndBodyEntry>>
+	{
+	};
+
+	virtual void ThreadFunction();
+
+	void UpdateBodies();
+	void StepCells();
+	void UpdateProxies(ndBodyEntry& entry, bool isMoving);
+	void MoveBody(ndBodyEntry& entry, ndWorldPartitionCell* const cell);
+	bool IsMoving(const ndBodyKinematic* const body) const;
+	void RemoveProxies(ndBodyEntry& entry);
+	ndWorldPartitionCell* FindCreateCell(const ndVector& point);
+	ndUnsigned64 GetCellKey(ndInt32 x, ndInt32 z) const;
+	ndInt32 GetCellIndex(ndFloat32 coordinate) const;
+
+	ndCellMap m_cells;
+	ndBodyMap m_bodies;
+	ndArray<ndWorldPartitionCell*> m_activeCells;
+	ndAtomic<ndInt32> m_cellIndex;
+	ndFloat32 m_cellSize;
+	ndFloat32 m_invCellSize;
+	ndFloat32 m_ghostMargin;
+	ndFloat32 m_timestep;
+	ndUnsigned32 m_frameIndex;
+} D_GCC_NEWTON_ALIGN_32;
+
+inline ndWorld* ndWorldPartitionCell::GetWorld() const
+{
+	return m_world;
+}
+
+inline ndInt32 ndWorldPartitionCell::GetX() const
+{
+	return m_x;
+}
+
+inline ndInt32 ndWorldPartitionCell::GetZ() const
+{
+	return m_z;
+}
+
+inline bool ndWorldPartitionCell::IsSleeping() const
+{
+	return !m_active;
+}
+
+inline void ndWorldPartitionCell::GetBox(ndVector& minBox, ndVector& maxBox) const
+{
+	minBox = m_minBox;
+	maxBox = m_maxBox;
+}
+
+inline void ndWorldPartition::Sync()
+{
+	ndSyncMutex::Sync();
+}
+
+inline void ndWorldPartition::Update(ndFloat32 timestep)
+{
+	// wait until previous update complete.
+	Sync();
+	m_timestep = timestep;
+
+	// update the next frame asynchronous 
+	TickOne();
+}
+
+inline ndInt32 ndWorldPartition::GetThreadCount() const
+{
+	return GetCount();
+}
+
+inline void ndWorldPartition::SetThreadCount(ndInt32 count)
+{
+	Sync();
+	SetCount(count);
+}
+
+inline ndFloat32 ndWorldPartition::GetCellSize() const
+{
+	return m_cellSize;
+}
+
+inline ndFloat32 ndWorldPartition::GetGhostMargin() const
+{
+	return m_ghostMargin;
+}
+
+inline void ndWorldPartition::SetGhostMargin(ndFloat32 margin)
+{
+	m_ghostMargin = dClamp(margin, ndFloat32(0.0f), m_cellSize * ndFloat32(0.5f));
+}
+
+inline ndInt32 ndWorldPartition::GetCellCount() const
+{
+	return m_cells.GetCount();
+}
+
+inline ndInt32 ndWorldPartition::GetActiveCellCount() const
+{
+	return m_activeCells.GetCount();
+}
+
+inline ndUnsigned32 ndWorldPartition::GetFrameIndex() const
+{
+	return m_frameIndex;
+}
+
+inline ndUnsigned64 ndWorldPartition::GetCellKey(ndInt32 x, ndInt32 z) const
+{
+	return (ndUnsigned64(ndUnsigned32(x)) << 32) + ndUnsigned32(z);
+}
+
+inline ndInt32 ndWorldPartition::GetCellIndex(ndFloat32 coordinate) const
+{
+	return ndInt32(ndFloor(coordinate * m_invCellSize));
+}
+
+#endif 
+
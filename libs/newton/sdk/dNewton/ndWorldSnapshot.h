@@ -0,0 +1,213 @@
+/* Copyright (c) <2003-2021> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef __ND_WORLD_SNAPSHOT_H__
+#define __ND_WORLD_SNAPSHOT_H__
+
+#include "ndNewtonStdafx.h"
+#include "ndContact.h"
+
+class ndBodyKinematic;
+class ndJointBilateralConstraint;
+
+/// In memory copy of the dynamic state of a world.
+/// It holds the body states, the joint warm start forces and the contact
+/// cache, so that a world can be rewound with ndWorld::RestoreSnapshot and
+/// replayed with the same results it produced the first time. 
+/// The snapshot does not own bodies or joints, it can only be restored to 
+/// the world that saved it while the same bodies and joints are in it.
+/// The arrays keep their memory between saves, so a ring of snapshots 
+/// reused every frame does not allocate.
+class ndWorldSnapshot: public ndClassAlloc
+{
+	public:
+	// only the state the integrator carries from one step to the next is 
+	// saved, the solver recalculates inertia, gyro and damping terms of
+	// moving bodies before using them.
+	class ndBodyState
+	{
+		public:
+		ndMatrix m_matrix;
+		ndQuaternion m_rotation;
+		ndVector m_veloc;
+		ndVector m_omega;
+		ndVector m_accel;
+		ndVector m_alpha;
+		ndVector m_globalCentreOfMass;
+		ndVector m_minAabb;
+		ndVector m_maxAabb;
+		ndVector m_sceneMinBox;
+		ndVector m_sceneMaxBox;
+
+		ndBodyKinematic* m_body;
+		ndUnsigned32 m_id;
+		ndInt32 m_sleepingCounter;
+		ndInt32 m_restState;
+		ndInt32 m_dynamicState;
+		ndUnsigned8 m_equilibrium;
+		ndUnsigned8 m_equilibrium0;
+		ndUnsigned8 m_islandSleep;
+		ndUnsigned8 m_sleepingIsland;
+		ndUnsigned8 m_wakeRequest;
+	};
+
+	// bodies in equilibrium skip the transform and solver updates, 
+	// so the terms those calculate are saved for them only.
+	class ndBodyRestState
+	{
+		public:
+		ndMatrix m_collisionMatrix;
+		ndMatrix m_invWorldInertiaMatrix;
+		ndVector m_gyroAlpha;
+		ndVector m_gyroTorque;
+		ndVector m_savedExternalForce;
+		ndVector m_savedExternalTorque;
+	};
+
+	class ndBodyDynamicState
+	{
+		public:
+		ndVector m_externalForce;
+		ndVector m_externalTorque;
+		ndVector m_impulseForce;
+		ndVector m_impulseTorque;
+	};
+
+	class ndJointState
+	{
+		public:
+		ndVector m_forceBody0;
+		ndVector m_torqueBody0;
+		ndVector m_forceBody1;
+		ndVector m_torqueBody1;
+		ndJointBilateralConstraint* m_joint;
+		ndInt32 m_forceStart;
+		ndInt32 m_forceCount;
+	};
+
+	class ndContactState
+	{
+		public:
+		ndVector m_positAcc;
+		ndQuaternion m_rotationAcc;
+		ndVector m_separatingVector;
+		ndMaterial m_material;
+		ndBodyKinematic* m_body0;
+		ndBodyKinematic* m_body1;
+		ndFloat32 m_timeOfImpact;
+		ndFloat32 m_separationDistance;
+		ndFloat32 m_contactPruningTolereance;
+		ndInt32 m_supportVertexCache[2];
+		ndUnsigned32 m_maxDOF;
+		ndUnsigned32 m_sceneLru;
+		ndInt32 m_pointStart;
+		ndInt32 m_pointCount;
+		ndInt32 m_childCache;
+		ndUnsigned8 m_active;
+		ndUnsigned8 m_isIntersetionTestOnly;
+		ndUnsigned8 m_skeletonIntraCollision;
+		ndUnsigned8 m_skeletonSelftCollision;
+		ndUnsigned8 m_sleepingIsland;
+		ndUnsigned8 m_isTouching;
+	};
+
+	class ndChildCacheState
+	{
+		public:
+		ndMatrix m_matrix;
+		ndVector m_scale0;
+		ndVector m_scale1;
+		const ndShape* m_shape0;
+		const ndShape* m_shape1;
+		ndFloat32 m_margin;
+		ndUnsigned32 m_revision0;
+		ndUnsigned32 m_revision1;
+		ndInt32 m_pairStart;
+		ndInt32 m_pairCount;
+	};
+
+	ndWorldSnapshot();
+
+	ndUnsigned64 GetChecksum() const;
+	ndUnsigned32 GetFrameIndex() const;
+	ndUnsigned64 GetSizeInBytes() const;
+
+	private:
+	ndArray<ndBodyState> m_bodies;
+	ndArray<ndBodyRestState> m_bodiesRest;
+	ndArray<ndBodyDynamicState> m_bodiesDynamic;
+	ndArray<ndJointState> m_joints;
+	ndArray<ndForceImpactPair> m_jointForces;
+	ndArray<ndContactState> m_contacts;
+	ndArray<ndContactMaterial> m_contactPoints;
+	ndArray<ndChildCacheState> m_childCaches;
+	ndArray<ndContactChildCache::ndPair> m_childPairs;
+	ndUnsigned64 m_checksum;
+	ndUnsigned32 m_frameIndex;
+	ndUnsigned32 m_sceneLru;
+
+	friend class ndWorld;
+};
+
+inline ndWorldSnapshot::ndWorldSnapshot()
+	:ndClassAlloc()
+	,m_bodies()
+	,m_bodiesRest()
+	,m_bodiesDynamic()
+	,m_joints()
+	,m_jointForces()
+	,m_contacts()
+	,m_contactPoints()
+	,m_childCaches()
+	,m_childPairs()
+	,m_checksum(0)
+	,m_frameIndex(0)
+	,m_sceneLru(0)
+{
+}
+
+// same value ndWorld::CalculateWorldHash returned when the snapshot was saved.
+inline ndUnsigned64 ndWorldSnapshot::GetChecksum() const
+{
+	return m_checksum;
+}
+
+inline ndUnsigned32 ndWorldSnapshot::GetFrameIndex() const
+{
+	return m_frameIndex;
+}
+
+inline ndUnsigned64 ndWorldSnapshot::GetSizeInBytes() const
+{
+	return 
+		ndUnsigned64(m_bodies.GetCount()) * sizeof(ndBodyState) +
+		ndUnsigned64(m_bodiesRest.GetCount()) * sizeof(ndBodyRestState) +
+		ndUnsigned64(m_bodiesDynamic.GetCount()) * sizeof(ndBodyDynamicState) +
+		ndUnsigned64(m_joints.GetCount()) * sizeof(ndJointState) +
+		ndUnsigned64(m_jointForces.GetCount()) * sizeof(ndForceImpactPair) +
+		ndUnsigned64(m_contacts.GetCount()) * sizeof(ndContactState) +
+		ndUnsigned64(m_contactPoints.GetCount()) * sizeof(ndContactMaterial) +
+		ndUnsigned64(m_childCaches.GetCount()) * sizeof(ndChildCacheState) +
+		ndUnsigned64(m_childPairs.GetCount()) * sizeof(ndContactChildCache::ndPair);
+}
+
+#endif
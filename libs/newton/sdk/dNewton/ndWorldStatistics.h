@@ -0,0 +1,170 @@
+/* Copyright (c) <2003-2021> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef __ND_WORLD_STATISTICS_H__
+#define __ND_WORLD_STATISTICS_H__
+
+#include "ndNewtonStdafx.h"
+
+#define D_MAX_STATISTICS_SUBSTEPS	16
+
+/// Times and counters of one world update.
+/// They are recorded only after calling ndWorld::SetStatisticsEnabled(true),
+/// times are in seconds.
+class ndWorldStatistics
+{
+	public:
+	enum ndPhase
+	{
+		m_updateSleepingIslands,
+		m_updateSkeletons,
+		m_initBodyArray,
+		m_findCollidingPairs,
+		m_calculateContacts,
+		m_updateSpecial,
+		m_particleUpdate,
+		m_modelUpdate,
+		m_solverBuildIsland,
+		m_solverIntegrateUnconstrainedBodies,
+		m_solverInitWeights,
+		m_solverInitBodyArray,
+		m_solverInitJacobianMatrix,
+		m_solverCalculateForces,
+		m_solverIntegrateBodies,
+		m_solverDetermineSleepStates,
+		m_contactEvents,
+		m_modelPostUpdate,
+		m_phaseCount,
+	};
+
+	class ndSubStep
+	{
+		public:
+		ndFloat32 m_phaseTime[m_phaseCount];
+		ndInt32 m_bodyCount;
+		ndInt32 m_sleepingBodyCount;
+		ndInt32 m_islandCount;
+		ndInt32 m_contactCount;
+		ndInt32 m_activeContactCount;
+		ndInt32 m_activeJointCount;
+		ndInt32 m_solverRowCount;
+	};
+
+	ndWorldStatistics();
+
+	static const char* GetPhaseName(ndPhase phase);
+
+	void BeginUpdate(ndUnsigned32 frameIndex);
+	void BeginSubStep();
+	void Lap(ndPhase phase);
+	ndFloat32 Lap();
+
+	ndSubStep m_subSteps[D_MAX_STATISTICS_SUBSTEPS];
+	ndInt32 m_subStepCount;
+	ndUnsigned32 m_frameIndex;
+
+	// per update times, out of the sub steps loop
+	ndFloat32 m_updateTransformsTime;
+	ndFloat32 m_postUpdateTime;
+	ndFloat32 m_updateTime;
+
+	// bytes allocated by ndMemory at the end of the update
+	ndUnsigned64 m_memoryUsed;
+
+	private:
+	std::chrono::steady_clock::time_point m_lapTime;
+};
+
+inline ndWorldStatistics::ndWorldStatistics()
+{
+	memset(m_subSteps, 0, sizeof(m_subSteps));
+	m_subStepCount = 0;
+	m_frameIndex = 0;
+	m_updateTransformsTime = ndFloat32(0.0f);
+	m_postUpdateTime = ndFloat32(0.0f);
+	m_updateTime = ndFloat32(0.0f);
+	m_memoryUsed = 0;
+	m_lapTime = std::chrono::steady_clock::now();
+}
+
+inline const char* ndWorldStatistics::GetPhaseName(ndPhase phase)
+{
+	static const char* const names[] =
+	{
+		"UpdateSleepingIslands",
+		"UpdateSkeletons",
+		"InitBodyArray",
+		"FindCollidingPairs",
+		"CalculateContacts",
+		"UpdateSpecial",
+		"ParticleUpdate",
+		"ModelUpdate",
+		"SolverBuildIsland",
+		"SolverIntegrateUnconstrainedBodies",
+		"SolverInitWeights",
+		"SolverInitBodyArray",
+		"SolverInitJacobianMatrix",
+		"SolverCalculateForces",
+		"SolverIntegrateBodies",
+		"SolverDetermineSleepStates",
+		"ContactEvents",
+		"ModelPostUpdate",
+	};
+	dAssert(sizeof(names) / sizeof(names[0]) == m_phaseCount);
+	return ((phase >= 0) && (phase < m_phaseCount)) ? names[phase] : "";
+}
+
+inline void ndWorldStatistics::BeginUpdate(ndUnsigned32 frameIndex)
+{
+	m_subStepCount = 0;
+	m_frameIndex = frameIndex;
+	m_updateTransformsTime = ndFloat32(0.0f);
+	m_postUpdateTime = ndFloat32(0.0f);
+	m_updateTime = ndFloat32(0.0f);
+	m_lapTime = std::chrono::steady_clock::now();
+}
+
+inline void ndWorldStatistics::BeginSubStep()
+{
+	dAssert(m_subStepCount < D_MAX_STATISTICS_SUBSTEPS);
+	memset(&m_subSteps[m_subStepCount], 0, sizeof(ndSubStep));
+	m_subStepCount++;
+	m_lapTime = std::chrono::steady_clock::now();
+}
+
+// return the seconds since the last lap and start a new lap
+inline ndFloat32 ndWorldStatistics::Lap()
+{
+	const std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+	const ndFloat32 elapsed = std::chrono::duration<ndFloat32>(time - m_lapTime).count();
+	m_lapTime = time;
+	return elapsed;
+}
+
+// add the seconds since the last lap to phase of the current sub step 
+inline void ndWorldStatistics::Lap(ndPhase phase)
+{
+	dAssert(m_subStepCount > 0);
+	m_subSteps[m_subStepCount - 1].m_phaseTime[phase] += Lap();
+}
+
+#endif